@@ -0,0 +1,270 @@
+//
+// Created by yangbin on 2021/7/10.
+//
+// Compare the MessageQueue engine with the previous sorted linked-list
+// implementation.
+//
+// Reports:
+//  * posts/sec: N producers post immediate tasks to one consumer.
+//  * wakeup latency: a single task is posted to an idle consumer, measure the
+//    time until it starts running.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/message_queue.h"
+
+using namespace media;
+using namespace media::base;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// The queue engine before the timer heap/lock-free rewrite. Every post heap
+// allocates a node and walks a sorted list under a recursive mutex.
+class LegacyMessageQueue {
+
+ public:
+
+  struct Node {
+    TaskClosure task;
+    TimeTicks when = TimeTicks::Now();
+    Node *next = nullptr;
+  };
+
+  ~LegacyMessageQueue() {
+    while (messages_ != nullptr) {
+      Node *n = messages_->next;
+      delete messages_;
+      messages_ = n;
+    }
+  }
+
+  void EnqueueMessage(const TaskClosure &task) {
+    std::unique_lock<std::recursive_mutex> auto_lock(message_queue_lock_);
+    auto *msg = new Node();
+    msg->task = task;
+    Node *p = messages_;
+    bool need_wake;
+    if (p == nullptr || msg->when < p->when) {
+      msg->next = p;
+      messages_ = msg;
+      need_wake = blocked_;
+    } else {
+      need_wake = false;
+      Node *prev;
+      for (;;) {
+        prev = p;
+        p = p->next;
+        if (p == nullptr || msg->when < p->when) {
+          break;
+        }
+      }
+      msg->next = p;
+      prev->next = msg;
+    }
+    if (need_wake) {
+      std::lock_guard<std::mutex> condition_lock(message_wait_lock_);
+      message_wait_condition_.notify_one();
+    }
+  }
+
+  Node *next() {
+    TimeDelta timeout;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> condition_lock(message_wait_lock_);
+        if (timeout.is_inf()) {
+          // The original waits without timeout and may miss a wakeup posted
+          // right before it goes to sleep, bound the wait to keep the benchmark going.
+          message_wait_condition_.wait_for(condition_lock, std::chrono::milliseconds(100));
+        } else {
+          message_wait_condition_.wait_for(condition_lock, std::chrono::microseconds(timeout.InMicroseconds()));
+        }
+      }
+      std::lock_guard<std::recursive_mutex> auto_lock(message_queue_lock_);
+      auto now = TimeTicks::Now();
+      Node *msg = messages_;
+      if (msg != nullptr) {
+        if (now < msg->when) {
+          timeout = msg->when - now;
+        } else {
+          blocked_ = false;
+          messages_ = msg->next;
+          return msg;
+        }
+      } else {
+        timeout = TimeDelta::Max();
+      }
+      if (quitting_) {
+        return nullptr;
+      }
+      blocked_ = true;
+    }
+  }
+
+  void Quit() {
+    std::lock_guard<std::recursive_mutex> auto_lock(message_queue_lock_);
+    quitting_ = true;
+    std::lock_guard<std::mutex> condition_lock(message_wait_lock_);
+    message_wait_condition_.notify_one();
+  }
+
+ private:
+  Node *messages_ = nullptr;
+  std::recursive_mutex message_queue_lock_;
+  std::condition_variable_any message_wait_condition_;
+  std::mutex message_wait_lock_;
+  bool quitting_ = false;
+  bool blocked_ = false;
+};
+
+struct LegacyEngine {
+  LegacyMessageQueue queue;
+
+  void Post(const TaskClosure &task) {
+    queue.EnqueueMessage(task);
+  }
+
+  bool RunOne() {
+    auto *msg = queue.next();
+    if (msg == nullptr) {
+      return false;
+    }
+    msg->task();
+    delete msg;
+    return true;
+  }
+
+  void Quit() { queue.Quit(); }
+};
+
+struct CurrentEngine {
+  MessageQueue queue;
+
+  void Post(const TaskClosure &task) {
+    queue.EnqueueMessage(Message(task, FROM_HERE, TimeDelta(), nullptr, 0));
+  }
+
+  bool RunOne() {
+    auto *msg = queue.next();
+    if (msg == nullptr) {
+      return false;
+    }
+    msg->task();
+    queue.Recycle(msg);
+    return true;
+  }
+
+  void Quit() { queue.Quit(); }
+};
+
+template<typename Engine>
+double MeasurePostsPerSecond(int producer_count, int posts_per_producer) {
+  Engine engine;
+  const int total = producer_count * posts_per_producer;
+  std::atomic_int executed(0);
+
+  std::thread consumer([&]() {
+    while (executed.load(std::memory_order_relaxed) < total && engine.RunOne()) {
+    }
+  });
+
+  auto start = Clock::now();
+  std::vector<std::thread> producers;
+  for (int i = 0; i < producer_count; ++i) {
+    producers.emplace_back([&]() {
+      TaskClosure task = [&executed]() { executed.fetch_add(1, std::memory_order_relaxed); };
+      for (int j = 0; j < posts_per_producer; ++j) {
+        engine.Post(task);
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  consumer.join();
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  engine.Quit();
+  return total / elapsed;
+}
+
+template<typename Engine>
+std::vector<double> MeasureWakeupLatency(int samples) {
+  Engine engine;
+  std::vector<double> latencies;
+  latencies.reserve(samples);
+
+  std::mutex mutex;
+  std::condition_variable done_condition;
+  bool done = false;
+  std::atomic_bool running(true);
+
+  std::thread consumer([&]() {
+    while (running && engine.RunOne()) {
+    }
+  });
+
+  for (int i = 0; i < samples; ++i) {
+    // Let the consumer go idle.
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    auto posted = Clock::now();
+    engine.Post([&, posted]() {
+      auto latency = std::chrono::duration<double, std::micro>(Clock::now() - posted).count();
+      std::lock_guard<std::mutex> lock(mutex);
+      latencies.push_back(latency);
+      done = true;
+      done_condition.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    done_condition.wait(lock, [&]() { return done; });
+    done = false;
+  }
+
+  running = false;
+  engine.Post([]() {});
+  consumer.join();
+  engine.Quit();
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+double Percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[index];
+}
+
+template<typename Engine>
+void RunBenchmark(const char *name, int total_posts, int latency_samples) {
+  for (int producers : {1, 4}) {
+    printf("%-8s posts/sec (%d producer%s): %12.0f\n", name, producers, producers > 1 ? "s" : " ",
+           MeasurePostsPerSecond<Engine>(producers, total_posts / producers));
+  }
+  auto latencies = MeasureWakeupLatency<Engine>(latency_samples);
+  printf("%-8s wakeup latency us: p50 %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f\n", name,
+         Percentile(latencies, 0.5), Percentile(latencies, 0.9), Percentile(latencies, 0.99),
+         Percentile(latencies, 1));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int posts = argc > 1 ? atoi(argv[1]) : 200000;
+  int latency_samples = argc > 2 ? atoi(argv[2]) : 1000;
+
+  RunBenchmark<LegacyEngine>("legacy", posts, latency_samples);
+  RunBenchmark<CurrentEngine>("current", posts, latency_samples);
+  return 0;
+}
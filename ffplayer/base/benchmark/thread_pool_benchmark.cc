@@ -0,0 +1,200 @@
+//
+// Created by yangbin on 2021/7/17.
+//
+// Scaling benchmark of dedicated looper threads vs the shared ThreadPool.
+//
+// Every simulated player owns the five loopers of a MediaPlayer: "media_player",
+// "demux", "audio_decoder", "video_decoder" and "video_render". The demuxer
+// feeds packets to both decoders, the renderer ticks at 60 fps. For 1, 8, 32
+// and 64 concurrent players it reports the executed tasks, render tick
+// lateness, CPU time and context switches.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+#include "base/message_loop.h"
+#include "base/task_runner.h"
+#include "base/thread_pool.h"
+
+using namespace media;
+using namespace media::base;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+void BusyWork(std::chrono::microseconds duration) {
+  auto end = Clock::now() + duration;
+  while (Clock::now() < end) {
+  }
+}
+
+struct Counters {
+  std::atomic<int64> tasks{0};
+  std::mutex mutex;
+  std::vector<double> render_lateness_us;
+};
+
+class SimulatedPlayer : public std::enable_shared_from_this<SimulatedPlayer> {
+
+ public:
+
+  SimulatedPlayer(bool use_pool, Counters *counters) : counters_(counters) {
+    auto create = [use_pool](const char *name) {
+      return use_pool ? MessageLooper::PrepareSequencedLooper(name) : MessageLooper::PrepareLooper(name);
+    };
+    player_ = TaskRunner(create("media_player"));
+    demux_ = TaskRunner(create("demux"));
+    audio_decoder_ = TaskRunner(create("audio_decoder"));
+    video_decoder_ = TaskRunner(create("video_decoder"));
+    video_render_ = TaskRunner(create("video_render"));
+  }
+
+  void Start() {
+    running_ = true;
+    demux_.PostTask(FROM_HERE, [this]() { Demux(); });
+    video_render_.PostTask(FROM_HERE, [this]() { Render(Clock::now()); });
+    player_.PostTask(FROM_HERE, [this]() { UpdateStatus(); });
+  }
+
+  void Stop() {
+    running_ = false;
+    // Let tasks in flight see |running_| before the runners go away.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    player_ = nullptr;
+    demux_ = nullptr;
+    audio_decoder_ = nullptr;
+    video_decoder_ = nullptr;
+    video_render_ = nullptr;
+  }
+
+ private:
+
+  Counters *counters_;
+  std::atomic_bool running_{false};
+
+  TaskRunner player_;
+  TaskRunner demux_;
+  TaskRunner audio_decoder_;
+  TaskRunner video_decoder_;
+  TaskRunner video_render_;
+
+  void Demux() {
+    if (!running_) return;
+    counters_->tasks++;
+    BusyWork(std::chrono::microseconds(20));
+    audio_decoder_.PostTask(FROM_HERE, [this]() {
+      counters_->tasks++;
+      BusyWork(std::chrono::microseconds(30));
+    });
+    video_decoder_.PostTask(FROM_HERE, [this]() {
+      counters_->tasks++;
+      BusyWork(std::chrono::microseconds(300));
+    });
+    demux_.PostDelayedTask(FROM_HERE, TimeDelta::FromMilliseconds(16), [this]() { Demux(); });
+  }
+
+  void Render(Clock::time_point expected) {
+    if (!running_) return;
+    counters_->tasks++;
+    auto lateness = std::chrono::duration<double, std::micro>(Clock::now() - expected).count();
+    {
+      std::lock_guard<std::mutex> lock(counters_->mutex);
+      counters_->render_lateness_us.push_back(lateness);
+    }
+    BusyWork(std::chrono::microseconds(100));
+    auto next = Clock::now() + std::chrono::microseconds(16666);
+    video_render_.PostDelayedTask(FROM_HERE, TimeDelta::FromMicroseconds(16666), [this, next]() { Render(next); });
+  }
+
+  void UpdateStatus() {
+    if (!running_) return;
+    counters_->tasks++;
+    player_.PostDelayedTask(FROM_HERE, TimeDelta::FromMilliseconds(100), [this]() { UpdateStatus(); });
+  }
+
+};
+
+struct ResourceUsage {
+  double cpu_seconds = 0;
+  long context_switches = 0;
+};
+
+ResourceUsage GetResourceUsage() {
+  ResourceUsage usage;
+#if !defined(_WIN32)
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+  usage.cpu_seconds = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+  usage.context_switches = ru.ru_nvcsw + ru.ru_nivcsw;
+#endif
+  return usage;
+}
+
+double Percentile(std::vector<double> &values, double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(p * static_cast<double>(values.size() - 1))];
+}
+
+void RunOnce(int player_count, bool use_pool, int duration_ms) {
+  Counters counters;
+  std::vector<std::shared_ptr<SimulatedPlayer>> players;
+  for (int i = 0; i < player_count; ++i) {
+    players.emplace_back(std::make_shared<SimulatedPlayer>(use_pool, &counters));
+  }
+
+  auto begin_usage = GetResourceUsage();
+  for (auto &player : players) {
+    player->Start();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  auto end_usage = GetResourceUsage();
+  int64 tasks = counters.tasks;
+  std::vector<double> lateness;
+  {
+    std::lock_guard<std::mutex> lock(counters.mutex);
+    lateness = counters.render_lateness_us;
+  }
+  for (auto &player : players) {
+    player->Stop();
+  }
+
+  int threads = use_pool ? ThreadPool::GetDefault()->worker_count() + 1 : player_count * 5;
+  double seconds = duration_ms / 1000.0;
+  printf("%-9s players %3d  threads %4d  tasks/s %9.0f  render late us p50 %8.1f p99 %9.1f  "
+         "cpu %6.2fs  ctx switches/s %9.0f\n",
+         use_pool ? "pool" : "dedicated", player_count, threads, tasks / seconds,
+         Percentile(lateness, 0.5), Percentile(lateness, 0.99),
+         end_usage.cpu_seconds - begin_usage.cpu_seconds,
+         (end_usage.context_switches - begin_usage.context_switches) / seconds);
+
+  players.clear();
+  // Let loopers of stopped players wind down before the next round.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int duration_ms = argc > 1 ? atoi(argv[1]) : 3000;
+  for (int players : {1, 8, 32, 64}) {
+    RunOnce(players, false, duration_ms);
+    RunOnce(players, true, duration_ms);
+  }
+  return 0;
+}
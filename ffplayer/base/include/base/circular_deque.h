@@ -5,6 +5,7 @@
 #ifndef MEDIA_BASE_CIRCULAR_DEQUE_H_
 #define MEDIA_BASE_CIRCULAR_DEQUE_H_
 
+#include "utility"
 #include "vector"
 
 #include "base/logging.h"
@@ -27,7 +28,7 @@ class CircularDeque {
   bool InsertFront(T value) {
     if (full_) return false;
     front_ = (front_ - 1 + capacity_) % capacity_;
-    deque_[front_] = value;
+    deque_[front_] = std::move(value);
     empty_ = false;
     if (front_ == behind_) full_ = true;
     return true;
@@ -35,7 +36,7 @@ class CircularDeque {
 
   bool InsertLast(T value) {
     if (full_) return false;
-    deque_[behind_] = value;
+    deque_[behind_] = std::move(value);
     behind_ = (behind_ + 1) % capacity_;
     empty_ = false;
     if (behind_ == front_) full_ = true;
@@ -52,9 +53,10 @@ class CircularDeque {
 
   T PopFront() {
     DCHECK(!empty_);
-    auto item = deque_[front_];
+    // Move out, so that the slot does not keep the item alive.
+    auto item = std::move(deque_[front_]);
     DeleteFront();
-    return std::move(item);
+    return item;
   }
 
   bool DeleteLast() {
@@ -97,11 +99,14 @@ class CircularDeque {
   int GetSize() const {
     if (empty_) return 0;
     if (full_) return capacity_;
-    return abs(behind_ - front_);
+    return (behind_ - front_ + capacity_) % capacity_;
   }
 
   void Clear() {
     if (empty_) return;
+    for (auto &item : deque_) {
+      item = T();
+    }
     full_ = false;
     empty_ = true;
     front_ = behind_ = 0;
@@ -0,0 +1,81 @@
+//
+// Created by yangbin on 2021/8/1.
+//
+
+#ifndef MEDIA_BASE_HISTOGRAM_H_
+#define MEDIA_BASE_HISTOGRAM_H_
+
+#include <atomic>
+
+#include "base/basictypes.h"
+
+namespace media {
+
+/**
+ * Lock-free histogram of non-negative integer samples, e.g. microseconds, in
+ * the manner of HdrHistogram: values below 32 have a bucket each, above that
+ * every power of two is split into 16 buckets, so a recorded value is off by
+ * less than 1 / 16 of itself. Values from 2^40 on are counted as 2^40 - 1.
+ *
+ * [Record] neither locks nor allocates, it is safe to call on a real-time
+ * thread. [GetSnapshot] may run concurrently with it, the snapshot is then
+ * off by the samples recorded meanwhile.
+ */
+class Histogram {
+
+ public:
+
+  struct Snapshot {
+    int64 count = 0;
+    int64 min = 0;
+    int64 max = 0;
+    double mean = 0;
+    int64 p50 = 0;
+    int64 p90 = 0;
+    int64 p99 = 0;
+  };
+
+  Histogram();
+
+  void Record(int64 value);
+
+  Snapshot GetSnapshot() const;
+
+  /**
+   * The highest value which is counted in the same bucket as samples at
+   * |percentile|, in [0, 100]. 0 if nothing was recorded.
+   */
+  int64 ValueAtPercentile(double percentile) const;
+
+  int64 count() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  void Reset();
+
+ private:
+
+  static const int kSubBucketBits = 5;
+  static const int kSubBucketCount = 1 << kSubBucketBits;
+  static const int kSubBucketHalfCount = kSubBucketCount / 2;
+  static const int kMaxValueBits = 40;
+  static const int kBucketCount = kSubBucketCount + (kMaxValueBits - kSubBucketBits) * kSubBucketHalfCount;
+
+  std::atomic<int64> buckets_[kBucketCount];
+  std::atomic<int64> count_;
+  std::atomic<int64> sum_;
+  std::atomic<int64> min_;
+  std::atomic<int64> max_;
+
+  static int BucketIndex(int64 value);
+
+  // The highest value counted in bucket |index|.
+  static int64 BucketHighestValue(int index);
+
+  DELETE_COPY_AND_ASSIGN(Histogram);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_BASE_HISTOGRAM_H_
@@ -5,7 +5,7 @@
 #ifndef MEDIA_BASE_MESSAGE_H_
 #define MEDIA_BASE_MESSAGE_H_
 
-#include <queue>
+#include <atomic>
 #include <functional>
 
 #include "base/time_delta.h"
@@ -28,9 +28,13 @@ struct Message {
           TaskRunner *task_runner,
           int task_id);
 
+  Message(const Message &other);
+
   ~Message();
 
-  // Used to support sorting.
+  // Used to support sorting. A message is "less" than |other| when it should
+  // run after |other|, so that a max-heap built with this operator keeps the
+  // earliest message on top.
   bool operator<(const Message &other) const;
 
   // The task to run
@@ -43,12 +47,27 @@ struct Message {
   TimeTicks when;
 
  private:
-  Message *next = nullptr;
-  TaskRunner* task_runner_;
+
+  // Only used by MessageQueue for the stub node of the immediate queue and
+  // for pooled nodes.
+  Message();
+
+  // Intrusive link. Used by the lock-free immediate queue and the ready list of
+  // MessageQueue. Must be nullptr when the message is handed to a looper.
+  std::atomic<Message *> next;
+
+  TaskRunner *task_runner_;
   int task_id_;
 
+  // Set by TaskRunner::PostTaskIfNotPending, cleared by MessageQueue once the
+  // message leaves the queue.
+  std::atomic_bool *pending_flag_;
+
+  Message &operator=(const Message &other) = delete;
+
   friend class MessageQueue;
   friend class MessageLooper;
+  friend class ::media::TaskRunner;
 
 };
 
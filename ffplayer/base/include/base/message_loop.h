@@ -12,6 +12,9 @@
 
 #include "location.h"
 #include "message_queue.h"
+#include "task_stats.h"
+#include "thread_pool.h"
+#include "time_ticks.h"
 
 namespace media {
 namespace base {
@@ -32,6 +35,23 @@ class MessageLooper : public std::enable_shared_from_this<MessageLooper> {
       int message_handle_expect_duration_ = std::numeric_limits<int>::max()
   );
 
+  /**
+   * Create a sequenced MessageLoop, which does not own a thread. Its tasks run
+   * in order on the workers of |thread_pool|, one at a time.
+   *
+   * Tasks must not block, e.g. on I/O: a blocked task holds a worker shared
+   * with every other sequenced looper. Use |PrepareLooper| for such work.
+   *
+   * @param loop_name the name of [MessageLoop]
+   * @param thread_pool the pool to run tasks, ThreadPool::GetDefault() if null.
+   * @return created MessageLoop.
+   */
+  static std::shared_ptr<MessageLooper> PrepareSequencedLooper(
+      const char *loop_name,
+      int message_handle_expect_duration_ = std::numeric_limits<int>::max(),
+      ThreadPool *thread_pool = nullptr
+  );
+
   static std::shared_ptr<MessageLooper> Create(
       const char *loop_name,
       int message_handle_expect_duration_ = std::numeric_limits<int>::max()
@@ -59,6 +79,20 @@ class MessageLooper : public std::enable_shared_from_this<MessageLooper> {
 
   void Loop();
 
+  MessageQueue::Stats GetQueueStats() const {
+    return message_queue_->GetStats();
+  }
+
+  /**
+   * Queueing delay and run time of the tasks run so far, and the |top_n|
+   * posting locations which spent the most run time.
+   */
+  TaskStats GetTaskStats(int top_n = 0) const;
+
+  void ResetTaskStats() {
+    task_stats_.Reset();
+  }
+
  private:
 
   explicit MessageLooper(
@@ -67,6 +101,7 @@ class MessageLooper : public std::enable_shared_from_this<MessageLooper> {
   );
 
   friend class ::media::TaskRunner;
+  friend class ThreadPool;
 
   bool prepared_ = false;
 
@@ -78,6 +113,26 @@ class MessageLooper : public std::enable_shared_from_this<MessageLooper> {
 
   int message_handle_expect_duration_;
 
+  // Not null for a sequenced looper.
+  ThreadPool *thread_pool_ = nullptr;
+
+  // Whether a batch of this looper is queued or running in |thread_pool_|.
+  std::atomic_bool scheduled_;
+
+  // Pending timer in |thread_pool_|, guarded by the timer lock of the pool.
+  bool has_timer_ = false;
+  TimeTicks timer_deadline_;
+
+  TaskStatsRecorder task_stats_;
+
+  void RunMessage(Message *msg);
+
+  // Queue a batch to |thread_pool_| unless one is already queued or running.
+  void ScheduleSequencedBatch();
+
+  // Run ready messages on a worker of |thread_pool_|.
+  void RunSequencedBatch();
+
   DELETE_COPY_AND_ASSIGN(MessageLooper);
 
   static thread_local std::weak_ptr<MessageLooper> thread_local_message_loop_;
@@ -5,8 +5,10 @@
 #ifndef MEDIA_BASE_MESSAGE_QUEUE_H_
 #define MEDIA_BASE_MESSAGE_QUEUE_H_
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #include "basictypes.h"
 #include "message.h"
@@ -14,43 +16,163 @@
 namespace media {
 namespace base {
 
+/**
+ * Message queue of a MessageLooper.
+ *
+ * Messages without delay are pushed to a lock-free multi-producer single-consumer
+ * FIFO, so posting from any thread never walks the queue or blocks on the consumer.
+ * Delayed messages are kept in a binary heap ordered by (when, sequence_num).
+ * Message nodes are recycled to avoid one heap allocation per post: recycled
+ * nodes go to a process-wide lock-free stack, which a posting thread takes as a
+ * whole into its own cache when that cache runs dry. See |ObtainMessage()|.
+ *
+ * Only one thread at a time may consume messages, by |next()| or |TryNext()|.
+ */
 class MessageQueue {
 
  public:
 
+  struct Stats {
+    // Count of messages accepted by the queue.
+    int64 enqueued_count = 0;
+    // Count of posts dropped because an identical task was already pending.
+    // See TaskRunner::PostTaskIfNotPending.
+    int64 coalesced_count = 0;
+    // Count of messages waiting in the queue.
+    int pending_count = 0;
+    // The max |pending_count| since the queue was created.
+    int max_pending_count = 0;
+  };
+
   MessageQueue();
 
   virtual ~MessageQueue();
 
   bool EnqueueMessage(const Message &message);
 
+  bool EnqueueMessage(Message &&message);
+
   void RemoveTask(TaskRunner *task_runner);
 
   void RemoveTask(TaskRunner *task_runner, int task_id);
 
+  /**
+   * Block until next message is ready to run.
+   *
+   * @return the message to run, or nullptr if the queue has quit. Caller should
+   * give the message back by |Recycle| after it has been handled.
+   */
   Message *next();
 
+  /**
+   * Non-blocking version of |next()|.
+   *
+   * @param next_delay set to the delay until the next delayed message is due,
+   * or TimeDelta::Max() if there is none, when nullptr is returned.
+   * @return the message to run, or nullptr if no message is ready.
+   */
+  Message *TryNext(TimeDelta *next_delay);
+
+  /**
+   * @return zero if a message is ready to run, TimeDelta::Max() if the queue is
+   * empty, or the delay until the next delayed message is due.
+   */
+  TimeDelta NextDelay();
+
+  /**
+   * Replace the built-in condition variable wakeup. |wake_up_handler| is called
+   * (on the posting thread) when a message becomes ready while the consumer is
+   * idle after |TryNext()| or |NextDelay()|. Used to drive the queue by a thread
+   * pool instead of a dedicated thread.
+   *
+   * Must be called before any message is enqueued.
+   */
+  void SetWakeUpHandler(std::function<void()> wake_up_handler);
+
+  /**
+   * Give back a message obtained from |next()| to the pool.
+   */
+  void Recycle(Message *message);
+
   void Quit();
+
+  Stats GetStats() const;
+
+  void RecordCoalescedTask();
+
  private:
 
-  Message *messages_ = nullptr;
+  // Stub node of the immediate queue, never handed out.
+  Message stub_;
+
+  // Producers push to |incoming_head_|, the consumer pops from |incoming_tail_|.
+  std::atomic<Message *> incoming_head_;
+  Message *incoming_tail_;
 
-  std::recursive_mutex message_queue_lock_;
+  // Guards the consumer side of the immediate queue, |ready_head_| and
+  // |delayed_messages_|. Producers of immediate messages never take it.
+  std::mutex message_queue_lock_;
 
-  std::condition_variable_any message_wait_condition_;
+  // Immediate messages moved out of the lock-free queue, in FIFO order.
+  Message *ready_head_ = nullptr;
+  Message *ready_tail_ = nullptr;
+
+  // Binary heap of delayed messages, earliest on top.
+  std::vector<Message *> delayed_messages_;
+
+  std::condition_variable message_wait_condition_;
   std::mutex message_wait_lock_;
+  bool wake_pending_ = false;
 
-  bool quitting_ = false;
+  std::function<void()> wake_up_handler_;
 
-  bool blocked_ = false;
+  std::atomic_bool quitting_;
 
-  void Wake();
+  std::atomic_bool blocked_;
+
+  std::atomic_int next_sequence_num_;
+
+  std::atomic<int64> enqueued_count_;
+  std::atomic<int64> coalesced_count_;
+  std::atomic_int pending_count_;
+  std::atomic_int max_pending_count_;
+
+  // Recycled messages owned by one thread, see |ObtainMessage()|.
+  struct MessageCache {
+    Message *head = nullptr;
 
-  void PollOnce(TimeDelta wait_duration);
+    ~MessageCache();
+  };
+
+  static thread_local MessageCache message_cache_;
+
+  static Message *ObtainMessage();
+
+  bool EnqueueMessageInternal(Message *msg);
+
+  // Called when |msg| leaves the queue, either to run or to be dropped.
+  void OnMessageDequeued(Message *msg);
+
+  void PushIncoming(Message *msg);
+
+  Message *PopIncomingLocked();
+
+  // Move all available messages of the lock-free queue to the ready list.
+  void DrainIncomingLocked();
+
+  // Take the message which should run now, or set |next_delay|.
+  Message *TakeReadyMessageLocked(TimeDelta *next_delay);
+
+  // Unlink all messages matching |predicate|, returns them chained by |next|.
+  template<typename Predicate>
+  Message *RemoveMessagesLocked(Predicate predicate);
+
+  void RecycleAll(Message *messages);
+
+  void Wake();
 
   DELETE_COPY_AND_ASSIGN(MessageQueue);
 
-  void RemoveAllMessageLocked();
 };
 
 } // namespace base
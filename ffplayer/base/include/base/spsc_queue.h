@@ -0,0 +1,144 @@
+//
+// Created by yangbin on 2021/7/20.
+//
+
+#ifndef MEDIA_BASE_SPSC_QUEUE_H_
+#define MEDIA_BASE_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/logging.h"
+
+namespace media {
+
+/**
+ * Bounded wait-free queue for exactly one producer thread and one consumer
+ * thread. No lock and no allocation after construction, safe to use on a
+ * real-time thread.
+ *
+ * [Push] must only be called by the producer. [Front] and [Pop] must only be
+ * called by the consumer.
+ */
+template<typename T>
+class SpscQueue {
+
+ public:
+
+  /**
+   * @param capacity rounded up to a power of two.
+   */
+  explicit SpscQueue(size_t capacity) : head_(0), tail_(0), cached_head_(0), cached_tail_(0) {
+    DCHECK_GT(capacity, 0u);
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  /**
+   * Producer only.
+   * @return false if the queue is full, |value| is left untouched.
+   */
+  bool Push(T &&value) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == slots_.size()) {
+        return false;
+      }
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool Push(const T &value) {
+    T copy(value);
+    return Push(std::move(copy));
+  }
+
+  /**
+   * Consumer only.
+   * @return the oldest item, or nullptr if the queue is empty.
+   */
+  T *Front() {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return nullptr;
+      }
+    }
+    return &slots_[head & mask_];
+  }
+
+  /**
+   * Consumer only. Remove the item returned by [Front], the slot is reset so it
+   * does not keep the item alive.
+   */
+  void Pop() {
+    auto head = head_.load(std::memory_order_relaxed);
+    DCHECK_NE(head, tail_.load(std::memory_order_acquire));
+    slots_[head & mask_] = T();
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * Count of items ever pushed. Exact on the producer thread.
+   */
+  uint64_t pushed_count() const {
+    return tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Count of items ever popped. Exact on the consumer thread.
+   */
+  uint64_t popped_count() const {
+    return head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Approximate when called from other threads than producer and consumer.
+   */
+  size_t size() const {
+    // Load the head first, the tail can only be ahead of it.
+    auto head = popped_count();
+    return static_cast<size_t>(pushed_count() - head);
+  }
+
+  size_t capacity() const {
+    return slots_.size();
+  }
+
+ private:
+
+  std::vector<T> slots_;
+  size_t mask_;
+
+  // Written by the consumer.
+  std::atomic<uint64_t> head_;
+  char head_padding_[64 - sizeof(std::atomic<uint64_t>)];
+
+  // Written by the producer.
+  std::atomic<uint64_t> tail_;
+  char tail_padding_[64 - sizeof(std::atomic<uint64_t>)];
+
+  // Last |head_| seen by the producer, saves touching the consumer's cache line.
+  uint64_t cached_head_;
+  char cached_head_padding_[64 - sizeof(uint64_t)];
+
+  // Last |tail_| seen by the consumer.
+  uint64_t cached_tail_;
+
+  DELETE_COPY_AND_ASSIGN(SpscQueue);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_BASE_SPSC_QUEUE_H_
@@ -41,14 +41,49 @@ class TaskRunner {
                        int task_id,
                        const TaskClosure &task_closure);
 
+  /**
+   * Post |task| unless a task with the same |task_id| posted by this method is
+   * still waiting in the queue. The pending state is cleared right before the
+   * task runs, so a post made while the task is running is not dropped.
+   *
+   * A coalesced post neither locks nor allocates, it is safe to call on a
+   * real-time thread.
+   *
+   * @param task_id should not be 0, also used by |RemoveTask(task_id)|. At
+   * most kMaxPendingTaskIds distinct ids per runner.
+   * @return false if the task was coalesced with the pending one.
+   */
+  bool PostTaskIfNotPending(const tracked_objects::Location &from_here, int task_id, const TaskClosure &task);
+
   void RemoveTask(int task_id);
 
   void RemoveAllTasks();
 
   bool BelongsToCurrentThread();
 
+  /**
+   * Stats of the queue of the looper, shared by all runners of the looper.
+   * Empty stats for a runner without looper.
+   */
+  MessageQueue::Stats GetQueueStats() const;
+
+  /**
+   * See MessageLooper::GetTaskStats. Empty stats for a runner without looper.
+   */
+  TaskStats GetTaskStats(int top_n = 0) const;
+
   void Reset();
 
+  /**
+   * Only copies the looper of |object|, tasks already posted keep running on
+   * the previous looper.
+   *
+   * A task posted by |PostTaskIfNotPending| must not be pending on the previous
+   * looper: its pending flag lives in this runner. All the callers assign to an
+   * empty runner or to one which was |Reset()|.
+   */
+  TaskRunner &operator=(const TaskRunner &object);
+
   TaskRunner &operator=(nullptr_t);
 
   explicit operator bool() const {
@@ -57,7 +92,20 @@ class TaskRunner {
 
  private:
 
+  // Max count of distinct task ids can be used with |PostTaskIfNotPending|.
+  static const int kMaxPendingTaskIds = 8;
+
+  struct PendingTask {
+    std::atomic_int task_id{0};
+    std::atomic_bool pending{false};
+  };
+
   std::shared_ptr<MessageLooper> looper_;
+
+  // Not copied with the runner, pending tasks belong to the runner which posted them.
+  PendingTask pending_tasks_[kMaxPendingTaskIds];
+
+  std::atomic_bool *FindPendingFlag(int task_id);
 };
 
 }
@@ -0,0 +1,100 @@
+//
+// Created by yangbin on 2021/8/3.
+//
+
+#ifndef MEDIA_BASE_TASK_STATS_H_
+#define MEDIA_BASE_TASK_STATS_H_
+
+#include <atomic>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/histogram.h"
+#include "base/location.h"
+#include "base/message_queue.h"
+
+namespace media {
+
+/**
+ * Tasks posted from one location.
+ */
+struct LocationTaskStats {
+  tracked_objects::Location location;
+  int64 count = 0;
+  int64 total_run_time_us = 0;
+  int64 max_run_time_us = 0;
+  int64 max_queue_delay_us = 0;
+};
+
+struct TaskStats {
+  base::MessageQueue::Stats queue;
+  // From the time a task is due to the time it starts running.
+  Histogram::Snapshot queue_delay_us;
+  Histogram::Snapshot run_time_us;
+  // The locations which spent the most run time, most first.
+  std::vector<LocationTaskStats> slowest_locations;
+};
+
+/**
+ * Accounts the queueing delay and the run time of the tasks of a looper.
+ *
+ * [Record] neither locks nor allocates. Locations are kept in a fixed open
+ * addressing table, the tasks of locations which do not fit are only counted
+ * in the histograms.
+ */
+class TaskStatsRecorder {
+
+ public:
+
+  static const int kMaxLocations = 256;
+
+  TaskStatsRecorder() = default;
+
+  /**
+   * Called by the looper after each task, from one thread at a time.
+   */
+  void Record(const tracked_objects::Location &posted_from, int64 queue_delay_us, int64 run_time_us);
+
+  /**
+   * Fill all but |TaskStats::queue| of |stats|, keep the |top_n| locations
+   * which spent the most run time.
+   */
+  void GetStats(int top_n, TaskStats *stats) const;
+
+  /**
+   * Zero the stats. The locations seen so far keep their slots.
+   */
+  void Reset();
+
+ private:
+
+  // Claimed by the recording thread, which sets |used| once the location is
+  // written, and read by any thread after that.
+  struct LocationSlot {
+    std::atomic<bool> used{false};
+    std::atomic<const char *> function_name{nullptr};
+    std::atomic<const char *> file_name{nullptr};
+    std::atomic<int> line_number{0};
+    std::atomic<const void *> program_counter{nullptr};
+
+    std::atomic<int64> count{0};
+    std::atomic<int64> total_run_time_us{0};
+    std::atomic<int64> max_run_time_us{0};
+    std::atomic<int64> max_queue_delay_us{0};
+  };
+
+  Histogram queue_delay_us_;
+  Histogram run_time_us_;
+
+  LocationSlot locations_[kMaxLocations];
+
+  // The slot of |location|, claimed if it is new. Null if the table is full.
+  LocationSlot *FindOrClaimSlot(const tracked_objects::Location &location);
+
+  DELETE_COPY_AND_ASSIGN(TaskStatsRecorder);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_BASE_TASK_STATS_H_
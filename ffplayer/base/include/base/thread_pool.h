@@ -0,0 +1,115 @@
+//
+// Created by yangbin on 2021/7/17.
+//
+
+#ifndef MEDIA_BASE_THREAD_POOL_H_
+#define MEDIA_BASE_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/time_delta.h"
+#include "base/time_ticks.h"
+
+namespace media {
+namespace base {
+
+class MessageLooper;
+
+/**
+ * Process-wide scheduler of sequenced MessageLoopers.
+ *
+ * A sequenced looper has no thread of its own. When it has ready messages it
+ * is scheduled to one of the workers, which runs a batch of its messages in
+ * order. A looper is never scheduled twice at the same time, so the tasks of
+ * one looper keep running sequentially.
+ *
+ * Each worker has its own run queue. Loopers scheduled from a worker go to the
+ * queue of that worker, an idle worker steals from the others.
+ */
+class ThreadPool {
+
+ public:
+
+  /**
+   * The pool shared by the whole process, created on first use with a worker
+   * per core (at least 4). Never destroyed.
+   */
+  static ThreadPool *GetDefault();
+
+  explicit ThreadPool(int worker_count, const char *name = "media_worker");
+
+  ~ThreadPool();
+
+  /**
+   * Run a batch of |looper| on a worker as soon as possible.
+   */
+  void Schedule(const std::weak_ptr<MessageLooper> &looper);
+
+  /**
+   * Run a batch of |looper| on a worker after |delay|.
+   */
+  void ScheduleDelayed(const std::shared_ptr<MessageLooper> &looper, TimeDelta delay);
+
+  int worker_count() const { return static_cast<int>(workers_.size()); }
+
+ private:
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::weak_ptr<MessageLooper>> run_queue;
+    std::unique_ptr<std::thread> thread;
+  };
+
+  struct Timer {
+    TimeTicks when;
+    std::weak_ptr<MessageLooper> looper;
+
+    // Used by std::push_heap to keep the earliest timer on top.
+    bool operator<(const Timer &other) const {
+      return when > other.when;
+    }
+  };
+
+  const char *name_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Round robin index for loopers scheduled out of the pool.
+  std::atomic_uint next_worker_;
+
+  // Count of loopers waiting in all run queues.
+  std::atomic_int pending_count_;
+
+  std::atomic_int idle_worker_count_;
+
+  std::mutex idle_mutex_;
+  std::condition_variable idle_condition_;
+
+  std::mutex timer_mutex_;
+  std::condition_variable timer_condition_;
+  std::vector<Timer> timers_;
+  std::unique_ptr<std::thread> timer_thread_;
+
+  std::atomic_bool quitting_;
+
+  void WorkerMain(int index);
+
+  void TimerMain();
+
+  std::shared_ptr<MessageLooper> TakeWork(int index);
+
+  DELETE_COPY_AND_ASSIGN(ThreadPool);
+
+};
+
+} // namespace base
+} // namespace media
+
+#endif //MEDIA_BASE_THREAD_POOL_H_
@@ -0,0 +1,176 @@
+//
+// Created by yangbin on 2021/8/2.
+//
+
+#ifndef MEDIA_BASE_TRACE_EVENT_H_
+#define MEDIA_BASE_TRACE_EVENT_H_
+
+#include <atomic>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/location.h"
+
+namespace media {
+
+struct TraceEvent {
+  // 'B' begin, 'E' end, 'C' counter, as in the Chrome trace event format.
+  char phase = 0;
+  const char *category = nullptr;
+  const char *name = nullptr;
+  const char *file_name = nullptr;
+  int line_number = 0;
+  int64 timestamp_us = 0;
+  // Null if the event has no argument. The value of a counter otherwise.
+  const char *arg_name = nullptr;
+  int64 arg_value = 0;
+};
+
+/**
+ * Records trace events of all threads, to be dumped as Chrome trace event
+ * JSON and opened in chrome://tracing or Perfetto.
+ *
+ * Each thread appends to its own ring buffer, which keeps the newest events
+ * only. Recording takes no lock and does not allocate, except once per thread
+ * for its buffer. The buffers of the latest exited threads are kept for
+ * dumping, older ones are freed. While disabled, a trace macro costs a relaxed
+ * load and a branch.
+ *
+ * Strings of an event are not copied, they must be long-lived, such as
+ * literals or the names of a [tracked_objects::Location].
+ */
+class TraceLog {
+
+ public:
+
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static void SetEnabled(bool enabled);
+
+  /**
+   * Drop the events recorded so far.
+   */
+  static void Clear();
+
+  /**
+   * Events kept per thread, for buffers created after this call.
+   */
+  static void SetBufferCapacity(int capacity);
+
+  /**
+   * Name the current thread in the dumped trace. Called by
+   * [utility::update_thread_name].
+   */
+  static void SetCurrentThreadName(const char *name);
+
+  static void AddEvent(char phase,
+                       const char *category,
+                       const char *name,
+                       const tracked_objects::Location &location,
+                       const char *arg_name = nullptr,
+                       int64 arg_value = 0);
+
+  static void AddCounter(const char *category, const char *name, int64 value);
+
+  static std::string DumpJson();
+
+  /**
+   * Buffers of live threads and of the exited threads which are kept.
+   */
+  static size_t buffer_count_for_testing();
+
+  /**
+   * @return false if |path| could not be written.
+   */
+  static bool DumpToFile(const char *path);
+
+ private:
+
+  static std::atomic_bool enabled_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(TraceLog);
+
+};
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TRACE_EVENT_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define TRACE_EVENT_UNLIKELY(x) (x)
+#endif
+
+/**
+ * Records a begin event on construction and the matching end event on
+ * destruction, if tracing was enabled on construction.
+ */
+class ScopedTraceEvent {
+
+ public:
+
+  ScopedTraceEvent(const char *category, const char *name,
+                   const char *function_name, const char *file_name, int line_number)
+      : category_(category), name_(name), function_name_(function_name), file_name_(file_name),
+        line_number_(line_number), enabled_(TraceLog::IsEnabled()) {
+    if (TRACE_EVENT_UNLIKELY(enabled_)) {
+      Begin(nullptr, 0);
+    }
+  }
+
+  ScopedTraceEvent(const char *category, const tracked_objects::Location &location,
+                   const char *arg_name = nullptr, int64 arg_value = 0)
+      : category_(category), name_(location.function_name()), function_name_(location.function_name()),
+        file_name_(location.file_name()), line_number_(location.line_number()),
+        enabled_(TraceLog::IsEnabled()) {
+    if (TRACE_EVENT_UNLIKELY(enabled_)) {
+      Begin(arg_name, arg_value);
+    }
+  }
+
+  ~ScopedTraceEvent() {
+    if (TRACE_EVENT_UNLIKELY(enabled_)) {
+      End();
+    }
+  }
+
+ private:
+  const char *category_;
+  const char *name_;
+  const char *function_name_;
+  const char *file_name_;
+  int line_number_;
+  bool enabled_;
+
+  void Begin(const char *arg_name, int64 arg_value);
+
+  void End();
+
+  DELETE_COPY_AND_ASSIGN(ScopedTraceEvent);
+
+};
+
+#define TRACE_EVENT_UID_CONCAT_(a, b) a##b
+#define TRACE_EVENT_UID_(a, b) TRACE_EVENT_UID_CONCAT_(a, b)
+
+/**
+ * Trace the rest of the enclosing scope as |name| in |category|.
+ */
+#define TRACE_EVENT(category, name) \
+  ::media::ScopedTraceEvent TRACE_EVENT_UID_(_trace_event_, __LINE__)(category, name, __FUNCTION__, __FILE__, __LINE__)
+
+/**
+ * Trace the rest of the enclosing scope as the function of |location|.
+ */
+#define TRACE_EVENT_WITH_LOCATION(category, location) \
+  ::media::ScopedTraceEvent TRACE_EVENT_UID_(_trace_event_, __LINE__)(category, location)
+
+#define TRACE_COUNTER(category, name, value)                        \
+  do {                                                              \
+    if (TRACE_EVENT_UNLIKELY(::media::TraceLog::IsEnabled())) {     \
+      ::media::TraceLog::AddCounter(category, name, value);         \
+    }                                                               \
+  } while (0)
+
+} // namespace media
+
+#endif //MEDIA_BASE_TRACE_EVENT_H_
@@ -0,0 +1,111 @@
+//
+// Created by yangbin on 2021/8/1.
+//
+
+#include "base/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace media {
+
+namespace {
+
+int HighestBit(uint64_t value) {
+  int bit = 0;
+  while (value >>= 1) {
+    bit++;
+  }
+  return bit;
+}
+
+} // namespace
+
+Histogram::Histogram() {
+  Reset();
+}
+
+void Histogram::Reset() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  min_.store(std::numeric_limits<int64>::max(), std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+// static
+int Histogram::BucketIndex(int64 value) {
+  if (value < kSubBucketCount) {
+    return static_cast<int>(value);
+  }
+  auto shift = HighestBit(static_cast<uint64_t>(value)) - (kSubBucketBits - 1);
+  auto sub_bucket = static_cast<int>(value >> shift);
+  return kSubBucketCount + (shift - 1) * kSubBucketHalfCount + (sub_bucket - kSubBucketHalfCount);
+}
+
+// static
+int64 Histogram::BucketHighestValue(int index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+  auto offset = index - kSubBucketCount;
+  auto shift = offset / kSubBucketHalfCount + 1;
+  auto sub_bucket = int64(offset % kSubBucketHalfCount + kSubBucketHalfCount);
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+void Histogram::Record(int64 value) {
+  value = std::min(std::max<int64>(value, 0), (int64(1) << kMaxValueBits) - 1);
+  buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+
+  auto min = min_.load(std::memory_order_relaxed);
+  while (value < min && !min_.compare_exchange_weak(min, value, std::memory_order_relaxed)) {
+  }
+  auto max = max_.load(std::memory_order_relaxed);
+  while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+int64 Histogram::ValueAtPercentile(double percentile) const {
+  int64 total = 0;
+  int64 counts[kBucketCount];
+  for (int i = 0; i < kBucketCount; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  auto rank = std::max<int64>(static_cast<int64>(std::ceil(percentile / 100 * double(total))), 1);
+  int64 seen = 0;
+  for (int i = 0; i < kBucketCount; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return std::min(BucketHighestValue(i), max_.load(std::memory_order_relaxed));
+    }
+  }
+  return max_.load(std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::GetSnapshot() const {
+  Snapshot snapshot;
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  if (snapshot.count == 0) {
+    return snapshot;
+  }
+  snapshot.min = min_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  snapshot.mean = double(sum_.load(std::memory_order_relaxed)) / double(snapshot.count);
+  snapshot.p50 = ValueAtPercentile(50);
+  snapshot.p90 = ValueAtPercentile(90);
+  snapshot.p99 = ValueAtPercentile(99);
+  return snapshot;
+}
+
+} // namespace media
@@ -16,16 +16,41 @@ Message::Message(TaskClosure task,
                  int task_id)
     : task(std::move(task)),
       posted_from(posted_from),
-      when(TimeTicks::Now() + delay),
       sequence_num(0),
+      when(TimeTicks::Now() + delay),
+      next(nullptr),
       task_runner_(task_runner),
-      task_id_(task_id) {
+      task_id_(task_id),
+      pending_flag_(nullptr) {
+
+}
+
+Message::Message(const Message &other)
+    : task(other.task),
+      posted_from(other.posted_from),
+      sequence_num(other.sequence_num),
+      when(other.when),
+      next(nullptr),
+      task_runner_(other.task_runner_),
+      task_id_(other.task_id_),
+      pending_flag_(other.pending_flag_) {
+
+}
+
+Message::Message()
+    : sequence_num(0),
+      when(TimeTicks::Now()),
+      next(nullptr),
+      task_runner_(nullptr),
+      task_id_(0),
+      pending_flag_(nullptr) {
 
 }
 
 bool Message::operator<(const Message &other) const {
-  if (when > other.when)
-    return true;
+  if (when != other.when) {
+    return when > other.when;
+  }
 
   // If the times happen to match, then we use the sequence number to decide.
   // Compare the difference to support integer roll-over.
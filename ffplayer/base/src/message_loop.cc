@@ -4,23 +4,31 @@
 
 #include "base/logging.h"
 #include "base/message_loop.h"
+#include "base/trace_event.h"
 #include "base/utility.h"
 
 namespace media {
 
 namespace base {
 
+// Max count of messages a sequenced looper runs before yielding its worker.
+static const int kMaxMessagesPerBatch = 16;
+
 thread_local std::weak_ptr<MessageLooper> MessageLooper::thread_local_message_loop_;
 
 MessageLooper::MessageLooper(const char *loop_name, int message_handle_timeout_ms)
     : loop_name_(loop_name),
       message_queue_(std::make_unique<MessageQueue>()),
-      message_handle_expect_duration_(message_handle_timeout_ms) {
+      message_handle_expect_duration_(message_handle_timeout_ms),
+      scheduled_(false),
+      timer_deadline_(TimeTicks::Now()) {
 }
 
 MessageLooper::~MessageLooper() {
   message_queue_->Quit();
-  thread_->join();
+  if (thread_) {
+    thread_->join();
+  }
 }
 
 void MessageLooper::Prepare() {
@@ -38,11 +46,61 @@ void MessageLooper::Loop() {
       return;
     }
 
-    DCHECK(msg->next == nullptr);
+    RunMessage(msg);
+  }
+}
 
+void MessageLooper::RunMessage(Message *msg) {
+  DCHECK(msg->next.load(std::memory_order_relaxed) == nullptr);
+  auto start_time = TimeTicks::Now();
+  auto queue_delay_us = (start_time - msg->when).InMicroseconds();
+  {
     TRACE_METHOD_DURATION_WITH_LOCATION(message_handle_expect_duration_, msg->posted_from);
+    ScopedTraceEvent trace_event(loop_name_, msg->posted_from, "queue_delay_us", queue_delay_us);
     msg->task();
-    delete msg;
+  }
+  task_stats_.Record(msg->posted_from, queue_delay_us, (TimeTicks::Now() - start_time).InMicroseconds());
+  message_queue_->Recycle(msg);
+}
+
+TaskStats MessageLooper::GetTaskStats(int top_n) const {
+  TaskStats stats;
+  stats.queue = message_queue_->GetStats();
+  task_stats_.GetStats(top_n, &stats);
+  return stats;
+}
+
+void MessageLooper::ScheduleSequencedBatch() {
+  DCHECK(thread_pool_);
+  if (!scheduled_.exchange(true)) {
+    thread_pool_->Schedule(shared_from_this());
+  }
+}
+
+void MessageLooper::RunSequencedBatch() {
+  DCHECK(thread_pool_);
+  DCHECK(scheduled_);
+
+  auto previous = thread_local_message_loop_;
+  thread_local_message_loop_ = shared_from_this();
+  TimeDelta next_delay;
+  for (int i = 0; i < kMaxMessagesPerBatch; ++i) {
+    Message *msg = message_queue_->TryNext(&next_delay);
+    if (msg == nullptr) {
+      break;
+    }
+    RunMessage(msg);
+  }
+  thread_local_message_loop_ = previous;
+
+  // A message posted after the check above sees |scheduled_| set and does not
+  // schedule us, so check again once the flag is cleared.
+  scheduled_ = false;
+  next_delay = message_queue_->NextDelay();
+  if (next_delay.is_zero()) {
+    ScheduleSequencedBatch();
+  } else if (!next_delay.is_max()) {
+    thread_pool_->ScheduleDelayed(shared_from_this(), next_delay);
   }
 }
 
@@ -53,8 +111,7 @@ void MessageLooper::PostTask(const tracked_objects::Location &from_here, const T
 void MessageLooper::PostDelayedTask(const tracked_objects::Location &from_here,
                                     TimeDelta delay,
                                     const TaskClosure &task_closure) {
-  Message message(task_closure, from_here, delay, nullptr, 0);
-  message_queue_->EnqueueMessage(message);
+  message_queue_->EnqueueMessage(Message(task_closure, from_here, delay, nullptr, 0));
 }
 
 std::shared_ptr<MessageLooper> MessageLooper::Current() {
@@ -75,6 +132,25 @@ std::shared_ptr<MessageLooper> MessageLooper::PrepareLooper(
   return looper;
 }
 
+// static
+std::shared_ptr<MessageLooper> MessageLooper::PrepareSequencedLooper(
+    const char *loop_name,
+    int message_handle_expect_duration_,
+    ThreadPool *thread_pool
+) {
+  auto looper = Create(loop_name, message_handle_expect_duration_);
+  looper->thread_pool_ = thread_pool ? thread_pool : ThreadPool::GetDefault();
+  looper->prepared_ = true;
+  std::weak_ptr<MessageLooper> weak_looper = looper;
+  looper->message_queue_->SetWakeUpHandler([weak_looper]() {
+    auto strong = weak_looper.lock();
+    if (strong) {
+      strong->ScheduleSequencedBatch();
+    }
+  });
+  return looper;
+}
+
 std::shared_ptr<MessageLooper> MessageLooper::Create(const char *loop_name, int message_handle_expect_duration_) {
   std::shared_ptr<MessageLooper> looper(new MessageLooper(loop_name, message_handle_expect_duration_));
   return looper;
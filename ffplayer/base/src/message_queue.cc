@@ -2,191 +2,432 @@
 // Created by boyan on 2021/3/27.
 //
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/message_queue.h"
 
 namespace media {
 namespace base {
 
-MessageQueue::MessageQueue() = default;
+// Approximate max count of recycled messages kept by the process.
+static const int kMaxPooledMessages = 1024;
+
+// Recycled messages, chained by |Message::next|. Only ever pushed one by one or
+// taken as a whole, so a compare-exchange on the head is free of ABA.
+static std::atomic<Message *> free_messages(nullptr);
+static std::atomic_int free_message_count(0);
+
+thread_local MessageQueue::MessageCache MessageQueue::message_cache_;
+
+MessageQueue::MessageCache::~MessageCache() {
+  while (head != nullptr) {
+    Message *n = head->next.load(std::memory_order_relaxed);
+    delete head;
+    head = n;
+  }
+}
+
+static bool CompareMessage(const Message *a, const Message *b) {
+  return *a < *b;
+}
+
+MessageQueue::MessageQueue()
+    : incoming_head_(&stub_),
+      incoming_tail_(&stub_),
+      quitting_(false),
+      blocked_(false),
+      next_sequence_num_(0),
+      enqueued_count_(0),
+      coalesced_count_(0),
+      pending_count_(0),
+      max_pending_count_(0) {
+}
 
 MessageQueue::~MessageQueue() {
   DCHECK(quitting_);
+  Message *removed;
+  {
+    std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+    removed = RemoveMessagesLocked([](const Message *) { return true; });
+  }
+  RecycleAll(removed);
+}
+
+// static
+Message *MessageQueue::ObtainMessage() {
+  auto &cache = message_cache_;
+  if (cache.head == nullptr && free_messages.load(std::memory_order_relaxed) != nullptr) {
+    cache.head = free_messages.exchange(nullptr, std::memory_order_acquire);
+    free_message_count.store(0, std::memory_order_relaxed);
+  }
+  if (cache.head != nullptr) {
+    Message *msg = cache.head;
+    cache.head = msg->next.load(std::memory_order_relaxed);
+    msg->next.store(nullptr, std::memory_order_relaxed);
+    return msg;
+  }
+  return new Message();
+}
+
+void MessageQueue::Recycle(Message *message) {
+  DCHECK(message);
+  DCHECK_NE(message, &stub_);
+  message->task = nullptr;
+  message->pending_flag_ = nullptr;
+  if (free_message_count.fetch_add(1, std::memory_order_relaxed) >= kMaxPooledMessages) {
+    free_message_count.fetch_sub(1, std::memory_order_relaxed);
+    delete message;
+    return;
+  }
+  Message *head = free_messages.load(std::memory_order_relaxed);
+  do {
+    message->next.store(head, std::memory_order_relaxed);
+  } while (!free_messages.compare_exchange_weak(head, message, std::memory_order_release,
+                                                 std::memory_order_relaxed));
 }
 
 bool MessageQueue::EnqueueMessage(const Message &message) {
-  std::unique_lock<std::recursive_mutex> auto_lock(message_queue_lock_);
+  auto *msg = ObtainMessage();
+  msg->task = message.task;
+  msg->posted_from = message.posted_from;
+  msg->when = message.when;
+  msg->task_runner_ = message.task_runner_;
+  msg->task_id_ = message.task_id_;
+  msg->pending_flag_ = message.pending_flag_;
+  return EnqueueMessageInternal(msg);
+}
+
+bool MessageQueue::EnqueueMessage(Message &&message) {
+  auto *msg = ObtainMessage();
+  msg->task = std::move(message.task);
+  msg->posted_from = message.posted_from;
+  msg->when = message.when;
+  msg->task_runner_ = message.task_runner_;
+  msg->task_id_ = message.task_id_;
+  msg->pending_flag_ = message.pending_flag_;
+  return EnqueueMessageInternal(msg);
+}
 
+bool MessageQueue::EnqueueMessageInternal(Message *msg) {
   if (quitting_) {
     DLOG(WARNING) << "sending message on a dead thread";
+    if (msg->pending_flag_) {
+      msg->pending_flag_->store(false);
+    }
+    Recycle(msg);
     return false;
   }
-  auto *msg = new Message(message);
 
-  Message *p = messages_;
-  bool needWake;
+  msg->sequence_num = next_sequence_num_.fetch_add(1, std::memory_order_relaxed);
 
-  if (p == nullptr || msg->when < p->when) {
-    msg->next = p;
-    messages_ = msg;
-    needWake = blocked_;
-  } else {
-    // Inserted withing the middle of the queue, We don't have to wake up the event queue.
-    needWake = false;
-    Message *prev;
-    for (;;) {
-      prev = p;
-      p = p->next;
-      if (p == nullptr || msg->when < p->when) {
-        break;
-      }
+  enqueued_count_.fetch_add(1, std::memory_order_relaxed);
+  int pending = pending_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  int max_pending = max_pending_count_.load(std::memory_order_relaxed);
+  while (pending > max_pending
+      && !max_pending_count_.compare_exchange_weak(max_pending, pending, std::memory_order_relaxed)) {
+  }
+
+  if (msg->when <= TimeTicks::Now()) {
+    PushIncoming(msg);
+    // Pairs with the store in next(): either the consumer observes this message
+    // before it goes to sleep, or we observe it is (about to be) blocked.
+    if (blocked_) {
+      Wake();
     }
-    msg->next = p;
-    prev->next = msg;
+    return true;
   }
 
-  if (needWake) {
+  bool need_wake;
+  {
+    std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+    delayed_messages_.push_back(msg);
+    std::push_heap(delayed_messages_.begin(), delayed_messages_.end(), CompareMessage);
+    // Inserted behind the earliest message, the consumer deadline is unchanged.
+    need_wake = delayed_messages_.front() == msg && blocked_;
+  }
+  if (need_wake) {
     Wake();
   }
   return true;
 }
 
-Message *MessageQueue::next() {
-  if (quitting_) {
+void MessageQueue::PushIncoming(Message *msg) {
+  msg->next.store(nullptr, std::memory_order_relaxed);
+  Message *prev = incoming_head_.exchange(msg);
+  prev->next.store(msg);
+}
+
+Message *MessageQueue::PopIncomingLocked() {
+  Message *tail = incoming_tail_;
+  Message *next = tail->next.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+    incoming_tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    incoming_tail_ = next;
+    tail->next.store(nullptr, std::memory_order_relaxed);
+    return tail;
+  }
+  if (tail != incoming_head_.load(std::memory_order_acquire)) {
+    // A producer is in the middle of a push, it will wake us up once it is done.
     return nullptr;
   }
+  PushIncoming(&stub_);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    incoming_tail_ = next;
+    tail->next.store(nullptr, std::memory_order_relaxed);
+    return tail;
+  }
+  return nullptr;
+}
 
-  TimeDelta next_poll_timeout_mills;
-  for (;;) {
-    PollOnce(next_poll_timeout_mills);
-    {
-      std::lock_guard<std::recursive_mutex> auto_lock(message_queue_lock_);
+void MessageQueue::DrainIncomingLocked() {
+  Message *msg;
+  while ((msg = PopIncomingLocked()) != nullptr) {
+    if (ready_tail_ == nullptr) {
+      ready_head_ = msg;
+    } else {
+      ready_tail_->next.store(msg, std::memory_order_relaxed);
+    }
+    ready_tail_ = msg;
+  }
+}
 
-      auto now = TimeTicks::Now();
+Message *MessageQueue::TakeReadyMessageLocked(TimeDelta *next_delay) {
+  DrainIncomingLocked();
 
-      Message *msg = messages_;
+  Message *delayed = delayed_messages_.empty() ? nullptr : delayed_messages_.front();
+  auto now = TimeTicks::Now();
 
-      if (msg != nullptr) {
-        if (now < msg->when) {
-          next_poll_timeout_mills = msg->when - now;
-        } else {
-          blocked_ = false;
-          messages_ = msg->next;
-          msg->next = nullptr;
-          return msg;
-        }
-      } else {
-        next_poll_timeout_mills = TimeDelta::Max();
-      }
+  if (delayed != nullptr && delayed->when <= now
+      && (ready_head_ == nullptr || *ready_head_ < *delayed)) {
+    std::pop_heap(delayed_messages_.begin(), delayed_messages_.end(), CompareMessage);
+    delayed_messages_.pop_back();
+    OnMessageDequeued(delayed);
+    return delayed;
+  }
+
+  if (ready_head_ != nullptr) {
+    Message *msg = ready_head_;
+    ready_head_ = msg->next.load(std::memory_order_relaxed);
+    if (ready_head_ == nullptr) {
+      ready_tail_ = nullptr;
+    }
+    msg->next.store(nullptr, std::memory_order_relaxed);
+    OnMessageDequeued(msg);
+    return msg;
+  }
+
+  *next_delay = delayed != nullptr ? delayed->when - now : TimeDelta::Max();
+  return nullptr;
+}
+
+Message *MessageQueue::next() {
+  for (;;) {
+    if (quitting_) {
+      return nullptr;
+    }
 
-      if (quitting_) {
-        break;
+    // Announce we are going to sleep before looking at the queues, so a
+    // producer either sees us blocked or we see its message.
+    blocked_ = true;
+
+    TimeDelta wait_duration;
+    {
+      std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+      Message *msg = TakeReadyMessageLocked(&wait_duration);
+      if (msg != nullptr) {
+        blocked_ = false;
+        return msg;
       }
+    }
 
-      blocked_ = true;
-      continue;
+    std::unique_lock<std::mutex> condition_lock(message_wait_lock_);
+    auto wake_up = [this]() { return wake_pending_ || quitting_; };
+    if (!wait_duration.is_max()) {
+      message_wait_condition_.wait_for(condition_lock,
+                                       std::chrono::microseconds(wait_duration.InMicroseconds()),
+                                       wake_up);
+    } else {
+      message_wait_condition_.wait(condition_lock, wake_up);
     }
+    wake_pending_ = false;
+  }
+}
 
+Message *MessageQueue::TryNext(TimeDelta *next_delay) {
+  DCHECK(next_delay);
+  *next_delay = TimeDelta::Max();
+  if (quitting_) {
+    return nullptr;
   }
-  return nullptr;
+  blocked_ = true;
+  std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+  Message *msg = TakeReadyMessageLocked(next_delay);
+  if (msg != nullptr) {
+    blocked_ = false;
+  }
+  return msg;
 }
 
-void MessageQueue::RemoveTask(TaskRunner *task_runner) {
-  if (!task_runner) {
-    return;
+TimeDelta MessageQueue::NextDelay() {
+  if (quitting_) {
+    return TimeDelta::Max();
+  }
+  blocked_ = true;
+  std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+  DrainIncomingLocked();
+  if (ready_head_ != nullptr) {
+    return TimeDelta();
   }
-  std::lock_guard<std::recursive_mutex> auto_lock(message_queue_lock_);
+  if (delayed_messages_.empty()) {
+    return TimeDelta::Max();
+  }
+  auto delay = delayed_messages_.front()->when - TimeTicks::Now();
+  return delay.is_positive() ? delay : TimeDelta();
+}
 
-  Message *p = messages_;
+void MessageQueue::SetWakeUpHandler(std::function<void()> wake_up_handler) {
+  DCHECK_EQ(enqueued_count_.load(), 0) << "wake up handler must be set before any message enqueued.";
+  wake_up_handler_ = std::move(wake_up_handler);
+  // There is no consumer until the handler schedules one.
+  blocked_ = true;
+}
 
-  // Remove all messages at front.
-  while (p != nullptr && p->task_runner_ == task_runner) {
-    Message *n = p->next;
-    messages_ = n;
-    delete p;
-    p = n;
+void MessageQueue::OnMessageDequeued(Message *msg) {
+  pending_count_.fetch_sub(1, std::memory_order_relaxed);
+  // Clear the flag before the task runs, a post made while it is running must
+  // not be dropped.
+  if (msg->pending_flag_) {
+    msg->pending_flag_->store(false);
+  }
+}
+
+void MessageQueue::RecycleAll(Message *messages) {
+  while (messages != nullptr) {
+    Message *n = messages->next.load(std::memory_order_relaxed);
+    Recycle(messages);
+    messages = n;
   }
+}
+
+template<typename Predicate>
+Message *MessageQueue::RemoveMessagesLocked(Predicate predicate) {
+  DrainIncomingLocked();
 
-  // Remove all message after front
+  // Removed messages are chained up and recycled by the caller after the lock
+  // is released, destroying a task may post or remove other tasks.
+  Message *removed = nullptr;
+  auto take = [this, &removed](Message *msg) {
+    OnMessageDequeued(msg);
+    msg->next.store(removed, std::memory_order_relaxed);
+    removed = msg;
+  };
+
+  Message *p = ready_head_;
+  Message *prev = nullptr;
   while (p != nullptr) {
-    Message *n = p->next;
-    if (n) {
-      if (n->task_runner_ == task_runner) {
-        Message *nn = n->next;
-        delete n;
-        p->next = nn;
-        continue;
+    Message *n = p->next.load(std::memory_order_relaxed);
+    if (predicate(p)) {
+      if (prev == nullptr) {
+        ready_head_ = n;
+      } else {
+        prev->next.store(n, std::memory_order_relaxed);
       }
+      if (ready_tail_ == p) {
+        ready_tail_ = prev;
+      }
+      take(p);
+    } else {
+      prev = p;
     }
     p = n;
   }
 
+  auto it = std::remove_if(delayed_messages_.begin(), delayed_messages_.end(), [&](Message *msg) {
+    if (predicate(msg)) {
+      take(msg);
+      return true;
+    }
+    return false;
+  });
+  if (it != delayed_messages_.end()) {
+    delayed_messages_.erase(it, delayed_messages_.end());
+    std::make_heap(delayed_messages_.begin(), delayed_messages_.end(), CompareMessage);
+  }
+  return removed;
 }
 
-void MessageQueue::RemoveTask(TaskRunner *task_runner, int task_id) {
+void MessageQueue::RemoveTask(TaskRunner *task_runner) {
   if (!task_runner) {
     return;
   }
-  std::lock_guard<std::recursive_mutex> auto_lock(message_queue_lock_);
-  Message *p = messages_;
-
-  // Remove all messages at front.
-  while (p != nullptr && p->task_runner_ == task_runner && p->task_id_ == task_id) {
-    Message *n = p->next;
-    messages_ = n;
-    delete p;
-    p = n;
+  Message *removed;
+  {
+    std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+    removed = RemoveMessagesLocked([task_runner](const Message *msg) {
+      return msg->task_runner_ == task_runner;
+    });
   }
+  RecycleAll(removed);
+}
 
-  // Remove all message after front
-  while (p != nullptr) {
-    Message *n = p->next;
-    if (n) {
-      if (n->task_runner_ == task_runner && n->task_id_ == task_id) {
-        Message *nn = n->next;
-        delete n;
-        p->next = nn;
-        continue;
-      }
-    }
-    p = n;
+void MessageQueue::RemoveTask(TaskRunner *task_runner, int task_id) {
+  if (!task_runner) {
+    return;
   }
-
+  Message *removed;
+  {
+    std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+    removed = RemoveMessagesLocked([task_runner, task_id](const Message *msg) {
+      return msg->task_runner_ == task_runner && msg->task_id_ == task_id;
+    });
+  }
+  RecycleAll(removed);
 }
 
 void MessageQueue::Wake() {
+  if (wake_up_handler_) {
+    wake_up_handler_();
+    return;
+  }
   std::lock_guard<std::mutex> condition_lock(message_wait_lock_);
+  wake_pending_ = true;
   message_wait_condition_.notify_one();
 }
 
-void MessageQueue::PollOnce(TimeDelta wait_duration) {
-  std::unique_lock<std::mutex> condition_lock(message_wait_lock_);
-  if (!wait_duration.is_inf()) {
-    message_wait_condition_.wait_for(condition_lock, std::chrono::microseconds(wait_duration.InMicroseconds()));
-  } else {
-    message_wait_condition_.wait(condition_lock);
-  }
-}
-
 void MessageQueue::Quit() {
-  std::lock_guard<std::recursive_mutex> auto_lock(message_queue_lock_);
-  if (quitting_) {
+  if (quitting_.exchange(true)) {
     return;
   }
-  quitting_ = true;
-  RemoveAllMessageLocked();
+  Message *removed;
+  {
+    std::lock_guard<std::mutex> auto_lock(message_queue_lock_);
+    removed = RemoveMessagesLocked([](const Message *) { return true; });
+  }
+  RecycleAll(removed);
   Wake();
 }
 
-void MessageQueue::RemoveAllMessageLocked() {
-  Message *p = messages_;
-  while (p != nullptr) {
-    Message *n = p->next;
-    delete p;
-    p = n;
-  }
-  messages_ = nullptr;
+MessageQueue::Stats MessageQueue::GetStats() const {
+  Stats stats;
+  stats.enqueued_count = enqueued_count_.load(std::memory_order_relaxed);
+  stats.coalesced_count = coalesced_count_.load(std::memory_order_relaxed);
+  stats.pending_count = pending_count_.load(std::memory_order_relaxed);
+  stats.max_pending_count = max_pending_count_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void MessageQueue::RecordCoalescedTask() {
+  coalesced_count_.fetch_add(1, std::memory_order_relaxed);
 }
 
 } // namespace base
-} // namespace media
\ No newline at end of file
+} // namespace media
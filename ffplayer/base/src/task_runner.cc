@@ -18,7 +18,8 @@ TaskRunner::TaskRunner(std::shared_ptr<MessageLooper> looper) : looper_(std::mov
 
 TaskRunner::TaskRunner() = default;
 
-TaskRunner::TaskRunner(const TaskRunner &object) = default;
+TaskRunner::TaskRunner(const TaskRunner &object) : looper_(object.looper_) {
+}
 
 TaskRunner::~TaskRunner() {
   if (!looper_) {
@@ -50,8 +51,43 @@ void TaskRunner::PostDelayedTask(
   if (!looper_) {
     return;
   }
-  Message message(task_closure, from_here, delay, this, task_id);
-  looper_->message_queue_->EnqueueMessage(message);
+  looper_->message_queue_->EnqueueMessage(Message(task_closure, from_here, delay, this, task_id));
+}
+
+bool TaskRunner::PostTaskIfNotPending(const tracked_objects::Location &from_here,
+                                      int task_id,
+                                      const TaskClosure &task) {
+  DCHECK_NE(task_id, 0);
+  if (!looper_) {
+    return false;
+  }
+  auto *pending = FindPendingFlag(task_id);
+  DCHECK(pending) << "more than " << kMaxPendingTaskIds << " task ids to coalesce";
+  if (!pending) {
+    LOG(WARNING) << "too many task ids to coalesce, post directly. " << from_here.ToString();
+    PostTask(from_here, task_id, task);
+    return true;
+  }
+  if (pending->exchange(true)) {
+    looper_->message_queue_->RecordCoalescedTask();
+    return false;
+  }
+  Message message(task, from_here, TimeDelta(), this, task_id);
+  message.pending_flag_ = pending;
+  return looper_->message_queue_->EnqueueMessage(std::move(message));
+}
+
+std::atomic_bool *TaskRunner::FindPendingFlag(int task_id) {
+  for (auto &pending_task : pending_tasks_) {
+    int id = pending_task.task_id.load(std::memory_order_acquire);
+    if (id == 0 && pending_task.task_id.compare_exchange_strong(id, task_id)) {
+      return &pending_task.pending;
+    }
+    if (id == task_id) {
+      return &pending_task.pending;
+    }
+  }
+  return nullptr;
 }
 
 void TaskRunner::RemoveTask(int task_id) {
@@ -73,11 +109,37 @@ bool TaskRunner::BelongsToCurrentThread() {
   return looper_->BelongsToCurrentThread();
 }
 
+MessageQueue::Stats TaskRunner::GetQueueStats() const {
+  if (!looper_) {
+    return MessageQueue::Stats();
+  }
+  return looper_->GetQueueStats();
+}
+
+TaskStats TaskRunner::GetTaskStats(int top_n) const {
+  if (!looper_) {
+    return TaskStats();
+  }
+  return looper_->GetTaskStats(top_n);
+}
+
 void TaskRunner::Reset() {
   RemoveAllTasks();
   looper_ = nullptr;
 }
 
+TaskRunner &TaskRunner::operator=(const TaskRunner &object) {
+  if (looper_ != object.looper_) {
+#if DCHECK_IS_ON()
+    for (auto &pending_task : pending_tasks_) {
+      DCHECK(!pending_task.pending) << "task " << pending_task.task_id << " is still pending on the previous looper";
+    }
+#endif
+    looper_ = object.looper_;
+  }
+  return *this;
+}
+
 TaskRunner &TaskRunner::operator=(nullptr_t) {
   Reset();
   return *this;
@@ -0,0 +1,111 @@
+//
+// Created by yangbin on 2021/8/3.
+//
+
+#include "base/task_stats.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "base/logging.h"
+
+namespace media {
+
+namespace {
+
+void StoreMax(std::atomic<int64> *max, int64 value) {
+  // Only the recording thread stores, a plain compare is enough.
+  if (value > max->load(std::memory_order_relaxed)) {
+    max->store(value, std::memory_order_relaxed);
+  }
+}
+
+} // namespace
+
+TaskStatsRecorder::LocationSlot *TaskStatsRecorder::FindOrClaimSlot(const tracked_objects::Location &location) {
+  // Strings of a location are literals, as in Location::operator<, their
+  // addresses tell locations apart.
+  auto hash = (reinterpret_cast<uintptr_t>(location.file_name()) >> 3) * 31
+      + static_cast<uintptr_t>(location.line_number());
+  for (int probe = 0; probe < kMaxLocations; ++probe) {
+    auto &slot = locations_[(hash + probe) % kMaxLocations];
+    if (!slot.used.load(std::memory_order_relaxed)) {
+      slot.function_name.store(location.function_name(), std::memory_order_relaxed);
+      slot.file_name.store(location.file_name(), std::memory_order_relaxed);
+      slot.line_number.store(location.line_number(), std::memory_order_relaxed);
+      slot.program_counter.store(location.program_counter(), std::memory_order_relaxed);
+      slot.used.store(true, std::memory_order_release);
+      return &slot;
+    }
+    if (slot.line_number.load(std::memory_order_relaxed) == location.line_number()
+        && slot.file_name.load(std::memory_order_relaxed) == location.file_name()
+        && slot.function_name.load(std::memory_order_relaxed) == location.function_name()) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+void TaskStatsRecorder::Record(const tracked_objects::Location &posted_from,
+                               int64 queue_delay_us,
+                               int64 run_time_us) {
+  queue_delay_us_.Record(queue_delay_us);
+  run_time_us_.Record(run_time_us);
+
+  auto *slot = FindOrClaimSlot(posted_from);
+  if (!slot) {
+    return;
+  }
+  slot->count.fetch_add(1, std::memory_order_relaxed);
+  slot->total_run_time_us.fetch_add(run_time_us, std::memory_order_relaxed);
+  StoreMax(&slot->max_run_time_us, run_time_us);
+  StoreMax(&slot->max_queue_delay_us, queue_delay_us);
+}
+
+void TaskStatsRecorder::GetStats(int top_n, TaskStats *stats) const {
+  DCHECK(stats);
+  stats->queue_delay_us = queue_delay_us_.GetSnapshot();
+  stats->run_time_us = run_time_us_.GetSnapshot();
+  stats->slowest_locations.clear();
+  if (top_n <= 0) {
+    return;
+  }
+  auto &locations = stats->slowest_locations;
+  for (auto &slot : locations_) {
+    if (!slot.used.load(std::memory_order_acquire)) {
+      continue;
+    }
+    LocationTaskStats location;
+    location.count = slot.count.load(std::memory_order_relaxed);
+    if (location.count == 0) {
+      continue;
+    }
+    location.location = tracked_objects::Location(slot.function_name.load(std::memory_order_relaxed),
+                                                  slot.file_name.load(std::memory_order_relaxed),
+                                                  slot.line_number.load(std::memory_order_relaxed),
+                                                  slot.program_counter.load(std::memory_order_relaxed));
+    location.total_run_time_us = slot.total_run_time_us.load(std::memory_order_relaxed);
+    location.max_run_time_us = slot.max_run_time_us.load(std::memory_order_relaxed);
+    location.max_queue_delay_us = slot.max_queue_delay_us.load(std::memory_order_relaxed);
+    locations.push_back(location);
+  }
+  auto n = std::min(locations.size(), static_cast<size_t>(top_n));
+  std::partial_sort(locations.begin(), locations.begin() + n, locations.end(),
+                    [](const LocationTaskStats &a, const LocationTaskStats &b) {
+                      return a.total_run_time_us > b.total_run_time_us;
+                    });
+  locations.resize(n);
+}
+
+void TaskStatsRecorder::Reset() {
+  queue_delay_us_.Reset();
+  run_time_us_.Reset();
+  for (auto &slot : locations_) {
+    slot.count.store(0, std::memory_order_relaxed);
+    slot.total_run_time_us.store(0, std::memory_order_relaxed);
+    slot.max_run_time_us.store(0, std::memory_order_relaxed);
+    slot.max_queue_delay_us.store(0, std::memory_order_relaxed);
+  }
+}
+
+} // namespace media
@@ -0,0 +1,187 @@
+//
+// Created by yangbin on 2021/7/17.
+//
+
+#include "base/thread_pool.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "base/utility.h"
+
+namespace media {
+namespace base {
+
+namespace {
+
+// The pool and index of the worker running on current thread.
+thread_local ThreadPool *current_pool = nullptr;
+thread_local int current_worker_index = -1;
+
+}
+
+// static
+ThreadPool *ThreadPool::GetDefault() {
+  static ThreadPool *pool = new ThreadPool(
+      std::max(4, static_cast<int>(std::thread::hardware_concurrency())));
+  return pool;
+}
+
+ThreadPool::ThreadPool(int worker_count, const char *name)
+    : name_(name),
+      next_worker_(0),
+      pending_count_(0),
+      idle_worker_count_(0),
+      quitting_(false) {
+  DCHECK_GT(worker_count, 0);
+  for (int i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(std::make_unique<Worker>());
+  }
+  for (int i = 0; i < worker_count; ++i) {
+    workers_[i]->thread = std::make_unique<std::thread>(&ThreadPool::WorkerMain, this, i);
+  }
+  timer_thread_ = std::make_unique<std::thread>(&ThreadPool::TimerMain, this);
+}
+
+ThreadPool::~ThreadPool() {
+  quitting_ = true;
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    idle_condition_.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    timer_condition_.notify_all();
+  }
+  for (auto &worker : workers_) {
+    worker->thread->join();
+  }
+  timer_thread_->join();
+}
+
+void ThreadPool::Schedule(const std::weak_ptr<MessageLooper> &looper) {
+  int index;
+  if (current_pool == this) {
+    // Keep the looper on the worker which scheduled it, other workers steal
+    // it when they run out of work.
+    index = current_worker_index;
+  } else {
+    index = static_cast<int>(next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size());
+  }
+  {
+    auto &worker = workers_[index];
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->run_queue.push_back(looper);
+  }
+  pending_count_.fetch_add(1);
+  if (idle_worker_count_.load() > 0) {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    idle_condition_.notify_one();
+  }
+}
+
+void ThreadPool::ScheduleDelayed(const std::shared_ptr<MessageLooper> &looper, TimeDelta delay) {
+  auto when = TimeTicks::Now() + delay;
+  std::lock_guard<std::mutex> lock(timer_mutex_);
+  // A looper only needs its earliest deadline, later ones are registered again
+  // once it has run.
+  if (looper->has_timer_ && looper->timer_deadline_ <= when) {
+    return;
+  }
+  looper->has_timer_ = true;
+  looper->timer_deadline_ = when;
+  bool earliest = timers_.empty() || when < timers_.front().when;
+  timers_.push_back(Timer{when, looper});
+  std::push_heap(timers_.begin(), timers_.end());
+  if (earliest) {
+    timer_condition_.notify_one();
+  }
+}
+
+std::shared_ptr<MessageLooper> ThreadPool::TakeWork(int index) {
+  auto count = workers_.size();
+  for (size_t i = 0; i < count; ++i) {
+    auto &worker = workers_[(index + i) % count];
+    std::weak_ptr<MessageLooper> looper;
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      if (worker->run_queue.empty()) {
+        continue;
+      }
+      if (i == 0) {
+        looper = std::move(worker->run_queue.front());
+        worker->run_queue.pop_front();
+      } else {
+        // Steal the looper scheduled last, it is the coldest in the victim's cache.
+        looper = std::move(worker->run_queue.back());
+        worker->run_queue.pop_back();
+      }
+    }
+    pending_count_.fetch_sub(1);
+    auto strong = looper.lock();
+    if (strong) {
+      return strong;
+    }
+  }
+  return nullptr;
+}
+
+void ThreadPool::WorkerMain(int index) {
+  std::string thread_name = std::string(name_) + "_" + std::to_string(index);
+  utility::update_thread_name(thread_name.c_str());
+  current_pool = this;
+  current_worker_index = index;
+
+  while (!quitting_) {
+    auto looper = TakeWork(index);
+    if (looper) {
+      looper->RunSequencedBatch();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_worker_count_.fetch_add(1);
+    idle_condition_.wait(lock, [this]() {
+      return pending_count_.load() > 0 || quitting_;
+    });
+    idle_worker_count_.fetch_sub(1);
+  }
+
+  current_pool = nullptr;
+  current_worker_index = -1;
+}
+
+void ThreadPool::TimerMain() {
+  std::string thread_name = std::string(name_) + "_timer";
+  utility::update_thread_name(thread_name.c_str());
+
+  std::unique_lock<std::mutex> lock(timer_mutex_);
+  while (!quitting_) {
+    if (timers_.empty()) {
+      timer_condition_.wait(lock);
+      continue;
+    }
+    auto now = TimeTicks::Now();
+    const auto &top = timers_.front();
+    if (now < top.when) {
+      timer_condition_.wait_for(lock, std::chrono::microseconds((top.when - now).InMicroseconds()));
+      continue;
+    }
+    std::pop_heap(timers_.begin(), timers_.end());
+    auto looper = timers_.back().looper.lock();
+    timers_.pop_back();
+    if (!looper) {
+      continue;
+    }
+    looper->has_timer_ = false;
+    lock.unlock();
+    looper->ScheduleSequencedBatch();
+    looper = nullptr;
+    lock.lock();
+  }
+}
+
+} // namespace base
+} // namespace media
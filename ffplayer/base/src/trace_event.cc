@@ -0,0 +1,372 @@
+//
+// Created by yangbin on 2021/8/2.
+//
+
+#include "base/trace_event.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "base/logging.h"
+
+namespace media {
+
+namespace {
+
+const int kDefaultBufferCapacity = 8192;
+
+// Buffers of exited threads kept for dumping, the oldest are freed beyond it.
+const size_t kMaxExitedBuffers = 32;
+
+// A TraceEvent guarded by a sequence lock, so that the owner thread may
+// overwrite it while another thread copies it.
+struct EventSlot {
+
+  // 2 * index + 1 while event |index| is written, 2 * index + 2 once written.
+  std::atomic<uint64_t> sequence{0};
+
+  std::atomic<char> phase{0};
+  std::atomic<const char *> category{nullptr};
+  std::atomic<const char *> name{nullptr};
+  std::atomic<const char *> file_name{nullptr};
+  std::atomic<int> line_number{0};
+  std::atomic<int64> timestamp_us{0};
+  std::atomic<const char *> arg_name{nullptr};
+  std::atomic<int64> arg_value{0};
+
+  void Write(uint64_t index, const TraceEvent &event) {
+    sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    phase.store(event.phase, std::memory_order_relaxed);
+    category.store(event.category, std::memory_order_relaxed);
+    name.store(event.name, std::memory_order_relaxed);
+    file_name.store(event.file_name, std::memory_order_relaxed);
+    line_number.store(event.line_number, std::memory_order_relaxed);
+    timestamp_us.store(event.timestamp_us, std::memory_order_relaxed);
+    arg_name.store(event.arg_name, std::memory_order_relaxed);
+    arg_value.store(event.arg_value, std::memory_order_relaxed);
+    sequence.store(2 * index + 2, std::memory_order_release);
+  }
+
+  /**
+   * @return false if the slot does not hold event |index| completely.
+   */
+  bool Read(uint64_t index, TraceEvent *event) const {
+    if (sequence.load(std::memory_order_acquire) != 2 * index + 2) {
+      return false;
+    }
+    event->phase = phase.load(std::memory_order_relaxed);
+    event->category = category.load(std::memory_order_relaxed);
+    event->name = name.load(std::memory_order_relaxed);
+    event->file_name = file_name.load(std::memory_order_relaxed);
+    event->line_number = line_number.load(std::memory_order_relaxed);
+    event->timestamp_us = timestamp_us.load(std::memory_order_relaxed);
+    event->arg_name = arg_name.load(std::memory_order_relaxed);
+    event->arg_value = arg_value.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence.load(std::memory_order_relaxed) == 2 * index + 2;
+  }
+
+};
+
+struct ThreadBuffer {
+
+  ThreadBuffer(int tid, int capacity)
+      : tid(tid), capacity(capacity), slots(new EventSlot[capacity]), write_index(0), read_index(0) {}
+
+  const int tid;
+  std::string thread_name;
+
+  // Slot |index % capacity| holds event |index|.
+  const uint64_t capacity;
+  std::unique_ptr<EventSlot[]> slots;
+
+  // Count of events written by the owner thread.
+  std::atomic<uint64_t> write_index;
+
+  // Events before it were cleared.
+  std::atomic<uint64_t> read_index;
+
+  // Set under the registry lock once the owner thread exited.
+  bool exited = false;
+
+};
+
+struct TraceRegistry {
+  std::mutex lock;
+  // In order of creation.
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  size_t exited_buffer_count = 0;
+  int buffer_capacity = kDefaultBufferCapacity;
+  int next_tid = 1;
+};
+
+TraceRegistry &GetRegistry() {
+  // Leaked, so that threads may trace during static destruction.
+  static auto *registry = new TraceRegistry();
+  return *registry;
+}
+
+// Owned by the registry, which keeps the buffer after the thread exits so that
+// its events are still dumped, up to kMaxExitedBuffers.
+class ThreadBufferHolder {
+
+ public:
+
+  ThreadBuffer *buffer = nullptr;
+
+  ThreadBufferHolder() = default;
+
+  ~ThreadBufferHolder() {
+    if (!buffer) {
+      return;
+    }
+    auto &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.lock);
+    buffer->exited = true;
+    buffer = nullptr;
+    if (++registry.exited_buffer_count <= kMaxExitedBuffers) {
+      return;
+    }
+    auto oldest = std::find_if(registry.buffers.begin(), registry.buffers.end(),
+                               [](const std::unique_ptr<ThreadBuffer> &buffer) { return buffer->exited; });
+    registry.buffers.erase(oldest);
+    registry.exited_buffer_count--;
+  }
+
+  DELETE_COPY_AND_ASSIGN(ThreadBufferHolder);
+
+};
+
+thread_local ThreadBufferHolder current_thread_buffer;
+thread_local std::string current_thread_name;
+
+ThreadBuffer *GetCurrentThreadBuffer() {
+  if (current_thread_buffer.buffer) {
+    return current_thread_buffer.buffer;
+  }
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.lock);
+  auto buffer = std::make_unique<ThreadBuffer>(registry.next_tid++, registry.buffer_capacity);
+  buffer->thread_name = current_thread_name;
+  current_thread_buffer.buffer = buffer.get();
+  registry.buffers.emplace_back(std::move(buffer));
+  return current_thread_buffer.buffer;
+}
+
+int64 NowInMicroseconds() {
+  auto time = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+}
+
+void Append(const TraceEvent &event) {
+  auto *buffer = GetCurrentThreadBuffer();
+  auto index = buffer->write_index.load(std::memory_order_relaxed);
+  buffer->slots[index % buffer->capacity].Write(index, event);
+  buffer->write_index.store(index + 1, std::memory_order_release);
+}
+
+// Copy the events of |buffer| which are not overwritten meanwhile, in order.
+std::vector<TraceEvent> CopyEvents(const ThreadBuffer &buffer) {
+  auto end = buffer.write_index.load(std::memory_order_acquire);
+  auto begin = std::max(buffer.read_index.load(std::memory_order_relaxed),
+                        end < buffer.capacity ? 0 : end - buffer.capacity);
+  std::vector<TraceEvent> events;
+  events.reserve(end - begin);
+  TraceEvent event;
+  for (auto index = begin; index < end; ++index) {
+    // The owner may have wrapped around while we copied, the slots it
+    // overwrote since fail to read.
+    if (buffer.slots[index % buffer.capacity].Read(index, &event)) {
+      events.push_back(event);
+    }
+  }
+  return events;
+}
+
+void AppendJsonString(std::ostringstream &out, const char *value) {
+  out << '"';
+  for (const char *c = value ? value : ""; *c; ++c) {
+    switch (*c) {
+      case '"':out << "\\\"";
+        break;
+      case '\\':out << "\\\\";
+        break;
+      case '\n':out << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          out << ' ';
+        } else {
+          out << *c;
+        }
+    }
+  }
+  out << '"';
+}
+
+} // namespace
+
+std::atomic_bool TraceLog::enabled_(false);
+
+// static
+void TraceLog::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+// static
+void TraceLog::Clear() {
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.lock);
+  for (auto &buffer : registry.buffers) {
+    buffer->read_index.store(buffer->write_index.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+// static
+void TraceLog::SetBufferCapacity(int capacity) {
+  DCHECK_GT(capacity, 0);
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.lock);
+  registry.buffer_capacity = capacity;
+}
+
+// static
+size_t TraceLog::buffer_count_for_testing() {
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.lock);
+  return registry.buffers.size();
+}
+
+// static
+void TraceLog::SetCurrentThreadName(const char *name) {
+  current_thread_name = name;
+  if (current_thread_buffer.buffer) {
+    std::lock_guard<std::mutex> lock(GetRegistry().lock);
+    current_thread_buffer.buffer->thread_name = name;
+  }
+}
+
+// static
+void TraceLog::AddEvent(char phase,
+                        const char *category,
+                        const char *name,
+                        const tracked_objects::Location &location,
+                        const char *arg_name,
+                        int64 arg_value) {
+  TraceEvent event;
+  event.phase = phase;
+  event.category = category;
+  event.name = name;
+  event.file_name = location.file_name();
+  event.line_number = location.line_number();
+  event.timestamp_us = NowInMicroseconds();
+  event.arg_name = arg_name;
+  event.arg_value = arg_value;
+  Append(event);
+}
+
+// static
+void TraceLog::AddCounter(const char *category, const char *name, int64 value) {
+  TraceEvent event;
+  event.phase = 'C';
+  event.category = category;
+  event.name = name;
+  event.timestamp_us = NowInMicroseconds();
+  event.arg_name = name;
+  event.arg_value = value;
+  Append(event);
+}
+
+// static
+std::string TraceLog::DumpJson() {
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.lock);
+
+  std::ostringstream out;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&]() {
+    if (!first) {
+      out << ",\n";
+    }
+    first = false;
+  };
+  for (auto &buffer : registry.buffers) {
+    if (!buffer->thread_name.empty()) {
+      separate();
+      out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->tid << R"(,"args":{"name":)";
+      AppendJsonString(out, buffer->thread_name.c_str());
+      out << "}}";
+    }
+
+    // The begin events of the oldest end events may be dropped by the ring.
+    int depth = 0;
+    for (auto &event : CopyEvents(*buffer)) {
+      if (event.phase == 'E') {
+        if (depth == 0) {
+          continue;
+        }
+        depth--;
+      } else if (event.phase == 'B') {
+        depth++;
+      }
+      separate();
+      out << "{\"name\":";
+      AppendJsonString(out, event.name);
+      out << ",\"cat\":";
+      AppendJsonString(out, event.category);
+      out << ",\"ph\":\"" << event.phase << "\",\"ts\":" << event.timestamp_us
+          << ",\"pid\":1,\"tid\":" << buffer->tid;
+      if (event.phase == 'C') {
+        out << ",\"args\":{";
+        AppendJsonString(out, event.arg_name);
+        out << ":" << event.arg_value << "}";
+      } else if (event.phase == 'B') {
+        out << ",\"args\":{\"location\":";
+        AppendJsonString(out, (std::string(event.file_name ? event.file_name : "")
+            + ":" + std::to_string(event.line_number)).c_str());
+        if (event.arg_name) {
+          out << ",";
+          AppendJsonString(out, event.arg_name);
+          out << ":" << event.arg_value;
+        }
+        out << "}";
+      }
+      out << "}";
+    }
+  }
+  out << "]}\n";
+  return out.str();
+}
+
+// static
+bool TraceLog::DumpToFile(const char *path) {
+  auto json = DumpJson();
+  auto *file = std::fopen(path, "wb");
+  if (!file) {
+    DLOG(ERROR) << "failed to open trace file: " << path;
+    return false;
+  }
+  auto written = std::fwrite(json.data(), 1, json.size(), file);
+  std::fclose(file);
+  return written == json.size();
+}
+
+void ScopedTraceEvent::Begin(const char *arg_name, int64 arg_value) {
+  TraceLog::AddEvent('B', category_, name_, tracked_objects::Location(function_name_, file_name_, line_number_, nullptr),
+                     arg_name, arg_value);
+}
+
+void ScopedTraceEvent::End() {
+  TraceLog::AddEvent('E', category_, name_, tracked_objects::Location(function_name_, file_name_, line_number_, nullptr));
+}
+
+} // namespace media
@@ -3,6 +3,7 @@
 //
 
 #include "base/utility.h"
+#include "base/trace_event.h"
 
 #if WIN32
 #include <Windows.h>
@@ -33,6 +34,7 @@ void update_thread_name(const char *name) {
 #else
   pthread_setname_np(name);
 #endif
+  TraceLog::SetCurrentThreadName(name);
 
 }
 
@@ -2,6 +2,8 @@
 // Created by yangbin on 2021/4/11.
 //
 
+#include <memory>
+
 #include "gtest/gtest.h"
 
 #include "base/circular_deque.h"
@@ -38,3 +40,32 @@ TEST(CircularDequeTest, Insert) {
   EXPECT_EQ(deque.IsEmpty(), true);
   EXPECT_EQ(deque.IsFull(), false);
 }
+
+TEST(CircularDequeTest, WrapAround) {
+  media::CircularDeque<int> deque(4);
+
+  for (int i = 0; i < 3; ++i) {
+    deque.InsertLast(i);
+  }
+  EXPECT_EQ(deque.PopFront(), 0);
+  EXPECT_EQ(deque.PopFront(), 1);
+  deque.InsertLast(3);
+  deque.InsertLast(4);
+  EXPECT_EQ(deque.GetSize(), 3);
+  EXPECT_EQ(deque.GetFront(), 2);
+  EXPECT_EQ(deque.GetRear(), 4);
+}
+
+TEST(CircularDequeTest, PopFrontReleasesSlot) {
+  media::CircularDeque<std::shared_ptr<int>> deque(2);
+  auto value = std::make_shared<int>(1);
+
+  deque.InsertLast(value);
+  EXPECT_EQ(value.use_count(), 2);
+  deque.PopFront();
+  EXPECT_EQ(value.use_count(), 1);
+
+  deque.InsertLast(value);
+  deque.Clear();
+  EXPECT_EQ(value.use_count(), 1);
+}
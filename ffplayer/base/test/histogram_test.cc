@@ -0,0 +1,75 @@
+//
+// Created by yangbin on 2021/8/1.
+//
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "base/histogram.h"
+
+using media::Histogram;
+
+TEST(HistogramTest, EmptySnapshot) {
+  Histogram histogram;
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 0);
+  EXPECT_EQ(snapshot.max, 0);
+  EXPECT_EQ(histogram.ValueAtPercentile(50), 0);
+}
+
+TEST(HistogramTest, SmallValuesAreExact) {
+  Histogram histogram;
+  for (int i = 1; i <= 20; ++i) {
+    histogram.Record(i);
+  }
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 20);
+  EXPECT_EQ(snapshot.min, 1);
+  EXPECT_EQ(snapshot.max, 20);
+  EXPECT_DOUBLE_EQ(snapshot.mean, 10.5);
+  EXPECT_EQ(snapshot.p50, 10);
+  EXPECT_EQ(snapshot.p90, 18);
+  EXPECT_EQ(histogram.ValueAtPercentile(100), 20);
+}
+
+TEST(HistogramTest, LargeValuesWithinPrecision) {
+  Histogram histogram;
+  for (int64 value = 1; value < (int64(1) << 36); value = value * 3 + 7) {
+    histogram.Reset();
+    histogram.Record(value);
+    histogram.Record(value * 2);
+    auto recorded = histogram.ValueAtPercentile(50);
+    EXPECT_GE(recorded, value);
+    EXPECT_LE(recorded - value, value / 16) << value;
+  }
+}
+
+TEST(HistogramTest, ClampsOutOfRange) {
+  Histogram histogram;
+  histogram.Record(-5);
+  histogram.Record(int64(1) << 50);
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.min, 0);
+  EXPECT_EQ(snapshot.max, (int64(1) << 40) - 1);
+}
+
+TEST(HistogramTest, ConcurrentRecords) {
+  Histogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&histogram]() {
+      for (int i = 0; i < 10000; ++i) {
+        histogram.Record(i % 1000);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 40000);
+  EXPECT_EQ(snapshot.max, 999);
+  EXPECT_NEAR(snapshot.p50, 500, 32);
+}
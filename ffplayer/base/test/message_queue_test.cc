@@ -121,4 +121,127 @@ TEST(MessageQueue, MultiThreadPostMessage) {
 
   }, on_message_cb.AsStdFunction());
 
-}
\ No newline at end of file
+}
+TEST(MessageQueue, DelayedMessageOrder) {
+  std::vector<int> order;
+
+  auto message = [&order](int value, int64_t delay_ms) {
+    return Message([&order, value]() { order.push_back(value); }, FROM_HERE,
+                   media::TimeDelta::FromMilliseconds(delay_ms), nullptr, 0);
+  };
+
+  simple_loop([&](MessageQueue &queue) {
+    queue.EnqueueMessage(message(3, 300));
+    queue.EnqueueMessage(message(1, 100));
+    queue.EnqueueMessage(message(2, 200));
+    queue.EnqueueMessage(message(0, 0));
+  }, [](MessageQueue &queue, Message *msg) {
+    msg->task();
+    queue.Recycle(msg);
+  }, milliseconds(1000));
+
+  EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3}));
+}
+
+TEST(MessageQueue, MultiProducerKeepsOrderOfEachProducer) {
+  const int kProducers = 4;
+  const int kMessagesPerProducer = 2000;
+
+  MessageQueue queue;
+  // Only touched by the consumer thread.
+  std::vector<std::vector<int>> received(kProducers);
+  int remaining = kProducers * kMessagesPerProducer;
+
+  std::thread consumer([&]() {
+    while (remaining > 0) {
+      auto *msg = queue.next();
+      ASSERT_NE(msg, nullptr);
+      msg->task();
+      queue.Recycle(msg);
+      remaining--;
+    }
+  });
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kProducers; ++producer) {
+    producers.emplace_back([&queue, &received, producer]() {
+      for (int i = 0; i < kMessagesPerProducer; ++i) {
+        queue.EnqueueMessage(Message([&received, producer, i]() { received[producer].push_back(i); },
+                                     FROM_HERE, media::TimeDelta(), nullptr, 0));
+      }
+    });
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  consumer.join();
+  queue.Quit();
+
+  for (int producer = 0; producer < kProducers; ++producer) {
+    ASSERT_EQ(received[producer].size(), static_cast<size_t>(kMessagesPerProducer));
+    for (int i = 0; i < kMessagesPerProducer; ++i) {
+      ASSERT_EQ(received[producer][i], i) << "producer " << producer;
+    }
+  }
+  auto stats = queue.GetStats();
+  EXPECT_EQ(stats.enqueued_count, kProducers * kMessagesPerProducer);
+  EXPECT_EQ(stats.pending_count, 0);
+}
+
+TEST(MessageQueue, DelayedMessagesFromManyThreadsRunByDeadline) {
+  const int kThreads = 4;
+  const int kMessagesPerThread = 8;
+
+  MessageQueue queue;
+  std::vector<int> order;
+  auto start = media::TimeTicks::Now();
+  // Deadlines are interleaved across threads: thread t posts t, t + 4, ...
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&queue, &order, start, t]() {
+      for (int i = kMessagesPerThread - 1; i >= 0; --i) {
+        int value = i * kThreads + t;
+        auto when = start + media::TimeDelta::FromMilliseconds(50 + value);
+        queue.EnqueueMessage(Message([&order, value]() { order.push_back(value); }, FROM_HERE,
+                                     when - media::TimeTicks::Now(), nullptr, 0));
+      }
+    });
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  // Posted last without delay, runs first.
+  queue.EnqueueMessage(Message([&order]() { order.push_back(-1); }, FROM_HERE, media::TimeDelta(), nullptr, 0));
+
+  for (int i = 0; i < kThreads * kMessagesPerThread + 1; ++i) {
+    auto *msg = queue.next();
+    ASSERT_NE(msg, nullptr);
+    msg->task();
+    queue.Recycle(msg);
+  }
+  queue.Quit();
+
+  ASSERT_EQ(order.size(), static_cast<size_t>(kThreads * kMessagesPerThread + 1));
+  for (size_t i = 0; i < order.size(); ++i) {
+    EXPECT_EQ(order[i], static_cast<int>(i) - 1);
+  }
+}
+
+TEST(MessageQueue, EqualDelaysRunInPostOrder) {
+  MessageQueue queue;
+  std::vector<int> order;
+  auto when = media::TimeDelta::FromMilliseconds(20);
+  for (int i = 0; i < 16; ++i) {
+    queue.EnqueueMessage(Message([&order, i]() { order.push_back(i); }, FROM_HERE, when, nullptr, 0));
+  }
+  for (int i = 0; i < 16; ++i) {
+    auto *msg = queue.next();
+    ASSERT_NE(msg, nullptr);
+    msg->task();
+    queue.Recycle(msg);
+  }
+  queue.Quit();
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+}
@@ -0,0 +1,70 @@
+//
+// Created by yangbin on 2021/7/20.
+//
+
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "base/spsc_queue.h"
+
+using media::SpscQueue;
+
+TEST(SpscQueueTest, PushPop) {
+  SpscQueue<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 4u);
+  EXPECT_EQ(queue.Front(), nullptr);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.Push(i));
+  }
+  EXPECT_FALSE(queue.Push(4));
+  EXPECT_EQ(queue.size(), 4u);
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(queue.Front(), nullptr);
+    EXPECT_EQ(*queue.Front(), i);
+    queue.Pop();
+  }
+  EXPECT_EQ(queue.Front(), nullptr);
+  EXPECT_EQ(queue.pushed_count(), 4u);
+  EXPECT_EQ(queue.popped_count(), 4u);
+}
+
+TEST(SpscQueueTest, PopReleasesSlot) {
+  SpscQueue<std::shared_ptr<int>> queue(2);
+  auto value = std::make_shared<int>(1);
+
+  queue.Push(value);
+  EXPECT_EQ(value.use_count(), 2);
+  queue.Pop();
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(SpscQueueTest, Threaded) {
+  const int kCount = 200000;
+  SpscQueue<int> queue(64);
+
+  std::thread producer([&]() {
+    for (int i = 0; i < kCount; ++i) {
+      while (!queue.Push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  while (expected < kCount) {
+    auto *value = queue.Front();
+    if (!value) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(*value, expected);
+    queue.Pop();
+    expected++;
+  }
+  producer.join();
+  EXPECT_EQ(queue.size(), 0u);
+}
@@ -101,3 +101,51 @@ TEST_F(TaskRunnerTest, RemoveTaskWithTaskId) {
 
 
 
+
+TEST_F(TaskRunnerTest, PostTaskIfNotPending) {
+  static const int kTaskId = 10;
+
+  std::mutex mutex;
+  mutex.lock();
+  // Block the looper, so that all posts below happen while the task is pending.
+  task_runner_.PostTask(FROM_HERE, [&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+  });
+
+  MockTask task;
+  EXPECT_CALL(task, Call()).Times(1);
+  EXPECT_TRUE(task_runner_.PostTaskIfNotPending(FROM_HERE, kTaskId, task.AsStdFunction()));
+  for (int i = 0; i < 9; ++i) {
+    EXPECT_FALSE(task_runner_.PostTaskIfNotPending(FROM_HERE, kTaskId, task.AsStdFunction()));
+  }
+  mutex.unlock();
+  WaitSeconds();
+
+  auto stats = looper_->GetQueueStats();
+  EXPECT_EQ(stats.enqueued_count, 2);
+  EXPECT_EQ(stats.coalesced_count, 9);
+  EXPECT_EQ(stats.pending_count, 0);
+}
+
+TEST_F(TaskRunnerTest, PostTaskIfNotPendingAfterRemoved) {
+  static const int kTaskId = 10;
+
+  MockTask task;
+  EXPECT_CALL(task, Call()).Times(1);
+  task_runner_.PostDelayedTask(FROM_HERE, media::TimeDelta::FromMilliseconds(100), [&]() {});
+  EXPECT_TRUE(task_runner_.PostTaskIfNotPending(FROM_HERE, kTaskId, []() {}));
+  task_runner_.RemoveTask(kTaskId);
+  EXPECT_TRUE(task_runner_.PostTaskIfNotPending(FROM_HERE, kTaskId, task.AsStdFunction()));
+  WaitSeconds();
+}
+
+TEST_F(TaskRunnerTest, AssignKeepsTasksOfPreviousLooper) {
+  MockTask task;
+  EXPECT_CALL(task, Call()).Times(1);
+  auto other_looper = MessageLooper::PrepareLooper("other_looper");
+  task_runner_.PostDelayedTask(FROM_HERE, media::TimeDelta::FromMilliseconds(100), task.AsStdFunction());
+  task_runner_ = TaskRunner(other_looper);
+  WaitSeconds();
+  task_runner_ = nullptr;
+  other_looper = nullptr;
+}
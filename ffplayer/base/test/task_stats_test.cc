@@ -0,0 +1,88 @@
+//
+// Created by yangbin on 2021/8/3.
+//
+
+#include <future>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "base/message_loop.h"
+#include "base/task_stats.h"
+
+using media::TaskStats;
+using media::TaskStatsRecorder;
+using media::base::MessageLooper;
+using media::tracked_objects::Location;
+
+TEST(TaskStatsTest, SlowestLocationsByRunTime) {
+  Location fast("Fast", __FILE__, 1, nullptr);
+  Location slow("Slow", __FILE__, 2, nullptr);
+  Location busy("Busy", __FILE__, 3, nullptr);
+
+  TaskStatsRecorder recorder;
+  recorder.Record(fast, 10, 5);
+  recorder.Record(slow, 2000, 900);
+  for (int i = 0; i < 100; ++i) {
+    recorder.Record(busy, 0, 20);
+  }
+
+  TaskStats stats;
+  recorder.GetStats(2, &stats);
+  EXPECT_EQ(stats.run_time_us.count, 102);
+  EXPECT_EQ(stats.run_time_us.max, 900);
+  EXPECT_EQ(stats.queue_delay_us.max, 2000);
+  ASSERT_EQ(stats.slowest_locations.size(), 2u);
+  EXPECT_STREQ(stats.slowest_locations[0].location.function_name(), "Busy");
+  EXPECT_EQ(stats.slowest_locations[0].count, 100);
+  EXPECT_EQ(stats.slowest_locations[0].total_run_time_us, 2000);
+  EXPECT_STREQ(stats.slowest_locations[1].location.function_name(), "Slow");
+  EXPECT_EQ(stats.slowest_locations[1].max_run_time_us, 900);
+  EXPECT_EQ(stats.slowest_locations[1].max_queue_delay_us, 2000);
+
+  recorder.Reset();
+  recorder.GetStats(2, &stats);
+  EXPECT_EQ(stats.run_time_us.count, 0);
+  EXPECT_TRUE(stats.slowest_locations.empty());
+}
+
+TEST(TaskStatsTest, LocationsBeyondTheTableOnlyCountInHistograms) {
+  TaskStatsRecorder recorder;
+  const int kLocations = TaskStatsRecorder::kMaxLocations + 10;
+  for (int line = 1; line <= kLocations; ++line) {
+    recorder.Record(Location("Task", __FILE__, line, nullptr), 0, line);
+  }
+  // Known locations are still found once the table is full.
+  recorder.Record(Location("Task", __FILE__, 1, nullptr), 0, 1000);
+
+  TaskStats stats;
+  recorder.GetStats(kLocations, &stats);
+  EXPECT_EQ(stats.run_time_us.count, kLocations + 1);
+  ASSERT_EQ(stats.slowest_locations.size(), static_cast<size_t>(TaskStatsRecorder::kMaxLocations));
+  EXPECT_EQ(stats.slowest_locations[0].location.line_number(), 1);
+  EXPECT_EQ(stats.slowest_locations[0].count, 2);
+  EXPECT_EQ(stats.slowest_locations[0].total_run_time_us, 1001);
+}
+
+TEST(TaskStatsTest, LooperAccountsRunTimeAndQueueDelay) {
+  auto looper = MessageLooper::PrepareLooper("task_stats_looper");
+  std::promise<void> done;
+  // The second task waits in the queue while the first one runs.
+  looper->PostTask(FROM_HERE, []() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+  looper->PostTask(FROM_HERE, [&done]() {
+    done.set_value();
+  });
+  done.get_future().wait();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  auto stats = looper->GetTaskStats(1);
+  EXPECT_EQ(stats.run_time_us.count, 2);
+  EXPECT_GE(stats.run_time_us.max, 20000);
+  EXPECT_GE(stats.queue_delay_us.max, 15000);
+  EXPECT_EQ(stats.queue.pending_count, 0);
+  ASSERT_EQ(stats.slowest_locations.size(), 1u);
+  EXPECT_GE(stats.slowest_locations[0].max_run_time_us, 20000);
+  EXPECT_EQ(stats.slowest_locations[0].count, 1);
+}
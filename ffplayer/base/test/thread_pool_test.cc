@@ -0,0 +1,136 @@
+//
+// Created by yangbin on 2021/7/17.
+//
+
+#include <thread>
+#include <set>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "base/message_loop.h"
+#include "base/task_runner.h"
+#include "base/thread_pool.h"
+
+using media::base::MessageLooper;
+using media::base::ThreadPool;
+using media::TaskRunner;
+
+typedef testing::MockFunction<void(void)> MockTask;
+
+class ThreadPoolTest : public testing::Test {
+
+ protected:
+
+  std::unique_ptr<ThreadPool> thread_pool_;
+
+  void SetUp() override {
+    thread_pool_ = std::make_unique<ThreadPool>(2, "test_worker");
+  }
+
+  void TearDown() override {
+    thread_pool_ = nullptr;
+  }
+
+  std::shared_ptr<MessageLooper> CreateLooper() {
+    return MessageLooper::PrepareSequencedLooper("test_sequence", std::numeric_limits<int>::max(),
+                                                 thread_pool_.get());
+  }
+
+};
+
+static void WaitSeconds() {
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+}
+
+TEST_F(ThreadPoolTest, PostTask) {
+  auto looper = CreateLooper();
+  TaskRunner task_runner(looper);
+
+  MockTask task;
+  EXPECT_CALL(task, Call()).Times(1).WillOnce([&]() {
+    EXPECT_EQ(MessageLooper::Current(), looper);
+    EXPECT_TRUE(task_runner.BelongsToCurrentThread());
+  });
+  task_runner.PostTask(FROM_HERE, task.AsStdFunction());
+  WaitSeconds();
+  EXPECT_FALSE(task_runner.BelongsToCurrentThread());
+}
+
+TEST_F(ThreadPoolTest, PostDelayedTask) {
+  auto looper = CreateLooper();
+  TaskRunner task_runner(looper);
+
+  MockTask task;
+  EXPECT_CALL(task, Call()).Times(1);
+  auto posted = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point executed;
+  task_runner.PostDelayedTask(FROM_HERE, media::TimeDelta::FromMilliseconds(200), [&]() {
+    executed = std::chrono::steady_clock::now();
+    task.Call();
+  });
+  WaitSeconds();
+  EXPECT_GE(executed - posted, std::chrono::milliseconds(200));
+}
+
+TEST_F(ThreadPoolTest, RemoveTask) {
+  auto looper = CreateLooper();
+  TaskRunner task_runner(looper);
+
+  MockTask task;
+  EXPECT_CALL(task, Call()).Times(0);
+  task_runner.PostDelayedTask(FROM_HERE, media::TimeDelta::FromMilliseconds(100), task.AsStdFunction());
+  task_runner.RemoveAllTasks();
+  WaitSeconds();
+}
+
+TEST_F(ThreadPoolTest, SequenceOrder) {
+  static const int kSequenceCount = 8;
+  static const int kTaskCount = 1000;
+
+  std::vector<std::shared_ptr<MessageLooper>> loopers;
+  std::vector<std::vector<int>> results(kSequenceCount);
+  std::vector<std::unique_ptr<std::atomic_int>> running;
+  std::atomic_bool overlapped(false);
+  std::mutex threads_mutex;
+  std::set<std::thread::id> threads;
+
+  for (int i = 0; i < kSequenceCount; ++i) {
+    loopers.emplace_back(CreateLooper());
+    running.emplace_back(std::make_unique<std::atomic_int>(0));
+  }
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kSequenceCount; ++i) {
+    producers.emplace_back([&, i]() {
+      TaskRunner task_runner(loopers[i]);
+      for (int j = 0; j < kTaskCount; ++j) {
+        task_runner.PostTask(FROM_HERE, [&, i, j]() {
+          if (running[i]->fetch_add(1) != 0) {
+            overlapped = true;
+          }
+          results[i].push_back(j);
+          {
+            std::lock_guard<std::mutex> lock(threads_mutex);
+            threads.insert(std::this_thread::get_id());
+          }
+          running[i]->fetch_sub(1);
+        });
+      }
+      // Keep the runner alive until all tasks are done, so they are not removed.
+      std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  EXPECT_FALSE(overlapped);
+  EXPECT_LE(threads.size(), 2u);
+  for (int i = 0; i < kSequenceCount; ++i) {
+    ASSERT_EQ(results[i].size(), static_cast<size_t>(kTaskCount));
+    for (int j = 0; j < kTaskCount; ++j) {
+      EXPECT_EQ(results[i][j], j);
+    }
+  }
+}
@@ -0,0 +1,134 @@
+//
+// Created by yangbin on 2021/8/2.
+//
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "base/trace_event.h"
+#include "base/utility.h"
+
+using media::TraceLog;
+
+namespace {
+
+int CountOf(const std::string &text, const std::string &pattern) {
+  int count = 0;
+  for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+} // namespace
+
+TEST(TraceEventTest, DisabledRecordsNothing) {
+  TraceLog::SetEnabled(false);
+  TraceLog::Clear();
+  std::thread([]() {
+    TRACE_EVENT("test", "disabled_event");
+    TRACE_COUNTER("test", "disabled_counter", 1);
+  }).join();
+  auto json = TraceLog::DumpJson();
+  EXPECT_EQ(json.find("disabled_event"), std::string::npos);
+  EXPECT_EQ(json.find("disabled_counter"), std::string::npos);
+}
+
+TEST(TraceEventTest, RecordsNestedEventsAndCounters) {
+  TraceLog::SetEnabled(true);
+  TraceLog::Clear();
+  std::thread([]() {
+    media::utility::update_thread_name("trace_test");
+    TRACE_EVENT("test", "outer_event");
+    {
+      TRACE_EVENT("test", "inner_event");
+      TRACE_COUNTER("test", "queue_depth", 42);
+    }
+  }).join();
+  TraceLog::SetEnabled(false);
+
+  auto json = TraceLog::DumpJson();
+  EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+  EXPECT_NE(json.find(R"("args":{"name":"trace_test"})"), std::string::npos);
+  EXPECT_EQ(CountOf(json, R"({"name":"outer_event","cat":"test","ph":"B")"), 1);
+  EXPECT_EQ(CountOf(json, R"({"name":"outer_event","cat":"test","ph":"E")"), 1);
+  EXPECT_EQ(CountOf(json, R"({"name":"inner_event","cat":"test","ph":"B")"), 1);
+  EXPECT_EQ(CountOf(json, R"({"name":"inner_event","cat":"test","ph":"E")"), 1);
+  EXPECT_NE(json.find(R"("args":{"queue_depth":42})"), std::string::npos);
+  EXPECT_NE(json.find("trace_event_test.cc:"), std::string::npos);
+  EXPECT_LT(json.find("\"inner_event\",\"cat\":\"test\",\"ph\":\"E\""),
+            json.find("\"outer_event\",\"cat\":\"test\",\"ph\":\"E\""));
+
+  TraceLog::Clear();
+  EXPECT_EQ(TraceLog::DumpJson().find("outer_event"), std::string::npos);
+}
+
+TEST(TraceEventTest, RingKeepsNewestEvents) {
+  TraceLog::SetBufferCapacity(16);
+  TraceLog::SetEnabled(true);
+  TraceLog::Clear();
+  std::thread([]() {
+    for (int i = 0; i < 100; ++i) {
+      TRACE_COUNTER("test", "ring_counter", i);
+    }
+    // Its begin event is dropped by the ring, so the end event must be too.
+    TRACE_EVENT("test", "ring_event");
+    for (int i = 100; i < 120; ++i) {
+      TRACE_COUNTER("test", "ring_counter", i);
+    }
+  }).join();
+  TraceLog::SetEnabled(false);
+  TraceLog::SetBufferCapacity(8192);
+
+  auto json = TraceLog::DumpJson();
+  EXPECT_EQ(CountOf(json, "\"ring_counter\":"), 15);
+  EXPECT_NE(json.find("\"ring_counter\":119}"), std::string::npos);
+  EXPECT_NE(json.find("\"ring_counter\":105}"), std::string::npos);
+  EXPECT_EQ(json.find("\"ring_counter\":104}"), std::string::npos);
+  EXPECT_EQ(json.find("ring_event"), std::string::npos);
+}
+
+TEST(TraceEventTest, FreesBuffersOfExitedThreads) {
+  TraceLog::SetEnabled(true);
+  for (int i = 0; i < 100; ++i) {
+    std::thread([]() {
+      TRACE_COUNTER("test", "exited_counter", 1);
+    }).join();
+  }
+  TraceLog::SetEnabled(false);
+  EXPECT_LE(TraceLog::buffer_count_for_testing(), 40u);
+  EXPECT_GE(CountOf(TraceLog::DumpJson(), "\"exited_counter\":"), 32);
+}
+
+TEST(TraceEventTest, DumpsWhileThreadsWrap) {
+  TraceLog::SetBufferCapacity(64);
+  TraceLog::SetEnabled(true);
+  TraceLog::Clear();
+  std::atomic_bool stop(false);
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 4; ++i) {
+    writers.emplace_back([&]() {
+      for (int64_t value = 0; !stop.load(); ++value) {
+        TRACE_EVENT("test", "wrap_event");
+        TRACE_COUNTER("test", "wrap_counter", value);
+      }
+    });
+  }
+  for (int i = 0; i < 100; ++i) {
+    auto json = TraceLog::DumpJson();
+    // Slots written during the copy are dropped, never torn.
+    EXPECT_EQ(CountOf(json, R"("name":"wrap_event","cat":"test","ph":"C")"), 0);
+    EXPECT_EQ(CountOf(json, R"("name":"wrap_counter","cat":"test","ph":"B")"), 0);
+    EXPECT_EQ(CountOf(json, R"("name":"")"), 0);
+  }
+  stop = true;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  TraceLog::SetEnabled(false);
+  TraceLog::SetBufferCapacity(8192);
+}
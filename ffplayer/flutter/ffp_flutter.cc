@@ -10,6 +10,7 @@
 #include "android/log.h"
 #include "oboe_audio_renderer_sink.h"
 #elif defined(_MEDIA_LINUX)
+#include "null_video_renderer_sink.h"
 #define _MEDIA_AUDIO_USE_SDL
 #elif defined(_MEDIA_DARWIN)
 #include "macos_audio_renderer_sink.h"
@@ -20,6 +21,7 @@
 #include "external_video_renderer_sink.h"
 
 #include "ffp_flutter.h"
+#include "base/trace_event.h"
 #include "dart/dart_api_dl.h"
 
 // Use SDL2 to render audio.
@@ -48,6 +50,25 @@ void ffplayer_seek_to_position(CPlayer *player, double position) {
   player->Seek(TimeDelta::FromSecondsD(position));
 }
 
+void ffplayer_seek_to_position_with_mode(CPlayer *player, double position, int mode) {
+  CHECK_VALUE(player);
+  if (mode < 0 || mode > static_cast<int>(SeekMode::kPreviousSync)) {
+    DLOG(WARNING) << "invalid seek mode: " << mode;
+    mode = static_cast<int>(SeekMode::kAccurate);
+  }
+  player->Seek(TimeDelta::FromSecondsD(position), static_cast<SeekMode>(mode));
+}
+
+void ffplayer_set_scrubbing(CPlayer *player, bool scrubbing) {
+  CHECK_VALUE(player);
+  player->SetScrubbing(scrubbing);
+}
+
+void ffplayer_set_display_size(CPlayer *player, int width, int height) {
+  CHECK_VALUE(player);
+  player->SetDisplaySize(width, height);
+}
+
 double ffplayer_get_current_position(CPlayer *player) {
   CHECK_VALUE_WITH_RETURN(player, 0);
   return player->GetCurrentPosition().InSecondsF();
@@ -162,7 +183,7 @@ CPlayer *ffp_create_player(PlayerConfiguration *config) {
 #endif
   auto player = std::make_shared<MediaPlayer>(
       std::move(video_render), std::move(audio_render),
-      TaskRunner(MessageLooper::PrepareLooper("media_player")));
+      TaskRunner(MessageLooper::PrepareSequencedLooper("media_player")));
   player->SetPlayWhenReady(true);
   av_log(nullptr, AV_LOG_INFO, "malloc player, %p\n", player.get());
   player->start_configuration = *config;
@@ -178,6 +199,11 @@ double ffp_get_video_aspect_ratio(CPlayer *player) {
   return 16.0 / 9;
 }
 
+int ffp_get_stats(CPlayer *player, int64_t *values, int count) {
+  CHECK_VALUE_WITH_RETURN(player, 0);
+  return player->GetStats(values, count);
+}
+
 // TODO rename this
 int64_t ffp_attach_video_render_flutter(CPlayer *player) {
   auto *video_render_sink = dynamic_cast<media::ExternalVideoRendererSink *>(player->GetVideoRenderSink());
@@ -207,3 +233,14 @@ void ffp_set_message_callback_dart(CPlayer *player, Dart_Port_DL send_port) {
 void ffp_detach_video_render_flutter(CPlayer *player) {
   //  DO NOTHING. since we do not support remove textures dynamic.
 }
+
+void ffp_set_trace_enabled(bool enabled) {
+  media::TraceLog::SetEnabled(enabled);
+}
+
+int ffp_dump_trace(const char *path) {
+  if (!path) {
+    return -1;
+  }
+  return media::TraceLog::DumpToFile(path) ? 0 : -1;
+}
@@ -37,6 +37,24 @@ FFPLAYER_EXPORT double ffplayer_get_current_position(CPlayer *player);
 
 FFPLAYER_EXPORT void ffplayer_seek_to_position(CPlayer *player, double position);
 
+/**
+ * @param mode 0: nearest keyframe, 1: accurate, 2: previous keyframe.
+ */
+FFPLAYER_EXPORT void ffplayer_seek_to_position_with_mode(CPlayer *player, double position, int mode);
+
+/**
+ * Call with true when the user starts dragging the progress bar, with false
+ * when the drag ends. Seeks made meanwhile show keyframes only.
+ */
+FFPLAYER_EXPORT void ffplayer_set_scrubbing(CPlayer *player, bool scrubbing);
+
+/**
+ * Size the video is shown at, in physical pixels, 0 for the size of the video.
+ * Frames are converted at no more than that. Set it before the player opens
+ * the video, e.g. for a thumbnail, to decode at a lower resolution as well.
+ */
+FFPLAYER_EXPORT void ffplayer_set_display_size(CPlayer *player, int width, int height);
+
 FFPLAYER_EXPORT double ffplayer_get_duration(CPlayer *player);
 
 /**
@@ -53,6 +71,15 @@ FFPLAYER_EXPORT int ffp_get_state(CPlayer *player);
  */
 FFPLAYER_EXPORT double ffp_get_video_aspect_ratio(CPlayer *player);
 
+/**
+ * Fill @param values with the current metrics of the player, indexed by PlayerStat in ffplayer.h.
+ * Durations are in microseconds. Each histogram takes PLAYER_STAT_HISTOGRAM_FIELDS values.
+ *
+ * @param count the size of values, kStatCount to get all of them.
+ * @return the count of values filled, 0 if player invalid.
+ */
+FFPLAYER_EXPORT int ffp_get_stats(CPlayer *player, int64_t *values, int count);
+
 
 /**
  * Set Message callback for dart. Post message to dart isolate by @param send_port.
@@ -68,4 +95,17 @@ FFPLAYER_EXPORT int64_t ffp_attach_video_render_flutter(CPlayer *player);
 
 FFPLAYER_EXPORT void ffp_detach_video_render_flutter(CPlayer *player);
 
+/**
+ * Start or stop recording trace events of all players, see base/trace_event.h.
+ */
+FFPLAYER_EXPORT void ffp_set_trace_enabled(bool enabled);
+
+/**
+ * Write the recorded trace events to @param path as Chrome trace event JSON,
+ * which can be opened in chrome://tracing or Perfetto.
+ *
+ * @return 0 on success, -1 if path can not be written.
+ */
+FFPLAYER_EXPORT int ffp_dump_trace(const char *path);
+
 #endif // FF_PLAYER_FLUTTER_H
@@ -0,0 +1,136 @@
+//
+// Created by yangbin on 2021/7/23.
+//
+// Open and seek latency of a slow DataSource, read directly and through
+// CachingDataSource. Reads are issued in 32 KB chunks like AVIO does, with a
+// short pause per chunk standing in for demuxing.
+//
+// usage: caching_data_source_benchmark [latency_ms] [bandwidth_mb_per_sec]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "caching_data_source.h"
+
+using namespace media;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int64_t kFileSize = 256 * 1024 * 1024;
+const int kChunkSize = 32 * 1024;
+const int kBitrate = 8 * 1000 * 1000;
+const auto kDemuxCost = std::chrono::microseconds(200);
+
+// A local stand-in for a network or slow disk: every read pays a fixed
+// latency plus its size over the bandwidth.
+class ThrottledDataSource : public DataSource {
+
+ public:
+
+  ThrottledDataSource(double latency_ms, double bandwidth_mb) : latency_ms_(latency_ms), bandwidth_mb_(bandwidth_mb) {}
+
+  void Read(int64_t position, int size, uint8_t *data, DataSource::ReadCB read_cb) override {
+    position = std::min(position, kFileSize);
+    auto count = static_cast<int>(std::min<int64_t>(size, kFileSize - position));
+    auto cost_ms = latency_ms_ + count / (bandwidth_mb_ * 1024 * 1024) * 1000;
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(cost_ms));
+    memset(data, static_cast<int>(position & 0xff), static_cast<size_t>(count));
+    read_cb(count);
+  }
+
+  void Stop() override {}
+  void Abort() override {}
+
+  bool GetSize(int64_t *size_out) override {
+    *size_out = kFileSize;
+    return true;
+  }
+
+  bool IsStreaming() override { return false; }
+  void SetBitrate(int) override {}
+
+ private:
+
+  double latency_ms_;
+  double bandwidth_mb_;
+
+};
+
+// Sequential AVIO style reads of |size| bytes from |position|.
+void ReadRange(DataSource *source, int64_t position, int64_t size) {
+  static std::vector<uint8_t> buffer(kChunkSize);
+  for (int64_t offset = 0; offset < size; offset += kChunkSize) {
+    source->Read(position + offset, kChunkSize, buffer.data(), [](int) {});
+    std::this_thread::sleep_for(kDemuxCost);
+  }
+}
+
+double MillisecondsSince(Clock::time_point begin) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// Header, index at the end of the file, then the first seconds of media.
+double Open(DataSource *source) {
+  auto begin = Clock::now();
+  ReadRange(source, 0, 64 * 1024);
+  ReadRange(source, kFileSize - 1024 * 1024, 1024 * 1024);
+  ReadRange(source, 64 * 1024, 2 * 1024 * 1024);
+  return MillisecondsSince(begin);
+}
+
+// Time until the first chunk after a seek, and until one second of media.
+void Seek(DataSource *source, int64_t position, double *first_read_ms, double *second_ms) {
+  auto begin = Clock::now();
+  ReadRange(source, position, kChunkSize);
+  *first_read_ms = MillisecondsSince(begin);
+  ReadRange(source, position + kChunkSize, kBitrate / 8 - kChunkSize);
+  *second_ms = MillisecondsSince(begin);
+}
+
+void Run(const char *name, double latency_ms, double bandwidth_mb, bool cached) {
+  std::unique_ptr<DataSource> source = std::make_unique<ThrottledDataSource>(latency_ms, bandwidth_mb);
+  if (cached) {
+    source = std::make_unique<CachingDataSource>(std::move(source));
+    source->SetBitrate(kBitrate);
+  }
+
+  auto open_ms = Open(source.get());
+
+  const int kSeeks = 10;
+  std::mt19937 random(7);
+  double first_read_total = 0;
+  double second_total = 0;
+  for (int i = 0; i < kSeeks; ++i) {
+    auto position = static_cast<int64_t>(random() % (kFileSize / 2));
+    double first_read_ms, second_ms;
+    Seek(source.get(), position, &first_read_ms, &second_ms);
+    first_read_total += first_read_ms;
+    second_total += second_ms;
+  }
+
+  printf("%-8s open: %8.1f ms   seek first read: %7.2f ms   seek + 1s of media: %8.1f ms\n",
+         name, open_ms, first_read_total / kSeeks, second_total / kSeeks);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  double latency_ms = argc > 1 ? atof(argv[1]) : 2;
+  double bandwidth_mb = argc > 2 ? atof(argv[2]) : 50;
+  printf("latency %.1f ms, bandwidth %.1f MB/s, bitrate %d kbps\n", latency_ms, bandwidth_mb, kBitrate / 1000);
+
+  Run("direct", latency_ms, bandwidth_mb, false);
+  Run("cached", latency_ms, bandwidth_mb, true);
+  return 0;
+}
@@ -0,0 +1,110 @@
+//
+// Created by yangbin on 2021/7/28.
+//
+// ms per frame of the software conversion to BGRA at 1080p and 4K, per source
+// format:
+//
+//   bicubic         sws_scale with SWS_BICUBIC on one thread, as before.
+//   swscale         FrameConverter without the yuv kernels, one thread.
+//   swscale-sliced  FrameConverter without the yuv kernels, a thread per core.
+//   kernel          FrameConverter, one thread.
+//   kernel-sliced   FrameConverter, a thread per core.
+//
+// The kernels only cover I420 and NV12, other formats go through swscale.
+//
+// usage: frame_converter_benchmark [frames]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "ffmpeg_deleters.h"
+#include "frame_converter.h"
+
+extern "C" {
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+}
+
+using namespace media;
+
+namespace {
+
+std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> CreateFrame(int width, int height, AVPixelFormat format) {
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->width = width;
+  frame->height = height;
+  frame->format = format;
+  if (av_frame_get_buffer(frame.get(), 0) < 0) {
+    return nullptr;
+  }
+  for (int i = 0; i < 4 && frame->buf[i]; ++i) {
+    for (int j = 0; j < frame->buf[i]->size; ++j) {
+      frame->buf[i]->data[j] = uint8_t(j * 7 + i * 31);
+    }
+  }
+  return frame;
+}
+
+template<typename Convert>
+double MeasureMs(int frames, Convert convert) {
+  // Warm up, allocates contexts and workers.
+  convert();
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; ++i) {
+    convert();
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / frames;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int frames = argc > 1 ? atoi(argv[1]) : 30;
+
+  struct Size {
+    const char *name;
+    int width;
+    int height;
+  };
+
+  printf("%-5s %-10s %9s %9s %15s %9s %14s  (ms/frame)\n",
+         "size", "format", "bicubic", "swscale", "swscale-sliced", "kernel", "kernel-sliced");
+  for (auto size : {Size{"1080p", 1920, 1080}, Size{"4k", 3840, 2160}}) {
+    std::vector<uint8_t> output(size_t(size.width) * size.height * 4);
+    uint8_t *dest[4] = {output.data()};
+    int dest_stride[4] = {size.width * 4};
+
+    for (auto format : {AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12, AV_PIX_FMT_YUV422P, AV_PIX_FMT_P010LE}) {
+      auto frame = CreateFrame(size.width, size.height, format);
+      if (!frame) {
+        fprintf(stderr, "can not allocate %s frame\n", av_get_pix_fmt_name(format));
+        continue;
+      }
+
+      SwsContext *bicubic = sws_getContext(size.width, size.height, format, size.width, size.height,
+                                           AV_PIX_FMT_BGRA, SWS_BICUBIC, nullptr, nullptr, nullptr);
+      double bicubic_ms = MeasureMs(frames, [&]() {
+        sws_scale(bicubic, frame->data, frame->linesize, 0, size.height, dest, dest_stride);
+      });
+      sws_freeContext(bicubic);
+
+      double results[4];
+      int index = 0;
+      for (bool use_yuv_kernels : {false, true}) {
+        for (int threads : {1, 0}) {
+          FrameConverter converter(threads, use_yuv_kernels);
+          results[index++] = MeasureMs(frames, [&]() {
+            converter.Convert(frame.get(), AV_PIX_FMT_BGRA, size.width, size.height, dest, dest_stride);
+          });
+        }
+      }
+      printf("%-5s %-10s %9.2f %9.2f %15.2f %9.2f %14.2f\n", size.name, av_get_pix_fmt_name(format),
+             bicubic_ms, results[0], results[1], results[2], results[3]);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,277 @@
+//
+// Created by yangbin on 2021/7/29.
+//
+// Headless throughput of a whole MediaPlayer: |file| is opened through the
+// DataSource path MediaPlayer picks for local files, and played with a
+// NullAudioRendererSink and a NullVideoRendererSink on a free running clock,
+// so that every stage runs as fast as it can and nothing is dropped for being
+// late.
+//
+// The result is printed to stdout as JSON: read MB/s, decode fps, the latency
+// percentiles PlayerStat keeps for each stage (decode, render callback, task
+// queue delay and run time of each looper), the startup latency, the peak RSS
+// and the count of C++ allocations. Allocations of FFmpeg (av_malloc) are not
+// counted.
+//
+// Allocations per presented video frame are also reported once the pipeline
+// is warm, after its first kWarmUpFrames frames. They are counted for the
+// whole process. If |max_steady_allocations_per_frame| is given and it is
+// exceeded, media_bench exits with 2, to be used as an allocation check.
+//
+// usage: media_bench file [max_steady_allocations_per_frame]
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <sys/stat.h>
+#endif
+
+#include "base/message_loop.h"
+
+#include "ffplayer.h"
+#include "media_player.h"
+#include "null_audio_renderer_sink.h"
+#include "null_video_renderer_sink.h"
+#include "time_source.h"
+
+using namespace media;
+
+namespace {
+
+std::atomic<int64_t> allocation_count{0};
+std::atomic<int64_t> allocation_bytes{0};
+
+} // namespace
+
+void *operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocation_bytes.fetch_add(int64_t(size), std::memory_order_relaxed);
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock SteadyClock;
+
+// Playback is over once nothing was decoded or presented for this long, the
+// player does not report the end of stream.
+const int kIdleMilliseconds = 500;
+
+const int kPollMilliseconds = 20;
+
+// Frames before the pools of the pipeline are expected to be warm.
+const int kWarmUpFrames = 64;
+
+double SecondsSince(SteadyClock::time_point begin) {
+  return std::chrono::duration<double>(SteadyClock::now() - begin).count();
+}
+
+struct Allocations {
+  int64_t count = 0;
+  int64_t bytes = 0;
+
+  static Allocations Now() {
+    Allocations allocations;
+    allocations.count = allocation_count.load();
+    allocations.bytes = allocation_bytes.load();
+    return allocations;
+  }
+
+  Allocations Since(const Allocations &begin) const {
+    Allocations allocations;
+    allocations.count = count - begin.count;
+    allocations.bytes = bytes - begin.bytes;
+    return allocations;
+  }
+};
+
+std::string EscapeJson(const std::string &value) {
+  std::string escaped;
+  for (auto c : value) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+int64_t FileSize(const std::string &path) {
+#if defined(_WIN32)
+  return 0;
+#else
+  struct stat st{};
+  return stat(path.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_size) : 0;
+#endif
+}
+
+int64_t PeakRssKilobytes() {
+#if defined(_WIN32)
+  return 0;
+#else
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+  return ru.ru_maxrss / 1024;
+#else
+  return ru.ru_maxrss;
+#endif
+#endif
+}
+
+// The PLAYER_STAT_HISTOGRAM_FIELDS values from |index|, in milliseconds.
+std::string HistogramToJson(const int64_t *stats, int index) {
+  char json[160];
+  snprintf(json, sizeof(json), R"({"count": %lld, "p50": %.3f, "p90": %.3f, "p99": %.3f, "max": %.3f})",
+           static_cast<long long>(stats[index]), stats[index + 1] / 1000.0, stats[index + 2] / 1000.0,
+           stats[index + 3] / 1000.0, stats[index + 4] / 1000.0);
+  return json;
+}
+
+int64_t Progress(const int64_t *stats) {
+  return stats[kStatVideoPacketsDemuxed] + stats[kStatAudioPacketsDemuxed] + stats[kStatVideoFramesDecoded]
+      + stats[kStatAudioBuffersDecoded] + stats[kStatVideoFramesRendered];
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: media_bench file [max_steady_allocations_per_frame]\n");
+    return 1;
+  }
+  std::string path = argv[1];
+  double max_steady_allocations_per_frame = argc > 2 ? atof(argv[2]) : -1;
+
+  MediaPlayer::GlobalInit();
+  auto video_sink = std::make_unique<NullVideoRendererSink>();
+  auto *video_sink_ptr = video_sink.get();
+  // Pulls the next buffer as soon as the previous one is rendered.
+  auto audio_sink = std::make_shared<NullAudioRendererSink>(0);
+  auto player = std::make_shared<MediaPlayer>(std::move(video_sink), audio_sink,
+                                              TaskRunner(MessageLooper::PrepareLooper("media_bench")));
+  player->SetTimeSource(std::make_shared<FreeRunningTimeSource>());
+
+  auto allocations_begin = Allocations::Now();
+  auto begin = SteadyClock::now();
+  player->SetPlayWhenReady(true);
+  if (player->OpenDataSource(path.c_str()) < 0) {
+    fprintf(stderr, "can not open %s\n", path.c_str());
+    return 1;
+  }
+
+  int64_t stats[kStatCount];
+  double startup_seconds = -1;
+  double last_progress_seconds = 0;
+  int64_t last_progress = -1;
+  Allocations warm_begin;
+  int64_t warm_begin_frames = -1;
+  Allocations warm_allocations;
+  int64_t warm_frames = 0;
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPollMilliseconds));
+    auto now = SecondsSince(begin);
+    player->GetStats(stats, kStatCount);
+    auto frames = stats[kStatVideoFramesRendered];
+    if (startup_seconds < 0 && (frames > 0 || audio_sink->rendered_frames() > audio_sink->underrun_frames())) {
+      startup_seconds = now;
+    }
+    if (warm_begin_frames < 0 && frames >= kWarmUpFrames) {
+      warm_begin = Allocations::Now();
+      warm_begin_frames = frames;
+    } else if (warm_begin_frames >= 0 && frames > warm_begin_frames) {
+      warm_allocations = Allocations::Now().Since(warm_begin);
+      warm_frames = frames - warm_begin_frames;
+    }
+    auto progress = Progress(stats);
+    if (progress != last_progress) {
+      last_progress = progress;
+      last_progress_seconds = now;
+    } else if ((now - last_progress_seconds) * 1000 >= kIdleMilliseconds) {
+      break;
+    }
+  }
+  player->SetPlayWhenReady(false);
+  // Up to the last progress, without the idle wait.
+  auto seconds = last_progress_seconds;
+  auto allocations = Allocations::Now().Since(allocations_begin);
+  auto file_bytes = FileSize(path);
+  auto presented_frames = video_sink_ptr->presented_frames().size();
+  auto steady_allocations_per_frame = warm_frames > 0 ? double(warm_allocations.count) / double(warm_frames) : 0;
+
+  printf("{\n");
+  printf(R"(  "file": "%s",)" "\n", EscapeJson(path).c_str());
+  printf(R"(  "duration": %.3f,)" "\n", player->GetDuration());
+  printf(R"(  "seconds": %.3f,)" "\n", seconds);
+  printf(R"(  "startup_seconds": %.3f,)" "\n", startup_seconds);
+  printf(R"(  "read": {"bytes": %lld, "mb_per_second": %.2f},)" "\n",
+         static_cast<long long>(file_bytes), seconds > 0 ? double(file_bytes) / 1e6 / seconds : 0);
+  printf(R"(  "demux": {"video_packets": %lld, "audio_packets": %lld, "task_queue_delay_ms": %s, )"
+         R"("task_run_time_ms": %s},)" "\n",
+         static_cast<long long>(stats[kStatVideoPacketsDemuxed]),
+         static_cast<long long>(stats[kStatAudioPacketsDemuxed]),
+         HistogramToJson(stats, kStatDemuxerTaskQueueDelay).c_str(),
+         HistogramToJson(stats, kStatDemuxerTaskRunTime).c_str());
+  printf(R"(  "video": {"decoded": %lld, "presented": %lld, "dropped": %lld, "fps": %.2f, "decode_ms": %s, )"
+         R"("render_callback_ms": %s, "decoder_task_queue_delay_ms": %s},)" "\n",
+         static_cast<long long>(stats[kStatVideoFramesDecoded]), static_cast<long long>(presented_frames),
+         static_cast<long long>(stats[kStatVideoFramesDropped]),
+         seconds > 0 ? double(stats[kStatVideoFramesDecoded]) / seconds : 0,
+         HistogramToJson(stats, kStatVideoDecodeTime).c_str(),
+         HistogramToJson(stats, kStatVideoRenderCallbackTime).c_str(),
+         HistogramToJson(stats, kStatVideoDecoderTaskQueueDelay).c_str());
+  printf(R"(  "audio": {"decoded": %lld, "played_seconds": %.3f, "realtime_factor": %.2f, "decode_ms": %s, )"
+         R"("render_callback_ms": %s, "decoder_task_queue_delay_ms": %s},)" "\n",
+         static_cast<long long>(stats[kStatAudioBuffersDecoded]), audio_sink->played_seconds(),
+         seconds > 0 ? audio_sink->played_seconds() / seconds : 0,
+         HistogramToJson(stats, kStatAudioDecodeTime).c_str(),
+         HistogramToJson(stats, kStatAudioRenderCallbackTime).c_str(),
+         HistogramToJson(stats, kStatAudioDecoderTaskQueueDelay).c_str());
+  printf(R"(  "player_task_queue_delay_ms": %s,)" "\n", HistogramToJson(stats, kStatPlayerTaskQueueDelay).c_str());
+  printf(R"(  "allocations": %lld, "allocated_bytes": %lld, "steady_allocations_per_frame": %.2f,)" "\n",
+         static_cast<long long>(allocations.count), static_cast<long long>(allocations.bytes),
+         steady_allocations_per_frame);
+  printf(R"(  "peak_rss_kb": %lld)" "\n", static_cast<long long>(PeakRssKilobytes()));
+  printf("}\n");
+
+  if (max_steady_allocations_per_frame >= 0 && steady_allocations_per_frame > max_steady_allocations_per_frame) {
+    fprintf(stderr, "%.2f allocations per video frame, expected at most %.2f\n",
+            steady_allocations_per_frame, max_steady_allocations_per_frame);
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,306 @@
+//
+// Created by yangbin on 2021/7/24.
+//
+// Seek latency of Demuxer for every SeekMode: the time from SeekTo until the
+// first frame which would be displayed is decoded. For accurate seeks that is
+// the first frame at the target, otherwise the first frame decoded.
+//
+// usage: seek_benchmark [file]
+//
+// Without |file|, a 20 second 720p MPEG-4 clip with a keyframe every 2 seconds
+// is encoded into a temporary Matroska file.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind_to_current_loop.h"
+#include "base/message_loop.h"
+
+#include "demuxer.h"
+#include "ffmpeg_deleters.h"
+#include "video_decoder.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+}
+
+using namespace media;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const char *kSynthesizedPath = "/tmp/seek_benchmark.mkv";
+
+class BenchmarkDemuxerHost : public DemuxerHost {
+
+ public:
+
+  void SetDuration(double duration) override {
+    duration_ = duration;
+  }
+
+  void OnDemuxerError(PipelineStatus error) override {
+    fprintf(stderr, "demuxer error: %d\n", error);
+  }
+
+  double duration_ = 0;
+
+};
+
+bool SynthesizeClip(const char *path) {
+  auto *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+  if (!codec) {
+    fprintf(stderr, "no mpeg4 encoder available\n");
+    return false;
+  }
+
+  AVFormatContext *output = nullptr;
+  if (avformat_alloc_output_context2(&output, nullptr, "matroska", path) < 0) {
+    fprintf(stderr, "no matroska muxer available\n");
+    return false;
+  }
+  std::unique_ptr<AVFormatContext, void (*)(AVFormatContext *)> scoped_output(
+      output, [](AVFormatContext *context) {
+        avio_closep(&context->pb);
+        avformat_free_context(context);
+      });
+
+  std::unique_ptr<AVCodecContext, AVCodecContextDeleter> encoder(avcodec_alloc_context3(codec));
+  encoder->width = 1280;
+  encoder->height = 720;
+  encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+  encoder->time_base = AVRational{1, 25};
+  encoder->framerate = AVRational{25, 1};
+  encoder->gop_size = 50;
+  encoder->max_b_frames = 0;
+  encoder->bit_rate = 4000000;
+  if (output->oformat->flags & AVFMT_GLOBALHEADER) {
+    encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
+  if (avcodec_open2(encoder.get(), codec, nullptr) < 0) {
+    return false;
+  }
+
+  auto *stream = avformat_new_stream(output, nullptr);
+  avcodec_parameters_from_context(stream->codecpar, encoder.get());
+  stream->time_base = encoder->time_base;
+  if (avio_open(&output->pb, path, AVIO_FLAG_WRITE) < 0 || avformat_write_header(output, nullptr) < 0) {
+    fprintf(stderr, "can not write %s\n", path);
+    return false;
+  }
+
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->format = encoder->pix_fmt;
+  frame->width = encoder->width;
+  frame->height = encoder->height;
+  av_frame_get_buffer(frame.get(), 0);
+
+  AVPacket packet;
+  av_init_packet(&packet);
+  auto drain = [&]() {
+    while (avcodec_receive_packet(encoder.get(), &packet) >= 0) {
+      av_packet_rescale_ts(&packet, encoder->time_base, stream->time_base);
+      packet.stream_index = stream->index;
+      av_interleaved_write_frame(output, &packet);
+    }
+  };
+
+  for (int i = 0; i < 20 * 25; ++i) {
+    av_frame_make_writable(frame.get());
+    for (int y = 0; y < frame->height; ++y) {
+      for (int x = 0; x < frame->width; ++x) {
+        frame->data[0][y * frame->linesize[0] + x] = static_cast<uint8_t>(x + y + i * 3);
+      }
+    }
+    for (int y = 0; y < frame->height / 2; ++y) {
+      for (int x = 0; x < frame->width / 2; ++x) {
+        frame->data[1][y * frame->linesize[1] + x] = static_cast<uint8_t>(128 + y + i * 2);
+        frame->data[2][y * frame->linesize[2] + x] = static_cast<uint8_t>(64 + x + i * 5);
+      }
+    }
+    frame->pts = i;
+    avcodec_send_frame(encoder.get(), frame.get());
+    drain();
+  }
+  avcodec_send_frame(encoder.get(), nullptr);
+  drain();
+  return av_write_trailer(output) >= 0;
+}
+
+const char *SeekModeName(SeekMode mode) {
+  switch (mode) {
+    case SeekMode::kFast:return "fast";
+    case SeekMode::kAccurate:return "accurate";
+    case SeekMode::kPreviousSync:return "previous";
+  }
+  return "unknown";
+}
+
+struct SeekResult {
+  double milliseconds = 0;
+  double frame_pts = NAN;
+  int decoded_frames = 0;
+};
+
+// Runs on |looper|: reads and decodes video after the seek until the first
+// displayable frame.
+class SeekSession : public std::enable_shared_from_this<SeekSession> {
+
+ public:
+
+  SeekSession(Demuxer *demuxer, DemuxerStream *stream, SeekMode mode, double target)
+      : demuxer_(demuxer), stream_(stream), mode_(mode), target_(target) {}
+
+  std::future<SeekResult> Start() {
+    decoder_ = std::make_unique<VideoDecoder>();
+    auto self = shared_from_this();
+    decoder_->Initialize(stream_->video_decode_config(), nullptr, [self](std::shared_ptr<VideoFrame> frame) {
+      self->OnFrame(std::move(frame));
+    });
+    if (mode_ == SeekMode::kAccurate) {
+      // Like VideoRenderer does after an accurate seek.
+      decoder_->SetTargetTimestamp(target_);
+    }
+
+    begin_ = Clock::now();
+    demuxer_->SeekTo(TimeDelta::FromSecondsD(target_), mode_, BindToCurrentLoop(std::function<void(bool)>(
+        [self](bool succeed) {
+          if (!succeed) {
+            self->Finish(NAN);
+            return;
+          }
+          self->ReadNext();
+        })));
+    return promise_.get_future();
+  }
+
+ private:
+
+  Demuxer *demuxer_;
+  DemuxerStream *stream_;
+  SeekMode mode_;
+  double target_;
+
+  std::unique_ptr<VideoDecoder> decoder_;
+  Clock::time_point begin_;
+  SeekResult result_;
+  bool finished_ = false;
+  std::promise<SeekResult> promise_;
+
+  void ReadNext() {
+    auto self = shared_from_this();
+    stream_->Read([self](std::shared_ptr<DecoderBuffer> buffer) {
+      if (buffer->end_of_stream()) {
+        self->Finish(NAN);
+        return;
+      }
+      self->decoder_->Decode(std::move(buffer));
+      if (!self->finished_) {
+        self->ReadNext();
+      }
+    });
+  }
+
+  void OnFrame(std::shared_ptr<VideoFrame> frame) {
+    if (finished_ || frame->IsEmpty()) {
+      return;
+    }
+    result_.decoded_frames++;
+    // Same condition as VideoRenderer uses to drop frames before the target.
+    if (mode_ == SeekMode::kAccurate && frame->pts() < target_ && frame->pts() + frame->duration() <= target_) {
+      return;
+    }
+    Finish(frame->pts());
+  }
+
+  void Finish(double pts) {
+    if (finished_) {
+      return;
+    }
+    finished_ = true;
+    result_.milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - begin_).count();
+    result_.frame_pts = pts;
+    promise_.set_value(result_);
+  }
+
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string path = argc > 1 ? argv[1] : kSynthesizedPath;
+  if (argc <= 1 && !SynthesizeClip(kSynthesizedPath)) {
+    return 1;
+  }
+
+  auto looper = MessageLooper::PrepareLooper("seek_benchmark");
+  auto demuxer = std::make_shared<Demuxer>(TaskRunner(MessageLooper::PrepareLooper("demuxer")), path,
+                                           [](std::unique_ptr<MediaTracks>) {});
+  BenchmarkDemuxerHost host;
+
+  std::promise<int> initialized;
+  looper->PostTask(FROM_HERE, [&]() {
+    demuxer->Initialize(&host, [&initialized](int status) { initialized.set_value(status); });
+  });
+  if (initialized.get_future().get() != 0) {
+    fprintf(stderr, "can not open %s\n", path.c_str());
+    return 1;
+  }
+  auto *stream = demuxer->GetFirstStream(DemuxerStream::Video);
+  if (!stream) {
+    fprintf(stderr, "no video stream in %s\n", path.c_str());
+    return 1;
+  }
+  printf("%s duration %.1f s, %zu keyframes indexed\n", path.c_str(), host.duration_, stream->keyframe_index().size());
+
+  std::vector<double> targets;
+  for (double fraction : {0.13, 0.37, 0.61, 0.89, 0.25, 0.52, 0.78}) {
+    targets.push_back(host.duration_ * fraction);
+  }
+
+  for (auto mode : {SeekMode::kFast, SeekMode::kAccurate, SeekMode::kPreviousSync}) {
+    double total_ms = 0, max_ms = 0, total_distance = 0;
+    int total_frames = 0, seeks = 0;
+    for (auto target : targets) {
+      auto session = std::make_shared<SeekSession>(demuxer.get(), stream, mode, target);
+      std::future<SeekResult> future;
+      std::promise<void> started;
+      looper->PostTask(FROM_HERE, [&]() {
+        future = session->Start();
+        started.set_value();
+      });
+      started.get_future().wait();
+      auto result = future.get();
+      if (std::isnan(result.frame_pts)) {
+        fprintf(stderr, "%s seek to %.2f failed\n", SeekModeName(mode), target);
+        continue;
+      }
+      seeks++;
+      total_ms += result.milliseconds;
+      max_ms = std::max(max_ms, result.milliseconds);
+      total_distance += std::abs(result.frame_pts - target);
+      total_frames += result.decoded_frames;
+    }
+    if (seeks == 0) {
+      continue;
+    }
+    printf("%-8s first frame avg %7.2f ms  max %7.2f ms  decoded frames %5.1f  distance to target %6.3f s\n",
+           SeekModeName(mode), total_ms / seeks, max_ms, double(total_frames) / seeks, total_distance / seeks);
+  }
+
+  std::promise<void> stopped;
+  demuxer->Stop([&stopped]() { stopped.set_value(); });
+  stopped.get_future().wait();
+  if (argc <= 1) {
+    remove(kSynthesizedPath);
+  }
+  return 0;
+}
@@ -0,0 +1,204 @@
+//
+// Created by yangbin on 2021/7/27.
+//
+// CPU time per frame of TextureUploader for 1080p and 4K frames, for each way
+// a texture can take them:
+//
+//   bgra       the texture only takes BGRA, frames are converted by FrameConverter.
+//   copy       the texture takes the decoded format, planes are copied.
+//   reference  the texture takes the decoded planes by reference.
+//
+// Each is run for a full size display and for a 320x180 thumbnail, which
+// frames are scaled down to before they are copied or converted.
+//
+// usage: texture_upload_benchmark [frames]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include "ffmpeg_deleters.h"
+#include "texture_uploader.h"
+
+extern "C" {
+#include "libavutil/imgutils.h"
+}
+
+using namespace media;
+
+namespace {
+
+enum class Mode { kBGRA, kCopy, kReference };
+
+const char *ModeName(Mode mode) {
+  switch (mode) {
+    case Mode::kBGRA:return "bgra";
+    case Mode::kCopy:return "copy";
+    case Mode::kReference:return "reference";
+  }
+  return "unknown";
+}
+
+// A texture backed by memory, like the platform textures which upload
+// GetBuffer()/GetPlanes() to the GPU.
+class MemoryTexture : public ExternalMediaTexture {
+
+ public:
+
+  explicit MemoryTexture(Mode mode) : mode_(mode) {}
+
+  int64_t GetTextureId() override { return 0; }
+
+  void MaybeInitPixelBuffer(int width, int height) override {
+    if (width == width_ && height == height_ && !rgb_.empty()) {
+      return;
+    }
+    width_ = width;
+    height_ = height;
+    rgb_.resize(size_t(width) * height * 4);
+  }
+
+  int GetWidth() override { return width_; }
+
+  int GetHeight() override { return height_; }
+
+  PixelFormat GetSupportFormat() override { return kFormat_32_BGRA; }
+
+  void UnlockBuffer() override {}
+
+  void NotifyBufferUpdate() override { updates_++; }
+
+  uint8_t *GetBuffer() override { return rgb_.data(); }
+
+  bool SupportsPixelFormat(PixelFormat format) override {
+    return mode_ == Mode::kBGRA ? format == kFormat_32_BGRA : true;
+  }
+
+  void MaybeInitPlanes(int width, int height, PixelFormat format) override {
+    if (width == width_ && height == height_ && format == planes_.format && !planar_.empty()) {
+      return;
+    }
+    width_ = width;
+    height_ = height;
+    planes_ = Planes{};
+    planes_.format = format;
+    planes_.width = width;
+    planes_.height = height;
+    planes_.num_planes = format == kFormat_I420 ? 3 : 2;
+    auto pixel_format = TextureUploader::GetPixelFormat(format);
+    av_image_fill_linesizes(planes_.stride, pixel_format, width);
+    auto size = av_image_get_buffer_size(pixel_format, width, height, 1);
+    planar_.resize(size_t(size));
+    uint8_t *data[4];
+    int linesize[4];
+    av_image_fill_arrays(data, linesize, planar_.data(), pixel_format, width, height, 1);
+    for (int i = 0; i < planes_.num_planes; ++i) {
+      planes_.data[i] = data[i];
+      planes_.stride[i] = linesize[i];
+    }
+  }
+
+  bool GetPlanes(Planes *planes) override {
+    *planes = planes_;
+    return !planar_.empty();
+  }
+
+  bool SupportsPlaneReference() override { return mode_ == Mode::kReference; }
+
+  void RenderWithPlanes(const Planes &, std::shared_ptr<void>) override {
+    // Released right away, as if it was uploaded.
+    updates_++;
+  }
+
+  int updates() const { return updates_; }
+
+ private:
+
+  Mode mode_;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint8_t> rgb_;
+  std::vector<uint8_t> planar_;
+  Planes planes_{};
+  int updates_ = 0;
+
+};
+
+std::shared_ptr<VideoFrame> CreateFrame(int width, int height, AVPixelFormat format) {
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->width = width;
+  frame->height = height;
+  frame->format = format;
+  if (av_frame_get_buffer(frame.get(), 0) < 0) {
+    return nullptr;
+  }
+  for (int i = 0; i < 4 && frame->buf[i]; ++i) {
+    for (int j = 0; j < frame->buf[i]->size; ++j) {
+      frame->buf[i]->data[j] = uint8_t(j * 7 + i * 31);
+    }
+  }
+  return std::make_shared<VideoFrame>(frame.get(), 0, 0, 0);
+}
+
+struct Result {
+  double cpu_ms;
+  double wall_ms;
+  int updates;
+};
+
+Result Measure(const std::shared_ptr<VideoFrame> &frame, Mode mode, bool thumbnail, int frames) {
+  MemoryTexture texture(mode);
+  TextureUploader uploader;
+  if (thumbnail) {
+    uploader.SetDisplaySize(320, 180);
+  }
+  // Warm up, allocates the buffers and the conversion contexts.
+  uploader.Upload(&texture, frame);
+
+  auto cpu_begin = std::clock();
+  auto wall_begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; ++i) {
+    uploader.Upload(&texture, frame);
+  }
+  Result result{};
+  result.cpu_ms = 1000.0 * double(std::clock() - cpu_begin) / CLOCKS_PER_SEC / frames;
+  result.wall_ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - wall_begin).count() / frames;
+  result.updates = texture.updates();
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int frames = argc > 1 ? atoi(argv[1]) : 60;
+
+  struct Size {
+    const char *name;
+    int width;
+    int height;
+  };
+
+  for (auto size : {Size{"1080p", 1920, 1080}, Size{"4k", 3840, 2160}}) {
+    for (auto format : {AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12, AV_PIX_FMT_P010LE}) {
+      auto frame = CreateFrame(size.width, size.height, format);
+      if (!frame) {
+        fprintf(stderr, "can not allocate %s frame\n", av_get_pix_fmt_name(format));
+        continue;
+      }
+      for (auto thumbnail : {false, true}) {
+        for (auto mode : {Mode::kBGRA, Mode::kCopy, Mode::kReference}) {
+          auto result = Measure(frame, mode, thumbnail, frames);
+          printf("%-5s %-8s %-9s %-9s cpu %8.3f ms/frame  wall %8.3f ms/frame  (%d uploads)\n",
+                 size.name, av_get_pix_fmt_name(format), ModeName(mode), thumbnail ? "thumbnail" : "full",
+                 result.cpu_ms, result.wall_ms, result.updates);
+        }
+      }
+    }
+  }
+  return 0;
+}
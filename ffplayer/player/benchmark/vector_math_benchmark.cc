@@ -0,0 +1,104 @@
+//
+// Created by yangbin on 2021/7/19.
+//
+// Samples/sec of the S16 volume path of AudioBuffer::Read: the former
+// memset + MixAudioVolume loop against the vector_math kernels.
+//
+// usage: vector_math_benchmark [seconds_per_case]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "vector_math.h"
+
+using namespace media;
+
+namespace {
+
+#define MAX_AUDIO_VOLUME 100
+#define ADJUST_VOLUME(s, v) (s = (s*v)/MAX_AUDIO_VOLUME)
+
+// Copy of the loop AudioBuffer::Read used before, from SDL_MixAudioFormat#AUDIO_S16LSB.
+void LegacyMixAudioVolume(uint8 *dst, const uint8 *src, uint32_t len, int volume) {
+  int16_t src1, src2;
+  int dst_sample;
+  const int max_audioval = ((1 << (16 - 1)) - 1);
+  const int min_audioval = -(1 << (16 - 1));
+
+  len /= 2;
+  while (len--) {
+    src1 = ((src[1]) << 8 | src[0]);
+    ADJUST_VOLUME(src1, volume);
+    src2 = ((dst[1]) << 8 | dst[0]);
+    src += 2;
+    dst_sample = src1 + src2;
+    if (dst_sample > max_audioval) {
+      dst_sample = max_audioval;
+    } else if (dst_sample < min_audioval) {
+      dst_sample = min_audioval;
+    }
+    dst[0] = dst_sample & 0xFF;
+    dst_sample >>= 8;
+    dst[1] = dst_sample & 0xFF;
+    dst += 2;
+  }
+}
+
+// A typical callback: 1024 stereo frames.
+const int kSamplesPerCall = 2048;
+
+void Run(const char *name, double seconds, const std::function<void()> &call) {
+  int64_t calls = 0;
+  auto begin = std::chrono::steady_clock::now();
+  auto end = begin + std::chrono::duration<double>(seconds);
+  while (std::chrono::steady_clock::now() < end) {
+    for (int i = 0; i < 1000; ++i) {
+      call();
+    }
+    calls += 1000;
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  printf("%-22s %10.1f M samples/s\n", name, double(calls) * kSamplesPerCall / elapsed / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+
+  std::vector<int16> src(kSamplesPerCall);
+  for (int i = 0; i < kSamplesPerCall; ++i) {
+    src[i] = static_cast<int16>(rand() % 65536 - 32768);
+  }
+  std::vector<int16> dest(kSamplesPerCall);
+  std::vector<float> src_float(kSamplesPerCall);
+  for (int i = 0; i < kSamplesPerCall; ++i) {
+    src_float[i] = src[i] / 32768.0f;
+  }
+  std::vector<float> dest_float(kSamplesPerCall);
+  auto *src_bytes = reinterpret_cast<const uint8 *>(src.data());
+  auto *dest_bytes = reinterpret_cast<uint8 *>(dest.data());
+
+  Run("legacy memset+mix", seconds, [&]() {
+    memset(dest_bytes, 0, kSamplesPerCall * 2);
+    LegacyMixAudioVolume(dest_bytes, src_bytes, kSamplesPerCall * 2, 50);
+  });
+  Run("ScaleS16", seconds, [&]() {
+    vector_math::ScaleS16(src.data(), 0.5f, kSamplesPerCall, dest.data());
+  });
+  Run("ScaleS16Ramp", seconds, [&]() {
+    vector_math::ScaleS16Ramp(src.data(), 0.5f, 0.6f, kSamplesPerCall, dest.data());
+  });
+  Run("ScaleFloat", seconds, [&]() {
+    vector_math::ScaleFloat(src_float.data(), 0.5f, kSamplesPerCall, dest_float.data());
+  });
+  Run("ScaleFloatRamp", seconds, [&]() {
+    vector_math::ScaleFloatRamp(src_float.data(), 0.5f, 0.6f, kSamplesPerCall, dest_float.data());
+  });
+  return 0;
+}
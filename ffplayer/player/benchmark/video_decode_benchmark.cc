@@ -0,0 +1,199 @@
+//
+// Created by yangbin on 2021/7/18.
+//
+// Headless decode throughput of VideoDecoder for several threading policies.
+//
+// usage: video_decode_benchmark [file] [max_frames]
+//
+// The packets of the best video stream of |file| are read into memory first,
+// so only decoding is measured. Without |file|, a 1080p MPEG-4 clip is encoded
+// on the fly. Prints decoded frames per second for each thread type and count.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "decoder_buffer.h"
+#include "ffmpeg_deleters.h"
+#include "video_decoder.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+}
+
+using namespace media;
+
+namespace {
+
+struct EncodedClip {
+  std::unique_ptr<AVCodecParameters, void (*)(AVCodecParameters *)> parameters{
+      avcodec_parameters_alloc(), [](AVCodecParameters *p) { avcodec_parameters_free(&p); }};
+  AVRational time_base{};
+  AVRational frame_rate{};
+  std::vector<std::unique_ptr<AVPacket, AVPacketDeleter>> packets;
+};
+
+void AppendPacket(EncodedClip *clip, AVPacket *packet) {
+  std::unique_ptr<AVPacket, AVPacketDeleter> copy(av_packet_alloc());
+  av_packet_ref(copy.get(), packet);
+  clip->packets.emplace_back(std::move(copy));
+}
+
+bool LoadClip(const char *path, int max_frames, EncodedClip *clip) {
+  AVFormatContext *format_context = nullptr;
+  if (avformat_open_input(&format_context, path, nullptr, nullptr) < 0) {
+    fprintf(stderr, "can not open %s\n", path);
+    return false;
+  }
+  std::unique_ptr<AVFormatContext, void (*)(AVFormatContext *)> scoped_context(
+      format_context, [](AVFormatContext *context) { avformat_close_input(&context); });
+
+  if (avformat_find_stream_info(format_context, nullptr) < 0) {
+    return false;
+  }
+  int index = av_find_best_stream(format_context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+  if (index < 0) {
+    fprintf(stderr, "no video stream in %s\n", path);
+    return false;
+  }
+  auto *stream = format_context->streams[index];
+  avcodec_parameters_copy(clip->parameters.get(), stream->codecpar);
+  clip->time_base = stream->time_base;
+  clip->frame_rate = av_guess_frame_rate(format_context, stream, nullptr);
+
+  std::unique_ptr<AVPacket, AVPacketDeleter> packet(av_packet_alloc());
+  while (static_cast<int>(clip->packets.size()) < max_frames && av_read_frame(format_context, packet.get()) >= 0) {
+    if (packet->stream_index == index) {
+      AppendPacket(clip, packet.get());
+    }
+    av_packet_unref(packet.get());
+  }
+  return !clip->packets.empty();
+}
+
+bool SynthesizeClip(int max_frames, EncodedClip *clip) {
+  auto *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+  if (!codec) {
+    fprintf(stderr, "no mpeg4 encoder available\n");
+    return false;
+  }
+  std::unique_ptr<AVCodecContext, AVCodecContextDeleter> encoder(avcodec_alloc_context3(codec));
+  encoder->width = 1920;
+  encoder->height = 1080;
+  encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+  encoder->time_base = AVRational{1, 25};
+  encoder->framerate = AVRational{25, 1};
+  encoder->gop_size = 25;
+  encoder->max_b_frames = 0;
+  encoder->bit_rate = 8000000;
+  if (avcodec_open2(encoder.get(), codec, nullptr) < 0) {
+    return false;
+  }
+
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->format = encoder->pix_fmt;
+  frame->width = encoder->width;
+  frame->height = encoder->height;
+  av_frame_get_buffer(frame.get(), 0);
+
+  AVPacket packet;
+  av_init_packet(&packet);
+  auto drain = [&]() {
+    while (avcodec_receive_packet(encoder.get(), &packet) >= 0) {
+      AppendPacket(clip, &packet);
+      av_packet_unref(&packet);
+    }
+  };
+
+  for (int i = 0; i < max_frames; ++i) {
+    av_frame_make_writable(frame.get());
+    // Moving gradients, so that every frame carries real motion.
+    for (int y = 0; y < frame->height; ++y) {
+      for (int x = 0; x < frame->width; ++x) {
+        frame->data[0][y * frame->linesize[0] + x] = static_cast<uint8_t>(x + y + i * 3);
+      }
+    }
+    for (int y = 0; y < frame->height / 2; ++y) {
+      for (int x = 0; x < frame->width / 2; ++x) {
+        frame->data[1][y * frame->linesize[1] + x] = static_cast<uint8_t>(128 + y + i * 2);
+        frame->data[2][y * frame->linesize[2] + x] = static_cast<uint8_t>(64 + x + i * 5);
+      }
+    }
+    frame->pts = i;
+    avcodec_send_frame(encoder.get(), frame.get());
+    drain();
+  }
+  avcodec_send_frame(encoder.get(), nullptr);
+  drain();
+
+  avcodec_parameters_from_context(clip->parameters.get(), encoder.get());
+  clip->time_base = encoder->time_base;
+  clip->frame_rate = encoder->framerate;
+  return !clip->packets.empty();
+}
+
+const char *ThreadTypeName(VideoDecoderThreadType type) {
+  switch (type) {
+    case VideoDecoderThreadType::kAuto:return "auto";
+    case VideoDecoderThreadType::kFrame:return "frame";
+    case VideoDecoderThreadType::kSlice:return "slice";
+  }
+  return "unknown";
+}
+
+void RunOnce(const EncodedClip &clip, VideoDecoderThreadType type, int thread_count) {
+  VideoDecodeConfig config(*clip.parameters, clip.time_base, clip.frame_rate, 10);
+  config.set_threading(type, thread_count);
+
+  int64_t frames = 0;
+  VideoDecoder decoder;
+  if (decoder.Initialize(config, nullptr, [&frames](std::shared_ptr<VideoFrame>) { frames++; }) < 0) {
+    fprintf(stderr, "failed to initialize decoder\n");
+    return;
+  }
+
+  std::vector<std::shared_ptr<DecoderBuffer>> buffers;
+  buffers.reserve(clip.packets.size());
+  for (const auto &packet : clip.packets) {
+    std::unique_ptr<AVPacket, AVPacketDeleter> copy(av_packet_alloc());
+    av_packet_ref(copy.get(), packet.get());
+    buffers.emplace_back(std::make_shared<DecoderBuffer>(copy.get()));
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  for (auto &buffer : buffers) {
+    decoder.Decode(buffer);
+  }
+  auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  // Frames still held by frame threading are not drained, they are at most
+  // |thread_count| of the whole clip.
+  printf("%-6s threads %2d  frames %5lld  fps %8.1f\n",
+         ThreadTypeName(type), thread_count,
+         static_cast<long long>(frames), frames / seconds);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int max_frames = argc > 2 ? atoi(argv[2]) : 250;
+
+  EncodedClip clip;
+  bool loaded = argc > 1 ? LoadClip(argv[1], max_frames, &clip) : SynthesizeClip(max_frames, &clip);
+  if (!loaded) {
+    return 1;
+  }
+  printf("%s %dx%d, %zu packets\n", avcodec_get_name(clip.parameters->codec_id),
+         clip.parameters->width, clip.parameters->height, clip.packets.size());
+
+  for (int thread_count : {1, 2, 4, 8}) {
+    RunOnce(clip, VideoDecoderThreadType::kFrame, thread_count);
+    RunOnce(clip, VideoDecoderThreadType::kSlice, thread_count);
+  }
+  RunOnce(clip, VideoDecoderThreadType::kAuto, 0);
+  return 0;
+}
@@ -4,65 +4,90 @@
 
 #include "audio_buffer.h"
 
+#include "atomic"
+#include "cmath"
+#include "cstdlib"
 #include "cstring"
 
 #include "base/logging.h"
 
 namespace media {
 
-#define MAX_AUDIO_VOLUME 100
-#define ADJUST_VOLUME(s, v) (s = (s*v)/MAX_AUDIO_VOLUME)
+AudioBuffer::AudioBuffer(int capacity, int bytes_per_sec)
+    : data_(nullptr), capacity_(0), size_(0), pts_(NAN), bytes_per_sec_(bytes_per_sec) {
+  Reserve(capacity);
+}
 
-// from SDL_MixAudioFormat#AUDIO_S16LSB
-static void MixAudioVolume(uint8 *dst, const uint8 *src, uint32_t len, int volume) {
-  int16_t src1, src2;
-  int dst_sample;
-  const int max_audioval = ((1 << (16 - 1)) - 1);
-  const int min_audioval = -(1 << (16 - 1));
+AudioBuffer::~AudioBuffer() {
+  free(data_);
+}
 
-  len /= 2;
-  while (len--) {
-    src1 = ((src[1]) << 8 | src[0]);
-    ADJUST_VOLUME(src1, volume);
-    src2 = ((dst[1]) << 8 | dst[0]);
-    src += 2;
-    dst_sample = src1 + src2;
-    if (dst_sample > max_audioval) {
-      dst_sample = max_audioval;
-    } else if (dst_sample < min_audioval) {
-      dst_sample = min_audioval;
-    }
-    dst[0] = dst_sample & 0xFF;
-    dst_sample >>= 8;
-    dst[1] = dst_sample & 0xFF;
-    dst += 2;
+void AudioBuffer::Reserve(int capacity) {
+  if (capacity <= capacity_) {
+    return;
   }
+  free(data_);
+  data_ = static_cast<uint8 *>(malloc(sizeof(uint8) * capacity));
+  DCHECK(data_);
+  capacity_ = capacity;
+  size_ = 0;
+  read_cursor_ = 0;
 }
 
-AudioBuffer::AudioBuffer(uint8 *data, int size, double pts, int bytes_per_sec)
-    : data_(data), size_(size), pts_(pts), bytes_per_sec_(bytes_per_sec) {}
-
-AudioBuffer::~AudioBuffer() {
-  free(data_);
+void AudioBuffer::Prepare(int size, double pts) {
+  DCHECK_GE(size, 0);
+  DCHECK_LE(size, capacity_);
+  size_ = size;
+  pts_ = pts;
+  read_cursor_ = 0;
 }
 
-int AudioBuffer::Read(uint8 *dest, int size, double volume) {
+int AudioBuffer::Read(uint8 *dest, int size, vector_math::GainRamp *volume) {
   DCHECK_GT(size, 0);
   DCHECK_LT(read_cursor_, size_);
+  DCHECK(volume);
 
   auto flush_size = std::min(size, size_ - read_cursor_);
+  // Samples are interleaved S16.
+  auto *src = reinterpret_cast<const int16 *>(data_ + read_cursor_);
+  auto *out = reinterpret_cast<int16 *>(dest);
+  auto samples = flush_size / 2;
+  if (flush_size % 2 != 0) {
+    // Half a sample cannot be scaled, it stays silent unless copied below.
+    dest[flush_size - 1] = 0;
+  }
 
-  if (volume == 0) {
+  if (volume->IsRamping()) {
+    auto start = volume->current;
+    vector_math::ScaleS16Ramp(src, start, volume->Advance(samples), samples, out);
+  } else if (volume->current == 0) {
     memset(dest, 0, flush_size);
-  } else if (volume == 1) {
+  } else if (volume->current == 1) {
     memcpy(dest, data_ + read_cursor_, flush_size);
   } else {
-    memset(dest, 0, flush_size);
-    MixAudioVolume(dest, data_ + read_cursor_, flush_size, int(volume * 100));
+    vector_math::ScaleS16(src, volume->current, samples, out);
   }
 
   read_cursor_ += flush_size;
   return flush_size;
 }
 
-}
\ No newline at end of file
+AudioBufferPool::AudioBufferPool(int bytes_per_sec) : bytes_per_sec_(bytes_per_sec) {}
+
+std::shared_ptr<AudioBuffer> AudioBufferPool::Acquire(int capacity) {
+  for (auto &buffer : buffers_) {
+    if (buffer.use_count() == 1) {
+      // Pairs with the release of the consumer's reference, its reads of the
+      // buffer happen before we write into it again.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      buffer->Reserve(capacity);
+      return buffer;
+    }
+  }
+  auto buffer = std::make_shared<AudioBuffer>(capacity, bytes_per_sec_);
+  buffers_.push_back(buffer);
+  DLOG_IF(WARNING, buffers_.size() > 16) << "audio buffer pool grows to " << buffers_.size();
+  return buffer;
+}
+
+}
@@ -5,26 +5,51 @@
 #ifndef MEDIA_PLAYER_SRC_AUDIO_BUFFER_H_
 #define MEDIA_PLAYER_SRC_AUDIO_BUFFER_H_
 
+#include <memory>
+#include <vector>
+
 #include "base/basictypes.h"
 
+#include "vector_math.h"
+
 namespace media {
 
 class AudioBuffer {
 
  public:
 
-  AudioBuffer(uint8 *data, int size, double pts, int bytes_per_sec);
+  AudioBuffer(int capacity, int bytes_per_sec);
 
   virtual ~AudioBuffer();
 
+  /**
+   * Grow the storage to hold at least |capacity| bytes. Content is discarded.
+   */
+  void Reserve(int capacity);
+
+  /**
+   * Mark the first |size| bytes of [writable_data] as the content to read, and
+   * rewind the read cursor.
+   */
+  void Prepare(int size, double pts);
+
+  uint8 *writable_data() {
+    return data_;
+  }
+
+  int capacity() const {
+    return capacity_;
+  }
+
   /**
    * Read data to stream.
    *
    * @param dest Output destination.
    * @param size  The size to read.
+   * @param volume Applied while copying, advanced by the samples read.
    * @return The size read done.
    */
-  int Read(uint8 *dest, int size, double volume);
+  int Read(uint8 *dest, int size, vector_math::GainRamp *volume);
 
   int size() const {
     return size_;
@@ -44,6 +69,13 @@ class AudioBuffer {
     return size_ == read_cursor_;
   }
 
+  /**
+   * Duration of the whole buffer in seconds.
+   */
+  double duration() const {
+    return double(size_) / bytes_per_sec_;
+  }
+
   /**
    * The presentation time of start of cursor.
    */
@@ -54,6 +86,7 @@ class AudioBuffer {
  private:
 
   uint8 *data_;
+  int capacity_;
   int size_;
 
   double pts_;
@@ -62,6 +95,47 @@ class AudioBuffer {
 
   int bytes_per_sec_;
 
+  DELETE_COPY_AND_ASSIGN(AudioBuffer);
+
+};
+
+/**
+ * Recycles AudioBuffers between the decoder and the audio device.
+ *
+ * The pool holds a reference to every buffer it created, so the last reference
+ * is never dropped by the consumer. Releasing a buffer on the audio callback
+ * thread is only an atomic decrement, the memory stays with the pool and is
+ * handed out again once nobody else references it.
+ *
+ * Not thread safe, [Acquire] must be called from one thread.
+ */
+class AudioBufferPool {
+
+ public:
+
+  explicit AudioBufferPool(int bytes_per_sec);
+
+  /**
+   * @return A buffer which can hold |capacity| bytes and is not referenced
+   * anywhere else. Allocates only if all pooled buffers are still in use.
+   */
+  std::shared_ptr<AudioBuffer> Acquire(int capacity);
+
+  /**
+   * Count of buffers created by this pool.
+   */
+  size_t size() const {
+    return buffers_.size();
+  }
+
+ private:
+
+  int bytes_per_sec_;
+
+  std::vector<std::shared_ptr<AudioBuffer>> buffers_;
+
+  DELETE_COPY_AND_ASSIGN(AudioBufferPool);
+
 };
 
 }
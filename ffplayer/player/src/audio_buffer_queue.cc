@@ -0,0 +1,55 @@
+//
+// Created by yangbin on 2021/7/20.
+//
+
+#include "audio_buffer_queue.h"
+
+#include <algorithm>
+
+namespace media {
+
+AudioBufferQueue::AudioBufferQueue(int capacity)
+    : queue_(static_cast<size_t>(capacity)), epoch_(0), flushed_count_(0) {}
+
+bool AudioBufferQueue::Push(std::shared_ptr<AudioBuffer> buffer) {
+  DCHECK(buffer);
+  Entry entry;
+  entry.epoch = epoch_.load(std::memory_order_relaxed);
+  entry.buffer = std::move(buffer);
+  return queue_.Push(std::move(entry));
+}
+
+void AudioBufferQueue::Flush() {
+  flushed_count_ = queue_.pushed_count();
+  // Entries pushed afterwards carry the new epoch. The consumer acquires an
+  // entry before it reads the epoch, so it never sees a new entry as stale.
+  epoch_.fetch_add(1, std::memory_order_release);
+}
+
+int AudioBufferQueue::size() const {
+  auto head = std::max(queue_.popped_count(), flushed_count_);
+  auto tail = queue_.pushed_count();
+  return tail > head ? static_cast<int>(tail - head) : 0;
+}
+
+bool AudioBufferQueue::IsFull() const {
+  return queue_.size() >= queue_.capacity();
+}
+
+AudioBuffer *AudioBufferQueue::Front() {
+  Entry *entry;
+  while ((entry = queue_.Front()) != nullptr) {
+    if (entry->epoch == epoch_.load(std::memory_order_acquire)) {
+      return entry->buffer.get();
+    }
+    // Only drops a reference, the memory belongs to the decoder's AudioBufferPool.
+    queue_.Pop();
+  }
+  return nullptr;
+}
+
+void AudioBufferQueue::Pop() {
+  queue_.Pop();
+}
+
+} // namespace media
@@ -0,0 +1,83 @@
+//
+// Created by yangbin on 2021/7/20.
+//
+
+#ifndef MEDIA_PLAYER_SRC_AUDIO_BUFFER_QUEUE_H_
+#define MEDIA_PLAYER_SRC_AUDIO_BUFFER_QUEUE_H_
+
+#include <atomic>
+#include <memory>
+
+#include "base/basictypes.h"
+#include "base/spsc_queue.h"
+
+#include "audio_buffer.h"
+
+namespace media {
+
+/**
+ * Hands decoded AudioBuffers from the decoder thread to the audio callback
+ * thread without locks.
+ *
+ * The decoder thread is the producer: [Push], [Flush] and [size]. The audio
+ * callback thread is the consumer: [Front] and [Pop].
+ *
+ * [Flush] can not remove items, only the consumer may. It starts a new epoch
+ * instead, buffers pushed in an older epoch are dropped by the consumer the
+ * next time it looks at the queue.
+ */
+class AudioBufferQueue {
+
+ public:
+
+  explicit AudioBufferQueue(int capacity);
+
+  /**
+   * @return false if the queue is full.
+   */
+  bool Push(std::shared_ptr<AudioBuffer> buffer);
+
+  /**
+   * Discard all buffers pushed so far.
+   */
+  void Flush();
+
+  /**
+   * Count of queued buffers which have not been flushed. Producer only.
+   */
+  int size() const;
+
+  bool IsFull() const;
+
+  /**
+   * @return the first buffer of the current epoch, or nullptr if there is none.
+   * Flushed buffers in front of it are dropped.
+   */
+  AudioBuffer *Front();
+
+  /**
+   * Remove the buffer returned by [Front].
+   */
+  void Pop();
+
+ private:
+
+  struct Entry {
+    uint32 epoch = 0;
+    std::shared_ptr<AudioBuffer> buffer;
+  };
+
+  SpscQueue<Entry> queue_;
+
+  std::atomic<uint32> epoch_;
+
+  // |queue_.pushed_count()| at the last flush, only used by the producer.
+  uint64_t flushed_count_;
+
+  DELETE_COPY_AND_ASSIGN(AudioBufferQueue);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_AUDIO_BUFFER_QUEUE_H_
@@ -32,6 +32,7 @@ int AudioDecoder::Initialize(const AudioDecodeConfig &config, DemuxerStream *str
       nullptr, audio_device_info_.channels, 1, audio_device_info_.fmt, 1);
   audio_device_info_.bytes_per_sec = av_samples_get_buffer_size(
       nullptr, audio_device_info_.channels, audio_device_info_.freq, audio_device_info_.fmt, 1);
+  audio_buffer_pool_ = std::make_unique<AudioBufferPool>(audio_device_info_.bytes_per_sec);
 
   auto ret = avcodec_parameters_to_context(codec_context_.get(), &config.codec_parameters());
   DCHECK_GE(ret, 0);
@@ -110,17 +111,19 @@ bool AudioDecoder::OnFrameAvailable(AVFrame *frame) {
     }
   }
 
-  uint8 *data;
+  std::shared_ptr<AudioBuffer> buffer;
   int data_size;
 
   if (swr_ctx_) {
     const auto **in = (const uint8_t **) frame->extended_data;
     int out_count = frame->nb_samples * audio_decode_config_.samples_per_second() / frame->sample_rate + 256;
     int out_size = av_samples_get_buffer_size(
-        nullptr, audio_decode_config_.channels(), out_count, AV_SAMPLE_FMT_S16, 0);
+        nullptr, audio_device_info_.channels, out_count, audio_device_info_.fmt, 0);
     DCHECK_GT(out_size, 0) << "av_samples_get_buffer_size() failed";
-    data = static_cast<uint8 *>(malloc(sizeof(uint8) * out_size));
-    auto out_nb_samples = swr_convert(swr_ctx_, &data, out_size, in, frame->nb_samples);
+    // Resample straight into a recycled buffer.
+    buffer = audio_buffer_pool_->Acquire(out_size);
+    uint8 *data = buffer->writable_data();
+    auto out_nb_samples = swr_convert(swr_ctx_, &data, out_count, in, frame->nb_samples);
     if (out_nb_samples < 0) {
       DLOG(ERROR) << "swr_convert Failed";
       return false;
@@ -135,12 +138,13 @@ bool AudioDecoder::OnFrameAvailable(AVFrame *frame) {
   } else {
     data_size = av_samples_get_buffer_size(nullptr, frame->channels, frame->nb_samples,
                                            AVSampleFormat(frame->format), 1);
-    data = static_cast<uint8 *>(malloc(sizeof(uint8) * data_size));
-    memcpy(data, frame->data[0], data_size);
+    buffer = audio_buffer_pool_->Acquire(data_size);
+    memcpy(buffer->writable_data(), frame->data[0], data_size);
   }
 
   double pts = frame->pts == AV_NOPTS_VALUE ? NAN : av_q2d(audio_decode_config_.time_base()) * double(frame->pts);
-  output_callback_(std::make_shared<AudioBuffer>(data, data_size, pts, audio_device_info_.bytes_per_sec));
+  buffer->Prepare(data_size, pts);
+  output_callback_(std::move(buffer));
   return true;
 }
 
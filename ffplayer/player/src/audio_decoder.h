@@ -55,6 +55,9 @@ class AudioDecoder {
 
   AudioDeviceInfo audio_device_info_;
 
+  // Created once the output format is known in [Initialize].
+  std::unique_ptr<AudioBufferPool> audio_buffer_pool_;
+
   bool OnFrameAvailable(AVFrame *frame);
 
   static int64 GetChannelLayout(AVFrame *frame);
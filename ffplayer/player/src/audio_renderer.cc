@@ -2,11 +2,14 @@
 // Created by yangbin on 2021/5/1.
 //
 
+#include "algorithm"
 #include "cmath"
 
 #include "base/logging.h"
 #include "base/lambda.h"
 #include "base/bind_to_current_loop.h"
+#include "base/time_ticks.h"
+#include "base/trace_event.h"
 
 #include "ffmpeg_utils.h"
 
@@ -14,16 +17,21 @@
 
 namespace media {
 
+// How often the decoder thread checks for a refill requested by the audio
+// callback while playing, well below the duration of the ready buffers.
+const auto kRefillPollInterval = TimeDelta::FromMilliseconds(5);
+
+// How long a volume change from 0 to 1 takes.
+const double kVolumeRampSeconds = 0.02;
+
 AudioRenderer::AudioRenderer(std::shared_ptr<TaskRunner> task_runner, std::shared_ptr<AudioRendererSink> sink)
     : task_runner_(std::move(task_runner)),
-      audio_buffer_(),
       sink_(std::move(sink)),
       volume_(1) {
 
 }
 
 AudioRenderer::~AudioRenderer() {
-  std::lock_guard<std::mutex> auto_lock(mutex_);
   sink_ = nullptr;
 }
 
@@ -35,8 +43,14 @@ void AudioRenderer::Initialize(DemuxerStream *stream,
   demuxer_stream_ = stream;
   init_callback_ = BindToCurrentLoop(std::move(init_callback));
 
+  // Room for the buffers of a few flushes which the audio callback has not
+  // dropped yet, on top of what [NeedReadStream] asks for.
+  audio_buffer_ = std::make_unique<AudioBufferQueue>(std::max(max_ready_buffers_ * 2 + 2, 8));
+
   decoder_stream_ = std::make_shared<AudioDecoderStream>(std::make_unique<AudioDecoderStream::StreamTraits>(),
                                                          task_runner_);
+  decoder_stream_->set_max_outputs(max_decoder_outputs_);
+  decoder_stream_->set_metrics(metrics_);
 
   decoder_stream_->Initialize(stream, bind_weak(&AudioRenderer::OnDecoderStreamInitialized,
                                                 shared_from_this()));
@@ -54,11 +68,15 @@ void AudioRenderer::OnDecoderStreamInitialized(bool success) {
   }
 
   auto audio_config = demuxer_stream_->audio_decode_config();
+  // Published to the audio thread by starting the sink.
+  InitializeVolumeRamp(audio_config.samples_per_second() * audio_config.channels());
   sink_->Initialize(
       av_get_channel_layout_nb_channels(audio_config.channel_layout()),
       audio_config.samples_per_second(),
       this);
 
+  CreateTaskClosures();
+
   std::move(init_callback_)(true);
   init_callback_ = nullptr;
 
@@ -66,6 +84,54 @@ void AudioRenderer::OnDecoderStreamInitialized(bool success) {
 
 }
 
+void AudioRenderer::InitializeForTesting(std::shared_ptr<MediaClock> media_clock, int samples_per_second) {
+  media_clock_ = std::move(media_clock);
+  audio_buffer_ = std::make_unique<AudioBufferQueue>(std::max(max_ready_buffers_ * 2 + 2, 8));
+  InitializeVolumeRamp(samples_per_second);
+  CreateTaskClosures();
+  // There is no decoder stream, |AttemptReadFrame| returns at once.
+  reading_ = true;
+}
+
+bool AudioRenderer::PushBufferForTesting(std::shared_ptr<AudioBuffer> buffer) {
+  return audio_buffer_->Push(std::move(buffer));
+}
+
+void AudioRenderer::InitializeVolumeRamp(int samples_per_second) {
+  volume_ramp_.step = float(1.0 / std::max(kVolumeRampSeconds * samples_per_second, 1.0));
+}
+
+void AudioRenderer::CreateTaskClosures() {
+  std::weak_ptr<AudioRenderer> weak_this = shared_from_this();
+  poll_refill_closure_ = [weak_this]() {
+    auto renderer = weak_this.lock();
+    if (renderer) {
+      renderer->PollRefill();
+    }
+  };
+}
+
+void AudioRenderer::StartRefillPolling() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  if (polling_refill_) {
+    return;
+  }
+  polling_refill_ = true;
+  PollRefill();
+}
+
+void AudioRenderer::PollRefill() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  if (!playing_.load(std::memory_order_relaxed)) {
+    polling_refill_ = false;
+    return;
+  }
+  if (refill_requested_.exchange(false, std::memory_order_relaxed)) {
+    AttemptReadFrame();
+  }
+  task_runner_->PostDelayedTask(FROM_HERE, kRefillPollInterval, poll_refill_closure_);
+}
+
 void AudioRenderer::AttemptReadFrame() {
   DCHECK(task_runner_->BelongsToCurrentThread());
 
@@ -81,11 +147,14 @@ void AudioRenderer::OnNewFrameAvailable(AudioDecoderStream::ReadResult result) {
   DCHECK(task_runner_->BelongsToCurrentThread());
   DCHECK(reading_);
   reading_ = false;
-  {
-    std::lock_guard<std::mutex> auto_lock(mutex_);
-    DLOG_IF(WARNING, audio_buffer_.size() > 3) << "audio buffer is enough: " << audio_buffer_.size();
-    audio_buffer_.emplace_back(std::move(result));
+  // Decoded from the keyframe before an accurate seek target.
+  if (result->pts() < start_time_ && result->pts() + result->duration() <= start_time_) {
+    AttemptReadFrame();
+    return;
   }
+  DLOG_IF(WARNING, audio_buffer_->size() > max_ready_buffers_) << "audio buffer is enough: " << audio_buffer_->size();
+  auto pushed = audio_buffer_->Push(std::move(result));
+  DCHECK(pushed) << "audio buffer queue is full";
   if (NeedReadStream()) {
     AttemptReadFrame();
   }
@@ -96,26 +165,28 @@ int AudioRenderer::Render(double delay, uint8 *stream, int len) {
   DCHECK_GT(len, 0);
   DCHECK(stream);
 
+  TRACE_EVENT("audio", "Render");
+  auto render_begin = TimeTicks::Now();
   double audio_clock_time = 0;
-  auto render_callback_time = av_gettime_relative() / 1000000.0;
+  auto render_callback_time = media_clock_->time_source()->Now();
+
+  volume_ramp_.target = float(volume_.load(std::memory_order_relaxed));
 
   auto len_flush = 0;
   while (len_flush < len) {
-    std::lock_guard<std::mutex> auto_lock(mutex_);
-    if (audio_buffer_.empty()) {
-      task_runner_->PostTask(FROM_HERE, bind_weak(&AudioRenderer::AttemptReadFrame, shared_from_this()));
+    auto *buffer = audio_buffer_->Front();
+    if (!buffer) {
+      RequestRefill();
       break;
     }
-    auto buffer = audio_buffer_.front();
-    DCHECK(buffer);
     if (audio_clock_time == 0 && !std::isnan(buffer->pts())) {
       audio_clock_time = buffer->PtsFromCursor() - delay;
     }
 
-    auto flushed = buffer->Read(stream + len_flush, len - len_flush, volume_);
+    auto flushed = buffer->Read(stream + len_flush, len - len_flush, &volume_ramp_);
     if (buffer->IsConsumed()) {
-      audio_buffer_.pop_front();
-      task_runner_->PostTask(FROM_HERE, bind_weak(&AudioRenderer::AttemptReadFrame, shared_from_this()));
+      audio_buffer_->Pop();
+      RequestRefill();
     }
     len_flush += flushed;
   }
@@ -127,46 +198,60 @@ int AudioRenderer::Render(double delay, uint8 *stream, int len) {
 
 //  decode_task_runner_->PostTask(FROM_HERE, bind_weak(&AudioRenderer::AttemptReadFrame, shared_from_this()));
 
+  if (metrics_) {
+    if (len_flush < len) {
+      metrics_->audio_underruns().fetch_add(1, std::memory_order_relaxed);
+    }
+    metrics_->audio().render_callback_time_us.Record((TimeTicks::Now() - render_begin).InMicroseconds());
+  }
+
   return len_flush;
 }
 
+void AudioRenderer::RequestRefill() {
+  refill_requested_.store(true, std::memory_order_relaxed);
+}
+
 void AudioRenderer::OnRenderError() {
 
 }
 
 void AudioRenderer::Start() {
+  playing_.store(true, std::memory_order_relaxed);
   sink_->Play();
+  task_runner_->PostTask(FROM_HERE, bind_weak(&AudioRenderer::StartRefillPolling, shared_from_this()));
 }
 
 void AudioRenderer::Stop() {
   sink_->Pause();
+  // The polling stops at its next run.
+  playing_.store(false, std::memory_order_relaxed);
 }
 
 bool AudioRenderer::NeedReadStream() {
   // FIXME temp solution.
-  return audio_buffer_.size() < 3;
+  return audio_buffer_->size() < max_ready_buffers_ && !audio_buffer_->IsFull();
 }
 
 void AudioRenderer::SetVolume(double volume) {
   DCHECK(volume >= 0);
   DCHECK(volume <= 1);
-  std::lock_guard<std::mutex> auto_lock(mutex_);
-  volume_ = volume;
+  volume_.store(volume, std::memory_order_relaxed);
 }
 
-void AudioRenderer::Flush() {
-  task_runner_->PostTask(FROM_HERE, [&]() {
-    std::lock_guard<std::mutex> auto_lock(mutex_);
-    audio_buffer_.clear();
+void AudioRenderer::Flush(double start_time) {
+  task_runner_->PostTask(FROM_HERE, [this, start_time]() {
+    start_time_ = start_time;
+    audio_buffer_->Flush();
     decoder_stream_->Flush();
   });
 
 }
 
 std::ostream &operator<<(std::ostream &os, const AudioRenderer &renderer) {
-  os << " audio_buffer_: " << renderer.audio_buffer_.size()
+  os << " audio_buffer_: " << (renderer.audio_buffer_ ? renderer.audio_buffer_->size() : 0)
      << " reading_: " << renderer.reading_
-     << " volume_: " << renderer.volume_;
+     << " volume_: " << renderer.GetVolume();
   if (renderer.decoder_stream_) {
     os << " decoder_stream( " << *renderer.decoder_stream_ << " )";
   }
@@ -5,6 +5,7 @@
 #ifndef MEDIA_PLAYER_SRC_AUDIO_RENDERER_H_
 #define MEDIA_PLAYER_SRC_AUDIO_RENDERER_H_
 
+#include <atomic>
 #include <ostream>
 #include "memory"
 
@@ -14,6 +15,8 @@
 #include "audio_decoder.h"
 #include "decoder_stream.h"
 #include "audio_renderer_sink.h"
+#include "audio_buffer_queue.h"
+#include "buffering_policy.h"
 
 namespace media {
 
@@ -28,6 +31,38 @@ class AudioRenderer : public std::enable_shared_from_this<AudioRenderer>, public
   using InitCallback = std::function<void(bool success)>;
   void Initialize(DemuxerStream *decoder_stream, std::shared_ptr<MediaClock> media_clock, InitCallback init_callback);
 
+  /**
+   * Make |Render| usable without a demuxer stream and decoder, buffers are
+   * queued by |PushBufferForTesting| instead. Nothing is ever read from the
+   * decoder, refills are only requested.
+   */
+  void InitializeForTesting(std::shared_ptr<MediaClock> media_clock, int samples_per_second);
+
+  /**
+   * @return false if the queue is full. Must be called from one thread.
+   */
+  bool PushBufferForTesting(std::shared_ptr<AudioBuffer> buffer);
+
+  /**
+   * Limits of decoded buffers, must be set before |Initialize|.
+   */
+  void SetBufferingPolicy(const BufferingPolicy &policy) {
+    max_ready_buffers_ = policy.max_decoded_audio_buffers;
+    max_decoder_outputs_ = policy.max_decoder_outputs;
+  }
+
+  /**
+   * Decoding, underruns and render callbacks go to |metrics|, which may be
+   * null. Must be set before |Initialize|.
+   */
+  void set_metrics(std::shared_ptr<MediaMetrics> metrics) {
+    metrics_ = std::move(metrics);
+  }
+
+  TaskStats GetDecoderTaskStats(int top_n = 0) const {
+    return task_runner_->GetTaskStats(top_n);
+  }
+
   void Start();
 
   void Stop();
@@ -38,9 +73,13 @@ class AudioRenderer : public std::enable_shared_from_this<AudioRenderer>, public
 
   void SetVolume(double volume);
 
-  double GetVolume() const { return volume_; };
+  double GetVolume() const { return volume_.load(std::memory_order_relaxed); };
 
-  void Flush();
+  /**
+   * Drop decoded buffers for a seek. Buffers which end before |start_time| are
+   * dropped as they are decoded.
+   */
+  void Flush(double start_time = 0);
 
   friend std::ostream &operator<<(std::ostream &os, const AudioRenderer &renderer);
 
@@ -55,20 +94,56 @@ class AudioRenderer : public std::enable_shared_from_this<AudioRenderer>, public
 
   std::shared_ptr<MediaClock> media_clock_;
 
-  std::deque<std::shared_ptr<AudioBuffer>> audio_buffer_;
+  // Filled on |task_runner_|, drained by the audio callback without locks.
+  // Created in |Initialize| once its capacity is known.
+  std::unique_ptr<AudioBufferQueue> audio_buffer_;
+
+  // Only used on |task_runner_|.
+  double start_time_ = 0;
+
+  int max_ready_buffers_ = 3;
+  int max_decoder_outputs_ = 9;
 
   InitCallback init_callback_;
 
   bool reading_ = false;
 
-  std::mutex mutex_;
+  std::atomic<double> volume_;
+
+  std::shared_ptr<MediaMetrics> metrics_;
 
-  double volume_;
+  // The gain applied on the audio callback thread, follows |volume_| smoothly.
+  vector_math::GainRamp volume_ramp_;
 
   void OnDecoderStreamInitialized(bool success);
 
+  // |samples_per_second| counts the samples of all channels.
+  void InitializeVolumeRamp(int samples_per_second);
+
+  // Set by the audio callback thread, which must not allocate or lock, so it
+  // posts nothing: |PollRefill| checks it on |task_runner_| while playing.
+  std::atomic_bool refill_requested_{false};
+
+  std::atomic_bool playing_{false};
+
+  // Only used on |task_runner_|.
+  bool polling_refill_ = false;
+
+  TaskClosure poll_refill_closure_;
+
+  void CreateTaskClosures();
+
   void AttemptReadFrame();
 
+  // Called from the audio callback thread.
+  void RequestRefill();
+
+  void StartRefillPolling();
+
+  // Run |AttemptReadFrame| if a refill was requested, then again after
+  // kRefillPollInterval until playback stops.
+  void PollRefill();
+
   void OnNewFrameAvailable(AudioDecoderStream::ReadResult result);
 
   bool NeedReadStream();
@@ -20,24 +20,39 @@ BlockingUrlProtocol::BlockingUrlProtocol(DataSource *data_source,
       last_read_bytes_(0),
       read_position_(0),
       aborted_(false),
+      read_complete_(false),
+      in_data_source_read_(false),
       read_condition_() {}
 
 BlockingUrlProtocol::~BlockingUrlProtocol() = default;
 
 void BlockingUrlProtocol::Abort() {
-  std::lock_guard<std::mutex> lock(data_source_lock_);
-  aborted_ = true;
-  read_condition_.notify_one();
-  data_source_ = nullptr;
+  DataSource *data_source;
+  {
+    std::lock_guard<std::mutex> lock(data_source_lock_);
+    aborted_ = true;
+    data_source = data_source_;
+  }
+  read_condition_.notify_all();
 
+  if (data_source) {
+    // Wake up a read blocked in the data source.
+    data_source->Abort();
+  }
+
+  std::unique_lock<std::mutex> lock(data_source_lock_);
+  read_condition_.wait(lock, [this] {
+    return !in_data_source_read_;
+  });
+  data_source_ = nullptr;
 }
 
 int BlockingUrlProtocol::Read(int size, uint8_t *data) {
+  DataSource *data_source;
   {
     // Read errors are unrecoverable.
     std::lock_guard<std::mutex> lock(data_source_lock_);
-    if (!data_source_) {
-      DCHECK(aborted_);
+    if (aborted_ || !data_source_) {
       return AVERROR(EIO);
     }
 
@@ -52,36 +67,48 @@ int BlockingUrlProtocol::Read(int size, uint8_t *data) {
     if (data_source_->GetSize(&file_size) && read_position_ >= file_size)
       return AVERROR_EOF;
 
-    // Blocking read from data source until either:
-    //   1) |last_read_bytes_| is set and |read_complete_| is signalled
-    //   2) |aborted_| is signalled
-    data_source_->Read(read_position_, size, data, [this](int size) {
-      SignalReadCompleted(size);
-    });
+    read_complete_ = false;
+    in_data_source_read_ = true;
+    data_source = data_source_;
   }
 
+  // Blocking read from data source until either:
+  //   1) |last_read_bytes_| is set and |read_complete_| is signalled
+  //   2) |aborted_| is signalled
+  data_source->Read(read_position_, size, data, [this](int size) {
+    SignalReadCompleted(size);
+  });
+
+  int last_read_bytes;
   {
     std::unique_lock<std::mutex> lock(data_source_lock_);
+    in_data_source_read_ = false;
+    // Abort() may wait for the data source to be released.
+    read_condition_.notify_all();
     read_condition_.wait(lock, [this] {
       return aborted_ || read_complete_;
     });
+    if (aborted_) {
+      return AVERROR(EIO);
+    }
     read_complete_ = false;
+    last_read_bytes = last_read_bytes_;
   }
 
-  if (aborted_)
-    return AVERROR(EIO);
-
-  if (last_read_bytes_ == DataSource::kReadError) {
-    aborted_ = true;
+  if (last_read_bytes == DataSource::kReadError) {
+    {
+      std::lock_guard<std::mutex> lock(data_source_lock_);
+      aborted_ = true;
+    }
     error_cb_();
     return AVERROR(EIO);
   }
 
-  if (last_read_bytes_ == DataSource::kAborted)
+  if (last_read_bytes == DataSource::kAborted)
     return AVERROR(EIO);
 
-  read_position_ += last_read_bytes_;
-  return last_read_bytes_;
+  read_position_ += last_read_bytes;
+  return last_read_bytes;
 }
 
 bool BlockingUrlProtocol::GetPosition(int64_t *position_out) {
@@ -113,9 +140,12 @@ bool BlockingUrlProtocol::IsStreaming() {
 }
 
 void BlockingUrlProtocol::SignalReadCompleted(int size) {
-  last_read_bytes_ = size;
-  read_complete_ = true;
-  read_condition_.notify_one();
+  {
+    std::lock_guard<std::mutex> lock(data_source_lock_);
+    last_read_bytes_ = size;
+    read_complete_ = true;
+  }
+  read_condition_.notify_all();
 }
 
 }  // namespace media
@@ -48,6 +48,10 @@ class BlockingUrlProtocol : public FFmpegURLProtocol {
   // |data_source_lock_| allows Abort() to be called from any thread and stop
   // all outstanding access to |data_source_|. Typically Abort() is called from
   // the media thread while ffmpeg is operating on another thread.
+  //
+  // It is never held while DataSource::Read runs, which may block: Abort()
+  // sets |aborted_| and aborts the data source first, then waits for
+  // |in_data_source_read_| to clear before it drops |data_source_|.
   std::mutex data_source_lock_;
   DataSource *data_source_;
 
@@ -60,9 +64,11 @@ class BlockingUrlProtocol : public FFmpegURLProtocol {
   // Cached position within the data source.
   int64_t read_position_;
 
+  // Guarded by |data_source_lock_|.
   bool aborted_;
   bool read_complete_;
-  std::condition_variable_any read_condition_;
+  bool in_data_source_read_;
+  std::condition_variable read_condition_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(BlockingUrlProtocol);
 };
@@ -0,0 +1,62 @@
+//
+// Created by yangbin on 2021/7/21.
+//
+
+#include "buffering_policy.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace media {
+
+// static
+BufferingPolicy BufferingPolicy::FromConfiguration(const PlayerConfiguration &configuration) {
+  BufferingPolicy policy;
+  if (configuration.min_buffer_seconds > 0) {
+    policy.min_buffer_seconds = configuration.min_buffer_seconds;
+  }
+  if (configuration.max_buffer_seconds > 0) {
+    policy.max_buffer_seconds = configuration.max_buffer_seconds;
+  }
+  if (configuration.max_buffer_bytes > 0) {
+    policy.max_buffer_bytes = configuration.max_buffer_bytes;
+  }
+  if (configuration.startup_buffer_seconds > 0) {
+    policy.startup_buffer_seconds = configuration.startup_buffer_seconds;
+  }
+  if (configuration.rebuffer_seconds > 0) {
+    policy.rebuffer_seconds = configuration.rebuffer_seconds;
+  }
+  if (configuration.max_decoded_video_frames > 0) {
+    policy.max_decoded_video_frames = configuration.max_decoded_video_frames;
+  }
+  if (configuration.max_decoded_audio_buffers > 0) {
+    policy.max_decoded_audio_buffers = configuration.max_decoded_audio_buffers;
+  }
+  if (configuration.max_decoder_outputs > 0) {
+    policy.max_decoder_outputs = configuration.max_decoder_outputs;
+  }
+
+  DLOG_IF(WARNING, policy.max_buffer_seconds < policy.min_buffer_seconds)
+      << "max_buffer_seconds is less than min_buffer_seconds: " << policy;
+  policy.max_buffer_seconds = std::max(policy.max_buffer_seconds, policy.min_buffer_seconds);
+  // Playback can not wait for more than the demuxer is allowed to buffer.
+  policy.startup_buffer_seconds = std::min(policy.startup_buffer_seconds, policy.max_buffer_seconds);
+  policy.rebuffer_seconds = std::min(policy.rebuffer_seconds, policy.max_buffer_seconds);
+  return policy;
+}
+
+std::ostream &operator<<(std::ostream &os, const BufferingPolicy &policy) {
+  os << "min_buffer_seconds: " << policy.min_buffer_seconds
+     << " max_buffer_seconds: " << policy.max_buffer_seconds
+     << " max_buffer_bytes: " << policy.max_buffer_bytes
+     << " startup_buffer_seconds: " << policy.startup_buffer_seconds
+     << " rebuffer_seconds: " << policy.rebuffer_seconds
+     << " max_decoded_video_frames: " << policy.max_decoded_video_frames
+     << " max_decoded_audio_buffers: " << policy.max_decoded_audio_buffers
+     << " max_decoder_outputs: " << policy.max_decoder_outputs;
+  return os;
+}
+
+} // namespace media
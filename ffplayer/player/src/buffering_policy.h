@@ -0,0 +1,64 @@
+//
+// Created by yangbin on 2021/7/21.
+//
+
+#ifndef MEDIA_PLAYER_SRC_BUFFERING_POLICY_H_
+#define MEDIA_PLAYER_SRC_BUFFERING_POLICY_H_
+
+#include <ostream>
+
+#include "base/basictypes.h"
+
+#include "ffplayer.h"
+
+namespace media {
+
+/**
+ * How much data the player keeps ahead of the playback position.
+ */
+struct BufferingPolicy {
+
+  /**
+   * Demuxing resumes once a stream has less than |min_buffer_seconds| of
+   * packets, and pauses once it has |max_buffer_seconds|.
+   */
+  double min_buffer_seconds = 2;
+  double max_buffer_seconds = 4;
+
+  /**
+   * Demuxing pauses once any stream holds this many bytes of packets, whatever
+   * its duration. Bounds memory when the duration of the queue is wrong, e.g.
+   * for streams without timestamps or with large B-frame reordering.
+   */
+  int64 max_buffer_bytes = 32 * 1024 * 1024;
+
+  /**
+   * Seconds every stream needs before the player leaves BUFFERING, when the
+   * data source is opened and after an underrun or a seek.
+   */
+  double startup_buffer_seconds = 0.5;
+  double rebuffer_seconds = 1.5;
+
+  /**
+   * Decoded output kept ahead of the renderers.
+   */
+  int max_decoded_video_frames = 3;
+  int max_decoded_audio_buffers = 3;
+
+  /**
+   * Decoded outputs a DecoderStream holds before it stops decoding.
+   */
+  int max_decoder_outputs = 9;
+
+  /**
+   * Defaults overridden by the positive fields of |configuration|.
+   */
+  static BufferingPolicy FromConfiguration(const PlayerConfiguration &configuration);
+
+  friend std::ostream &operator<<(std::ostream &os, const BufferingPolicy &policy);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_BUFFERING_POLICY_H_
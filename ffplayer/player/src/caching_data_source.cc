@@ -0,0 +1,409 @@
+//
+// Created by yangbin on 2021/7/23.
+//
+
+#include "caching_data_source.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace media {
+
+namespace {
+
+// Read ahead when the bitrate is not known yet.
+const int64_t kDefaultReadAheadBytes = 4 * 1024 * 1024;
+
+}
+
+CachingDataSource::CachingDataSource(std::unique_ptr<DataSource> data_source, int page_size, int max_pages)
+    : data_source_(std::move(data_source)),
+      page_size_(page_size),
+      max_pages_(max_pages),
+      size_(-1),
+      is_streaming_(false),
+      read_position_(0),
+      bitrate_(0),
+      end_page_(-1),
+      tail_first_page_(-1),
+      prefetch_failed_(false),
+      reader_fetches_(0),
+      prefetch_idle_(false),
+      stopped_(false),
+      abort_count_(0),
+      cache_hits_(0),
+      cache_misses_(0),
+      inner_reads_(0) {
+  DCHECK(data_source_);
+  DCHECK_GT(page_size_, 0);
+  // Room for the tail and a read-ahead window.
+  DCHECK_GE(max_pages_, 4);
+
+  is_streaming_ = data_source_->IsStreaming();
+  int64_t size;
+  if (data_source_->GetSize(&size) && size >= 0) {
+    size_ = size;
+    end_page_ = (size_ + page_size_ - 1) / page_size_;
+    if (!is_streaming_) {
+      // At most a quarter of the cache is pinned.
+      auto tail_pages = std::min<int64_t>((kTailCacheSize + page_size_ - 1) / page_size_, max_pages_ / 4);
+      tail_first_page_ = std::max<int64_t>(end_page_ - tail_pages, 0);
+    }
+  }
+
+  prefetch_thread_ = std::thread(&CachingDataSource::PrefetchLoop, this);
+}
+
+CachingDataSource::~CachingDataSource() {
+  Stop();
+  prefetch_thread_.join();
+}
+
+void CachingDataSource::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+  }
+  prefetch_condition_.notify_all();
+  page_condition_.notify_all();
+  // Also wakes up a prefetch blocked in the inner source.
+  data_source_->Stop();
+}
+
+void CachingDataSource::Abort() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    abort_count_++;
+  }
+  page_condition_.notify_all();
+  data_source_->Abort();
+}
+
+void CachingDataSource::Read(int64_t position,
+                             int size,
+                             uint8_t *data,
+                             DataSource::ReadCB read_cb) {
+  DCHECK_GE(position, 0);
+  DCHECK_GE(size, 0);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  if (stopped_) {
+    lock.unlock();
+    std::move(read_cb)(kReadError);
+    return;
+  }
+
+  if (size_ >= 0) {
+    position = std::min(position, size_);
+    size = static_cast<int>(std::min(static_cast<int64_t>(size), size_ - position));
+  }
+
+  auto abort_count = abort_count_;
+  if (read_position_ / page_size_ != position / page_size_) {
+    prefetch_failed_ = false;
+  }
+  read_position_ = position;
+  prefetch_condition_.notify_one();
+
+  int copied = 0;
+  int error = 0;
+  bool missed = false;
+  while (copied < size) {
+    auto offset = position + copied;
+    auto index = offset / page_size_;
+
+    auto it = pages_.find(index);
+    if (it == pages_.end()) {
+      if (!missed) {
+        cache_misses_++;
+        missed = true;
+      }
+      if (pending_pages_.count(index)) {
+        // Being prefetched, wait for it instead of reading it twice.
+        page_condition_.wait(lock, [&]() {
+          return stopped_ || abort_count_ != abort_count || pending_pages_.count(index) == 0;
+        });
+        if (stopped_) {
+          error = kReadError;
+          break;
+        }
+        if (abort_count_ != abort_count) {
+          error = kAborted;
+          break;
+        }
+        // Look again, the prefetch may have failed.
+        continue;
+      }
+      pending_pages_.insert(index);
+      reader_fetches_++;
+      lock.unlock();
+      auto result = FetchPage(index);
+      lock.lock();
+      reader_fetches_--;
+      if (result < 0) {
+        error = result;
+        break;
+      }
+      it = pages_.find(index);
+      if (it == pages_.end()) {
+        // End of stream.
+        break;
+      }
+    } else if (!missed) {
+      cache_hits_++;
+    }
+    missed = false;
+
+    auto &page = *it->second;
+    lru_.splice(lru_.begin(), lru_, it->second);
+
+    auto page_offset = static_cast<size_t>(offset - index * page_size_);
+    if (page_offset >= page.data.size()) {
+      // Past the end of a short page.
+      break;
+    }
+    auto count = std::min(static_cast<size_t>(size - copied), page.data.size() - page_offset);
+    memcpy(data + copied, page.data.data() + page_offset, count);
+    copied += static_cast<int>(count);
+    if (page.data.size() < static_cast<size_t>(page_size_) && page_offset + count == page.data.size()) {
+      break;
+    }
+  }
+
+  read_position_ = position + copied;
+  lock.unlock();
+  prefetch_condition_.notify_one();
+
+  if (copied == 0 && error != 0) {
+    std::move(read_cb)(error);
+    return;
+  }
+  std::move(read_cb)(copied);
+}
+
+bool CachingDataSource::GetSize(int64_t *size_out) {
+  if (size_ < 0) {
+    return false;
+  }
+  *size_out = size_;
+  return true;
+}
+
+bool CachingDataSource::IsStreaming() {
+  return is_streaming_;
+}
+
+void CachingDataSource::SetBitrate(int bitrate) {
+  if (bitrate <= 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    bitrate_ = bitrate;
+  }
+  data_source_->SetBitrate(bitrate);
+  prefetch_condition_.notify_one();
+}
+
+bool CachingDataSource::AssumeFullyBuffered() const {
+  return data_source_->AssumeFullyBuffered();
+}
+
+int64_t CachingDataSource::GetMemoryUsage() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return static_cast<int64_t>(pages_.size()) * page_size_;
+}
+
+int64_t CachingDataSource::read_ahead_bytes() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return ReadAheadBytesLocked();
+}
+
+int64_t CachingDataSource::ReadAheadBytesLocked() const {
+  auto bytes = bitrate_ > 0 ? static_cast<int64_t>(bitrate_) / 8 * kReadAheadSeconds : kDefaultReadAheadBytes;
+  auto tail_pages = tail_first_page_ >= 0 ? end_page_ - tail_first_page_ : 0;
+  // Keep a few pages for the reader, which may be behind the window.
+  auto max_bytes = std::max<int64_t>(max_pages_ - tail_pages - 2, 1) * page_size_;
+  return std::max<int64_t>(std::min(bytes, max_bytes), page_size_);
+}
+
+void CachingDataSource::WaitForPrefetchForTesting() {
+  std::unique_lock<std::mutex> lock(lock_);
+  page_condition_.wait(lock, [this]() {
+    return stopped_ || (prefetch_idle_ && NextPageToPrefetchLocked() < 0);
+  });
+}
+
+void CachingDataSource::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!stopped_) {
+    if (reader_fetches_ > 0) {
+      prefetch_condition_.wait(lock);
+      continue;
+    }
+    auto index = NextPageToPrefetchLocked();
+    if (index < 0) {
+      prefetch_idle_ = true;
+      page_condition_.notify_all();
+      prefetch_condition_.wait(lock);
+      continue;
+    }
+    prefetch_idle_ = false;
+    pending_pages_.insert(index);
+    lock.unlock();
+    auto result = FetchPage(index);
+    lock.lock();
+    if (result < 0) {
+      DLOG(WARNING) << "prefetch page " << index << " failed: " << result;
+      prefetch_failed_ = true;
+    }
+  }
+}
+
+int64_t CachingDataSource::NextPageToPrefetchLocked() const {
+  if (stopped_ || prefetch_failed_) {
+    return -1;
+  }
+
+  auto first = read_position_ / page_size_;
+  if (end_page_ >= 0 && first >= end_page_) {
+    return -1;
+  }
+  if (!IsCachedOrPendingLocked(first)) {
+    return first;
+  }
+
+  // The index is read next when the container has one at the end.
+  if (tail_first_page_ >= 0) {
+    for (auto index = tail_first_page_; index < end_page_; ++index) {
+      if (!IsCachedOrPendingLocked(index)) {
+        return index;
+      }
+    }
+  }
+
+  auto last = (read_position_ + ReadAheadBytesLocked() - 1) / page_size_;
+  if (end_page_ >= 0) {
+    last = std::min(last, end_page_ - 1);
+  }
+  for (auto index = first + 1; index <= last; ++index) {
+    if (!IsCachedOrPendingLocked(index)) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+bool CachingDataSource::IsCachedOrPendingLocked(int64_t index) const {
+  return pages_.count(index) || pending_pages_.count(index);
+}
+
+bool CachingDataSource::IsTailPage(int64_t index) const {
+  return tail_first_page_ >= 0 && index >= tail_first_page_;
+}
+
+int CachingDataSource::FetchPage(int64_t index) {
+  Page page;
+  page.index = index;
+  page.pinned = IsTailPage(index);
+  page.data.resize(static_cast<size_t>(page_size_));
+
+  // The inner source may return less than asked before its end.
+  int result = 0;
+  while (result < page_size_) {
+    auto read = ReadInner(index * page_size_ + result, page_size_ - result, page.data.data() + result);
+    if (read < 0) {
+      result = read;
+      break;
+    }
+    if (read == 0) {
+      break;
+    }
+    result += read;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  pending_pages_.erase(index);
+  if (result >= 0) {
+    if (result < page_size_ && end_page_ < 0) {
+      end_page_ = result == 0 ? index : index + 1;
+    }
+    if (result > 0) {
+      page.data.resize(static_cast<size_t>(result));
+      InsertPageLocked(std::move(page));
+    }
+  }
+  page_condition_.notify_all();
+  return result;
+}
+
+int CachingDataSource::ReadInner(int64_t position, int size, uint8_t *data) {
+  struct ReadState {
+    std::mutex lock;
+    std::condition_variable condition;
+    bool completed = false;
+    int result = 0;
+  };
+  std::lock_guard<std::mutex> data_source_lock(data_source_lock_);
+  // Shared with the callback, which may run on another thread.
+  auto state = std::make_shared<ReadState>();
+  data_source_->Read(position, size, data, [state](int result) {
+    std::lock_guard<std::mutex> lock(state->lock);
+    state->result = result;
+    state->completed = true;
+    state->condition.notify_one();
+  });
+
+  std::unique_lock<std::mutex> lock(state->lock);
+  state->condition.wait(lock, [&state]() {
+    return state->completed;
+  });
+
+  {
+    std::lock_guard<std::mutex> cache_lock(lock_);
+    inner_reads_++;
+  }
+  return state->result;
+}
+
+void CachingDataSource::InsertPageLocked(Page page) {
+  DCHECK(!pages_.count(page.index));
+  auto index = page.index;
+  lru_.push_front(std::move(page));
+  pages_[index] = lru_.begin();
+
+  while (static_cast<int>(pages_.size()) > max_pages_) {
+    auto victim = FindEvictionCandidateLocked();
+    if (victim == lru_.end()) {
+      break;
+    }
+    pages_.erase(victim->index);
+    lru_.erase(victim);
+  }
+}
+
+CachingDataSource::PageList::iterator CachingDataSource::FindEvictionCandidateLocked() {
+  auto window_first = read_position_ / page_size_;
+  auto window_last = (read_position_ + ReadAheadBytesLocked() - 1) / page_size_;
+  auto fallback = lru_.end();
+  for (auto it = lru_.rbegin(); it != lru_.rend(); ++it) {
+    if (it->pinned) {
+      continue;
+    }
+    auto candidate = std::next(it).base();
+    if (it->index < window_first || it->index > window_last) {
+      return candidate;
+    }
+    if (fallback == lru_.end()) {
+      fallback = candidate;
+    }
+  }
+  return fallback;
+}
+
+} // namespace media
@@ -0,0 +1,186 @@
+//
+// Created by yangbin on 2021/7/23.
+//
+
+#ifndef MEDIA_PLAYER_SRC_CACHING_DATA_SOURCE_H_
+#define MEDIA_PLAYER_SRC_CACHING_DATA_SOURCE_H_
+
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "data_source.h"
+
+namespace media {
+
+/**
+ * Decorates a DataSource with a page cache and a read-ahead thread.
+ *
+ * The inner source is read in pages of |page_size| bytes, kept in LRU order up
+ * to |max_pages|. A prefetch thread fills the pages ahead of the last read
+ * position, as many seconds of media as |kReadAheadSeconds| at the bitrate from
+ * [SetBitrate], so the demuxer thread mostly copies from memory instead of
+ * making a round trip into the inner source for every AVIO read.
+ *
+ * The last |kTailCacheSize| bytes are fetched early and never evicted, most
+ * containers keep their index (moov, cues, ...) there and FFmpeg seeks to it
+ * while opening and while seeking.
+ *
+ * [Read] may be called from one thread at a time, like BlockingUrlProtocol does.
+ */
+class CachingDataSource : public DataSource {
+
+ public:
+
+  static const int kDefaultPageSize = 64 * 1024;
+  static const int kDefaultMaxPages = 256;
+
+  // Read ahead this long at the bitrate of the media.
+  static const int kReadAheadSeconds = 10;
+
+  static const int kTailCacheSize = 1024 * 1024;
+
+  explicit CachingDataSource(std::unique_ptr<DataSource> data_source,
+                             int page_size = kDefaultPageSize,
+                             int max_pages = kDefaultMaxPages);
+  ~CachingDataSource() override;
+
+  // Implementation of DataSource.
+  void Stop() override;
+  void Abort() override;
+  void Read(int64_t position,
+            int size,
+            uint8_t *data,
+            DataSource::ReadCB read_cb) override;
+  bool GetSize(int64_t *size_out) override;
+  bool IsStreaming() override;
+  void SetBitrate(int bitrate) override;
+  bool AssumeFullyBuffered() const override;
+  int64_t GetMemoryUsage() override;
+
+  /**
+   * Bytes the prefetch thread keeps ahead of the read position. Changes with
+   * the bitrate, so it is read under the lock.
+   */
+  int64_t read_ahead_bytes() const;
+
+  /**
+   * Block until the prefetch thread has nothing to do. For tests and
+   * benchmarks.
+   */
+  void WaitForPrefetchForTesting();
+
+  int64_t cache_hits_for_testing() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return cache_hits_;
+  }
+  int64_t cache_misses_for_testing() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return cache_misses_;
+  }
+  int64_t inner_reads_for_testing() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return inner_reads_;
+  }
+  size_t cached_pages_for_testing() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return pages_.size();
+  }
+
+ private:
+
+  struct Page {
+    int64_t index;
+    // Shorter than the page size for the last page.
+    std::vector<uint8_t> data;
+    bool pinned;
+  };
+
+  typedef std::list<Page> PageList;
+
+  std::unique_ptr<DataSource> data_source_;
+  std::mutex data_source_lock_;
+
+  const int page_size_;
+  const int max_pages_;
+
+  // -1 if the size is unknown.
+  int64_t size_;
+  bool is_streaming_;
+
+  // Guards everything below.
+  mutable std::mutex lock_;
+
+  // Most recently used first.
+  PageList lru_;
+  std::unordered_map<int64_t, PageList::iterator> pages_;
+
+  // Pages being read from |data_source_|, by any thread.
+  std::set<int64_t> pending_pages_;
+  std::condition_variable page_condition_;
+
+  int64_t read_position_;
+  int bitrate_;
+
+  // Count of pages, -1 until the end of an unknown sized source is reached.
+  int64_t end_page_;
+
+  // First page of the tail cache, -1 if there is none.
+  int64_t tail_first_page_;
+
+  // Set when prefetch failed, no retry until the reader moves to another page.
+  bool prefetch_failed_;
+
+  // Pages the reader is fetching itself, prefetch waits for them so that it
+  // does not queue up in front of the reader.
+  int reader_fetches_;
+
+  bool prefetch_idle_;
+  bool stopped_;
+  // Bumped by Abort(), reads waiting for a page since an older value give up.
+  int abort_count_;
+  std::condition_variable prefetch_condition_;
+  std::thread prefetch_thread_;
+
+  int64_t cache_hits_;
+  int64_t cache_misses_;
+  int64_t inner_reads_;
+
+  void PrefetchLoop();
+
+  // Next page the prefetch thread should fetch, or -1 if there is none.
+  int64_t NextPageToPrefetchLocked() const;
+
+  int64_t ReadAheadBytesLocked() const;
+
+  bool IsCachedOrPendingLocked(int64_t index) const;
+
+  bool IsTailPage(int64_t index) const;
+
+  // Read page |index| from |data_source_| into the cache. Called without
+  // |lock_| held, |index| must be in |pending_pages_|.
+  // @return the bytes read or a DataSource error.
+  int FetchPage(int64_t index);
+
+  // Blocking read of the inner source. Reads are serialized, a DataSource
+  // supports only one outstanding read.
+  int ReadInner(int64_t position, int size, uint8_t *data);
+
+  void InsertPageLocked(Page page);
+
+  // Least recently used page which is neither pinned nor in the read-ahead
+  // window, or the least recently used unpinned page.
+  PageList::iterator FindEvictionCandidateLocked();
+
+  DELETE_COPY_AND_ASSIGN(CachingDataSource);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_CACHING_DATA_SOURCE_H_
@@ -8,36 +8,73 @@
 
 namespace media {
 
+namespace {
+
+// A blank packet in |storage|, or allocated if AVPacket may not be held by
+// value. av_init_packet is deprecated, unref resets a zeroed packet to the
+// defaults.
+AVPacket *InitPacket(AVPacket *storage) {
+  if (storage) {
+    *storage = AVPacket();
+    av_packet_unref(storage);
+    return storage;
+  }
+  auto *packet = av_packet_alloc();
+  CHECK(packet) << "can not allocate packet";
+  return packet;
+}
+
+} // namespace
+
+#if LIBAVCODEC_VERSION_MAJOR < 59
+#define PACKET_STORAGE (&av_packet_storage_)
+#else
+#define PACKET_STORAGE nullptr
+#endif
+
 // static
 std::shared_ptr<DecoderBuffer> DecoderBuffer::CreateEOSBuffer() {
-  return std::make_shared<DecoderBuffer>(nullptr);
+  return std::make_shared<DecoderBuffer>();
 }
 
-DecoderBuffer::DecoderBuffer(std::unique_ptr<AVPacket, AVPacketDeleter> av_packet)
-    : timestamp_(-1) {
-  if (av_packet) {
-    av_packet_ = new AVPacket;
-    *av_packet_ = *av_packet;
-    av_packet_ref(av_packet_, av_packet.get());
-  } else {
-    av_packet_ = nullptr;
-  }
+DecoderBuffer::DecoderBuffer()
+    : av_packet_(InitPacket(PACKET_STORAGE)), end_of_stream_(true), timestamp_(-1) {
 }
 
-DecoderBuffer::~DecoderBuffer() {
-  if (av_packet_) {
+DecoderBuffer::DecoderBuffer(AVPacket *packet)
+    : av_packet_(InitPacket(PACKET_STORAGE)), end_of_stream_(false), timestamp_(-1) {
+  DCHECK(packet);
+  av_packet_move_ref(av_packet_, packet);
+}
+
+DecoderBuffer::DecoderBuffer(DecoderBuffer &&other) noexcept
+    : av_packet_(InitPacket(PACKET_STORAGE)), end_of_stream_(other.end_of_stream_), timestamp_(other.timestamp_) {
+  av_packet_move_ref(av_packet_, other.av_packet_);
+  other.end_of_stream_ = true;
+}
+
+DecoderBuffer &DecoderBuffer::operator=(DecoderBuffer &&other) noexcept {
+  if (this != &other) {
     av_packet_unref(av_packet_);
-    delete av_packet_;
+    av_packet_move_ref(av_packet_, other.av_packet_);
+    end_of_stream_ = other.end_of_stream_;
+    timestamp_ = other.timestamp_;
+    other.end_of_stream_ = true;
   }
+  return *this;
 }
 
-size_t DecoderBuffer::data_size() {
+DecoderBuffer::~DecoderBuffer() {
+#if LIBAVCODEC_VERSION_MAJOR < 59
+  av_packet_unref(av_packet_);
+#else
+  av_packet_free(&av_packet_);
+#endif
+}
+
+size_t DecoderBuffer::data_size() const {
   DCHECK(!end_of_stream());
   return av_packet_->size;
 }
 
-bool DecoderBuffer::end_of_stream() {
-  return av_packet_ == nullptr;
 }
-
-}
\ No newline at end of file
@@ -5,20 +5,44 @@
 #ifndef MEDIA_PLAYER_SRC_DECODER_BUFFER_H_
 #define MEDIA_PLAYER_SRC_DECODER_BUFFER_H_
 
+#include <memory>
+
 #include <base/basictypes.h>
 
 #include "ffmpeg_deleters.h"
 
 namespace media {
 
+/**
+ * A demuxed packet, or the end of stream.
+ *
+ * Before FFmpeg 5.0 the size of AVPacket is part of the ABI and the packet is
+ * held by value, so a buffer made by std::make_shared is one allocation. From
+ * 5.0 it is made by av_packet_alloc. It takes the reference of the packet it is
+ * made from instead of adding one. Move-only.
+ */
 class DecoderBuffer {
 
  public:
-  explicit DecoderBuffer(std::unique_ptr<AVPacket, AVPacketDeleter> av_packet);
+
+  /**
+   * The end of stream.
+   */
+  DecoderBuffer();
+
+  /**
+   * Take the reference of |packet| by av_packet_move_ref. |packet| is left
+   * blank, it can be read into again.
+   */
+  explicit DecoderBuffer(AVPacket *packet);
+
+  DecoderBuffer(DecoderBuffer &&other) noexcept;
+
+  DecoderBuffer &operator=(DecoderBuffer &&other) noexcept;
 
   static std::shared_ptr<DecoderBuffer> CreateEOSBuffer();
 
-  size_t data_size();
+  size_t data_size() const;
 
   double timestamp() const {
     return timestamp_;
@@ -28,17 +52,30 @@ class DecoderBuffer {
     timestamp_ = timestamp;
   }
 
+  /**
+   * @return null for the end of stream.
+   */
   AVPacket *av_packet() {
-    return av_packet_;
+    return end_of_stream_ ? nullptr : av_packet_;
+  }
+
+  bool end_of_stream() const {
+    return end_of_stream_;
   }
 
-  bool end_of_stream();
   virtual ~DecoderBuffer();
 
  private:
 
+#if LIBAVCODEC_VERSION_MAJOR < 59
+  AVPacket av_packet_storage_;
+#endif
+
+  // Never null, points to |av_packet_storage_| if there is one.
   AVPacket *av_packet_;
 
+  bool end_of_stream_;
+
   // pts.
   double timestamp_;
 
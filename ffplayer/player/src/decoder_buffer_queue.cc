@@ -8,7 +8,8 @@
 
 namespace media {
 
-DecoderBufferQueue::DecoderBufferQueue() : data_size_(0), earliest_valid_timestamp_(-1) {
+DecoderBufferQueue::DecoderBufferQueue()
+    : first_in_order_index_(0), in_order_count_(0), data_size_(0), earliest_valid_timestamp_(-1) {
 
 }
 
@@ -17,53 +18,64 @@ DecoderBufferQueue::~DecoderBufferQueue() = default;
 void DecoderBufferQueue::Push(std::shared_ptr<DecoderBuffer> buffer) {
   DCHECK(!buffer->end_of_stream());
 
-  queue_.push_back(buffer);
   data_size_ += buffer->data_size();
+  auto timestamp = buffer->timestamp();
+  queue_.push_back({std::move(buffer), false});
 
-  if (buffer->timestamp() < 0) {
-    DLOG(WARNING) << "Buffer has no timestamp: " << buffer->timestamp();
+  if (timestamp < 0) {
+    DLOG(WARNING) << "Buffer has no timestamp: " << timestamp;
     return;
   }
 
   if (earliest_valid_timestamp_ < 0) {
-    earliest_valid_timestamp_ = buffer->timestamp();
+    earliest_valid_timestamp_ = timestamp;
   }
 
-  if (buffer->timestamp() < earliest_valid_timestamp_) {
+  if (timestamp < earliest_valid_timestamp_) {
 //    DLOG(WARNING) << "Out of order timestamps: "
-//                  << buffer->timestamp() << " vs. "
+//                  << timestamp << " vs. "
 //                  << earliest_valid_timestamp_;
     return;
   }
 
-  earliest_valid_timestamp_ = buffer->timestamp();
-  in_order_queue_.emplace_back(std::move(buffer));
-
+  earliest_valid_timestamp_ = timestamp;
+  queue_.back().in_order = true;
+  if (in_order_count_++ == 0) {
+    first_in_order_index_ = queue_.size() - 1;
+  }
 }
 
 std::shared_ptr<DecoderBuffer> DecoderBufferQueue::Pop() {
   DCHECK(!queue_.empty());
 
-  // FIXME crash here. queue_ size == 0
-  auto buffer = std::move(queue_.front());
+  auto entry = std::move(queue_.front());
   queue_.pop_front();
 
-  auto buffer_data_size = buffer->data_size();
+  auto buffer_data_size = entry.buffer->data_size();
   DCHECK_LE(buffer_data_size, data_size_);
   data_size_ -= buffer_data_size;
 
-  if (!in_order_queue_.empty() && in_order_queue_.front() == buffer) {
-    in_order_queue_.pop_front();
+  if (in_order_count_ > 0) {
+    if (!entry.in_order) {
+      first_in_order_index_--;
+    } else if (--in_order_count_ > 0) {
+      // Skip the out of order buffers up to the next in order one.
+      first_in_order_index_ = 0;
+      while (!queue_[first_in_order_index_].in_order) {
+        first_in_order_index_++;
+      }
+    }
   }
 
-  return buffer;
+  return std::move(entry.buffer);
 }
 
 void DecoderBufferQueue::Clear() {
   data_size_ = 0;
   earliest_valid_timestamp_ = -1;
+  first_in_order_index_ = 0;
+  in_order_count_ = 0;
   queue_.clear();
-  in_order_queue_.clear();
 }
 
 bool DecoderBufferQueue::IsEmpty() {
@@ -71,12 +83,11 @@ bool DecoderBufferQueue::IsEmpty() {
 }
 
 double DecoderBufferQueue::Duration() {
-  if (in_order_queue_.size() < 2) {
+  if (in_order_count_ < 2) {
     return 0;
   }
-  auto start = in_order_queue_.front()->timestamp();
-  auto end = in_order_queue_.back()->timestamp();
-  return end - start;
+  auto start = queue_[first_in_order_index_].buffer->timestamp();
+  return earliest_valid_timestamp_ - start;
 }
 
-}
\ No newline at end of file
+}
@@ -5,12 +5,19 @@
 #ifndef MEDIA_PLAYER_SRC_DECODER_BUFFER_QUEUE_H_
 #define MEDIA_PLAYER_SRC_DECODER_BUFFER_QUEUE_H_
 
-#include "queue"
+#include "deque"
 
 #include "decoder_buffer.h"
 
 namespace media {
 
+/**
+ * Packets of a demuxer stream, in decode order.
+ *
+ * The buffered duration is measured over the buffers whose timestamps do not
+ * go backwards, e.g. skipping the B-frames after their reference frame, which
+ * are flagged in the same queue.
+ */
 class DecoderBufferQueue {
 
  public:
@@ -35,11 +42,21 @@ class DecoderBufferQueue {
 
  private:
 
-  std::deque<std::shared_ptr<DecoderBuffer>> queue_;
-  std::deque<std::shared_ptr<DecoderBuffer>> in_order_queue_;
+  struct Entry {
+    std::shared_ptr<DecoderBuffer> buffer;
+    bool in_order;
+  };
+
+  std::deque<Entry> queue_;
+
+  // Index in |queue_| of the first in order buffer, valid if
+  // |in_order_count_| is not 0.
+  size_t first_in_order_index_;
+  size_t in_order_count_;
 
   size_t data_size_;
 
+  // Timestamp of the last in order buffer.
   double earliest_valid_timestamp_;
 
 };
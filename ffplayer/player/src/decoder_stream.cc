@@ -9,6 +9,8 @@
 
 #include "base/bind_to_current_loop.h"
 #include "base/lambda.h"
+#include "base/time_ticks.h"
+#include "base/trace_event.h"
 
 namespace media {
 
@@ -55,28 +57,37 @@ void DecoderStream<StreamType>::ReadFromDemuxerStream() {
   DCHECK(task_runner_->BelongsToCurrentThread());
   if (CanDecodeMore() && !reading_demuxer_stream_) {
     reading_demuxer_stream_ = true;
-    demuxer_stream_->Read(std::bind(&DecoderStream<StreamType>::OnBufferReady, this, std::placeholders::_1));
+    demuxer_stream_->Read(std::bind(&DecoderStream<StreamType>::OnBufferReady,
+                                    this, flush_generation_.load(), std::placeholders::_1));
   }
 }
 
 template<DemuxerStream::Type StreamType>
-void DecoderStream<StreamType>::OnBufferReady(std::shared_ptr<DecoderBuffer> buffer) {
+void DecoderStream<StreamType>::OnBufferReady(int generation, std::shared_ptr<DecoderBuffer> buffer) {
   DCHECK(buffer);
   DCHECK(reading_demuxer_stream_);
   reading_demuxer_stream_ = false;
   task_runner_->PostTask(FROM_HERE,
-                         [weak_this(std::weak_ptr<DecoderStream<StreamType>>(this->shared_from_this())), buffer]() {
+                         [weak_this(std::weak_ptr<DecoderStream<StreamType>>(this->shared_from_this())),
+                             generation, buffer]() {
                            auto ptr = weak_this.lock();
                            if (ptr) {
-                             ptr->DecodeTask(buffer);
+                             ptr->DecodeTask(generation, buffer);
                            }
                          });
 }
 
 template<DemuxerStream::Type StreamType>
-void DecoderStream<StreamType>::DecodeTask(std::shared_ptr<DecoderBuffer> decoder_buffer) {
+void DecoderStream<StreamType>::DecodeTask(int generation, std::shared_ptr<DecoderBuffer> decoder_buffer) {
   DCHECK(task_runner_->BelongsToCurrentThread());
 
+  if (generation != flush_generation_.load()) {
+    DLOG(INFO) << "drop a buffer read before flush";
+    task_runner_->PostTask(FROM_HERE,
+                           bind_weak(&DecoderStream<StreamType>::ReadFromDemuxerStream, this->shared_from_this()));
+    return;
+  }
+
   if (decoder_buffer->end_of_stream()) {
     DLOG(WARNING) << "an end stream decode buffer";
 //    decode_task_runner_->PostTask(FROM_HERE,
@@ -95,7 +106,15 @@ void DecoderStream<StreamType>::DecodeTask(std::shared_ptr<DecoderBuffer> decode
   DCHECK_LT(pending_decode_requests_, GetMaxDecodeRequests());
 
   ++pending_decode_requests_;
-  decoder_->Decode(std::move(decoder_buffer));
+  auto decode_begin = TimeTicks::Now();
+  {
+    TRACE_EVENT(StreamType == DemuxerStream::Video ? "video" : "audio", "Decode");
+    decoder_->Decode(std::move(decoder_buffer));
+  }
+  if (metrics_) {
+    metrics_->stream(StreamType == DemuxerStream::Video).decode_time_us.Record(
+        (TimeTicks::Now() - decode_begin).InMicroseconds());
+  }
   --pending_decode_requests_;
 
   task_runner_->PostTask(FROM_HERE,
@@ -106,14 +125,17 @@ void DecoderStream<StreamType>::DecodeTask(std::shared_ptr<DecoderBuffer> decode
 template<DemuxerStream::Type StreamType>
 bool DecoderStream<StreamType>::CanDecodeMore() {
   DCHECK(task_runner_->BelongsToCurrentThread());
-  return pending_decode_requests_ < GetMaxDecodeRequests() && outputs_.size() <= 9;
+  return pending_decode_requests_ < GetMaxDecodeRequests() && static_cast<int>(outputs_.size()) < max_outputs_;
 }
 
 template<DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::OnFrameAvailable(std::shared_ptr<Output> output) {
   DCHECK(task_runner_->BelongsToCurrentThread());
 
-  DLOG_IF(WARNING, outputs_.size() > 9) << "outputs is full enough. " << outputs_.size();
+  DLOG_IF(WARNING, static_cast<int>(outputs_.size()) >= max_outputs_) << "outputs is full enough. " << outputs_.size();
+  if (metrics_) {
+    metrics_->stream(StreamType == DemuxerStream::Video).decoded.fetch_add(1, std::memory_order_relaxed);
+  }
   outputs_.emplace_back(std::move(output));
   if (read_callback_) {
     std::shared_ptr<Output> front = std::move(outputs_.front());
@@ -132,8 +154,41 @@ int DecoderStream<StreamType>::GetMaxDecodeRequests() {
 
 template<DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::Flush() {
-  decoder_->Flush();
-  outputs_.clear();
+  // Buffers already read are dropped from now on, the decoder and the outputs
+  // are only touched on |task_runner_|.
+  flush_generation_++;
+  task_runner_->PostTask(FROM_HERE,
+                         [weak_this(std::weak_ptr<DecoderStream<StreamType>>(this->shared_from_this()))]() {
+                           auto ptr = weak_this.lock();
+                           if (ptr) {
+                             ptr->decoder_->Flush();
+                             ptr->outputs_.clear();
+                           }
+                         });
+}
+
+template<DemuxerStream::Type StreamType>
+void DecoderStream<StreamType>::SetTargetTimestamp(double timestamp) {
+  // The decoder is only used on |task_runner_|.
+  task_runner_->PostTask(FROM_HERE,
+                         [weak_this(std::weak_ptr<DecoderStream<StreamType>>(this->shared_from_this())), timestamp]() {
+                           auto ptr = weak_this.lock();
+                           if (ptr && ptr->decoder_) {
+                             ptr->traits_->SetTargetTimestamp(ptr->decoder_.get(), timestamp);
+                           }
+                         });
+}
+
+template<DemuxerStream::Type StreamType>
+void DecoderStream<StreamType>::SetKeyframesOnly(bool keyframes_only) {
+  task_runner_->PostTask(FROM_HERE,
+                         [weak_this(std::weak_ptr<DecoderStream<StreamType>>(this->shared_from_this())),
+                             keyframes_only]() {
+                           auto ptr = weak_this.lock();
+                           if (ptr && ptr->decoder_) {
+                             ptr->traits_->SetKeyframesOnly(ptr->decoder_.get(), keyframes_only);
+                           }
+                         });
 }
 
 template
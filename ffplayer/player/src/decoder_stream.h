@@ -5,6 +5,7 @@
 #ifndef MEDIA_PLAYER_SRC_DECODER_STREAM_H_
 #define MEDIA_PLAYER_SRC_DECODER_STREAM_H_
 
+#include <atomic>
 #include <ostream>
 #include "memory"
 #include "functional"
@@ -14,6 +15,7 @@
 
 #include "demuxer_stream.h"
 #include "decoder_stream_traits.h"
+#include "media_metrics.h"
 
 namespace media {
 
@@ -36,8 +38,38 @@ class DecoderStream : public std::enable_shared_from_this<DecoderStream<StreamTy
   using InitCallback = std::function<void(bool success)>;
   void Initialize(DemuxerStream *stream, InitCallback init_callback);
 
+  /**
+   * Callable from any thread. The decoder is flushed and the outputs dropped
+   * on |task_runner_|, before any task posted there after this call.
+   */
   void Flush();
 
+  /**
+   * Outputs before |timestamp| are decoded but discarded by the decoder, after
+   * an accurate seek. 0 turns it off.
+   */
+  void SetTargetTimestamp(double timestamp);
+
+  /**
+   * Only decode keyframes, while the user is scrubbing.
+   */
+  void SetKeyframesOnly(bool keyframes_only);
+
+  /**
+   * Count of decoded outputs to hold before decoding pauses.
+   */
+  void set_max_outputs(int max_outputs) {
+    max_outputs_ = max_outputs;
+  }
+
+  /**
+   * Decode times and outputs go to |metrics|, which may be null. Must be set
+   * before |Initialize|.
+   */
+  void set_metrics(std::shared_ptr<MediaMetrics> metrics) {
+    metrics_ = std::move(metrics);
+  }
+
   friend std::ostream &operator<<(std::ostream &os, const DecoderStream<StreamType> &stream) {
     os << " outputs_: " << stream.outputs_.size()
        << " pending_decode_requests_: " << stream.pending_decode_requests_
@@ -61,13 +93,21 @@ class DecoderStream : public std::enable_shared_from_this<DecoderStream<StreamTy
 
   int pending_decode_requests_;
 
+  int max_outputs_ = 9;
+
+  std::shared_ptr<MediaMetrics> metrics_;
+
   bool reading_demuxer_stream_ = false;
 
+  // Increased by every Flush. Buffers read before a flush are dropped instead
+  // of decoded, they belong to a position which was seeked away from.
+  std::atomic_int flush_generation_{0};
+
   void ReadFromDemuxerStream();
 
-  void OnBufferReady(std::shared_ptr<DecoderBuffer> buffer);
+  void OnBufferReady(int generation, std::shared_ptr<DecoderBuffer> buffer);
 
-  void DecodeTask(std::shared_ptr<DecoderBuffer> decoder_buffer);
+  void DecodeTask(int generation, std::shared_ptr<DecoderBuffer> decoder_buffer);
 
   void OnFrameAvailable(std::shared_ptr<Output> output);
 
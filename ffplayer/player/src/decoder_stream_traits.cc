@@ -6,6 +6,13 @@
 
 namespace media {
 
+DecoderStreamTraits<DemuxerStream::Video>::DecoderStreamTraits(VideoDecoderThreadType thread_type,
+                                                               int thread_count,
+                                                               std::vector<AVHWDeviceType> hw_device_types)
+    : thread_type_(thread_type), thread_count_(thread_count), hw_device_types_(std::move(hw_device_types)) {
+
+}
+
 DecoderStreamTraits<DemuxerStream::Video>::~DecoderStreamTraits() {
 
 }
@@ -15,7 +22,19 @@ void DecoderStreamTraits<DemuxerStream::Video>::InitializeDecoder(
     DemuxerStream *stream,
     OutputCallback output_callback
 ) {
-  decoder->Initialize(stream->video_decode_config(), stream, std::move(output_callback));
+  auto config = stream->video_decode_config();
+  config.set_threading(thread_type_, thread_count_);
+  config.set_hw_device_types(hw_device_types_);
+  config.set_display_size(display_width_, display_height_);
+  decoder->Initialize(config, stream, std::move(output_callback));
+}
+
+void DecoderStreamTraits<DemuxerStream::Video>::SetTargetTimestamp(VideoDecoder *decoder, double timestamp) {
+  decoder->SetTargetTimestamp(timestamp);
+}
+
+void DecoderStreamTraits<DemuxerStream::Video>::SetKeyframesOnly(VideoDecoder *decoder, bool keyframes_only) {
+  decoder->SetKeyframesOnly(keyframes_only);
 }
 
 DecoderStreamTraits<DemuxerStream::Audio>::~DecoderStreamTraits() {
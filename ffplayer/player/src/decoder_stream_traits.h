@@ -26,10 +26,33 @@ class DecoderStreamTraits<DemuxerStream::Video> {
 
   using OutputCallback = VideoDecoder::OutputCallback;
 
+  explicit DecoderStreamTraits(VideoDecoderThreadType thread_type = VideoDecoderThreadType::kAuto,
+                               int thread_count = 0,
+                               std::vector<AVHWDeviceType> hw_device_types = {});
+
   ~DecoderStreamTraits();
 
   void InitializeDecoder(DecoderType *decoder, DemuxerStream *stream, OutputCallback output_callback);
 
+  void SetTargetTimestamp(DecoderType *decoder, double timestamp);
+
+  void SetKeyframesOnly(DecoderType *decoder, bool keyframes_only);
+
+  /**
+   * See VideoDecodeConfig::set_display_size, used when the decoder is initialized.
+   */
+  void SetDisplaySize(int width, int height) {
+    display_width_ = width;
+    display_height_ = height;
+  }
+
+ private:
+  VideoDecoderThreadType thread_type_;
+  int thread_count_;
+  std::vector<AVHWDeviceType> hw_device_types_;
+  int display_width_ = 0;
+  int display_height_ = 0;
+
 };
 
 template<>
@@ -45,6 +68,12 @@ class DecoderStreamTraits<DemuxerStream::Audio> {
 
   void InitializeDecoder(DecoderType *decoder, DemuxerStream *stream, OutputCallback output_callback);
 
+  // AudioRenderer drops the buffers before the target, decoding audio is cheap.
+  void SetTargetTimestamp(DecoderType *, double) {}
+
+  // Every audio frame is a keyframe.
+  void SetKeyframesOnly(DecoderType *, bool) {}
+
 };
 
 }
@@ -6,28 +6,31 @@
 #include "demuxer.h"
 
 #include "algorithm"
+#include "cmath"
 
 #include "base/logging.h"
 #include "base/bind_to_current_loop.h"
 #include "base/lambda.h"
+#include "base/trace_event.h"
 
 namespace {
 const auto kSeekTaskId = 100;
 const auto kDemuxTaskId = 101;
 
 const int PIPELINE_ERROR_ABORT = -1;
+const int PIPELINE_ERROR_READ = -2;
 const int PIPELINE_OK = 0;
 
-const media::TimeDelta kInvalidTimeStamp = media::TimeDelta::FromMicroseconds(-1);
-
 }
 
 namespace media {
 
 Demuxer::Demuxer(const TaskRunner &task_runner,
                  std::string url,
-                 MediaTracksUpdatedCB media_tracks_updated_cb)
+                 MediaTracksUpdatedCB media_tracks_updated_cb,
+                 DataSource *data_source)
     : task_runner_(task_runner),
+      data_source_(data_source),
       media_tracks_updated_cb_(std::move(media_tracks_updated_cb)),
       host_(nullptr),
       format_context_(nullptr),
@@ -39,12 +42,13 @@ Demuxer::Demuxer(const TaskRunner &task_runner,
       read_has_failed_(false),
       read_position_(0),
       last_read_bytes_(0),
-      pending_seek_position_(kInvalidTimeStamp),
-      seek_mutex_() {
+      seek_coalescer_(),
+      packet_(av_packet_alloc()) {
+  CHECK(packet_) << "can not allocate packet";
 }
 
 void Demuxer::PostDemuxTask() {
-  task_runner_.PostTask(FROM_HERE, kDemuxTaskId, std::bind(&Demuxer::DemuxTask, this));
+  task_runner_.PostTaskIfNotPending(FROM_HERE, kDemuxTaskId, std::bind(&Demuxer::DemuxTask, this));
 }
 
 void Demuxer::DemuxTask() {
@@ -55,9 +59,14 @@ void Demuxer::DemuxTask() {
     return;
   }
 
-  // Allocate and read an AVPacket from the media.
-  std::unique_ptr<AVPacket, AVPacketDeleter> packet(new AVPacket());
-  int result = ffmpeg::ReadFrameAndDiscardEmpty(format_context_, packet.get());
+  // Read an AVPacket from the media into the reused |packet_|, the stream
+  // takes its reference.
+  auto *packet = packet_.get();
+  int result;
+  {
+    TRACE_EVENT("demux", "ReadFrame");
+    result = ffmpeg::ReadFrameAndDiscardEmpty(format_context_, packet);
+  }
   if (result < 0) {
     // Update the duration based on the audio stream if it was previously unknown.
     // http://crbug.com/86830
@@ -87,8 +96,9 @@ void Demuxer::DemuxTask() {
   if (packet->stream_index >= 0 && packet->stream_index < streams_.size() && streams_[packet->stream_index]
       && (!audio_disabled_ || streams_[packet->stream_index]->type() != DemuxerStream::Audio)) {
     auto demuxer_stream = streams_[packet->stream_index];
-    demuxer_stream->EnqueuePacket(std::move(packet));
+    demuxer_stream->EnqueuePacket(packet);
   }
+  av_packet_unref(packet);
 
   // Create a loop by posting another task.  This allows seek and message loop
   // quit tasks to get processed.
@@ -102,12 +112,23 @@ void Demuxer::Initialize(DemuxerHost *host, PipelineStatusCB status_cb) {
   host_ = host;
   init_callback_ = BindToCurrentLoop(std::move(status_cb));
 
+  if (data_source_) {
+    // Created here so that |Stop| can abort a read blocking the demuxer thread.
+    url_protocol_ = std::make_unique<BlockingUrlProtocol>(data_source_, [this]() {
+      DLOG(ERROR) << "failed to read " << url_;
+      if (host_) {
+        host_->OnDemuxerError(PIPELINE_ERROR_READ);
+      }
+    });
+    glue_ = std::make_unique<FFmpegGlue>(url_protocol_.get());
+  }
+
   task_runner_.PostTask(FROM_HERE, std::bind(&Demuxer::InitializeTask, this));
 }
 
 void Demuxer::InitializeTask() {
 
-  format_context_ = avformat_alloc_context();
+  format_context_ = glue_ ? glue_->format_context() : avformat_alloc_context();
 
   format_context_->interrupt_callback.opaque = this;
   format_context_->interrupt_callback.callback = [](void *opaque) -> int {
@@ -126,6 +147,15 @@ void Demuxer::InitializeTask() {
   // streams from being detected properly; this value was chosen arbitrarily.
 //  format_context_->max_analyze_duration = 60 * AV_TIME_BASE;
 
+  if (glue_) {
+    auto open = glue_->OpenContext();
+    // FFmpeg may free the context on failure.
+    format_context_ = glue_->format_context();
+    DLOG_IF(ERROR, !open) << "failed to open avformat context from data source.";
+    OnOpenContextDone(open);
+    return;
+  }
+
   auto ret = avformat_open_input(&format_context_, url_.c_str(), nullptr, nullptr);
   if (ret < 0) {
     DLOG(ERROR) << "failed to open avformat context. " << ffmpeg::AVErrorToString(ret);
@@ -260,6 +290,7 @@ void Demuxer::OnOpenContextDone(bool open) {
     // things like: codec, channel layout, sample/pixel format, etc...
     auto demuxer_stream = DemuxerStream::Create(this, stream, format_context_);
     if (demuxer_stream) {
+      demuxer_stream->set_metrics(metrics_);
       streams_[i] = std::move(demuxer_stream);
     } else {
       if (codec_type == AVMEDIA_TYPE_AUDIO) {
@@ -393,8 +424,18 @@ void Demuxer::OnOpenContextDone(bool open) {
   duration_ = max_duration;
   duration_known_ = (max_duration != std::numeric_limits<double>::max());
 
+  if (data_source_) {
+    int64 filesize_in_bytes = 0;
+    url_protocol_->GetSize(&filesize_in_bytes);
+    auto bitrate = CalculateBitrate(format_context_, max_duration, filesize_in_bytes);
+    DLOG(INFO) << "bitrate: " << bitrate;
+    data_source_->SetBitrate(bitrate);
+  }
+
   media_tracks_updated_cb_(std::move(media_tracks));
 
+  StartBuffering(buffering_policy_.startup_buffer_seconds);
+
   init_callback_(PIPELINE_OK);
 
 }
@@ -406,32 +447,61 @@ void Demuxer::StreamHasEnded() {
       stream->SetEndOfStream();
     }
   }
+  NotifyBufferingChanged();
 }
 
 void Demuxer::NotifyBufferingChanged() {
   DCHECK(task_runner_.BelongsToCurrentThread());
-//  Ranges<TimeDelta> buffered;
-//  std::shared_ptr<DemuxerStream> audio = audio_disabled_ ? nullptr : GetFFmpegStream(DemuxerStream::Audio);
-//  std::shared_ptr<DemuxerStream> video = GetFFmpegStream(DemuxerStream::Video);
-//  if (audio && video) {
-//    buffered = audio->GetBufferedRanges().IntersectionWith(video->GetBufferedRanges());
-//  } else if (audio_disabled_) {
-//    buffered = audio->GetBufferedRanges();
-//  } else if (video) {
-//    buffered = video->GetBufferedRanges();
-//  }
-//  for (size_t i = 0; i < buffered.size(); ++i) {
-//    host_->AddBufferedTimeRange(buffered.start(i), buffered.end(i));
-//  }
+  if (!buffering_) {
+    auto starving = std::any_of(streams_.begin(), streams_.end(), [](const std::shared_ptr<DemuxerStream> &stream) {
+      return stream && stream->IsStarving();
+    });
+    if (starving) {
+      StartBuffering(buffering_policy_.rebuffer_seconds);
+    }
+    return;
+  }
+
+  // Streams which have ended or hit the byte limit can not buffer any further.
+  auto ready = std::all_of(streams_.begin(), streams_.end(), [this](const std::shared_ptr<DemuxerStream> &stream) {
+    return !stream || stream->end_of_stream() || stream->IsOverByteLimit()
+        || stream->buffered_duration() >= buffering_threshold_;
+  });
+  if (!ready) {
+    return;
+  }
+  DLOG(INFO) << "buffering finished.";
+  buffering_ = false;
+  if (host_) {
+    host_->OnBufferingStateChanged(false);
+  }
+}
+
+void Demuxer::StartBuffering(double threshold) {
+  DCHECK(task_runner_.BelongsToCurrentThread());
+  buffering_threshold_ = threshold;
+  if (buffering_) {
+    return;
+  }
+  DLOG(INFO) << "start buffering, threshold: " << threshold;
+  buffering_ = true;
+  if (host_) {
+    host_->OnBufferingStateChanged(true);
+  }
 }
 
 void Demuxer::Stop(std::function<void(void)> callback) {
-  task_runner_.PostTask(FROM_HERE, [&]() {
+  task_runner_.PostTask(FROM_HERE, [this, callback]() {
     StopTask(callback);
   });
 
   // Then wakes up the thread from reading.
-//  SignalReadCompleted(DataSource::kReadError);
+  if (url_protocol_) {
+    url_protocol_->Abort();
+  }
+  if (data_source_) {
+    data_source_->Stop();
+  }
 }
 
 void Demuxer::StopTask(const std::function<void(void)> &callback) {
@@ -442,6 +512,7 @@ void Demuxer::StopTask(const std::function<void(void)> &callback) {
     }
   }
   abort_request_ = true;
+  seek_coalescer_.Cancel();
   callback();
 }
 
@@ -484,6 +555,20 @@ std::vector<DemuxerStream *> Demuxer::GetAllStreams() {
 
 bool Demuxer::StreamsHaveAvailableCapacity() {
   DCHECK(task_runner_.BelongsToCurrentThread());
+  // A waiting decoder wins over every limit, otherwise packets are interleaved
+  // and one full stream stops reading for all of them.
+  auto starving = std::any_of(streams_.begin(), streams_.end(), [](const std::shared_ptr<DemuxerStream> &stream) {
+    return stream && stream->IsStarving();
+  });
+  if (starving) {
+    return true;
+  }
+  auto over_limit = std::any_of(streams_.begin(), streams_.end(), [](const std::shared_ptr<DemuxerStream> &stream) {
+    return stream && stream->IsOverByteLimit();
+  });
+  if (over_limit) {
+    return false;
+  }
   return std::any_of(streams_.begin(), streams_.end(), [](const std::shared_ptr<DemuxerStream> &stream) {
     return stream && stream->HasAvailableCapacity();
   });
@@ -494,44 +579,65 @@ void Demuxer::NotifyCapacityAvailable() {
   PostDemuxTask();
 }
 
-void Demuxer::SeekTo(TimeDelta position, SeekCallback seek_callback) {
+void Demuxer::SeekTo(TimeDelta position, SeekMode mode, SeekCallback seek_callback) {
   task_runner_.RemoveTask(kDemuxTaskId);
-  task_runner_.RemoveTask(kSeekTaskId);
-
-  if (!seek_mutex_.try_lock()) {
-    DLOG(WARNING) << "seek processing, we should handle it lately. ";
-    task_runner_.PostTask(FROM_HERE, std::bind(&Demuxer::SeekTo, this, position, seek_callback));
-    return;
-  }
-
-  if (seek_callback_) {
-    seek_callback_(false);
-  }
-
-  pending_seek_position_ = position;
-  seek_callback_ = std::move(seek_callback);
-
-  task_runner_.PostTask(FROM_HERE,
-                        kSeekTaskId,
-                        std::bind(&Demuxer::SeekTask, this));
-  seek_mutex_.unlock();
+  seek_coalescer_.Push(position, mode, std::move(seek_callback));
+  // A pending task takes the latest request when it runs.
+  task_runner_.PostTaskIfNotPending(FROM_HERE, kSeekTaskId, std::bind(&Demuxer::SeekTask, this));
 }
 
 void Demuxer::SeekTask() {
   DCHECK(task_runner_.BelongsToCurrentThread());
-  DCHECK(pending_seek_position_.is_positive());
-  DCHECK(seek_callback_);
 
-  std::lock_guard<std::mutex> lock(seek_mutex_);
+  SeekCoalescer::Request request;
+  if (!seek_coalescer_.Take(&request)) {
+    // Cancelled by Stop.
+    return;
+  }
+  DCHECK(request.position >= TimeDelta());
+
+  auto dest = request.position;
+  auto mode = request.mode;
+
+  auto target = dest.InSecondsF();
+  int64 min_ts = INT64_MIN;
+  int64 ts = dest.InMicroseconds();
+  int64 max_ts = INT64_MAX;
 
-  TimeDelta dest;
-  dest = pending_seek_position_;
-  pending_seek_position_ = kInvalidTimeStamp;
+  // Keyframes of video decide where decoding can start.
+  auto *index_stream = GetFirstStream(DemuxerStream::Video);
+  if (!index_stream) {
+    index_stream = GetFirstStream(DemuxerStream::Audio);
+  }
+  KeyframeIndex::Entry keyframe{};
+  // Around a hole of the index, e.g. where nothing was demuxed yet, it may miss
+  // the keyframe we want.
+  bool indexed = index_stream && index_stream->keyframe_index().Covers(target);
+  switch (mode) {
+    case SeekMode::kFast:
+      if (indexed && index_stream->keyframe_index().FindNearest(target, &keyframe)) {
+        ts = static_cast<int64>(std::llround(keyframe.timestamp * AV_TIME_BASE));
+        // Slack for rounding, so FFmpeg does not fall back to the keyframe before.
+        max_ts = ts + AV_TIME_BASE / 1000;
+      }
+      break;
+    case SeekMode::kAccurate:
+    case SeekMode::kPreviousSync:
+      max_ts = ts;
+      if (indexed && index_stream->keyframe_index().FindPrevious(target, &keyframe)) {
+        ts = std::min<int64>(ts, std::llround(keyframe.timestamp * AV_TIME_BASE));
+      }
+      break;
+  }
 
-  DLOG(INFO) << "do seek to: " << dest.InSecondsF();
+  DLOG(INFO) << "do seek to: " << target << " mode: " << mode << " keyframe: " << (ts / double(AV_TIME_BASE));
 
-  auto ret = avformat_seek_file(format_context_, -1, INT64_MIN,
-                                dest.InMicroseconds(), INT64_MAX, 0);
+  auto ret = avformat_seek_file(format_context_, -1, min_ts, ts, max_ts, 0);
+  if (ret < 0 && max_ts != INT64_MAX) {
+    // e.g. no keyframe at or before the target, take the nearest one.
+    DLOG(WARNING) << "bounded seek failed, " << ffmpeg::AVErrorToString(ret);
+    ret = avformat_seek_file(format_context_, -1, INT64_MIN, dest.InMicroseconds(), INT64_MAX, 0);
+  }
 
   DLOG_IF(ERROR, ret < 0) << "failed seek to " << dest.InSecondsF() << " reason: " << ffmpeg::AVErrorToString(ret);
 
@@ -542,9 +648,10 @@ void Demuxer::SeekTask() {
     }
   }
 
+  StartBuffering(buffering_policy_.rebuffer_seconds);
+
   // Notify seek completed.
-  seek_callback_(true);
-  seek_callback_ = nullptr;
+  request.callback(true);
 
   PostDemuxTask();
 }
@@ -14,6 +14,8 @@
 #include "media_tracks.h"
 #include "ffmpeg_glue.h"
 #include "blocking_url_protocol.h"
+#include "data_source.h"
+#include "seek_coalescer.h"
 
 namespace media {
 
@@ -22,6 +24,7 @@ constexpr double kNoTimestamp() {
 }
 
 typedef int PipelineStatus;
+
 typedef std::function<void(int)> PipelineStatusCB;
 
 class DemuxerHost {
@@ -39,6 +42,12 @@ class DemuxerHost {
    */
   virtual void OnDemuxerError(PipelineStatus error) = 0;
 
+  /**
+   * Called on the demuxer thread when a stream runs out of packets, and when
+   * every stream has buffered enough to play again.
+   */
+  virtual void OnBufferingStateChanged(bool) {}
+
  protected:
 
   virtual ~DemuxerHost() = default;
@@ -51,9 +60,41 @@ class Demuxer : public std::enable_shared_from_this<Demuxer> {
 
   using MediaTracksUpdatedCB = std::function<void(std::unique_ptr<MediaTracks>)>;
 
+  /**
+   * @param data_source if not null, all reads of FFmpeg go through it and |url|
+   * only names the media. Otherwise FFmpeg opens |url| with its own protocols.
+   * Must outlive the demuxer.
+   */
   Demuxer(const TaskRunner &task_runner,
           std::string url,
-          MediaTracksUpdatedCB media_tracks_updated_cb);
+          MediaTracksUpdatedCB media_tracks_updated_cb,
+          DataSource *data_source = nullptr);
+
+  /**
+   * Must be called before |Initialize|, streams copy the policy when they are
+   * created.
+   */
+  void SetBufferingPolicy(const BufferingPolicy &policy) {
+    buffering_policy_ = policy;
+  }
+
+  const BufferingPolicy &buffering_policy() const {
+    return buffering_policy_;
+  }
+
+  /**
+   * Must be called before |Initialize|, passed to the streams.
+   */
+  void set_metrics(std::shared_ptr<MediaMetrics> metrics) {
+    metrics_ = std::move(metrics);
+  }
+
+  /**
+   * Stats of the tasks of the demuxer thread, see MessageLooper::GetTaskStats.
+   */
+  TaskStats GetTaskStats(int top_n = 0) const {
+    return task_runner_.GetTaskStats(top_n);
+  }
 
   void Initialize(DemuxerHost *host, PipelineStatusCB status_cb);
 
@@ -66,6 +107,13 @@ class Demuxer : public std::enable_shared_from_this<Demuxer> {
   // about what buffered data is available.
   void NotifyBufferingChanged();
 
+  /**
+   * Whether the host was told it is buffering. Demuxer thread only.
+   */
+  bool is_buffering() const {
+    return buffering_;
+  }
+
   // The pipeline is being stopped either as a result of an error or because
   // the client called Stop().
   virtual void Stop(std::function<void(void)> callback);
@@ -76,12 +124,19 @@ class Demuxer : public std::enable_shared_from_this<Demuxer> {
 
   void NotifyCapacityAvailable();
 
-  using SeekCallback = std::function<void(bool)>;
-  void SeekTo(TimeDelta position, SeekCallback seek_callback);
+  using SeekCallback = SeekCoalescer::SeekCallback;
+
+  /**
+   * Thread safe. A seek which is still pending is replaced, its callback is
+   * run with false, so rapid seeks only execute the latest target.
+   */
+  void SeekTo(TimeDelta position, SeekMode mode, SeekCallback seek_callback);
 
   void AbortPendingReads();
 
-  TimeDelta GetPendingSeekingPosition() { return pending_seek_position_; }
+  TimeDelta GetPendingSeekingPosition() { return seek_coalescer_.pending_position(); }
+
+  int64 superseded_seek_count() const { return seek_coalescer_.superseded_count(); }
 
  protected:
 
@@ -116,6 +171,9 @@ class Demuxer : public std::enable_shared_from_this<Demuxer> {
 
   bool StreamsHaveAvailableCapacity();
 
+  // Enter buffering with |threshold| seconds to collect before leaving it.
+  void StartBuffering(double threshold);
+
   DemuxerHost *host_;
   PipelineStatusCB init_callback_;
 
@@ -123,6 +181,13 @@ class Demuxer : public std::enable_shared_from_this<Demuxer> {
 
   std::string url_;
 
+  DataSource *data_source_;
+
+  // Proxy the reads of |format_context_| to |data_source_|, only created when
+  // there is a |data_source_|. |glue_| owns |format_context_| then.
+  std::unique_ptr<BlockingUrlProtocol> url_protocol_;
+  std::unique_ptr<FFmpegGlue> glue_;
+
   double duration_ = kNoTimestamp();
 
   // FFmpeg context handle.
@@ -166,10 +231,19 @@ class Demuxer : public std::enable_shared_from_this<Demuxer> {
   // stream -- at this moment we definitely know duration.
   bool duration_known_;
 
-  TimeDelta pending_seek_position_;
-  SeekCallback seek_callback_;
+  SeekCoalescer seek_coalescer_;
+
+  // Every packet is read into it, then its reference moves to a DecoderBuffer.
+  std::unique_ptr<AVPacket, AVPacketDeleter> packet_;
+
+  BufferingPolicy buffering_policy_;
+
+  std::shared_ptr<MediaMetrics> metrics_;
 
-  std::mutex seek_mutex_;
+  // Whether the host was told it is buffering, and the seconds every stream
+  // needs before it is told otherwise.
+  bool buffering_ = false;
+  double buffering_threshold_ = 0;
 
   DELETE_COPY_AND_ASSIGN(Demuxer);
 
@@ -4,10 +4,14 @@
 
 #include "demuxer_stream.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "base/logging.h"
 #include "base/bind_to_current_loop.h"
 
 #include "demuxer.h"
+#include "base/trace_event.h"
 
 namespace media {
 
@@ -55,8 +59,26 @@ DemuxerStream::DemuxerStream(
     buffer_queue_(std::make_shared<DecoderBufferQueue>()),
     end_of_stream_(false),
     waiting_for_key_frame_(false),
-    abort_(false) {
-
+    abort_(false),
+    buffering_policy_(demuxer ? demuxer->buffering_policy() : BufferingPolicy()),
+    filling_(true),
+    demuxed_since_(NAN) {
+  if (!stream_) {
+    return;
+  }
+  // Whatever the container index knows, e.g. the stss box of mp4 or the cues
+  // of mkv once they were read.
+  double first_keyframe = NAN, last_keyframe = NAN;
+  for (int i = 0; i < stream_->nb_index_entries; ++i) {
+    const auto &entry = stream_->index_entries[i];
+    if (entry.flags & AVINDEX_KEYFRAME) {
+      auto timestamp = ffmpeg::ConvertFromTimeBase(stream_->time_base, entry.timestamp);
+      keyframe_index_.Add(timestamp, entry.pos);
+      first_keyframe = std::isnan(first_keyframe) ? timestamp : std::min(first_keyframe, timestamp);
+      last_keyframe = std::isnan(last_keyframe) ? timestamp : std::max(last_keyframe, timestamp);
+    }
+  }
+  keyframe_index_.AddCoveredRange(first_keyframe, last_keyframe);
 }
 
 AudioDecodeConfig DemuxerStream::audio_decode_config() {
@@ -69,7 +91,7 @@ VideoDecodeConfig DemuxerStream::video_decode_config() {
   return *video_decode_config_;
 }
 
-void DemuxerStream::EnqueuePacket(std::unique_ptr<AVPacket, AVPacketDeleter> packet) {
+void DemuxerStream::EnqueuePacket(AVPacket *packet) {
   DCHECK(task_runner_.BelongsToCurrentThread());
   DCHECK(packet->size);
   DCHECK(packet->data);
@@ -101,11 +123,35 @@ void DemuxerStream::EnqueuePacket(std::unique_ptr<AVPacket, AVPacketDeleter> pac
     return;
   }
 
-  std::shared_ptr<DecoderBuffer> buffer = std::make_shared<DecoderBuffer>(std::move(packet));
-  buffer->set_timestamp(ffmpeg::ConvertFromTimeBase(stream_->time_base, pkt_pts));
+  auto timestamp = ffmpeg::ConvertFromTimeBase(stream_->time_base, pkt_pts);
+  if (packet->flags & AV_PKT_FLAG_KEY) {
+    keyframe_index_.Add(timestamp, packet->pos);
+  }
+  if (std::isnan(demuxed_since_)) {
+    demuxed_since_ = timestamp;
+  }
+  keyframe_index_.AddCoveredRange(demuxed_since_, timestamp);
+
+  auto buffer = std::make_shared<DecoderBuffer>(packet);
+  buffer->set_timestamp(timestamp);
 
   buffer_queue_->Push(std::move(buffer));
+  if (metrics_) {
+    metrics_->stream(type_ == Video).packets_demuxed.fetch_add(1, std::memory_order_relaxed);
+  }
+  UpdateBufferedBytes();
+  UpdateFillingState();
+
+  SatisfyPendingRead();
+  // Only a buffering demuxer can change its state for a new packet.
+  if (demuxer_->is_buffering()) {
+    demuxer_->NotifyBufferingChanged();
+  }
+}
 
+void DemuxerStream::SetEndOfStream() {
+  DCHECK(task_runner_.BelongsToCurrentThread());
+  end_of_stream_ = true;
   SatisfyPendingRead();
 }
 
@@ -123,22 +169,58 @@ void DemuxerStream::SatisfyPendingRead() {
     if (!buffer_queue_->IsEmpty()) {
       read_callback_(buffer_queue_->Pop());
       read_callback_ = nullptr;
+      UpdateBufferedBytes();
+      UpdateFillingState();
     } else if (end_of_stream_) {
       read_callback_(DecoderBuffer::CreateEOSBuffer());
       read_callback_ = nullptr;
     }
   }
 
+  if (IsStarving() && !demuxer_->is_buffering()) {
+    demuxer_->NotifyBufferingChanged();
+  }
+
   if (!end_of_stream_ && HasAvailableCapacity()) {
-    // TODO notify to read more.
     demuxer_->NotifyCapacityAvailable();
   }
 }
 
-bool DemuxerStream::HasAvailableCapacity() {
-  // Try to have two second's worth of encoded data per stream.
-  const double kCapacity = 2;
-  return !abort_ && read_callback_ && buffer_queue_->IsEmpty() || buffer_queue_->Duration() < kCapacity;
+void DemuxerStream::UpdateBufferedBytes() {
+  TRACE_COUNTER("demux", type_ == Video ? "video_buffered_bytes" : "audio_buffered_bytes",
+                static_cast<int64>(buffer_queue_->data_size()));
+  if (metrics_) {
+    metrics_->stream(type_ == Video).buffered_bytes.store(static_cast<int64>(buffer_queue_->data_size()),
+                                                          std::memory_order_relaxed);
+  }
+}
+
+bool DemuxerStream::HasAvailableCapacity() const {
+  if (IsStarving()) {
+    return true;
+  }
+  return filling_ && !IsOverByteLimit();
+}
+
+void DemuxerStream::UpdateFillingState() {
+  auto duration = buffered_duration();
+  if (filling_) {
+    filling_ = duration < buffering_policy_.max_buffer_seconds;
+  } else {
+    filling_ = duration < buffering_policy_.min_buffer_seconds;
+  }
+}
+
+bool DemuxerStream::IsStarving() const {
+  return !abort_ && !end_of_stream_ && read_callback_ && buffer_queue_->IsEmpty();
+}
+
+bool DemuxerStream::IsOverByteLimit() const {
+  return static_cast<int64>(buffer_queue_->data_size()) >= buffering_policy_.max_buffer_bytes;
+}
+
+double DemuxerStream::buffered_duration() const {
+  return buffer_queue_->Duration();
 }
 
 void DemuxerStream::Read(ReadCallback read_callback) {
@@ -172,6 +254,7 @@ void DemuxerStream::Stop() {
   DCHECK(task_runner_.BelongsToCurrentThread());
 
   buffer_queue_->Clear();
+  UpdateBufferedBytes();
   stream_ = nullptr;
   demuxer_ = nullptr;
   end_of_stream_ = true;
@@ -191,8 +274,14 @@ void DemuxerStream::FlushBuffers() {
   DCHECK(!read_callback_);
 
   buffer_queue_->Clear();
+  UpdateBufferedBytes();
   end_of_stream_ = false;
   abort_ = false;
+  filling_ = true;
+  // Packets before the next keyframe can not be decoded.
+  waiting_for_key_frame_ = type_ == Video;
+  // The demuxer seeked, the next packet starts a new covered range.
+  demuxed_since_ = NAN;
 }
 
 void DemuxerStream::Abort() {
@@ -203,6 +292,7 @@ void DemuxerStream::Abort() {
 std::ostream &operator<<(std::ostream &os, const DemuxerStream &stream) {
   os << "type_: " << stream.type_
      << " buffer_queue_: " << stream.buffer_queue_->data_size()
+     << " filling_: " << stream.filling_
      << " end_of_stream_: " << stream.end_of_stream_
      << " read_callback_: " << (stream.read_callback_ != nullptr)
      << " abort_: " << stream.abort_;
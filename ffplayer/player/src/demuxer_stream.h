@@ -20,6 +20,9 @@ extern "C" {
 #include "video_decode_config.h"
 #include "decoder_buffer.h"
 #include "decoder_buffer_queue.h"
+#include "buffering_policy.h"
+#include "keyframe_index.h"
+#include "media_metrics.h"
 
 namespace media {
 
@@ -55,7 +58,11 @@ class DemuxerStream {
   using ReadCallback = std::function<void(std::shared_ptr<DecoderBuffer>)>;
   void Read(ReadCallback read_callback);
 
-  void EnqueuePacket(std::unique_ptr<AVPacket, AVPacketDeleter> packet);
+  /**
+   * Take the reference of |packet|, which is left blank unless it is dropped.
+   * The caller unrefs it either way.
+   */
+  void EnqueuePacket(AVPacket *packet);
 
   Type type() {
     return type_;
@@ -67,8 +74,14 @@ class DemuxerStream {
 
   double duration();
 
-  void SetEndOfStream() {
-    end_of_stream_ = true;
+  /**
+   * No more packets will be enqueued, a pending read gets the end of stream
+   * once the queue is drained.
+   */
+  void SetEndOfStream();
+
+  bool end_of_stream() const {
+    return end_of_stream_;
   }
 
   // Returns the value associated with |key| in the metadata for the avstream.
@@ -78,14 +91,54 @@ class DemuxerStream {
   // Empties the queues and ignores any additional calls to Read().
   void Stop();
 
-  bool HasAvailableCapacity();
+  /**
+   * Whether the demuxer should read more packets for this stream.
+   *
+   * Filling stops once the queue reaches |max_buffer_seconds| and restarts
+   * once it drains below |min_buffer_seconds|, so the demuxer reads in bursts
+   * instead of one packet per decoder read.
+   */
+  bool HasAvailableCapacity() const;
+
+  /**
+   * A read is waiting and there is nothing to satisfy it.
+   */
+  bool IsStarving() const;
+
+  /**
+   * The queue holds |max_buffer_bytes| or more.
+   */
+  bool IsOverByteLimit() const;
+
+  /**
+   * Duration of the queued packets in seconds.
+   */
+  double buffered_duration() const;
 
   void SetEnabled(bool enabled, double timestamp);
 
   void Abort();
 
+  /**
+   * Drop queued packets for a seek. Video then waits for a keyframe.
+   */
   void FlushBuffers();
 
+  /**
+   * Packets demuxed and bytes buffered go to |metrics|, which may be null.
+   * Demuxer thread only.
+   */
+  void set_metrics(std::shared_ptr<MediaMetrics> metrics) {
+    metrics_ = std::move(metrics);
+  }
+
+  /**
+   * Keyframes seen so far, demuxer thread only.
+   */
+  const KeyframeIndex &keyframe_index() const {
+    return keyframe_index_;
+  }
+
   friend std::ostream &operator<<(std::ostream &os, const DemuxerStream &stream);
 
  private:
@@ -110,10 +163,29 @@ class DemuxerStream {
 
   bool abort_;
 
+  BufferingPolicy buffering_policy_;
+
+  KeyframeIndex keyframe_index_;
+
+  std::shared_ptr<MediaMetrics> metrics_;
+
+  // Between reaching |min_buffer_seconds| and |max_buffer_seconds| of the policy,
+  // whether the queue is being filled or drained.
+  bool filling_;
+
+  // Timestamp of the first packet enqueued since the last flush, every
+  // keyframe from it to the last packet is in |keyframe_index_|.
+  double demuxed_since_;
+
   void ReadTask(ReadCallback read_callback);
 
   void SatisfyPendingRead();
 
+  void UpdateBufferedBytes();
+
+  // Move |filling_| between the buffering limits, after the queue changed.
+  void UpdateFillingState();
+
 };
 
 } // namespace media
@@ -8,6 +8,7 @@
 #include "cinttypes"
 #include "memory"
 #include "functional"
+#include "vector"
 
 #ifdef _WIN32
 #define API_EXPORT extern "C"  __declspec(dllexport)
@@ -23,8 +24,19 @@ class ExternalMediaTexture {
     kFormat_32_BGRA,
     kFormat_32_ARGB,
     kFormat_32_RGBA,
+    // 8 bit Y, U and V planes, chroma subsampled 2x2.
+    kFormat_I420,
+    // 8 bit Y plane and an interleaved UV plane, chroma subsampled 2x2.
+    kFormat_NV12,
+    // As NV12 with 16 bit little endian samples, the 10 significant bits are
+    // the high bits.
+    kFormat_P010,
   };
 
+  static bool IsPlanarFormat(PixelFormat format) {
+    return format == kFormat_I420 || format == kFormat_NV12 || format == kFormat_P010;
+  }
+
   virtual int64_t GetTextureId() = 0;
 
   [[deprecated]]
@@ -64,8 +76,87 @@ class ExternalMediaTexture {
 
   virtual ~ExternalMediaTexture() = default;
 
+  /**
+   * Planar formats are uploaded as they are decoded, the texture converts them
+   * to RGB (e.g. in a shader). Frames of other formats are converted to
+   * [GetSupportFormat] on the CPU.
+   */
+  virtual bool SupportsPixelFormat(PixelFormat format) { return format == GetSupportFormat(); }
+
+  struct Planes {
+    PixelFormat format;
+    int width;
+    int height;
+    // 3 for I420, 2 for NV12 and P010.
+    int num_planes;
+    uint8_t *data[3];
+    int stride[3];
+  };
+
+  /**
+   * Allocate planes of the given format to copy frames into, like
+   * [MaybeInitPixelBuffer].
+   */
+  virtual void MaybeInitPlanes(int, int, PixelFormat) {}
+
+  /**
+   * @return the planes allocated by [MaybeInitPlanes], valid while the buffer
+   * is locked.
+   */
+  virtual bool GetPlanes(Planes *) { return false; }
+
+  /**
+   * Whether frames can be passed by [RenderWithPlanes] instead of being copied
+   * into [GetPlanes].
+   */
+  virtual bool SupportsPlaneReference() { return false; }
+
+  /**
+   * Take the planes of a decoded frame without a copy. They stay valid until
+   * the holder is released, which the texture should do once it uploaded them.
+   */
+  virtual void RenderWithPlanes(const Planes &, std::shared_ptr<void>) {}
+
+  /**
+   * Decoded hardware surfaces a texture can take without a copy through
+   * [GetBuffer].
+   */
+  enum HWSurfaceType {
+    // CVPixelBufferRef of VideoToolbox, passed to [RenderWithHWAccel].
+    kHWSurface_CVPixelBuffer,
+    // DMA-BUF planes of VAAPI or DRM-PRIME decoders, passed to [RenderWithDmaBuf].
+    kHWSurface_DmaBuf,
+  };
+
+  /**
+   * Frames of a type which is not supported are read back into [GetBuffer].
+   */
+  virtual bool SupportsHWSurface(HWSurfaceType) { return false; }
+
   virtual void RenderWithHWAccel(void *pixel_buffer) {}
 
+  struct DmaBufPlane {
+    int fd;
+    uint32_t offset;
+    uint32_t pitch;
+    uint64_t modifier;
+  };
+
+  struct DmaBufFrame {
+    int width;
+    int height;
+    // DRM_FORMAT_* fourcc of the whole frame, e.g. DRM_FORMAT_NV12.
+    uint32_t drm_format;
+    int num_planes;
+    DmaBufPlane planes[4];
+  };
+
+  /**
+   * The file descriptors are only valid during the call, import them (e.g.
+   * into an EGLImage) or dup them.
+   */
+  virtual void RenderWithDmaBuf(const DmaBufFrame &) {}
+
 };
 
 typedef void(*FlutterTextureAdapterFactory)(std::function<void(std::unique_ptr<ExternalMediaTexture>)> callback);
@@ -11,21 +11,9 @@ namespace media {
 // static
 FlutterTextureAdapterFactory ExternalVideoRendererSink::factory_ = nullptr;
 
-// static
-AVPixelFormat ExternalVideoRendererSink::GetPixelFormat(ExternalMediaTexture::PixelFormat format) {
-  switch (format) {
-    case ExternalMediaTexture::kFormat_32_ARGB: return AV_PIX_FMT_ARGB;
-    case ExternalMediaTexture::kFormat_32_BGRA: return AV_PIX_FMT_BGRA;
-    case ExternalMediaTexture::kFormat_32_RGBA: return AV_PIX_FMT_RGBA;
-  }
-  NOTREACHED();
-  return AV_PIX_FMT_BGRA;
-}
-
 ExternalVideoRendererSink::ExternalVideoRendererSink()
     : destroyed_(false),
-    // TODO maybe we can use a global render thread?
-      task_runner_(std::make_unique<TaskRunner>(base::MessageLooper::PrepareLooper("video_render"))),
+      task_runner_(std::make_unique<TaskRunner>(base::MessageLooper::PrepareSequencedLooper("video_render"))),
       render_callback_(nullptr) {
   DCHECK(factory_) << "factory_ do not register yet.";
   // FIXME bind weak.
@@ -47,10 +35,14 @@ void ExternalVideoRendererSink::Stop() {
   task_runner_->RemoveAllTasks();
 }
 
+void ExternalVideoRendererSink::SetDisplaySize(int width, int height) {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  uploader_.SetDisplaySize(width, height);
+}
+
 ExternalVideoRendererSink::~ExternalVideoRendererSink() {
   std::lock_guard<std::mutex> lock_guard(render_mutex_);
   task_runner_.reset(nullptr);
-  sws_freeContext(img_convert_ctx_);
   texture_.reset(nullptr);
   destroyed_ = true;
 }
@@ -62,53 +54,7 @@ void ExternalVideoRendererSink::DoRender(const std::shared_ptr<VideoFrame> &fram
     return;
   }
 
-  texture_->MaybeInitPixelBuffer(frame->Width(), frame->Height());
-
-  if (!texture_->TryLockBuffer()) {
-    DLOG(WARNING) << "failed to lock buffer, skip render this frame.";
-    return;
-  }
-
-  if (frame->frame()->hw_frames_ctx != nullptr) {
-    DLOG(WARNING) << "DoRender with hardware accel";
-    texture_->RenderWithHWAccel(frame->frame()->data[3]);
-    return;
-  }
-
-  auto *output = texture_->GetBuffer();
-  DCHECK(output);
-
-  img_convert_ctx_ = sws_getCachedContext(
-      img_convert_ctx_, frame->Width(), frame->Height(), AVPixelFormat(frame->frame()->format),
-      texture_->GetWidth(), texture_->GetHeight(),
-      GetPixelFormat(texture_->GetSupportFormat()), SWS_BICUBIC,
-      nullptr, nullptr, nullptr);
-
-  if (!img_convert_ctx_) {
-    DLOG(ERROR) << "can not init image convert context";
-    texture_->UnlockBuffer();
-    return;
-  }
-
-#if 1
-  auto *av_frame = frame->frame();
-  int linesize[4] = {4 * texture_->GetWidth()};
-  uint8_t *bgr_buffer[8] = {static_cast<uint8_t *>(output)};
-  sws_scale(img_convert_ctx_, av_frame->data, av_frame->linesize, 0, av_frame->height, bgr_buffer, linesize);
-#endif
-
-#if 0
-  auto bitmap = reinterpret_cast<uint32_t *>(output);
-  for (unsigned long i = 0; i < texture_->GetWidth() * texture_->GetHeight(); i++) {
-    bitmap[i] = 0x000000ff;
-  }
-  DLOG(INFO) << "render bitmap: width = " << texture_->GetWidth() << " height = " << texture_->GetHeight();
-#endif
-
-  texture_->UnlockBuffer();
-
-  texture_->NotifyBufferUpdate();
-
+  uploader_.Upload(texture_.get(), frame);
 }
 
 void ExternalVideoRendererSink::OnTextureAvailable(std::unique_ptr<ExternalMediaTexture> texture) {
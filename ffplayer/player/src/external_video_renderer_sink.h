@@ -10,9 +10,7 @@
 
 #include "base/task_runner.h"
 
-extern "C" {
-#include "libswscale/swscale.h"
-}
+#include "texture_uploader.h"
 
 namespace media {
 
@@ -22,8 +20,6 @@ class ExternalVideoRendererSink : public VideoRendererSink {
 
   static FlutterTextureAdapterFactory factory_;
 
-  static AVPixelFormat GetPixelFormat(ExternalMediaTexture::PixelFormat format);
-
   ExternalVideoRendererSink();
 
   ~ExternalVideoRendererSink() override;
@@ -34,11 +30,13 @@ class ExternalVideoRendererSink : public VideoRendererSink {
 
   void Stop() override;
 
+  void SetDisplaySize(int width, int height) override;
+
  private:
 
   std::unique_ptr<ExternalMediaTexture> texture_;
 
-  struct SwsContext *img_convert_ctx_ = nullptr;
+  TextureUploader uploader_;
 
   void OnTextureAvailable(std::unique_ptr<ExternalMediaTexture> texture);
 
@@ -33,11 +33,11 @@ struct ScopedPtrAVFreeFrame {
   }
 };
 
+// Frees an AVPacket made by av_packet_alloc.
 struct AVPacketDeleter {
   void operator()(void *x) const {
     auto *packet = static_cast<AVPacket *>(x);
-    av_packet_unref(packet);
-    delete packet;
+    av_packet_free(&packet);
   }
 };
 
@@ -16,6 +16,72 @@ struct PlayerConfiguration {
 
   double start_time = 0;
   int32_t loop = 1;
+
+  // Threading of the video decoder. 0: auto, 1: frame threads, 2: slice threads.
+  int32_t video_decoder_thread_type = 0;
+  // Count of video decoder threads. 0 keeps a single thread, a negative value
+  // means one per core.
+  int32_t video_decoder_thread_count = 0;
+
+  // Decode video with the hardware devices of the platform, falling back to
+  // software when none can be used.
+  int32_t video_hw_accel = false;
+
+  // Buffering policy, see BufferingPolicy. 0 means the default value.
+  double min_buffer_seconds = 0;
+  double max_buffer_seconds = 0;
+  int64_t max_buffer_bytes = 0;
+  double startup_buffer_seconds = 0;
+  double rebuffer_seconds = 0;
+  int32_t max_decoded_video_frames = 0;
+  int32_t max_decoded_audio_buffers = 0;
+  int32_t max_decoder_outputs = 0;
+};
+
+// A histogram in the values of MediaPlayer::GetStats takes this many values:
+// count, p50, p90, p99 and max.
+#define PLAYER_STAT_HISTOGRAM_FIELDS 5
+
+/**
+ * Index of a value filled by MediaPlayer::GetStats. Durations are microseconds.
+ */
+enum PlayerStat {
+  kStatVideoPacketsDemuxed = 0,
+  kStatAudioPacketsDemuxed,
+  // Bytes of packets queued in the demuxer stream.
+  kStatVideoBufferedBytes,
+  kStatAudioBufferedBytes,
+  kStatVideoFramesDecoded,
+  kStatVideoFramesDropped,
+  kStatVideoFramesRendered,
+  kStatAudioBuffersDecoded,
+  // Audio callbacks which were not filled completely.
+  kStatAudioUnderruns,
+  // Pts of the latest rendered video frame minus the audio clock.
+  kStatAVDrift,
+  // Tasks waiting in the queue of each looper.
+  kStatPlayerQueueDepth,
+  kStatDemuxerQueueDepth,
+  kStatVideoDecoderQueueDepth,
+  kStatAudioDecoderQueueDepth,
+  // Histograms.
+  kStatVideoDecodeTime,
+  kStatAudioDecodeTime = kStatVideoDecodeTime + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatVideoRenderCallbackTime = kStatAudioDecodeTime + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatAudioRenderCallbackTime = kStatVideoRenderCallbackTime + PLAYER_STAT_HISTOGRAM_FIELDS,
+  // Of the absolute value of kStatAVDrift.
+  kStatAVDriftAbs = kStatAudioRenderCallbackTime + PLAYER_STAT_HISTOGRAM_FIELDS,
+  // From the time a task of each looper is due to the time it runs.
+  kStatPlayerTaskQueueDelay = kStatAVDriftAbs + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatDemuxerTaskQueueDelay = kStatPlayerTaskQueueDelay + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatVideoDecoderTaskQueueDelay = kStatDemuxerTaskQueueDelay + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatAudioDecoderTaskQueueDelay = kStatVideoDecoderTaskQueueDelay + PLAYER_STAT_HISTOGRAM_FIELDS,
+  // Run time of the tasks of each looper.
+  kStatPlayerTaskRunTime = kStatAudioDecoderTaskQueueDelay + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatDemuxerTaskRunTime = kStatPlayerTaskRunTime + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatVideoDecoderTaskRunTime = kStatDemuxerTaskRunTime + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatAudioDecoderTaskRunTime = kStatVideoDecoderTaskRunTime + PLAYER_STAT_HISTOGRAM_FIELDS,
+  kStatCount = kStatAudioDecoderTaskRunTime + PLAYER_STAT_HISTOGRAM_FIELDS,
 };
 
 }
@@ -72,6 +72,10 @@ bool FileDataSource::IsStreaming() {
 
 void FileDataSource::SetBitrate(int bitrate) {}
 
-FileDataSource::~FileDataSource() = default;
+FileDataSource::~FileDataSource() {
+  if (file_) {
+    fclose(file_);
+  }
+}
 
 } // namespace media
\ No newline at end of file
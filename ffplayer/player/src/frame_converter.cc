@@ -0,0 +1,230 @@
+//
+// Created by yangbin on 2021/7/28.
+//
+
+#include "frame_converter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "base/logging.h"
+
+#include "yuv_convert.h"
+
+extern "C" {
+#include "libavutil/pixdesc.h"
+}
+
+namespace media {
+
+namespace {
+
+// Smaller slices cost more in scheduling than they save.
+const int kMinSliceRows = 64;
+
+const int kMaxThreads = 8;
+
+struct SliceJob {
+  const std::function<void(int)> *convert_slice;
+  int slice_count;
+  std::atomic_int next_slice{0};
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  int done_count = 0;
+
+  // Convert slices until none is left. Tasks which run after the job is done
+  // find none and return, |convert_slice| is not touched again.
+  void Run() {
+    int slice;
+    while ((slice = next_slice++) < slice_count) {
+      (*convert_slice)(slice);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (++done_count == slice_count) {
+        condition.notify_all();
+      }
+    }
+  }
+
+};
+
+// Plane |plane| of |data| moved down by |rows| luma rows.
+uint8_t *OffsetPlane(uint8_t *const data[4], const int stride[4], const AVPixFmtDescriptor *descriptor,
+                     int plane, int rows) {
+  if (!data[plane]) {
+    return nullptr;
+  }
+  // U and V planes, or the UV plane of semi-planar formats.
+  int shift = (plane == 1 || plane == 2) ? descriptor->log2_chroma_h : 0;
+  return data[plane] + (rows >> shift) * stride[plane];
+}
+
+}
+
+FrameConverter::FrameConverter(int max_threads, bool use_yuv_kernels)
+    : max_threads_(max_threads), use_yuv_kernels_(use_yuv_kernels) {
+  if (max_threads_ <= 0) {
+    max_threads_ = std::min(std::max(int(std::thread::hardware_concurrency()), 1), kMaxThreads);
+  }
+}
+
+FrameConverter::~FrameConverter() {
+  for (auto *context : sws_contexts_) {
+    sws_freeContext(context);
+  }
+}
+
+int FrameConverter::Convert(const AVFrame *frame,
+                            AVPixelFormat dest_format, int dest_width, int dest_height,
+                            uint8_t *const dest[4], const int dest_stride[4]) {
+  DCHECK(frame);
+  if (use_yuv_kernels_ && dest_width == frame->width && dest_height == frame->height
+      && ConvertWithKernel(frame, dest_format, dest, dest_stride)) {
+    return 0;
+  }
+  return ConvertWithSwscale(frame, dest_format, dest_width, dest_height, dest, dest_stride);
+}
+
+int FrameConverter::SliceRows(int height, int rows_alignment) const {
+  int slice_count = std::max(std::min(max_threads_, height / kMinSliceRows), 1);
+  int rows = (height + slice_count - 1) / slice_count;
+  return (rows + rows_alignment - 1) / rows_alignment * rows_alignment;
+}
+
+void FrameConverter::RunSlices(int slice_count, const std::function<void(int)> &convert_slice) {
+  if (slice_count <= 1) {
+    convert_slice(0);
+    return;
+  }
+  while (int(workers_.size()) < slice_count - 1) {
+    workers_.emplace_back(base::MessageLooper::PrepareSequencedLooper("frame_converter"));
+  }
+
+  auto job = std::make_shared<SliceJob>();
+  job->convert_slice = &convert_slice;
+  job->slice_count = slice_count;
+  for (int i = 0; i < slice_count - 1; ++i) {
+    workers_[i].PostTask(FROM_HERE, [job]() { job->Run(); });
+  }
+  // Never waits for a slice which did not start, even if all workers are busy.
+  job->Run();
+
+  std::unique_lock<std::mutex> lock(job->mutex);
+  job->condition.wait(lock, [&job]() { return job->done_count == job->slice_count; });
+}
+
+bool FrameConverter::ConvertWithKernel(const AVFrame *frame, AVPixelFormat dest_format,
+                                       uint8_t *const dest[4], const int dest_stride[4]) {
+  yuv_convert::RgbOrder order;
+  if (dest_format == AV_PIX_FMT_BGRA) {
+    order = yuv_convert::RgbOrder::kBGRA;
+  } else if (dest_format == AV_PIX_FMT_RGBA) {
+    order = yuv_convert::RgbOrder::kRGBA;
+  } else {
+    return false;
+  }
+  auto format = AVPixelFormat(frame->format);
+  if (format != AV_PIX_FMT_YUV420P && format != AV_PIX_FMT_YUVJ420P && format != AV_PIX_FMT_NV12) {
+    return false;
+  }
+
+  yuv_convert::YuvColorSpace color_space;
+  color_space.matrix = frame->colorspace == AVCOL_SPC_BT709 ? yuv_convert::YuvMatrix::kBT709
+                                                            : yuv_convert::YuvMatrix::kBT601;
+  color_space.full_range = frame->color_range == AVCOL_RANGE_JPEG || format == AV_PIX_FMT_YUVJ420P;
+
+  const int height = frame->height;
+  const int slice_rows = SliceRows(height, 2);
+  const int slice_count = (height + slice_rows - 1) / slice_rows;
+  RunSlices(slice_count, [&](int slice) {
+    int start = slice * slice_rows;
+    int rows = std::min(slice_rows, height - start);
+    const uint8_t *y = frame->data[0] + start * frame->linesize[0];
+    uint8_t *rgb = dest[0] + start * dest_stride[0];
+    if (format == AV_PIX_FMT_NV12) {
+      yuv_convert::NV12ToRGB32(y, frame->linesize[0],
+                               frame->data[1] + start / 2 * frame->linesize[1], frame->linesize[1],
+                               rgb, dest_stride[0], frame->width, rows, color_space, order);
+    } else {
+      yuv_convert::I420ToRGB32(y, frame->linesize[0],
+                               frame->data[1] + start / 2 * frame->linesize[1], frame->linesize[1],
+                               frame->data[2] + start / 2 * frame->linesize[2], frame->linesize[2],
+                               rgb, dest_stride[0], frame->width, rows, color_space, order);
+    }
+  });
+  return true;
+}
+
+int FrameConverter::ConvertWithSwscale(const AVFrame *frame,
+                                       AVPixelFormat dest_format, int dest_width, int dest_height,
+                                       uint8_t *const dest[4], const int dest_stride[4]) {
+  auto format = AVPixelFormat(frame->format);
+  auto *src_descriptor = av_pix_fmt_desc_get(format);
+  auto *dest_descriptor = av_pix_fmt_desc_get(dest_format);
+  if (!src_descriptor || !dest_descriptor) {
+    return AVERROR(EINVAL);
+  }
+
+  // Nothing to interpolate without scaling, except chroma.
+  int flags = dest_width == frame->width && dest_height == frame->height ? SWS_POINT : SWS_BICUBIC;
+
+  // Slices need the same rows in and out, and a filter which does not read
+  // rows of the slice next to it, or the borders show up as seams. Scaled
+  // frames go through one context. The second plane of palette formats is
+  // the palette.
+  int slice_count = 1;
+  int slice_rows = frame->height;
+  if (flags == SWS_POINT
+      && !((src_descriptor->flags | dest_descriptor->flags) & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+    int alignment = 1 << std::max(src_descriptor->log2_chroma_h, dest_descriptor->log2_chroma_h);
+    slice_rows = SliceRows(frame->height, alignment);
+    slice_count = (frame->height + slice_rows - 1) / slice_rows;
+  }
+
+  for (size_t i = slice_count; i < sws_contexts_.size(); ++i) {
+    sws_freeContext(sws_contexts_[i]);
+  }
+  sws_contexts_.resize(slice_count, nullptr);
+
+  if (slice_count == 1) {
+    sws_contexts_[0] = sws_getCachedContext(sws_contexts_[0], frame->width, frame->height, format,
+                                            dest_width, dest_height, dest_format, flags,
+                                            nullptr, nullptr, nullptr);
+    if (!sws_contexts_[0]) {
+      DLOG(ERROR) << "can not init image convert context";
+      return AVERROR(EINVAL);
+    }
+    sws_scale(sws_contexts_[0], frame->data, frame->linesize, 0, frame->height, dest, dest_stride);
+    return 0;
+  }
+
+  // Set up the contexts first, so that the slices do not fail halfway.
+  for (int slice = 0; slice < slice_count; ++slice) {
+    int rows = std::min(slice_rows, frame->height - slice * slice_rows);
+    sws_contexts_[slice] = sws_getCachedContext(sws_contexts_[slice], frame->width, rows, format,
+                                                dest_width, rows, dest_format, flags,
+                                                nullptr, nullptr, nullptr);
+    if (!sws_contexts_[slice]) {
+      DLOG(ERROR) << "can not init image convert context";
+      return AVERROR(EINVAL);
+    }
+  }
+
+  RunSlices(slice_count, [&](int slice) {
+    int start = slice * slice_rows;
+    int rows = std::min(slice_rows, frame->height - start);
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    for (int plane = 0; plane < 4; ++plane) {
+      src[plane] = OffsetPlane(frame->data, frame->linesize, src_descriptor, plane, start);
+      dst[plane] = OffsetPlane(dest, dest_stride, dest_descriptor, plane, start);
+    }
+    sws_scale(sws_contexts_[slice], src, frame->linesize, 0, rows, dst, dest_stride);
+  });
+  return 0;
+}
+
+} // namespace media
@@ -0,0 +1,86 @@
+//
+// Created by yangbin on 2021/7/28.
+//
+
+#ifndef MEDIA_PLAYER_SRC_FRAME_CONVERTER_H_
+#define MEDIA_PLAYER_SRC_FRAME_CONVERTER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/task_runner.h"
+
+extern "C" {
+#include "libavutil/frame.h"
+#include "libswscale/swscale.h"
+}
+
+namespace media {
+
+/**
+ * Converts decoded frames to the pixel format of a render target, on the CPU.
+ *
+ * The picture is split into horizontal slices which are converted in parallel
+ * on the default ThreadPool, the calling thread converts slices as well. Frames
+ * of I420 or NV12 converted to BGRA/RGBA at the same size use the kernels of
+ * yuv_convert, everything else uses swscale, with SWS_POINT when the size does
+ * not change and SWS_BICUBIC otherwise. Only conversions at the same size are
+ * sliced, a scaling filter reads rows across the slice borders.
+ *
+ * Not thread safe, one frame is converted at a time.
+ */
+class FrameConverter {
+
+ public:
+
+  /**
+   * @param max_threads threads converting one frame, including the caller. 0
+   *        for one per cpu core.
+   * @param use_yuv_kernels false to always use swscale.
+   */
+  explicit FrameConverter(int max_threads = 0, bool use_yuv_kernels = true);
+
+  ~FrameConverter();
+
+  /**
+   * Convert |frame| into |dest|, scaled to |dest_width| x |dest_height|.
+   *
+   * @return 0 on success, a negative AVERROR otherwise.
+   */
+  int Convert(const AVFrame *frame,
+              AVPixelFormat dest_format, int dest_width, int dest_height,
+              uint8_t *const dest[4], const int dest_stride[4]);
+
+ private:
+
+  int max_threads_;
+  bool use_yuv_kernels_;
+
+  // Created on first use, a slice goes to each of them.
+  std::vector<TaskRunner> workers_;
+
+  // One per slice, a context can not be used by two threads at once.
+  std::vector<SwsContext *> sws_contexts_;
+
+  // Rows of every slice but the last, a multiple of |rows_alignment|.
+  int SliceRows(int height, int rows_alignment) const;
+
+  // Run |convert_slice| for slices [0, |slice_count|) and wait for all of them.
+  void RunSlices(int slice_count, const std::function<void(int)> &convert_slice);
+
+  bool ConvertWithKernel(const AVFrame *frame, AVPixelFormat dest_format,
+                         uint8_t *const dest[4], const int dest_stride[4]);
+
+  int ConvertWithSwscale(const AVFrame *frame,
+                         AVPixelFormat dest_format, int dest_width, int dest_height,
+                         uint8_t *const dest[4], const int dest_stride[4]);
+
+  DELETE_COPY_AND_ASSIGN(FrameConverter);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_FRAME_CONVERTER_H_
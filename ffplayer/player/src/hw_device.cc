@@ -0,0 +1,91 @@
+//
+// Created by yangbin on 2021/7/26.
+//
+
+#include "hw_device.h"
+
+#include <sstream>
+
+#include "base/logging.h"
+
+#include "ffmpeg_utils.h"
+
+namespace media {
+
+namespace {
+
+// The pixel format |codec| decodes into with a device of |type|.
+AVPixelFormat FindHwFormat(const AVCodec *codec, AVHWDeviceType type) {
+  for (int i = 0;; i++) {
+    auto *config = avcodec_get_hw_config(codec, i);
+    if (!config) {
+      return AV_PIX_FMT_NONE;
+    }
+    if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) && config->device_type == type) {
+      return config->pix_fmt;
+    }
+  }
+}
+
+}
+
+std::vector<AVHWDeviceType> DefaultHwDeviceTypes() {
+#if defined(_MEDIA_MACOS) || defined(_MEDIA_IOS)
+  return {AV_HWDEVICE_TYPE_VIDEOTOOLBOX};
+#elif defined(_MEDIA_ANDROID)
+  return {AV_HWDEVICE_TYPE_MEDIACODEC};
+#elif defined(_MEDIA_WINDOWS)
+  return {AV_HWDEVICE_TYPE_D3D11VA, AV_HWDEVICE_TYPE_DXVA2};
+#else
+  // DRM-PRIME frames of VAAPI can be handed to the texture as DMA-BUF.
+  return {AV_HWDEVICE_TYPE_VAAPI, AV_HWDEVICE_TYPE_DRM, AV_HWDEVICE_TYPE_VDPAU, AV_HWDEVICE_TYPE_CUDA};
+#endif
+}
+
+std::vector<AVHWDeviceType> ParseHwDeviceTypes(const std::string &names) {
+  std::vector<AVHWDeviceType> types;
+  std::istringstream stream(names);
+  std::string name;
+  while (std::getline(stream, name, ',')) {
+    if (name.empty()) {
+      continue;
+    }
+    auto type = av_hwdevice_find_type_by_name(name.c_str());
+    if (type == AV_HWDEVICE_TYPE_NONE) {
+      DLOG(WARNING) << "unknown hardware device: " << name;
+      continue;
+    }
+    types.push_back(type);
+  }
+  return types;
+}
+
+AVBufferRef *CreateHwDevice(const AVCodec *codec,
+                            const std::vector<AVHWDeviceType> &types,
+                            AVPixelFormat *hw_format,
+                            const HwDeviceCreator &creator) {
+  DCHECK(codec);
+  DCHECK(hw_format);
+  for (auto type : types) {
+    auto format = FindHwFormat(codec, type);
+    if (format == AV_PIX_FMT_NONE) {
+      DLOG(INFO) << codec->name << " can not decode with " << av_hwdevice_get_type_name(type);
+      continue;
+    }
+    AVBufferRef *device = nullptr;
+    auto ret = creator ? creator(&device, type) : av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0);
+    if (ret < 0 || !device) {
+      DLOG(INFO) << "failed to create " << av_hwdevice_get_type_name(type) << " device: "
+                 << ffmpeg::AVErrorToString(ret);
+      av_buffer_unref(&device);
+      continue;
+    }
+    DLOG(INFO) << "decode " << codec->name << " with " << av_hwdevice_get_type_name(type);
+    *hw_format = format;
+    return device;
+  }
+  *hw_format = AV_PIX_FMT_NONE;
+  return nullptr;
+}
+
+} // namespace media
@@ -0,0 +1,48 @@
+//
+// Created by yangbin on 2021/7/26.
+//
+
+#ifndef MEDIA_PLAYER_SRC_HW_DEVICE_H_
+#define MEDIA_PLAYER_SRC_HW_DEVICE_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavutil/hwcontext.h"
+}
+
+namespace media {
+
+/**
+ * The hardware decoders worth trying on the current platform, best first.
+ */
+std::vector<AVHWDeviceType> DefaultHwDeviceTypes();
+
+/**
+ * Parse a comma separated list of FFmpeg device names, e.g. "vaapi,vdpau".
+ * Unknown names are skipped.
+ */
+std::vector<AVHWDeviceType> ParseHwDeviceTypes(const std::string &names);
+
+// Creates a device of |type| into |device|, returns an AVERROR on failure.
+using HwDeviceCreator = std::function<int(AVBufferRef **device, AVHWDeviceType type)>;
+
+/**
+ * Create a device for the first of |types| which |codec| can decode with.
+ *
+ * @param hw_format set to the pixel format of the frames the device decodes.
+ * @param creator defaults to av_hwdevice_ctx_create on the default device.
+ * @return the device, or null if none could be created and decoding should
+ * fall back to software.
+ */
+AVBufferRef *CreateHwDevice(const AVCodec *codec,
+                            const std::vector<AVHWDeviceType> &types,
+                            AVPixelFormat *hw_format,
+                            const HwDeviceCreator &creator = nullptr);
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_HW_DEVICE_H_
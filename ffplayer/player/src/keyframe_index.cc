@@ -0,0 +1,103 @@
+//
+// Created by yangbin on 2021/7/24.
+//
+
+#include "keyframe_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace media {
+
+namespace {
+
+bool EntryBefore(const KeyframeIndex::Entry &entry, double timestamp) {
+  return entry.timestamp < timestamp;
+}
+
+}
+
+void KeyframeIndex::Add(double timestamp, int64 position) {
+  if (std::isnan(timestamp)) {
+    return;
+  }
+  if (entries_.empty() || entries_.back().timestamp < timestamp) {
+    entries_.push_back({timestamp, position});
+    return;
+  }
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), timestamp, EntryBefore);
+  if (it != entries_.end() && it->timestamp == timestamp) {
+    if (it->position < 0) {
+      it->position = position;
+    }
+    return;
+  }
+  entries_.insert(it, {timestamp, position});
+}
+
+void KeyframeIndex::AddCoveredRange(double start, double end) {
+  if (std::isnan(start) || std::isnan(end) || start > end) {
+    return;
+  }
+  // First range which ends at or after |start|, it and the following ones
+  // which start before |end| are merged.
+  auto first = std::lower_bound(covered_ranges_.begin(), covered_ranges_.end(), start,
+                                [](const Range &range, double value) { return range.end < value; });
+  auto last = first;
+  while (last != covered_ranges_.end() && last->start <= end) {
+    start = std::min(start, last->start);
+    end = std::max(end, last->end);
+    ++last;
+  }
+  if (first == last) {
+    covered_ranges_.insert(first, {start, end});
+  } else {
+    *first = {start, end};
+    covered_ranges_.erase(first + 1, last);
+  }
+}
+
+bool KeyframeIndex::FindPrevious(double timestamp, Entry *entry) const {
+  // First entry after |timestamp|.
+  auto it = std::upper_bound(entries_.begin(), entries_.end(), timestamp,
+                             [](double value, const Entry &e) { return value < e.timestamp; });
+  if (it == entries_.begin()) {
+    return false;
+  }
+  *entry = *(it - 1);
+  return true;
+}
+
+bool KeyframeIndex::FindNearest(double timestamp, Entry *entry) const {
+  if (entries_.empty()) {
+    return false;
+  }
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), timestamp, EntryBefore);
+  if (it == entries_.end()) {
+    *entry = entries_.back();
+  } else if (it == entries_.begin()) {
+    *entry = *it;
+  } else {
+    auto previous = it - 1;
+    *entry = timestamp - previous->timestamp <= it->timestamp - timestamp ? *previous : *it;
+  }
+  return true;
+}
+
+bool KeyframeIndex::Covers(double timestamp) const {
+  // The last range which starts at or before |timestamp|.
+  auto range = std::upper_bound(covered_ranges_.begin(), covered_ranges_.end(), timestamp,
+                                [](double value, const Range &r) { return value < r.start; });
+  if (range == covered_ranges_.begin() || (--range)->end < timestamp) {
+    return false;
+  }
+  Entry previous{}, next{};
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), timestamp, EntryBefore);
+  if (it == entries_.end()) {
+    return false;
+  }
+  next = *it;
+  return FindPrevious(timestamp, &previous) && previous.timestamp >= range->start && next.timestamp <= range->end;
+}
+
+} // namespace media
@@ -0,0 +1,91 @@
+//
+// Created by yangbin on 2021/7/24.
+//
+
+#ifndef MEDIA_PLAYER_SRC_KEYFRAME_INDEX_H_
+#define MEDIA_PLAYER_SRC_KEYFRAME_INDEX_H_
+
+#include <vector>
+
+#include "base/basictypes.h"
+
+namespace media {
+
+/**
+ * Timestamps of the keyframes of one stream, in seconds, sorted.
+ *
+ * Seeded from the index of the container and completed lazily with the
+ * keyframes which are demuxed, so it only knows the parts of the media that
+ * were indexed or played. Those parts are tracked as ranges, seeking around
+ * leaves holes between them where keyframes are missing.
+ */
+class KeyframeIndex {
+
+ public:
+
+  struct Entry {
+    double timestamp;
+    // Byte position in the file, -1 if unknown.
+    int64 position;
+  };
+
+  KeyframeIndex() = default;
+
+  /**
+   * Record a keyframe. Amortized O(1) when keyframes come in order.
+   */
+  void Add(double timestamp, int64 position);
+
+  /**
+   * Every keyframe from |start| to |end| was added, e.g. they were demuxed
+   * without a seek in between. Merged with the ranges it overlaps.
+   */
+  void AddCoveredRange(double start, double end);
+
+  /**
+   * The last keyframe at or before |timestamp|.
+   * @return false if there is none.
+   */
+  bool FindPrevious(double timestamp, Entry *entry) const;
+
+  /**
+   * The keyframe closest to |timestamp|, on either side.
+   * @return false if the index is empty.
+   */
+  bool FindNearest(double timestamp, Entry *entry) const;
+
+  /**
+   * Whether the keyframes on both sides of |timestamp| are known: a covered
+   * range holds |timestamp|, a keyframe at or before it and one at or after
+   * it. Otherwise [FindPrevious] and [FindNearest] may answer with a keyframe
+   * across a hole.
+   */
+  bool Covers(double timestamp) const;
+
+  bool empty() const {
+    return entries_.empty();
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+
+  struct Range {
+    double start;
+    double end;
+  };
+
+  std::vector<Entry> entries_;
+
+  // Sorted and disjoint.
+  std::vector<Range> covered_ranges_;
+
+  DELETE_COPY_AND_ASSIGN(KeyframeIndex);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_KEYFRAME_INDEX_H_
@@ -9,13 +9,14 @@
 
 namespace media {
 
-Clock::Clock(int *queue_serial)
+Clock::Clock(int *queue_serial, TimeSource *time_source)
     : queue_serial_(queue_serial),
       speed_(1.0),
       paused(0),
       pts_(NAN),
       pts_drift_(0),
-      serial(-1) {
+      serial(-1),
+      time_source_(time_source) {
   SetClock(NAN, -1);
 }
 
@@ -23,15 +24,20 @@ Clock::Clock() : Clock(&serial) {
 
 }
 
+void Clock::SetTimeSource(TimeSource *time_source) {
+  time_source_ = time_source;
+  SetClock(NAN, -1);
+}
+
 void Clock::SetClockAt(double pts, int _serial, double time) {
-  pts = pts;
+  pts_ = pts;
   last_updated = time;
   pts_drift_ = pts - time;
   serial = _serial;
 }
 
 void Clock::SetClock(double pts, int _serial) {
-  double time = av_gettime_relative() / 1000000.0;
+  double time = time_source_->Now();
   SetClockAt(pts, _serial, time);
 }
 
@@ -54,7 +60,7 @@ double Clock::GetClock() {
   if (paused) {
     return pts_;
   } else {
-    double time = av_gettime_relative() / 1000000.0;
+    double time = time_source_->Now();
     return pts_drift_ + time - (time - last_updated) * (1.0 - speed_);
   }
 }
@@ -93,6 +99,13 @@ double MediaClock::GetMasterClock() {
   }
 }
 
+void MediaClock::SetTimeSource(std::shared_ptr<TimeSource> time_source) {
+  time_source_ = std::move(time_source);
+  audio_clock_->SetTimeSource(this->time_source());
+  video_clock_->SetTimeSource(this->time_source());
+  ext_clock_->SetTimeSource(this->time_source());
+}
+
 MediaClock::MediaClock(
     int *audio_queue_serial,
     int *video_queue_serial,
@@ -8,6 +8,8 @@
 #include <memory>
 #include <functional>
 
+#include "time_source.h"
+
 extern "C" {
 #include <libavutil/time.h> // NOLINT(modernize-deprecated-headers)
 };
@@ -40,12 +42,19 @@ struct Clock {
   /* clock base minus time at which we updated the clock */
   double pts_drift_;
 
+  TimeSource *time_source_;
+
  public:
 
-  explicit Clock(int *queue_serial);
+  explicit Clock(int *queue_serial, TimeSource *time_source = TimeSource::WallClock());
 
   explicit Clock();
 
+  /**
+   * Resets the clock, times of the previous source mean nothing to the new one.
+   */
+  void SetTimeSource(TimeSource *time_source);
+
   double GetClock();
 
   void SetClockAt(double pts, int serial, double time);
@@ -74,10 +83,27 @@ class MediaClock {
 
   std::function<int(int sync_type)> sync_type_confirm_;
 
+  std::shared_ptr<TimeSource> time_source_;
+
  public:
 
   MediaClock(int *audio_queue_serial, int *video_queue_serial, std::function<int(int)> sync_type_confirm);
 
+  /**
+   * The wall clock by default. Resets the clocks, so it is set before playback
+   * starts. Not thread safe, it must not be called once a renderer reads the
+   * clocks.
+   */
+  void SetTimeSource(std::shared_ptr<TimeSource> time_source);
+
+  TimeSource *time_source() const {
+    return time_source_ ? time_source_.get() : TimeSource::WallClock();
+  }
+
+  bool IsFreeRunning() const {
+    return time_source()->IsFreeRunning();
+  }
+
   Clock *GetAudioClock();
 
   Clock *GetVideoClock();
@@ -0,0 +1,59 @@
+//
+// Created by yangbin on 2021/8/1.
+//
+
+#include "media_metrics.h"
+
+#include <cstdlib>
+
+namespace media {
+
+namespace {
+
+void SetValue(int64_t *values, int count, int index, int64 value) {
+  if (index < count) {
+    values[index] = value;
+  }
+}
+
+void SetHistogram(int64_t *values, int count, int index, const Histogram &histogram) {
+  MediaMetrics::WriteHistogram(values, count, index, histogram.GetSnapshot());
+}
+
+} // namespace
+
+// static
+void MediaMetrics::WriteHistogram(int64_t *values, int count, int index, const Histogram::Snapshot &snapshot) {
+  if (index + PLAYER_STAT_HISTOGRAM_FIELDS > count) {
+    return;
+  }
+  values[index] = snapshot.count;
+  values[index + 1] = snapshot.p50;
+  values[index + 2] = snapshot.p90;
+  values[index + 3] = snapshot.p99;
+  values[index + 4] = snapshot.max;
+}
+
+void MediaMetrics::RecordAVDrift(int64 drift_us) {
+  av_drift_us_.store(drift_us, std::memory_order_relaxed);
+  av_drift_abs_us_.Record(std::llabs(drift_us));
+}
+
+void MediaMetrics::Snapshot(int64_t *values, int count) const {
+  SetValue(values, count, kStatVideoPacketsDemuxed, video_.packets_demuxed.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatAudioPacketsDemuxed, audio_.packets_demuxed.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatVideoBufferedBytes, video_.buffered_bytes.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatAudioBufferedBytes, audio_.buffered_bytes.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatVideoFramesDecoded, video_.decoded.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatVideoFramesRendered, frames_rendered_.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatAudioBuffersDecoded, audio_.decoded.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatAudioUnderruns, audio_underruns_.load(std::memory_order_relaxed));
+  SetValue(values, count, kStatAVDrift, av_drift_us_.load(std::memory_order_relaxed));
+  SetHistogram(values, count, kStatVideoDecodeTime, video_.decode_time_us);
+  SetHistogram(values, count, kStatAudioDecodeTime, audio_.decode_time_us);
+  SetHistogram(values, count, kStatVideoRenderCallbackTime, video_.render_callback_time_us);
+  SetHistogram(values, count, kStatAudioRenderCallbackTime, audio_.render_callback_time_us);
+  SetHistogram(values, count, kStatAVDriftAbs, av_drift_abs_us_);
+}
+
+} // namespace media
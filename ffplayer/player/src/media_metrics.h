@@ -0,0 +1,97 @@
+//
+// Created by yangbin on 2021/8/1.
+//
+
+#ifndef MEDIA_PLAYER_SRC_MEDIA_METRICS_H_
+#define MEDIA_PLAYER_SRC_MEDIA_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "base/basictypes.h"
+#include "base/histogram.h"
+
+#include "ffplayer.h"
+
+namespace media {
+
+/**
+ * Counters and histograms of one player, recorded by the stages of the
+ * pipeline on their own threads. Recording neither locks nor allocates.
+ *
+ * Components share it by |set_metrics| and record nothing while
+ * it is null.
+ */
+class MediaMetrics {
+
+ public:
+
+  struct StreamMetrics {
+    std::atomic<int64> packets_demuxed{0};
+    std::atomic<int64> buffered_bytes{0};
+    // Video frames or audio buffers.
+    std::atomic<int64> decoded{0};
+    // Each Decode call of the decoder.
+    Histogram decode_time_us;
+    // Each Render call of the sink to the renderer.
+    Histogram render_callback_time_us;
+  };
+
+  MediaMetrics() = default;
+
+  StreamMetrics &stream(bool video) {
+    return video ? video_ : audio_;
+  }
+
+  StreamMetrics &video() {
+    return video_;
+  }
+
+  StreamMetrics &audio() {
+    return audio_;
+  }
+
+  std::atomic<int64> &frames_rendered() {
+    return frames_rendered_;
+  }
+
+  std::atomic<int64> &audio_underruns() {
+    return audio_underruns_;
+  }
+
+  /**
+   * Video pts minus audio clock when a frame is rendered, in microseconds.
+   */
+  void RecordAVDrift(int64 drift_us);
+
+  /**
+   * Write the values of the metrics at their PlayerStat index in |values|,
+   * which holds |count| values. Those this registry does not keep, e.g. the
+   * queue depths, are left untouched.
+   */
+  void Snapshot(int64_t *values, int count) const;
+
+  /**
+   * Write |snapshot| as the PLAYER_STAT_HISTOGRAM_FIELDS values from |index|,
+   * if they fit in |count|.
+   */
+  static void WriteHistogram(int64_t *values, int count, int index, const Histogram::Snapshot &snapshot);
+
+ private:
+
+  StreamMetrics video_;
+  StreamMetrics audio_;
+
+  std::atomic<int64> frames_rendered_{0};
+  std::atomic<int64> audio_underruns_{0};
+
+  std::atomic<int64> av_drift_us_{0};
+  Histogram av_drift_abs_us_;
+
+  DELETE_COPY_AND_ASSIGN(MediaMetrics);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_MEDIA_METRICS_H_
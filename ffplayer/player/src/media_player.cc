@@ -2,11 +2,17 @@
 // Created by yangbin on 2021/2/13.
 //
 
+#include <algorithm>
+
 #include <base/bind_to_current_loop.h>
 #include "base/logging.h"
 #include "base/lambda.h"
 
 #include "media_player.h"
+#include "file_data_source.h"
+#include "caching_data_source.h"
+#include "mmap_data_source.h"
+#include "hw_device.h"
 
 extern "C" {
 #include "libavutil/bprint.h"
@@ -14,21 +20,56 @@ extern "C" {
 
 namespace media {
 
+namespace {
+
+const int kSeekTaskId = 1;
+
+// Local files are read through a DataSource, anything else is left to the
+// protocols of FFmpeg. Without a mapping, reads go through a read-ahead cache.
+std::unique_ptr<DataSource> CreateDataSource(const std::string &url) {
+  const std::string kFileScheme = "file://";
+  std::string path;
+  if (url.compare(0, kFileScheme.size(), kFileScheme) == 0) {
+    path = url.substr(kFileScheme.size());
+  } else if (url.find("://") == std::string::npos) {
+    path = url;
+  } else {
+    return nullptr;
+  }
+
+  auto mmap_data_source = std::make_unique<MmapDataSource>();
+  if (mmap_data_source->Initialize(path)) {
+    return mmap_data_source;
+  }
+  auto file_data_source = std::make_unique<FileDataSource>();
+  if (file_data_source->Initialize(path)) {
+    return std::make_unique<CachingDataSource>(std::move(file_data_source));
+  }
+  return nullptr;
+}
+
+}
+
 MediaPlayer::MediaPlayer(
     std::unique_ptr<VideoRendererSink> video_renderer_sink,
     std::shared_ptr<AudioRendererSink> audio_renderer_sink,
     const TaskRunner &task_runner
-) : task_runner_(task_runner) {
+) : task_runner_(task_runner),
+    // Demuxing blocks on I/O, it keeps a thread of its own out of the pool.
+    demux_task_runner_(MessageLooper::PrepareLooper("demux")),
+    metrics_(std::make_shared<MediaMetrics>()) {
   task_runner_.PostTask(FROM_HERE, [&]() {
     Initialize();
   });
-  auto decoder_looper = MessageLooper::PrepareLooper("audio_decoder");
+  auto decoder_looper = MessageLooper::PrepareSequencedLooper("audio_decoder");
   auto decoder_task_runner = std::make_shared<TaskRunner>(decoder_looper);
   audio_renderer_ = std::make_shared<AudioRenderer>(decoder_task_runner, std::move(audio_renderer_sink));
   video_renderer_ = std::make_shared<VideoRenderer>(
       task_runner_,
-      std::make_shared<TaskRunner>(MessageLooper::PrepareLooper("video_decoder")),
+      std::make_shared<TaskRunner>(MessageLooper::PrepareSequencedLooper("video_decoder")),
       std::move(video_renderer_sink));
+  audio_renderer_->set_metrics(metrics_);
+  video_renderer_->set_metrics(metrics_);
 }
 
 void MediaPlayer::Initialize() {
@@ -126,6 +167,10 @@ int MediaPlayer::OpenDataSource(const char *filename) {
     av_log(nullptr, AV_LOG_ERROR, "can not open file multi-times.\n");
     return -1;
   }
+  {
+    std::lock_guard<std::mutex> lock_guard(player_mutex_);
+    data_source_opened_ = true;
+  }
   task_runner_.PostTask(FROM_HERE, [&, filename]() {
     OpenDataSourceTask(filename);
   });
@@ -138,13 +183,19 @@ void MediaPlayer::OpenDataSourceTask(const char *filename) {
 
   DLOG(INFO) << "open file: " << filename;
   state_ = kPreparing;
-  demuxer_ = std::make_shared<Demuxer>(TaskRunner(MessageLooper::PrepareLooper("demux")), filename,
+  buffering_policy_ = BufferingPolicy::FromConfiguration(start_configuration);
+  DLOG(INFO) << "buffering policy: " << buffering_policy_;
+  data_source_ = CreateDataSource(filename);
+  demuxer_ = std::make_shared<Demuxer>(demux_task_runner_, filename,
                                        [](std::unique_ptr<MediaTracks> tracks) {
                                          DLOG(INFO) << "on tracks update.";
                                          for (auto &track: tracks->tracks()) {
                                            DLOG(INFO) << "track: " << *track;
                                          }
-                                       });
+                                       },
+                                       data_source_.get());
+  demuxer_->SetBufferingPolicy(buffering_policy_);
+  demuxer_->set_metrics(metrics_);
   demuxer_->Initialize(this, bind_weak(&MediaPlayer::OnDataSourceOpen, shared_from_this()));
 }
 
@@ -162,6 +213,13 @@ void MediaPlayer::OnDataSourceOpen(int open_status) {
 void MediaPlayer::InitVideoRender() {
   auto stream = demuxer_->GetFirstStream(DemuxerStream::Video);
   if (stream) {
+    video_renderer_->SetDecoderThreading(
+        static_cast<VideoDecoderThreadType>(start_configuration.video_decoder_thread_type),
+        start_configuration.video_decoder_thread_count);
+    if (start_configuration.video_hw_accel) {
+      video_renderer_->SetHwDeviceTypes(DefaultHwDeviceTypes());
+    }
+    video_renderer_->SetBufferingPolicy(buffering_policy_);
     video_renderer_->Initialize(stream,
                                 clock_context,
                                 bind_weak(&MediaPlayer::OnVideoRendererInitialized, shared_from_this()));
@@ -182,6 +240,7 @@ void MediaPlayer::OnVideoRendererInitialized(bool success) {
 void MediaPlayer::InitAudioRender() {
   auto stream = demuxer_->GetFirstStream(DemuxerStream::Audio);
   if (stream) {
+    audio_renderer_->SetBufferingPolicy(buffering_policy_);
     audio_renderer_->Initialize(stream, clock_context,
                                 bind_weak(&MediaPlayer::OnAudioRendererInitialized, shared_from_this()));
   }
@@ -191,6 +250,7 @@ void MediaPlayer::OnAudioRendererInitialized(bool success) {
   DLOG(INFO) << __func__ << " : " << success;
   if (success) {
     state_ = kPrepared;
+    ChangePlaybackState(demuxer_buffering_ ? MediaPlayerState::BUFFERING : MediaPlayerState::READY);
     if (play_when_ready_) {
       StartRenders();
     }
@@ -200,7 +260,72 @@ void MediaPlayer::OnAudioRendererInitialized(bool success) {
 }
 
 void MediaPlayer::DumpStatus() {
+  int64_t stats[kStatCount];
+  GetStats(stats, kStatCount);
+  DLOG(INFO) << "packets demuxed video " << stats[kStatVideoPacketsDemuxed]
+             << " audio " << stats[kStatAudioPacketsDemuxed]
+             << ", buffered bytes video " << stats[kStatVideoBufferedBytes]
+             << " audio " << stats[kStatAudioBufferedBytes];
+  DLOG(INFO) << "video frames decoded " << stats[kStatVideoFramesDecoded]
+             << " rendered " << stats[kStatVideoFramesRendered]
+             << " dropped " << stats[kStatVideoFramesDropped]
+             << ", audio buffers decoded " << stats[kStatAudioBuffersDecoded]
+             << " underruns " << stats[kStatAudioUnderruns];
+  DLOG(INFO) << "decode p99 video " << stats[kStatVideoDecodeTime + 3]
+             << "us audio " << stats[kStatAudioDecodeTime + 3]
+             << "us, av drift " << stats[kStatAVDrift] << "us";
+  DLOG(INFO) << "queue depth player " << stats[kStatPlayerQueueDepth]
+             << " demuxer " << stats[kStatDemuxerQueueDepth]
+             << " video decoder " << stats[kStatVideoDecoderQueueDepth]
+             << " audio decoder " << stats[kStatAudioDecoderQueueDepth];
+
+  auto dump_tasks = [](const char *name, const TaskStats &task_stats) {
+    DLOG(INFO) << name << " tasks " << task_stats.run_time_us.count
+               << ", queue delay p99 " << task_stats.queue_delay_us.p99
+               << "us max " << task_stats.queue_delay_us.max
+               << "us, run time p99 " << task_stats.run_time_us.p99
+               << "us max " << task_stats.run_time_us.max << "us";
+    for (auto &location : task_stats.slowest_locations) {
+      DLOG(INFO) << "  " << location.location.ToShortString() << " count " << location.count
+                 << " total " << location.total_run_time_us << "us max " << location.max_run_time_us
+                 << "us max queue delay " << location.max_queue_delay_us << "us";
+    }
+  };
+  static const int kSlowestLocationsToDump = 3;
+  dump_tasks("player", task_runner_.GetTaskStats(kSlowestLocationsToDump));
+  dump_tasks("demuxer", demux_task_runner_.GetTaskStats(kSlowestLocationsToDump));
+  dump_tasks("video decoder", video_renderer_->GetDecoderTaskStats(kSlowestLocationsToDump));
+  dump_tasks("audio decoder", audio_renderer_->GetDecoderTaskStats(kSlowestLocationsToDump));
+}
 
+int MediaPlayer::GetStats(int64_t *values, int count) {
+  count = std::min(count, static_cast<int>(kStatCount));
+  if (!values || count <= 0) {
+    return 0;
+  }
+  std::fill(values, values + count, 0);
+  metrics_->Snapshot(values, count);
+  auto set_value = [values, count](int index, int64_t value) {
+    if (index < count) {
+      values[index] = value;
+    }
+  };
+  set_value(kStatVideoFramesDropped, video_renderer_->frame_drop_count());
+  auto set_task_stats = [values, count, &set_value](const TaskStats &task_stats, int queue_depth_index,
+                                                    int queue_delay_index, int run_time_index) {
+    set_value(queue_depth_index, task_stats.queue.pending_count);
+    MediaMetrics::WriteHistogram(values, count, queue_delay_index, task_stats.queue_delay_us);
+    MediaMetrics::WriteHistogram(values, count, run_time_index, task_stats.run_time_us);
+  };
+  set_task_stats(task_runner_.GetTaskStats(),
+                 kStatPlayerQueueDepth, kStatPlayerTaskQueueDelay, kStatPlayerTaskRunTime);
+  set_task_stats(demux_task_runner_.GetTaskStats(),
+                 kStatDemuxerQueueDepth, kStatDemuxerTaskQueueDelay, kStatDemuxerTaskRunTime);
+  set_task_stats(video_renderer_->GetDecoderTaskStats(),
+                 kStatVideoDecoderQueueDepth, kStatVideoDecoderTaskQueueDelay, kStatVideoDecoderTaskRunTime);
+  set_task_stats(audio_renderer_->GetDecoderTaskStats(),
+                 kStatAudioDecoderQueueDepth, kStatAudioDecoderTaskQueueDelay, kStatAudioDecoderTaskRunTime);
+  return count;
 }
 
 TimeDelta MediaPlayer::GetCurrentPosition() {
@@ -244,16 +369,100 @@ double MediaPlayer::GetDuration() const {
   return duration_;
 }
 
-void MediaPlayer::Seek(TimeDelta position) {
+void MediaPlayer::Seek(TimeDelta position, SeekMode mode) {
   if (position < TimeDelta::Zero()) {
     DLOG(WARNING) << "invalid seek position: " << position.InSecondsF();
     return;
   }
-  task_runner_.PostTask(FROM_HERE, [&, position]() {
-    ChangePlaybackState(MediaPlayerState::BUFFERING);
-    demuxer_->AbortPendingReads();
-    demuxer_->SeekTo(position, BindToCurrentLoop(bind_weak(&MediaPlayer::OnSeekCompleted, shared_from_this())));
+  {
+    std::lock_guard<std::mutex> lock_guard(player_mutex_);
+    seek_position_pending_ = position;
+    seek_mode_pending_ = mode;
+  }
+  task_runner_.PostTaskIfNotPending(FROM_HERE, kSeekTaskId, bind_weak(&MediaPlayer::SeekTask, shared_from_this()));
+}
+
+void MediaPlayer::SeekTask() {
+  DCHECK(task_runner_.BelongsToCurrentThread());
+  TimeDelta position;
+  SeekMode mode;
+  {
+    std::lock_guard<std::mutex> lock_guard(player_mutex_);
+    position = seek_position_pending_;
+    mode = seek_mode_pending_;
+  }
+  if (scrubbing_) {
+    mode = SeekMode::kFast;
+    scrubbed_ = true;
+  }
+
+  ChangePlaybackState(MediaPlayerState::BUFFERING);
+  demuxer_->AbortPendingReads();
+  auto start_time = mode == SeekMode::kAccurate ? position.InSecondsF() : 0;
+  std::weak_ptr<MediaPlayer> weak_this = shared_from_this();
+  demuxer_->SeekTo(position, mode, BindToCurrentLoop(std::function<void(bool)>(
+      [weak_this, start_time](bool succeed) {
+        auto player = weak_this.lock();
+        if (player) {
+          player->OnSeekCompleted(succeed, start_time);
+        }
+      })));
+}
+
+void MediaPlayer::SetScrubbing(bool scrubbing) {
+  task_runner_.PostTask(FROM_HERE, [weak_this(std::weak_ptr<MediaPlayer>(shared_from_this())), scrubbing]() {
+    auto player = weak_this.lock();
+    if (player) {
+      player->SetScrubbingTask(scrubbing);
+    }
+  });
+}
+
+void MediaPlayer::SetDisplaySize(int width, int height) {
+  task_runner_.PostTask(FROM_HERE, [weak_this(std::weak_ptr<MediaPlayer>(shared_from_this())), width, height]() {
+    auto player = weak_this.lock();
+    if (player && player->video_renderer_) {
+      player->video_renderer_->SetDisplaySize(width, height);
+    }
+  });
+}
+
+int MediaPlayer::SetTimeSource(std::shared_ptr<TimeSource> time_source) {
+  std::lock_guard<std::mutex> lock_guard(player_mutex_);
+  if (data_source_opened_) {
+    av_log(nullptr, AV_LOG_ERROR, "can not change the time source after opening a data source.\n");
+    return -1;
+  }
+  // After |Initialize|, which creates the clock, and before |OpenDataSourceTask|,
+  // so no renderer thread reads the clock yet.
+  task_runner_.PostTask(FROM_HERE, [weak_this(std::weak_ptr<MediaPlayer>(shared_from_this())), time_source]() {
+    auto player = weak_this.lock();
+    if (player && player->clock_context) {
+      DCHECK_EQ(player->state_, kIdle);
+      player->clock_context->SetTimeSource(time_source);
+    }
   });
+  return 0;
+}
+
+void MediaPlayer::SetScrubbingTask(bool scrubbing) {
+  DCHECK(task_runner_.BelongsToCurrentThread());
+  if (scrubbing_ == scrubbing) {
+    return;
+  }
+  scrubbing_ = scrubbing;
+  if (video_renderer_) {
+    video_renderer_->SetKeyframesOnly(scrubbing);
+  }
+  if (!scrubbing && scrubbed_) {
+    scrubbed_ = false;
+    TimeDelta position;
+    {
+      std::lock_guard<std::mutex> lock_guard(player_mutex_);
+      position = seek_position_pending_;
+    }
+    Seek(position, SeekMode::kAccurate);
+  }
 }
 
 void MediaPlayer::GlobalInit() {
@@ -345,16 +554,31 @@ void MediaPlayer::OnDemuxerError(PipelineStatus error) {
 
 }
 
-void MediaPlayer::OnSeekCompleted(bool succeed) {
-  DLOG(INFO) << "OnSeekCompleted: " << succeed;
+void MediaPlayer::OnBufferingStateChanged(bool buffering) {
+  std::weak_ptr<MediaPlayer> weak_this = shared_from_this();
+  task_runner_.PostTask(FROM_HERE, [weak_this, buffering]() {
+    auto player = weak_this.lock();
+    if (!player) {
+      return;
+    }
+    player->demuxer_buffering_ = buffering;
+    // Still preparing, reported by |OnAudioRendererInitialized|.
+    if (player->state_ == kPrepared) {
+      player->ChangePlaybackState(buffering ? MediaPlayerState::BUFFERING : MediaPlayerState::READY);
+    }
+  });
+}
+
+void MediaPlayer::OnSeekCompleted(bool succeed, double start_time) {
+  DLOG(INFO) << "OnSeekCompleted: " << succeed << " start time: " << start_time;
   if (!succeed) {
     return;
   }
   if (audio_renderer_) {
-    audio_renderer_->Flush();
+    audio_renderer_->Flush(start_time);
   }
   if (video_renderer_) {
-    video_renderer_->Flush();
+    video_renderer_->Flush(start_time);
   }
 }
 
@@ -19,6 +19,8 @@
 #include "audio_decoder.h"
 #include "decoder_stream.h"
 #include "demuxer.h"
+#include "buffering_policy.h"
+#include "media_metrics.h"
 
 namespace media {
 
@@ -59,19 +61,40 @@ class MediaPlayer : public std::enable_shared_from_this<MediaPlayer>, public Dem
 
   std::shared_ptr<MediaClock> clock_context;
 
+  // Must outlive |demuxer_|.
+  std::unique_ptr<DataSource> data_source_;
+
   std::shared_ptr<Demuxer> demuxer_;
 
   std::shared_ptr<AudioRenderer> audio_renderer_;
   std::shared_ptr<VideoRenderer> video_renderer_;
 
   MediaPlayerState player_state_ = MediaPlayerState::IDLE;
+
+  // Last buffering state of the demuxer, applied once prepared.
+  bool demuxer_buffering_ = false;
   std::mutex player_mutex_;
 
+  // Set by |OpenDataSource|, guarded by |player_mutex_|.
+  bool data_source_opened_ = false;
+
   double buffering_check_last_stamp_ = 0;
 
+  BufferingPolicy buffering_policy_;
+
   bool play_when_ready_ = false;
   bool play_when_ready_pending_ = false;
 
+  // Latest requested seek, guarded by |player_mutex_|. Requests made before
+  // |SeekTask| runs are coalesced into it.
+  TimeDelta seek_position_pending_;
+  SeekMode seek_mode_pending_ = SeekMode::kAccurate;
+
+  // Only used on |task_runner_|. |scrubbed_| is set when a seek ran while
+  // scrubbing, an accurate seek is made when scrubbing ends.
+  bool scrubbing_ = false;
+  bool scrubbed_ = false;
+
   // buffered position in seconds. -1 if not available
   double buffered_position_ = -1;
 
@@ -100,6 +123,7 @@ class MediaPlayer : public std::enable_shared_from_this<MediaPlayer>, public Dem
  public:
   void SetDuration(double duration) override;
   void OnDemuxerError(PipelineStatus error) override;
+  void OnBufferingStateChanged(bool buffering) override;
 
  public:
   PlayerConfiguration start_configuration{};
@@ -118,7 +142,39 @@ class MediaPlayer : public std::enable_shared_from_this<MediaPlayer>, public Dem
 
   double GetDuration() const;
 
-  void Seek(TimeDelta position);
+  void Seek(TimeDelta position, SeekMode mode = SeekMode::kAccurate);
+
+  /**
+   * Call with true when the user starts dragging a scrubber and with false
+   * when the drag ends.
+   *
+   * While scrubbing, seeks go to the nearest keyframe and only keyframes are
+   * decoded, as a cheap preview. Ending it seeks accurately to the last
+   * scrubbed position.
+   */
+  void SetScrubbing(bool scrubbing);
+
+  /**
+   * Size the video is shown at, in physical pixels, 0 for the size of the
+   * video. Frames are converted at no more than that, and when it is set
+   * before the video stream opens, decoders which support it decode at a
+   * lower resolution.
+   */
+  void SetDisplaySize(int width, int height);
+
+  /**
+   * Where the playback clock takes the time from, the wall clock by default.
+   * A free running source plays as fast as the pipeline can go. The renderer
+   * threads read it without a lock, so it can only be set before
+   * [OpenDataSource].
+   *
+   * @return -1 if a data source was already opened.
+   */
+  int SetTimeSource(std::shared_ptr<TimeSource> time_source);
+
+  int GetDroppedFrameCount() const {
+    return video_renderer_->frame_drop_count();
+  }
 
   VideoRendererSink *GetVideoRenderSink() {
     return video_renderer_->video_renderer_sink();
@@ -129,6 +185,14 @@ class MediaPlayer : public std::enable_shared_from_this<MediaPlayer>, public Dem
    */
   void DumpStatus();
 
+  /**
+   * Fill |values| with the current metrics of the pipeline, indexed by
+   * PlayerStat. Lock-free, cheap enough to poll every frame.
+   *
+   * @return count of values filled, at most kStatCount.
+   */
+  int GetStats(int64_t *values, int count);
+
   using OnVideoSizeChangeCallback = std::function<void(int width, int height)>;
   void set_on_video_size_changed_callback(OnVideoSizeChangeCallback callback) {
     on_video_size_changed_ = std::move(callback);
@@ -138,6 +202,10 @@ class MediaPlayer : public std::enable_shared_from_this<MediaPlayer>, public Dem
 
   TaskRunner task_runner_;
 
+  TaskRunner demux_task_runner_;
+
+  std::shared_ptr<MediaMetrics> metrics_;
+
   OnVideoSizeChangeCallback on_video_size_changed_;
 
   double duration_ = -1;
@@ -148,10 +216,15 @@ class MediaPlayer : public std::enable_shared_from_this<MediaPlayer>, public Dem
 
   void DumpMediaClockStatus();
 
-  void OnSeekCompleted(bool succeed);
+  // |start_time| is where rendering resumes, frames before it are dropped.
+  void OnSeekCompleted(bool succeed, double start_time);
 
   void SetPlayWhenReadyTask(bool play_when_ready);
 
+  void SeekTask();
+
+  void SetScrubbingTask(bool scrubbing);
+
 
 };
 
@@ -0,0 +1,212 @@
+//
+// Created by yangbin on 2021/7/22.
+//
+
+#include "mmap_data_source.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "base/logging.h"
+
+namespace media {
+
+#if !defined(_WIN32)
+
+// Bytes advised ahead of the read position. Large enough to cover the header
+// and first seconds of a typical file in a single request.
+const int64_t kPrefetchWindow = 4 * 1024 * 1024;
+
+MmapDataSource::MmapDataSource()
+    : data_(nullptr),
+      size_(0),
+      fd_(-1),
+      truncated_(false),
+      prefetched_start_(0),
+      prefetched_end_(0),
+      stopped_(false),
+      bytes_read_(0) {
+}
+
+MmapDataSource::~MmapDataSource() {
+  if (data_) {
+    munmap(const_cast<uint8_t *>(data_), static_cast<size_t>(size_));
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool MmapDataSource::Initialize(const std::string &file_path) {
+  DCHECK(!data_);
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    DLOG(ERROR) << "failed to open " << file_path << " : " << strerror(errno);
+    return false;
+  }
+
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+    DLOG(ERROR) << "can not map " << file_path;
+    close(fd);
+    return false;
+  }
+
+  auto *address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  if (address == MAP_FAILED) {
+    DLOG(ERROR) << "failed to map " << file_path << " : " << strerror(errno);
+    close(fd);
+    return false;
+  }
+
+  fd_ = fd;
+  data_ = static_cast<const uint8_t *>(address);
+  size_ = st.st_size;
+  madvise(address, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+  Prefetch(0);
+  return true;
+}
+
+void MmapDataSource::Prefetch(int64_t position) {
+  // Only advise again once the reader got past half of the window, or jumped
+  // out of it.
+  if (position >= prefetched_start_
+      && (position + kPrefetchWindow / 2 < prefetched_end_ || prefetched_end_ == size_)) {
+    return;
+  }
+  static const int64_t page_size = sysconf(_SC_PAGESIZE);
+  auto start = position / page_size * page_size;
+  auto end = std::min(position + kPrefetchWindow, size_);
+  if (start >= end) {
+    return;
+  }
+  madvise(const_cast<uint8_t *>(data_) + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+  prefetched_start_ = start;
+  prefetched_end_ = end;
+}
+
+void MmapDataSource::Read(int64_t position,
+                          int size,
+                          uint8_t *data,
+                          DataSource::ReadCB read_cb) {
+  if (stopped_ || !data_) {
+    std::move(read_cb)(kReadError);
+    return;
+  }
+
+  DCHECK_GE(position, 0);
+  DCHECK_GE(size, 0);
+
+  struct stat st{};
+  if (!truncated_ && (fstat(fd_, &st) != 0 || st.st_size < size_)) {
+    LOG(WARNING) << "mapped file was truncated, reading it without the mapping.";
+    truncated_ = true;
+  }
+  if (truncated_) {
+    auto result = ReadTruncated(position, size, data);
+    if (result > 0) {
+      bytes_read_ += result;
+    }
+    std::move(read_cb)(result);
+    return;
+  }
+
+  // Cap position and size within bounds.
+  position = std::min(position, size_);
+  auto clamped_size = static_cast<int>(std::min(static_cast<int64_t>(size), size_ - position));
+
+  Prefetch(position);
+  memcpy(data, data_ + position, static_cast<size_t>(clamped_size));
+
+  bytes_read_ += clamped_size;
+  std::move(read_cb)(clamped_size);
+}
+
+int MmapDataSource::ReadTruncated(int64_t position, int size, uint8_t *data) {
+  int read = 0;
+  while (read < size) {
+    auto result = pread(fd_, data + read, static_cast<size_t>(size - read), position + read);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return kReadError;
+    }
+    if (result == 0) {
+      break;
+    }
+    read += static_cast<int>(result);
+  }
+  return read;
+}
+
+#else
+
+MmapDataSource::MmapDataSource()
+    : data_(nullptr),
+      size_(0),
+      fd_(-1),
+      truncated_(false),
+      prefetched_start_(0),
+      prefetched_end_(0),
+      stopped_(false),
+      bytes_read_(0) {
+}
+
+MmapDataSource::~MmapDataSource() = default;
+
+bool MmapDataSource::Initialize(const std::string &) {
+  DLOG(WARNING) << "MmapDataSource is not supported on this platform.";
+  return false;
+}
+
+void MmapDataSource::Prefetch(int64_t) {}
+
+void MmapDataSource::Read(int64_t,
+                          int,
+                          uint8_t *,
+                          DataSource::ReadCB read_cb) {
+  std::move(read_cb)(kReadError);
+}
+
+int MmapDataSource::ReadTruncated(int64_t, int, uint8_t *) {
+  return kReadError;
+}
+
+#endif
+
+void MmapDataSource::Stop() {
+  // The mapping stays until destruction, a read on another thread may still
+  // be copying from it.
+  stopped_ = true;
+}
+
+void MmapDataSource::Abort() {}
+
+bool MmapDataSource::GetSize(int64_t *size_out) {
+  if (!data_) {
+    return false;
+  }
+  *size_out = size_;
+  return true;
+}
+
+bool MmapDataSource::IsStreaming() {
+  return false;
+}
+
+void MmapDataSource::SetBitrate(int) {}
+
+int64_t MmapDataSource::GetMemoryUsage() {
+  // Clean file-backed pages, the kernel reclaims them under pressure.
+  return 0;
+}
+
+} // namespace media
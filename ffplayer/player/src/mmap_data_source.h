@@ -0,0 +1,82 @@
+//
+// Created by yangbin on 2021/7/22.
+//
+
+#ifndef MEDIA_PLAYER_SRC_MMAP_DATA_SOURCE_H_
+#define MEDIA_PLAYER_SRC_MMAP_DATA_SOURCE_H_
+
+#include <atomic>
+#include <string>
+
+#include "data_source.h"
+
+namespace media {
+
+/**
+ * Serves reads of a local file from a read-only memory mapping.
+ *
+ * A read is a single copy out of the page cache, there is no syscall and no
+ * stdio buffer on the way. The kernel is told the access is sequential, and
+ * the window ahead of every read is prefetched with MADV_WILLNEED, so a cold
+ * open or a seek waits for one batch of I/O instead of one page fault per
+ * AVIO read.
+ *
+ * The file may be truncated while it is mapped, and touching a mapped page past
+ * the new end raises SIGBUS. So every read checks the size of the file first,
+ * and once it shrank, reads go through pread instead of the mapping.
+ *
+ * Only available on POSIX, |Initialize| fails elsewhere.
+ */
+class MmapDataSource : public DataSource {
+
+ public:
+
+  MmapDataSource();
+  ~MmapDataSource() override;
+
+  bool Initialize(const std::string &file_path);
+
+  // Implementation of DataSource.
+  void Stop() override;
+  void Abort() override;
+  void Read(int64_t position,
+            int size,
+            uint8_t *data,
+            DataSource::ReadCB read_cb) override;
+  bool GetSize(int64_t *size_out) override;
+  bool IsStreaming() override;
+  void SetBitrate(int bitrate) override;
+  int64_t GetMemoryUsage() override;
+
+  uint64_t bytes_read_for_testing() const { return bytes_read_; }
+
+ private:
+
+  const uint8_t *data_;
+  // Size of the mapping.
+  int64_t size_;
+
+  // Kept open to watch the size of the file and to read it once truncated.
+  int fd_;
+  bool truncated_;
+
+  // Range last advised with MADV_WILLNEED.
+  int64_t prefetched_start_;
+  int64_t prefetched_end_;
+
+  std::atomic_bool stopped_;
+
+  uint64_t bytes_read_;
+
+  void Prefetch(int64_t position);
+
+  // @return the bytes read, or kReadError.
+  int ReadTruncated(int64_t position, int size, uint8_t *data);
+
+  DELETE_COPY_AND_ASSIGN(MmapDataSource);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_MMAP_DATA_SOURCE_H_
@@ -0,0 +1,120 @@
+//
+// Created by yangbin on 2021/7/30.
+//
+
+#include "null_audio_renderer_sink.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace media {
+
+// Samples are signed 16 bit, as the renderer writes them.
+const int kBytesPerSample = 2;
+
+// How soon a free running sink pulls again after the renderer ran out of data.
+const int64 kFreeRunningUnderrunDelayUs = 1000;
+
+// How often a time source other than the wall clock is checked.
+const int64 kTimeSourcePollDelayUs = 1000;
+
+NullAudioRendererSink::NullAudioRendererSink(double speed, int frames_per_buffer,
+                                             std::shared_ptr<TimeSource> time_source)
+    : speed_(speed),
+      frames_per_buffer_(frames_per_buffer),
+      time_source_(std::move(time_source)),
+      task_runner_(std::make_unique<TaskRunner>(base::MessageLooper::PrepareSequencedLooper("audio_render"))) {
+  DCHECK_GE(speed_, 0);
+  DCHECK_GT(frames_per_buffer_, 0);
+}
+
+NullAudioRendererSink::~NullAudioRendererSink() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  playing_ = false;
+  task_runner_.reset(nullptr);
+}
+
+void NullAudioRendererSink::Initialize(int wanted_nb_channels, int wanted_sample_rate,
+                                       RenderCallback *render_callback) {
+  DCHECK(render_callback);
+  DCHECK_GT(wanted_nb_channels, 0);
+  DCHECK_GT(wanted_sample_rate, 0);
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  channels_ = wanted_nb_channels;
+  sample_rate_ = wanted_sample_rate;
+  render_callback_ = render_callback;
+  buffer_.resize(size_t(frames_per_buffer_) * channels_ * kBytesPerSample);
+}
+
+bool NullAudioRendererSink::SetVolume(double) {
+  // The renderer applies the volume to the samples.
+  return false;
+}
+
+void NullAudioRendererSink::Play() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  DCHECK(render_callback_) << "Play before Initialize.";
+  if (playing_) {
+    return;
+  }
+  playing_ = true;
+  start_time_ = time_source()->Now();
+  pulled_buffers_ = 0;
+  next_pull_time_ = start_time_;
+  task_runner_->PostTask(FROM_HERE, std::bind(&NullAudioRendererSink::RenderTask, this));
+}
+
+void NullAudioRendererSink::Pause() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  playing_ = false;
+  task_runner_->RemoveAllTasks();
+}
+
+void NullAudioRendererSink::RenderTask() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  if (!playing_) {
+    return;
+  }
+  if (speed_ != 0 && time_source()->Now() < next_pull_time_.load()) {
+    ScheduleRenderTask(next_pull_time_.load());
+    return;
+  }
+
+  auto len = static_cast<int>(buffer_.size());
+  // A device starts playing the buffer right after the callback, nothing is
+  // queued before it.
+  auto read = render_callback_->Render(0, buffer_.data(), len);
+  if (read < len) {
+    memset(buffer_.data() + read, 0, len - read);
+  }
+  auto bytes_per_frame = channels_ * kBytesPerSample;
+  rendered_frames_.fetch_add(frames_per_buffer_, std::memory_order_relaxed);
+  underrun_frames_.fetch_add((len - read) / bytes_per_frame, std::memory_order_relaxed);
+
+  if (speed_ == 0) {
+    task_runner_->PostDelayedTask(FROM_HERE,
+                                  TimeDelta::FromMicroseconds(read < len ? kFreeRunningUnderrunDelayUs : 0),
+                                  std::bind(&NullAudioRendererSink::RenderTask, this));
+    return;
+  }
+  // Scheduled from the device time instead of now, so that the time spent in
+  // the callback and late wake ups do not slow the device down. Not summed up
+  // buffer by buffer, which would drift from the time source by rounding.
+  pulled_buffers_++;
+  next_pull_time_ = start_time_ + double(pulled_buffers_ * frames_per_buffer_) / (sample_rate_ * speed_);
+  ScheduleRenderTask(next_pull_time_.load());
+}
+
+void NullAudioRendererSink::ScheduleRenderTask(double time) {
+  auto delay_us = std::max<int64>(static_cast<int64>((time - time_source()->Now()) * 1000000), 0);
+  if (time_source_ && delay_us > 0) {
+    // Only the wall clock tells how long to wait.
+    delay_us = kTimeSourcePollDelayUs;
+  }
+  task_runner_->PostDelayedTask(FROM_HERE, TimeDelta::FromMicroseconds(delay_us),
+                                std::bind(&NullAudioRendererSink::RenderTask, this));
+}
+
+} // namespace media
@@ -0,0 +1,126 @@
+//
+// Created by yangbin on 2021/7/30.
+//
+
+#ifndef MEDIA_PLAYER_SRC_NULL_AUDIO_RENDERER_SINK_H_
+#define MEDIA_PLAYER_SRC_NULL_AUDIO_RENDERER_SINK_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/task_runner.h"
+
+#include "audio_renderer_sink.h"
+#include "time_source.h"
+
+namespace media {
+
+/**
+ * A sink which plays nothing, for playback without an audio device in tests
+ * and benchmarks. It simulates a device: a buffer of |frames_per_buffer|
+ * frames of signed 16 bit samples is pulled from the renderer every time the
+ * previous one would have been played at the sample rate.
+ *
+ * With |speed| above 1 buffers are pulled that much faster, the audio clock
+ * follows since the renderer sets it from the pts of every buffer. With a
+ * |speed| of 0 the next buffer is pulled right away, for a MediaClock with a
+ * free running TimeSource.
+ *
+ * The device runs on |time_source|, the wall clock if it is null. A
+ * ManualTimeSource makes playback deterministic: a buffer is only pulled once
+ * the source reached its time, and the sink checks the source again every
+ * millisecond while it waits, since it can not know when the source is
+ * stepped.
+ */
+class NullAudioRendererSink : public AudioRendererSink {
+
+ public:
+
+  explicit NullAudioRendererSink(double speed = 1.0, int frames_per_buffer = 1024,
+                                 std::shared_ptr<TimeSource> time_source = nullptr);
+
+  ~NullAudioRendererSink() override;
+
+  void Initialize(int wanted_nb_channels, int wanted_sample_rate, RenderCallback *render_callback) override;
+
+  bool SetVolume(double volume) override;
+
+  void Play() override;
+
+  void Pause() override;
+
+  /**
+   * Frames pulled from the renderer, the renderer had no data for
+   * |underrun_frames| of them and silence was played instead.
+   */
+  int64 rendered_frames() const {
+    return rendered_frames_.load(std::memory_order_relaxed);
+  }
+
+  int64 underrun_frames() const {
+    return underrun_frames_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Seconds of audio played by the simulated device.
+   */
+  double played_seconds() const {
+    return sample_rate_ > 0 ? double(rendered_frames()) / sample_rate_ : 0;
+  }
+
+  /**
+   * Time of the time source the next buffer is pulled at. Once it is after
+   * the current time, every buffer due was pulled.
+   */
+  double next_pull_time() const {
+    return next_pull_time_.load();
+  }
+
+ private:
+
+  double speed_;
+  int frames_per_buffer_;
+
+  std::shared_ptr<TimeSource> time_source_;
+
+  int channels_ = 0;
+  int sample_rate_ = 0;
+
+  RenderCallback *render_callback_ = nullptr;
+
+  std::unique_ptr<TaskRunner> task_runner_;
+
+  // Guards |playing_|, |buffer_| and the render callback.
+  std::mutex render_mutex_;
+
+  bool playing_ = false;
+
+  std::vector<uint8> buffer_;
+
+  std::atomic<int64> rendered_frames_{0};
+  std::atomic<int64> underrun_frames_{0};
+
+  // Time of |time_source_| playback started at, and buffers pulled since.
+  double start_time_ = 0;
+  int64 pulled_buffers_ = 0;
+  std::atomic<double> next_pull_time_{0};
+
+  TimeSource *time_source() const {
+    return time_source_ ? time_source_.get() : TimeSource::WallClock();
+  }
+
+  void RenderTask();
+
+  // Run |RenderTask| once |time_source_| reaches |time|.
+  void ScheduleRenderTask(double time);
+
+  DELETE_COPY_AND_ASSIGN(NullAudioRendererSink);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_NULL_AUDIO_RENDERER_SINK_H_
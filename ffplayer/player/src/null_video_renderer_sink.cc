@@ -0,0 +1,143 @@
+//
+// Created by yangbin on 2021/7/30.
+//
+
+#include "null_video_renderer_sink.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+extern "C" {
+#include "libavutil/adler32.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+}
+
+namespace media {
+
+// How often a time source other than the wall clock is checked.
+const int64 kTimeSourcePollDelayUs = 1000;
+
+NullVideoRendererSink::NullVideoRendererSink(std::shared_ptr<TimeSource> time_source)
+    : time_source_(std::move(time_source)),
+      task_runner_(std::make_unique<TaskRunner>(base::MessageLooper::PrepareSequencedLooper("video_render"))) {
+}
+
+NullVideoRendererSink::~NullVideoRendererSink() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  task_runner_.reset(nullptr);
+  if (output_) {
+    fclose(output_);
+    output_ = nullptr;
+  }
+}
+
+void NullVideoRendererSink::Start(VideoRendererSink::RenderCallback *callback) {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  DCHECK(callback);
+  DCHECK_EQ(state_, kIdle);
+  render_callback_ = callback;
+  state_ = kRunning;
+  start_time_ = time_source()->Now();
+  next_render_time_ = start_time_;
+  task_runner_->PostTask(FROM_HERE, std::bind(&NullVideoRendererSink::RenderTask, this));
+}
+
+void NullVideoRendererSink::Stop() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  render_callback_ = nullptr;
+  state_ = kIdle;
+  task_runner_->RemoveAllTasks();
+}
+
+void NullVideoRendererSink::set_compute_checksums(bool compute_checksums) {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  compute_checksums_ = compute_checksums;
+}
+
+bool NullVideoRendererSink::SetOutputPath(const std::string &path) {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  DCHECK_EQ(state_, kIdle);
+  if (output_) {
+    fclose(output_);
+  }
+  output_ = fopen(path.c_str(), "w");
+  DLOG_IF(ERROR, !output_) << "can not open " << path;
+  return output_ != nullptr;
+}
+
+std::vector<NullVideoRendererSink::PresentedFrame> NullVideoRendererSink::presented_frames() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  return presented_frames_;
+}
+
+// static
+uint32 NullVideoRendererSink::ComputeChecksum(const AVFrame *frame) {
+  auto format = static_cast<AVPixelFormat>(frame->format);
+  const auto *desc = av_pix_fmt_desc_get(format);
+  if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+    return 0;
+  }
+  // Only the visible bytes of each row, the padding up to the linesize is
+  // whatever the decoder left there.
+  unsigned long checksum = av_adler32_update(0, nullptr, 0);
+  for (int plane = 0; plane < 4 && frame->data[plane]; ++plane) {
+    auto row_bytes = av_image_get_linesize(format, frame->width, plane);
+    if (row_bytes <= 0) {
+      break;
+    }
+    auto rows = frame->height;
+    if (plane == 1 || plane == 2) {
+      rows = AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h);
+    }
+    for (int row = 0; row < rows; ++row) {
+      checksum = av_adler32_update(checksum, frame->data[plane] + row * frame->linesize[plane], row_bytes);
+    }
+  }
+  return static_cast<uint32>(checksum);
+}
+
+void NullVideoRendererSink::RenderTask() {
+  std::lock_guard<std::mutex> lock_guard(render_mutex_);
+  if (render_callback_ == nullptr) {
+    return;
+  }
+  auto now = time_source()->Now();
+  if (now < next_render_time_.load()) {
+    ScheduleRenderTask(next_render_time_.load());
+    return;
+  }
+  TimeDelta next_delay;
+  auto frame = render_callback_->Render(next_delay);
+  if (!frame->IsEmpty() && frame != last_frame_) {
+    Present(frame);
+  }
+  next_render_time_ = now + next_delay.InSecondsF();
+  ScheduleRenderTask(next_render_time_.load());
+}
+
+void NullVideoRendererSink::ScheduleRenderTask(double time) {
+  auto delay_us = std::max<int64>(static_cast<int64>((time - time_source()->Now()) * 1000000), 0);
+  if (time_source_ && delay_us > 0) {
+    // Only the wall clock tells how long to wait.
+    delay_us = kTimeSourcePollDelayUs;
+  }
+  task_runner_->PostDelayedTask(FROM_HERE, TimeDelta::FromMicroseconds(delay_us),
+                                std::bind(&NullVideoRendererSink::RenderTask, this));
+}
+
+void NullVideoRendererSink::Present(const std::shared_ptr<VideoFrame> &frame) {
+  last_frame_ = frame;
+  PresentedFrame presented{};
+  presented.pts = frame->pts();
+  presented.presented_at = static_cast<int64>((time_source()->Now() - start_time_) * 1000000);
+  presented.checksum = compute_checksums_ ? ComputeChecksum(frame->frame()) : 0;
+  presented_frames_.push_back(presented);
+  if (output_) {
+    fprintf(output_, "%.6f %lld %08x\n", presented.pts,
+            static_cast<long long>(presented.presented_at), presented.checksum);
+  }
+}
+
+} // namespace media
@@ -0,0 +1,123 @@
+//
+// Created by yangbin on 2021/7/30.
+//
+
+#ifndef MEDIA_PLAYER_SRC_NULL_VIDEO_RENDERER_SINK_H_
+#define MEDIA_PLAYER_SRC_NULL_VIDEO_RENDERER_SINK_H_
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/task_runner.h"
+
+#include "time_source.h"
+#include "video_renderer_sink.h"
+
+namespace media {
+
+/**
+ * A sink which shows nothing, for playback without a display in tests and
+ * benchmarks. It pulls frames from the renderer as a real sink does and
+ * records each new frame: its pts, when it was presented and optionally a
+ * checksum of its pixels, so that a run can be compared with another one.
+ *
+ * The sink runs on |time_source|, the wall clock if it is null. With a
+ * ManualTimeSource the renderer is only called once the source reached the
+ * time it asked for, the source is checked every millisecond meanwhile.
+ */
+class NullVideoRendererSink : public VideoRendererSink {
+
+ public:
+
+  struct PresentedFrame {
+    double pts;
+    // Microseconds of the time source since |Start|.
+    int64 presented_at;
+    // Adler-32 of the visible pixels, 0 when checksums are off or the frame
+    // is in GPU memory.
+    uint32 checksum;
+  };
+
+  explicit NullVideoRendererSink(std::shared_ptr<TimeSource> time_source = nullptr);
+
+  ~NullVideoRendererSink() override;
+
+  void Start(RenderCallback *callback) override;
+
+  void Stop() override;
+
+  /**
+   * Checksum every presented frame, off by default.
+   */
+  void set_compute_checksums(bool compute_checksums);
+
+  /**
+   * Also write every presented frame to |path|, a line of "pts presented_at
+   * checksum" each. Must be called before |Start|.
+   *
+   * @return false if |path| can not be opened.
+   */
+  bool SetOutputPath(const std::string &path);
+
+  std::vector<PresentedFrame> presented_frames();
+
+  /**
+   * Time of the time source the renderer is called at next. Once it is after
+   * the current time, every frame due was presented.
+   */
+  double next_render_time() const {
+    return next_render_time_.load();
+  }
+
+  static uint32 ComputeChecksum(const AVFrame *frame);
+
+ private:
+
+  std::shared_ptr<TimeSource> time_source_;
+
+  std::unique_ptr<TaskRunner> task_runner_;
+
+  enum State { kIdle, kRunning };
+  State state_ = kIdle;
+
+  RenderCallback *render_callback_ = nullptr;
+
+  // Guards all below and the fields above.
+  std::mutex render_mutex_;
+
+  bool compute_checksums_ = false;
+
+  FILE *output_ = nullptr;
+
+  double start_time_ = 0;
+
+  std::atomic<double> next_render_time_{0};
+
+  // The last presented frame, a renderer returns the same frame until the
+  // next one is due.
+  std::shared_ptr<VideoFrame> last_frame_;
+
+  std::vector<PresentedFrame> presented_frames_;
+
+  TimeSource *time_source() const {
+    return time_source_ ? time_source_.get() : TimeSource::WallClock();
+  }
+
+  void RenderTask();
+
+  // Run |RenderTask| once |time_source_| reaches |time|.
+  void ScheduleRenderTask(double time);
+
+  void Present(const std::shared_ptr<VideoFrame> &frame);
+
+  DELETE_COPY_AND_ASSIGN(NullVideoRendererSink);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_NULL_VIDEO_RENDERER_SINK_H_
@@ -0,0 +1,140 @@
+//
+// Created by yangbin on 2021/8/4.
+//
+
+#include "picture_buffer_pool.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+extern "C" {
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+}
+
+namespace media {
+
+PictureBufferPool::PictureBufferPool() : allocated_planes_(0) {}
+
+PictureBufferPool::~PictureBufferPool() {
+  ReleasePools();
+}
+
+void PictureBufferPool::ReleasePools() {
+  for (auto &pool : pools_) {
+    // Buffers still referenced by frames are freed when they are released.
+    av_buffer_pool_uninit(&pool);
+  }
+  plane_count_ = 0;
+  format_ = AV_PIX_FMT_NONE;
+}
+
+// static
+AVBufferRef *PictureBufferPool::AllocatePlane(void *opaque, int size) {
+  auto *pool = static_cast<PictureBufferPool *>(opaque);
+  // av_malloc only aligns to what the SIMD of FFmpeg needs.
+  auto *memory = static_cast<uint8_t *>(av_malloc(size + kAlignment - 1));
+  if (!memory) {
+    return nullptr;
+  }
+  auto address = (reinterpret_cast<uintptr_t>(memory) + kAlignment - 1) & ~uintptr_t(kAlignment - 1);
+  auto *buffer = av_buffer_create(reinterpret_cast<uint8_t *>(address), size,
+                                  [](void *memory, uint8_t *) { av_free(memory); }, memory, 0);
+  if (!buffer) {
+    av_free(memory);
+    return nullptr;
+  }
+  pool->allocated_planes_.fetch_add(1, std::memory_order_relaxed);
+  return buffer;
+}
+
+int PictureBufferPool::UpdatePools(AVCodecContext *context, const AVFrame *frame) {
+  auto format = static_cast<AVPixelFormat>(frame->format);
+  if (plane_count_ > 0 && format == format_ && frame->width == width_ && frame->height == height_) {
+    return 0;
+  }
+  ReleasePools();
+
+  int width = frame->width;
+  int height = frame->height;
+  int linesize_align[AV_NUM_DATA_POINTERS];
+  avcodec_align_dimensions2(context, &width, &height, linesize_align);
+
+  // Widen the picture until every line size is aligned, as
+  // avcodec_default_get_buffer2 does.
+  int linesizes[4];
+  bool unaligned;
+  do {
+    auto ret = av_image_fill_linesizes(linesizes, format, width);
+    if (ret < 0) {
+      return ret;
+    }
+    width += width & ~(width - 1);
+    unaligned = false;
+    for (int i = 0; i < 4; ++i) {
+      unaligned |= linesizes[i] % kAlignment != 0 || linesizes[i] % std::max(linesize_align[i], 1) != 0;
+    }
+  } while (unaligned);
+
+  // Offsets of the planes in a picture starting at null.
+  uint8_t *data[4];
+  auto total_size = av_image_fill_pointers(data, format, height, nullptr, linesizes);
+  if (total_size < 0) {
+    return total_size;
+  }
+  int sizes[4] = {};
+  int plane = 0;
+  for (; plane < 3 && data[plane + 1]; ++plane) {
+    sizes[plane] = static_cast<int>(data[plane + 1] - data[plane]);
+  }
+  sizes[plane] = total_size - static_cast<int>(data[plane] - data[0]);
+
+  for (int i = 0; i <= plane; ++i) {
+    // Codecs may read up to 16 bytes past the end of the last line.
+    pools_[i] = av_buffer_pool_init2(sizes[i] + 16, this, &PictureBufferPool::AllocatePlane, nullptr);
+    if (!pools_[i]) {
+      ReleasePools();
+      return AVERROR(ENOMEM);
+    }
+    linesizes_[i] = linesizes[i];
+  }
+  plane_count_ = plane + 1;
+  format_ = format;
+  width_ = frame->width;
+  height_ = frame->height;
+  DLOG(INFO) << "picture buffer pool for " << av_get_pix_fmt_name(format) << " "
+             << width_ << "x" << height_ << ", planes: " << plane_count_;
+  return 0;
+}
+
+int PictureBufferPool::GetBuffer(AVCodecContext *context, AVFrame *frame, int flags) {
+  auto *descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+  if (!descriptor || (descriptor->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM))
+      || context->hw_frames_ctx || frame->width <= 0 || frame->height <= 0) {
+    return avcodec_default_get_buffer2(context, frame, flags);
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  auto ret = UpdatePools(context, frame);
+  if (ret < 0) {
+    return ret;
+  }
+  for (int i = 0; i < plane_count_; ++i) {
+    frame->buf[i] = av_buffer_pool_get(pools_[i]);
+    if (!frame->buf[i]) {
+      av_frame_unref(frame);
+      return AVERROR(ENOMEM);
+    }
+    frame->data[i] = frame->buf[i]->data;
+    frame->linesize[i] = linesizes_[i];
+  }
+  for (int i = plane_count_; i < AV_NUM_DATA_POINTERS; ++i) {
+    frame->data[i] = nullptr;
+    frame->linesize[i] = 0;
+  }
+  frame->extended_data = frame->data;
+  return 0;
+}
+
+}
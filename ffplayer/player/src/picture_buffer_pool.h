@@ -0,0 +1,80 @@
+//
+// Created by yangbin on 2021/8/4.
+//
+
+#ifndef MEDIA_PLAYER_SRC_PICTURE_BUFFER_POOL_H_
+#define MEDIA_PLAYER_SRC_PICTURE_BUFFER_POOL_H_
+
+#include <atomic>
+#include <mutex>
+
+#include "base/basictypes.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+}
+
+namespace media {
+
+/**
+ * Picture buffers for AVCodecContext::get_buffer2, recycled once the decoder
+ * and every AVFrame which referenced them let go.
+ *
+ * Planes are allocated with av_malloc, aligned to kAlignment bytes and with
+ * every line size a multiple of it, so the SIMD converters can read whole
+ * vectors. Buffers of the previous geometry are freed when they are released
+ * after a resolution or format change.
+ */
+class PictureBufferPool {
+
+ public:
+
+  static const int kAlignment = 64;
+
+  PictureBufferPool();
+
+  ~PictureBufferPool();
+
+  /**
+   * AVCodecContext::get_buffer2, for a codec with AV_CODEC_CAP_DR1. Falls back
+   * to avcodec_default_get_buffer2 for hardware, palette and bitstream formats.
+   *
+   * Safe to call from the frame threads of the codec.
+   */
+  int GetBuffer(AVCodecContext *context, AVFrame *frame, int flags);
+
+  /**
+   * Count of planes allocated so far, for tests and benchmarks.
+   */
+  int64 allocated_planes() const {
+    return allocated_planes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+
+  std::mutex lock_;
+
+  AVPixelFormat format_ = AV_PIX_FMT_NONE;
+  int width_ = 0;
+  int height_ = 0;
+
+  int linesizes_[4] = {};
+  int plane_count_ = 0;
+  AVBufferPool *pools_[4] = {};
+
+  std::atomic<int64> allocated_planes_;
+
+  // Size the pools for |frame| in |context|, if its geometry changed.
+  int UpdatePools(AVCodecContext *context, const AVFrame *frame);
+
+  void ReleasePools();
+
+  static AVBufferRef *AllocatePlane(void *opaque, int size);
+
+  DELETE_COPY_AND_ASSIGN(PictureBufferPool);
+
+};
+
+}
+
+#endif //MEDIA_PLAYER_SRC_PICTURE_BUFFER_POOL_H_
@@ -0,0 +1,78 @@
+//
+// Created by yangbin on 2021/7/25.
+//
+
+#include "seek_coalescer.h"
+
+namespace media {
+
+std::ostream &operator<<(std::ostream &os, SeekMode mode) {
+  switch (mode) {
+    case SeekMode::kFast:return os << "fast";
+    case SeekMode::kAccurate:return os << "accurate";
+    case SeekMode::kPreviousSync:return os << "previous_sync";
+  }
+  return os << "unknown(" << static_cast<int>(mode) << ")";
+}
+
+void SeekCoalescer::Push(TimeDelta position, SeekMode mode, SeekCallback callback) {
+  SeekCallback superseded;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (has_pending_) {
+      superseded = std::move(pending_.callback);
+      superseded_count_++;
+    }
+    pending_.position = position;
+    pending_.mode = mode;
+    pending_.callback = std::move(callback);
+    has_pending_ = true;
+  }
+  if (superseded) {
+    superseded(false);
+  }
+}
+
+bool SeekCoalescer::Take(Request *request) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!has_pending_) {
+    return false;
+  }
+  *request = std::move(pending_);
+  pending_ = Request();
+  has_pending_ = false;
+  return true;
+}
+
+void SeekCoalescer::Cancel() {
+  SeekCallback cancelled;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!has_pending_) {
+      return;
+    }
+    cancelled = std::move(pending_.callback);
+    pending_ = Request();
+    has_pending_ = false;
+  }
+  if (cancelled) {
+    cancelled(false);
+  }
+}
+
+bool SeekCoalescer::has_pending() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return has_pending_;
+}
+
+TimeDelta SeekCoalescer::pending_position() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return has_pending_ ? pending_.position : TimeDelta::FromMicroseconds(-1);
+}
+
+int64 SeekCoalescer::superseded_count() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return superseded_count_;
+}
+
+} // namespace media
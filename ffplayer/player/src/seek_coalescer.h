@@ -0,0 +1,99 @@
+//
+// Created by yangbin on 2021/7/25.
+//
+
+#ifndef MEDIA_PLAYER_SRC_SEEK_COALESCER_H_
+#define MEDIA_PLAYER_SRC_SEEK_COALESCER_H_
+
+#include <functional>
+#include <mutex>
+#include <ostream>
+
+#include "base/basictypes.h"
+#include "base/time_delta.h"
+
+namespace media {
+
+/**
+ * Where playback starts after a seek.
+ */
+enum class SeekMode {
+  // The keyframe nearest to the target, before or after it.
+  kFast = 0,
+  // Exactly the target. Decoding starts at the previous keyframe, frames
+  // before the target are decoded but not rendered.
+  kAccurate = 1,
+  // The last keyframe at or before the target.
+  kPreviousSync = 2,
+};
+
+std::ostream &operator<<(std::ostream &os, SeekMode mode);
+
+/**
+ * Holds the latest seek request which has not been executed yet.
+ *
+ * A scrubber issues dozens of seeks per second. Each request replaces the
+ * pending one, whose callback is run with false right away, so however many
+ * are issued while a seek runs, only the latest one runs after it. A seek
+ * which already started is completed, it is the preview shown during a drag.
+ *
+ * Thread safe, callbacks are run without the lock held.
+ */
+class SeekCoalescer {
+
+ public:
+
+  using SeekCallback = std::function<void(bool)>;
+
+  struct Request {
+    TimeDelta position;
+    SeekMode mode = SeekMode::kAccurate;
+    SeekCallback callback;
+  };
+
+  SeekCoalescer() = default;
+
+  /**
+   * Replace the pending request, if any, with a new one.
+   */
+  void Push(TimeDelta position, SeekMode mode, SeekCallback callback);
+
+  /**
+   * Take the pending request out.
+   * @return false if there is none.
+   */
+  bool Take(Request *request);
+
+  /**
+   * Drop the pending request, its callback is run with false.
+   */
+  void Cancel();
+
+  bool has_pending() const;
+
+  /**
+   * Position of the pending request, negative if there is none.
+   */
+  TimeDelta pending_position() const;
+
+  /**
+   * Count of requests replaced before they were executed.
+   */
+  int64 superseded_count() const;
+
+ private:
+
+  mutable std::mutex lock_;
+
+  bool has_pending_ = false;
+  Request pending_;
+
+  int64 superseded_count_ = 0;
+
+  DELETE_COPY_AND_ASSIGN(SeekCoalescer);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_SEEK_COALESCER_H_
@@ -0,0 +1,237 @@
+//
+// Created by yangbin on 2021/7/27.
+//
+
+#include "texture_uploader.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+extern "C" {
+#include "libavutil/hwcontext.h"
+#include "libavutil/hwcontext_drm.h"
+#include "libavutil/imgutils.h"
+}
+
+namespace media {
+
+// static
+AVPixelFormat TextureUploader::GetPixelFormat(ExternalMediaTexture::PixelFormat format) {
+  switch (format) {
+    case ExternalMediaTexture::kFormat_32_ARGB: return AV_PIX_FMT_ARGB;
+    case ExternalMediaTexture::kFormat_32_BGRA: return AV_PIX_FMT_BGRA;
+    case ExternalMediaTexture::kFormat_32_RGBA: return AV_PIX_FMT_RGBA;
+    case ExternalMediaTexture::kFormat_I420: return AV_PIX_FMT_YUV420P;
+    case ExternalMediaTexture::kFormat_NV12: return AV_PIX_FMT_NV12;
+    case ExternalMediaTexture::kFormat_P010: return AV_PIX_FMT_P010LE;
+  }
+  NOTREACHED();
+  return AV_PIX_FMT_BGRA;
+}
+
+// static
+bool TextureUploader::GetPlanarFormat(AVPixelFormat format, ExternalMediaTexture::PixelFormat *planar_format) {
+  switch (format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P: {
+      *planar_format = ExternalMediaTexture::kFormat_I420;
+      return true;
+    }
+    case AV_PIX_FMT_NV12: {
+      *planar_format = ExternalMediaTexture::kFormat_NV12;
+      return true;
+    }
+    case AV_PIX_FMT_P010LE: {
+      *planar_format = ExternalMediaTexture::kFormat_P010;
+      return true;
+    }
+    default:return false;
+  }
+}
+
+// static
+void TextureUploader::GetUploadSize(int width, int height, int display_width, int display_height,
+                                    int *upload_width, int *upload_height) {
+  *upload_width = width;
+  *upload_height = height;
+  if (display_width <= 0 || display_height <= 0 || (width <= display_width && height <= display_height)) {
+    return;
+  }
+  // Fit in the display, never scale up.
+  double scale = std::min(double(display_width) / width, double(display_height) / height);
+  *upload_width = std::max(2, int(width * scale) & ~1);
+  *upload_height = std::max(2, int(height * scale) & ~1);
+}
+
+TextureUploader::TextureUploader() = default;
+
+TextureUploader::~TextureUploader() = default;
+
+void TextureUploader::Upload(ExternalMediaTexture *texture, const std::shared_ptr<VideoFrame> &frame) {
+  DCHECK(texture);
+  if (frame->IsEmpty()) {
+    return;
+  }
+
+  auto *av_frame = frame->frame();
+  if (av_frame->hw_frames_ctx != nullptr) {
+    if (UploadHardwareFrame(texture, av_frame)) {
+      return;
+    }
+    // The texture can not take the surface, copy it to memory.
+    if (!software_frame_) {
+      software_frame_.reset(av_frame_alloc());
+    }
+    av_frame_unref(software_frame_.get());
+    auto ret = av_hwframe_transfer_data(software_frame_.get(), av_frame, 0);
+    if (ret < 0) {
+      DLOG(ERROR) << "failed to read back hardware frame: " << ret;
+      return;
+    }
+    av_frame = software_frame_.get();
+  }
+
+  if (!UploadPlanes(texture, av_frame)) {
+    ConvertToRGB(texture, av_frame);
+  }
+}
+
+bool TextureUploader::UploadPlanes(ExternalMediaTexture *texture, AVFrame *frame) {
+  ExternalMediaTexture::PixelFormat format;
+  if (!GetPlanarFormat(AVPixelFormat(frame->format), &format) || !texture->SupportsPixelFormat(format)) {
+    return false;
+  }
+
+  ExternalMediaTexture::Planes planes{};
+  planes.format = format;
+  planes.width = frame->width;
+  planes.height = frame->height;
+  planes.num_planes = format == ExternalMediaTexture::kFormat_I420 ? 3 : 2;
+
+  if (texture->SupportsPlaneReference()) {
+    for (int i = 0; i < planes.num_planes; ++i) {
+      planes.data[i] = frame->data[i];
+      planes.stride[i] = frame->linesize[i];
+    }
+    // A new reference, |frame| may be the reused readback frame.
+    std::shared_ptr<AVFrame> holder(av_frame_clone(frame), [](AVFrame *f) { av_frame_free(&f); });
+    if (!holder) {
+      return false;
+    }
+    texture->RenderWithPlanes(planes, std::move(holder));
+    return true;
+  }
+
+  int width, height;
+  GetUploadSize(frame->width, frame->height, display_width_, display_height_, &width, &height);
+  texture->MaybeInitPlanes(width, height, format);
+  if (!texture->TryLockBuffer()) {
+    DLOG(WARNING) << "failed to lock buffer, skip render this frame.";
+    return true;
+  }
+  if (!texture->GetPlanes(&planes) || planes.format != format || planes.width != width || planes.height != height) {
+    DLOG(ERROR) << "texture planes do not match the frame";
+    texture->UnlockBuffer();
+    return false;
+  }
+  if (width != frame->width || height != frame->height) {
+    uint8_t *dest[4] = {planes.data[0], planes.data[1], planes.data[2], nullptr};
+    int dest_stride[4] = {planes.stride[0], planes.stride[1], planes.stride[2], 0};
+    auto ret = converter_.Convert(frame, GetPixelFormat(format), width, height, dest, dest_stride);
+    DLOG_IF(ERROR, ret < 0) << "failed to scale frame: " << ret;
+    texture->UnlockBuffer();
+    texture->NotifyBufferUpdate();
+    return true;
+  }
+  const uint8_t *src_data[4] = {frame->data[0], frame->data[1], frame->data[2], nullptr};
+  int src_linesize[4] = {frame->linesize[0], frame->linesize[1], frame->linesize[2], 0};
+  uint8_t *dst_data[4] = {planes.data[0], planes.data[1], planes.data[2], nullptr};
+  int dst_linesize[4] = {planes.stride[0], planes.stride[1], planes.stride[2], 0};
+  av_image_copy(dst_data, dst_linesize, src_data, src_linesize,
+                AVPixelFormat(frame->format), frame->width, frame->height);
+  texture->UnlockBuffer();
+  texture->NotifyBufferUpdate();
+  return true;
+}
+
+void TextureUploader::ConvertToRGB(ExternalMediaTexture *texture, AVFrame *frame) {
+  int width, height;
+  GetUploadSize(frame->width, frame->height, display_width_, display_height_, &width, &height);
+  texture->MaybeInitPixelBuffer(width, height);
+
+  if (!texture->TryLockBuffer()) {
+    DLOG(WARNING) << "failed to lock buffer, skip render this frame.";
+    return;
+  }
+
+  auto *output = texture->GetBuffer();
+  DCHECK(output);
+
+  int linesize[4] = {4 * texture->GetWidth()};
+  uint8_t *bgr_buffer[4] = {static_cast<uint8_t *>(output)};
+  auto ret = converter_.Convert(frame, GetPixelFormat(texture->GetSupportFormat()),
+                                texture->GetWidth(), texture->GetHeight(), bgr_buffer, linesize);
+  DLOG_IF(ERROR, ret < 0) << "failed to convert frame: " << ret;
+
+  texture->UnlockBuffer();
+  texture->NotifyBufferUpdate();
+}
+
+// static
+bool TextureUploader::UploadHardwareFrame(ExternalMediaTexture *texture, AVFrame *frame) {
+  switch (frame->format) {
+    case AV_PIX_FMT_VIDEOTOOLBOX: {
+      if (!texture->SupportsHWSurface(ExternalMediaTexture::kHWSurface_CVPixelBuffer)) {
+        return false;
+      }
+      texture->RenderWithHWAccel(frame->data[3]);
+      return true;
+    }
+    case AV_PIX_FMT_DRM_PRIME: {
+      if (!texture->SupportsHWSurface(ExternalMediaTexture::kHWSurface_DmaBuf)) {
+        return false;
+      }
+      return UploadDrmPrimeFrame(texture, frame);
+    }
+    default: {
+      if (!texture->SupportsHWSurface(ExternalMediaTexture::kHWSurface_DmaBuf)) {
+        return false;
+      }
+      // e.g. VAAPI surfaces, exported as DMA-BUF without a copy.
+      std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> mapped(av_frame_alloc());
+      mapped->format = AV_PIX_FMT_DRM_PRIME;
+      if (av_hwframe_map(mapped.get(), frame, AV_HWFRAME_MAP_READ) < 0) {
+        return false;
+      }
+      return UploadDrmPrimeFrame(texture, mapped.get());
+    }
+  }
+}
+
+// static
+bool TextureUploader::UploadDrmPrimeFrame(ExternalMediaTexture *texture, const AVFrame *frame) {
+  auto *descriptor = reinterpret_cast<const AVDRMFrameDescriptor *>(frame->data[0]);
+  if (!descriptor || descriptor->nb_layers != 1) {
+    // Multi-layer frames would need a texture per layer.
+    return false;
+  }
+  const auto &layer = descriptor->layers[0];
+  ExternalMediaTexture::DmaBufFrame dma_buf{};
+  dma_buf.width = frame->width;
+  dma_buf.height = frame->height;
+  dma_buf.drm_format = layer.format;
+  dma_buf.num_planes = std::min(layer.nb_planes, 4);
+  for (int i = 0; i < dma_buf.num_planes; ++i) {
+    const auto &plane = layer.planes[i];
+    const auto &object = descriptor->objects[plane.object_index];
+    dma_buf.planes[i].fd = object.fd;
+    dma_buf.planes[i].offset = static_cast<uint32_t>(plane.offset);
+    dma_buf.planes[i].pitch = static_cast<uint32_t>(plane.pitch);
+    dma_buf.planes[i].modifier = object.format_modifier;
+  }
+  texture->RenderWithDmaBuf(dma_buf);
+  return true;
+}
+
+} // namespace media
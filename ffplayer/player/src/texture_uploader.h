@@ -0,0 +1,90 @@
+//
+// Created by yangbin on 2021/7/27.
+//
+
+#ifndef MEDIA_PLAYER_SRC_TEXTURE_UPLOADER_H_
+#define MEDIA_PLAYER_SRC_TEXTURE_UPLOADER_H_
+
+#include <memory>
+
+#include "base/basictypes.h"
+
+#include "external_media_texture.h"
+#include "ffmpeg_deleters.h"
+#include "frame_converter.h"
+#include "video_frame.h"
+
+namespace media {
+
+/**
+ * Puts decoded frames into an ExternalMediaTexture, in the cheapest way the
+ * texture supports:
+ *
+ * 1. hardware surfaces, passed through.
+ * 2. I420/NV12/P010 frames, by reference or by a plane copy.
+ * 3. everything else, converted to the RGB format of the texture.
+ *
+ * Not thread safe, used on the render thread.
+ */
+class TextureUploader {
+
+ public:
+
+  static AVPixelFormat GetPixelFormat(ExternalMediaTexture::PixelFormat format);
+
+  /**
+   * @return false if frames of |format| can not be uploaded as planes.
+   */
+  static bool GetPlanarFormat(AVPixelFormat format, ExternalMediaTexture::PixelFormat *planar_format);
+
+  TextureUploader();
+
+  ~TextureUploader();
+
+  void Upload(ExternalMediaTexture *texture, const std::shared_ptr<VideoFrame> &frame);
+
+  /**
+   * Frames which are copied or converted are scaled down to fit in
+   * |width| x |height|, keeping their aspect ratio. 0 to keep the frame size.
+   */
+  void SetDisplaySize(int width, int height) {
+    display_width_ = width;
+    display_height_ = height;
+  }
+
+  /**
+   * The size |width| x |height| is uploaded at for the display size, even for
+   * the chroma planes.
+   */
+  static void GetUploadSize(int width, int height, int display_width, int display_height,
+                            int *upload_width, int *upload_height);
+
+ private:
+
+  FrameConverter converter_;
+
+  int display_width_ = 0;
+  int display_height_ = 0;
+
+  // Hardware frames which can not be passed through are read back into it.
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> software_frame_;
+
+  // Hand a hardware |frame| to |texture| without a readback.
+  // @return false if the texture can not take it.
+  static bool UploadHardwareFrame(ExternalMediaTexture *texture, AVFrame *frame);
+
+  static bool UploadDrmPrimeFrame(ExternalMediaTexture *texture, const AVFrame *frame);
+
+  // @return false if |frame| or |texture| has no matching planar format, then
+  // it is converted to RGB instead.
+  bool UploadPlanes(ExternalMediaTexture *texture, AVFrame *frame);
+
+  void ConvertToRGB(ExternalMediaTexture *texture, AVFrame *frame);
+
+  DELETE_COPY_AND_ASSIGN(TextureUploader);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_TEXTURE_UPLOADER_H_
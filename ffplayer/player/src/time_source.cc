@@ -0,0 +1,37 @@
+//
+// Created by yangbin on 2021/7/31.
+//
+
+#include "time_source.h"
+
+#include "base/logging.h"
+
+extern "C" {
+#include "libavutil/time.h"
+}
+
+namespace media {
+
+// static
+TimeSource *TimeSource::WallClock() {
+  static WallClockTimeSource wall_clock;
+  return &wall_clock;
+}
+
+double WallClockTimeSource::Now() {
+  return double(av_gettime_relative()) / 1000000.0;
+}
+
+void ManualTimeSource::Advance(TimeDelta delta) {
+  DCHECK_GE(delta, TimeDelta());
+  auto now = now_.load();
+  while (!now_.compare_exchange_weak(now, now + delta.InSecondsF())) {
+  }
+}
+
+void ManualTimeSource::SetNow(double now) {
+  DCHECK_GE(now, now_.load());
+  now_.store(now);
+}
+
+} // namespace media
@@ -0,0 +1,101 @@
+//
+// Created by yangbin on 2021/7/31.
+//
+
+#ifndef MEDIA_PLAYER_SRC_TIME_SOURCE_H_
+#define MEDIA_PLAYER_SRC_TIME_SOURCE_H_
+
+#include <atomic>
+
+#include "base/basictypes.h"
+#include "base/time_delta.h"
+
+namespace media {
+
+/**
+ * Where the clocks of MediaClock take the current time from.
+ */
+class TimeSource {
+
+ public:
+
+  virtual ~TimeSource() = default;
+
+  /**
+   * Current time in seconds, never decreases. Called from any thread.
+   */
+  virtual double Now() = 0;
+
+  /**
+   * Time does not pass by itself: renderers present every frame in order as
+   * soon as it is decoded, nothing is dropped for being late, and the clocks
+   * only move with the pts of what was rendered.
+   */
+  virtual bool IsFreeRunning() const {
+    return false;
+  }
+
+  /**
+   * The shared wall clock, av_gettime_relative.
+   */
+  static TimeSource *WallClock();
+
+};
+
+class WallClockTimeSource : public TimeSource {
+
+ public:
+
+  double Now() override;
+
+};
+
+/**
+ * Time only passes when it is stepped, for tests.
+ */
+class ManualTimeSource : public TimeSource {
+
+ public:
+
+  explicit ManualTimeSource(double now = 0) : now_(now) {}
+
+  double Now() override {
+    return now_.load();
+  }
+
+  void Advance(TimeDelta delta);
+
+  /**
+   * Must not be before the current time.
+   */
+  void SetNow(double now);
+
+ private:
+
+  std::atomic<double> now_;
+
+};
+
+/**
+ * Process as fast as the pipeline can go, for thumbnailing, analysis and
+ * tests. See [IsFreeRunning].
+ */
+class FreeRunningTimeSource : public TimeSource {
+
+ public:
+
+  // The clocks are set at time 0 and read at time 0, so they read the last
+  // pts they were set to.
+  double Now() override {
+    return 0;
+  }
+
+  bool IsFreeRunning() const override {
+    return true;
+  }
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_TIME_SOURCE_H_
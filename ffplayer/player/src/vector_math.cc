@@ -0,0 +1,227 @@
+//
+// Created by yangbin on 2021/7/19.
+//
+
+#include "vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define MEDIA_VECTOR_MATH_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// Compiled with the target attribute and picked at runtime, the rest of the
+// code keeps running on cpus without AVX2.
+#define MEDIA_VECTOR_MATH_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MEDIA_VECTOR_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace media {
+namespace vector_math {
+
+namespace {
+
+const float kMaxS16 = 32767.0f;
+const float kMinS16 = -32768.0f;
+
+// The gain of sample i is |gain| + |step| * i, a constant gain has step 0.
+
+void ScaleS16_C(const int16 *src, float gain, float step, int count, int16 *dest) {
+  for (int i = 0; i < count; ++i) {
+    float value = float(src[i]) * (gain + step * float(i));
+    value = std::min(std::max(value, kMinS16), kMaxS16);
+    dest[i] = static_cast<int16>(lrintf(value));
+  }
+}
+
+void ScaleFloat_C(const float *src, float gain, float step, int count, float *dest) {
+  for (int i = 0; i < count; ++i) {
+    dest[i] = src[i] * (gain + step * float(i));
+  }
+}
+
+#if defined(MEDIA_VECTOR_MATH_SSE2)
+
+void ScaleS16_SSE2(const int16 *src, float gain, float step, int count, int16 *dest) {
+  const __m128 steps = _mm_set_ps(3 * step, 2 * step, step, 0);
+  const __m128 max = _mm_set1_ps(kMaxS16);
+  const __m128 min = _mm_set1_ps(kMinS16);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128 gain_lo = _mm_add_ps(_mm_set1_ps(gain + step * float(i)), steps);
+    __m128 gain_hi = _mm_add_ps(_mm_set1_ps(gain + step * float(i + 4)), steps);
+    __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    // Sign extend to int32 by placing each sample in the high half.
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+    __m128 scaled_lo = _mm_mul_ps(_mm_cvtepi32_ps(lo), gain_lo);
+    __m128 scaled_hi = _mm_mul_ps(_mm_cvtepi32_ps(hi), gain_hi);
+    scaled_lo = _mm_min_ps(_mm_max_ps(scaled_lo, min), max);
+    scaled_hi = _mm_min_ps(_mm_max_ps(scaled_hi, min), max);
+    __m128i result = _mm_packs_epi32(_mm_cvtps_epi32(scaled_lo), _mm_cvtps_epi32(scaled_hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), result);
+  }
+  ScaleS16_C(src + i, gain + step * float(i), step, count - i, dest + i);
+}
+
+void ScaleFloat_SSE2(const float *src, float gain, float step, int count, float *dest) {
+  const __m128 steps = _mm_set_ps(3 * step, 2 * step, step, 0);
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 gains = _mm_add_ps(_mm_set1_ps(gain + step * float(i)), steps);
+    _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), gains));
+  }
+  ScaleFloat_C(src + i, gain + step * float(i), step, count - i, dest + i);
+}
+
+#endif // MEDIA_VECTOR_MATH_SSE2
+
+#if defined(MEDIA_VECTOR_MATH_AVX2)
+
+bool HasAVX2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+__attribute__((target("avx2")))
+void ScaleS16_AVX2(const int16 *src, float gain, float step, int count, int16 *dest) {
+  const __m256 steps = _mm256_set_ps(7 * step, 6 * step, 5 * step, 4 * step, 3 * step, 2 * step, step, 0);
+  const __m256 max = _mm256_set1_ps(kMaxS16);
+  const __m256 min = _mm256_set1_ps(kMinS16);
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256 gain_lo = _mm256_add_ps(_mm256_set1_ps(gain + step * float(i)), steps);
+    __m256 gain_hi = _mm256_add_ps(_mm256_set1_ps(gain + step * float(i + 8)), steps);
+    __m128i samples_lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i samples_hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8));
+    __m256 scaled_lo = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(samples_lo)), gain_lo);
+    __m256 scaled_hi = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(samples_hi)), gain_hi);
+    scaled_lo = _mm256_min_ps(_mm256_max_ps(scaled_lo, min), max);
+    scaled_hi = _mm256_min_ps(_mm256_max_ps(scaled_hi, min), max);
+    // packs works per 128 bit lane, put the 64 bit blocks back in order.
+    __m256i result = _mm256_packs_epi32(_mm256_cvtps_epi32(scaled_lo), _mm256_cvtps_epi32(scaled_hi));
+    result = _mm256_permute4x64_epi64(result, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i), result);
+  }
+  ScaleS16_SSE2(src + i, gain + step * float(i), step, count - i, dest + i);
+}
+
+__attribute__((target("avx2")))
+void ScaleFloat_AVX2(const float *src, float gain, float step, int count, float *dest) {
+  const __m256 steps = _mm256_set_ps(7 * step, 6 * step, 5 * step, 4 * step, 3 * step, 2 * step, step, 0);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 gains = _mm256_add_ps(_mm256_set1_ps(gain + step * float(i)), steps);
+    _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), gains));
+  }
+  ScaleFloat_SSE2(src + i, gain + step * float(i), step, count - i, dest + i);
+}
+
+#endif // MEDIA_VECTOR_MATH_AVX2
+
+#if defined(MEDIA_VECTOR_MATH_NEON)
+
+void ScaleS16_NEON(const int16 *src, float gain, float step, int count, int16 *dest) {
+  const float step_values[4] = {0, step, 2 * step, 3 * step};
+  const float32x4_t steps = vld1q_f32(step_values);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    float32x4_t gain_lo = vaddq_f32(vdupq_n_f32(gain + step * float(i)), steps);
+    float32x4_t gain_hi = vaddq_f32(vdupq_n_f32(gain + step * float(i + 4)), steps);
+    int16x8_t samples = vld1q_s16(src + i);
+    float32x4_t scaled_lo = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), gain_lo);
+    float32x4_t scaled_hi = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), gain_hi);
+    // Round to nearest, then narrow with saturation.
+    int16x8_t result = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(scaled_lo)),
+                                    vqmovn_s32(vcvtnq_s32_f32(scaled_hi)));
+    vst1q_s16(dest + i, result);
+  }
+  ScaleS16_C(src + i, gain + step * float(i), step, count - i, dest + i);
+}
+
+void ScaleFloat_NEON(const float *src, float gain, float step, int count, float *dest) {
+  const float step_values[4] = {0, step, 2 * step, 3 * step};
+  const float32x4_t steps = vld1q_f32(step_values);
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t gains = vaddq_f32(vdupq_n_f32(gain + step * float(i)), steps);
+    vst1q_f32(dest + i, vmulq_f32(vld1q_f32(src + i), gains));
+  }
+  ScaleFloat_C(src + i, gain + step * float(i), step, count - i, dest + i);
+}
+
+#endif // MEDIA_VECTOR_MATH_NEON
+
+void ScaleS16Impl(const int16 *src, float gain, float step, int count, int16 *dest) {
+#if defined(MEDIA_VECTOR_MATH_AVX2)
+  if (HasAVX2()) {
+    ScaleS16_AVX2(src, gain, step, count, dest);
+    return;
+  }
+#endif
+#if defined(MEDIA_VECTOR_MATH_SSE2)
+  ScaleS16_SSE2(src, gain, step, count, dest);
+#elif defined(MEDIA_VECTOR_MATH_NEON)
+  ScaleS16_NEON(src, gain, step, count, dest);
+#else
+  ScaleS16_C(src, gain, step, count, dest);
+#endif
+}
+
+void ScaleFloatImpl(const float *src, float gain, float step, int count, float *dest) {
+#if defined(MEDIA_VECTOR_MATH_AVX2)
+  if (HasAVX2()) {
+    ScaleFloat_AVX2(src, gain, step, count, dest);
+    return;
+  }
+#endif
+#if defined(MEDIA_VECTOR_MATH_SSE2)
+  ScaleFloat_SSE2(src, gain, step, count, dest);
+#elif defined(MEDIA_VECTOR_MATH_NEON)
+  ScaleFloat_NEON(src, gain, step, count, dest);
+#else
+  ScaleFloat_C(src, gain, step, count, dest);
+#endif
+}
+
+} // namespace
+
+void ScaleS16(const int16 *src, float gain, int count, int16 *dest) {
+  ScaleS16Impl(src, gain, 0, count, dest);
+}
+
+void ScaleS16Ramp(const int16 *src, float start_gain, float end_gain, int count, int16 *dest) {
+  if (count <= 0) {
+    return;
+  }
+  ScaleS16Impl(src, start_gain, (end_gain - start_gain) / float(count), count, dest);
+}
+
+void ScaleFloat(const float *src, float gain, int count, float *dest) {
+  ScaleFloatImpl(src, gain, 0, count, dest);
+}
+
+void ScaleFloatRamp(const float *src, float start_gain, float end_gain, int count, float *dest) {
+  if (count <= 0) {
+    return;
+  }
+  ScaleFloatImpl(src, start_gain, (end_gain - start_gain) / float(count), count, dest);
+}
+
+float GainRamp::Advance(int count) {
+  float max_delta = step * float(count);
+  if (std::fabs(target - current) <= max_delta) {
+    current = target;
+  } else {
+    current += target > current ? max_delta : -max_delta;
+  }
+  return current;
+}
+
+} // namespace vector_math
+} // namespace media
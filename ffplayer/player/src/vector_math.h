@@ -0,0 +1,60 @@
+//
+// Created by yangbin on 2021/7/19.
+//
+
+#ifndef MEDIA_PLAYER_SRC_VECTOR_MATH_H_
+#define MEDIA_PLAYER_SRC_VECTOR_MATH_H_
+
+#include "base/basictypes.h"
+
+namespace media {
+namespace vector_math {
+
+/**
+ * dest[i] = saturate(src[i] * gain). |src| and |dest| may be the same buffer.
+ *
+ * Uses AVX2 when the cpu supports it, otherwise SSE2 or NEON, otherwise plain C.
+ */
+void ScaleS16(const int16 *src, float gain, int count, int16 *dest);
+
+/**
+ * Same as [ScaleS16], the gain goes linearly from |start_gain| at src[0]
+ * towards |end_gain| at src[count].
+ */
+void ScaleS16Ramp(const int16 *src, float start_gain, float end_gain, int count, int16 *dest);
+
+/**
+ * dest[i] = src[i] * gain. |src| and |dest| may be the same buffer.
+ */
+void ScaleFloat(const float *src, float gain, int count, float *dest);
+
+void ScaleFloatRamp(const float *src, float start_gain, float end_gain, int count, float *dest);
+
+/**
+ * A gain which moves to |target| by at most |step| per sample, so that volume
+ * changes do not click.
+ */
+struct GainRamp {
+
+  float current = 1;
+
+  float target = 1;
+
+  float step = 1;
+
+  bool IsRamping() const {
+    return current != target;
+  }
+
+  /**
+   * Move |current| towards |target| for |count| samples.
+   * @return the new |current|.
+   */
+  float Advance(int count);
+
+};
+
+} // namespace vector_math
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_VECTOR_MATH_H_
@@ -5,12 +5,27 @@
 #ifndef MEDIA_PLAYER_SRC_VIDEO_DECODE_CONFIG_H_
 #define MEDIA_PLAYER_SRC_VIDEO_DECODE_CONFIG_H_
 
+#include <vector>
+
 extern "C" {
 #include "libavformat/avformat.h"
+#include "libavutil/hwcontext.h"
 }
 
 namespace media {
 
+// How the software video decoder spreads work over threads.
+enum class VideoDecoderThreadType {
+  // Let FFmpeg use frame and slice threading, whichever the codec supports.
+  kAuto = 0,
+  // Decode several frames in parallel. Best throughput, adds |thread_count|
+  // frames of latency.
+  kFrame = 1,
+  // Decode the slices of one frame in parallel. No latency, depends on the
+  // stream being encoded with multiple slices.
+  kSlice = 2,
+};
+
 class VideoDecodeConfig {
 
  public:
@@ -50,7 +65,46 @@ class VideoDecodeConfig {
    * 1 -> 1/2  2-> 1/4
    */
   int low_res() const {
-    return 0;
+    return low_res_;
+  }
+
+  void set_low_res(int low_res) {
+    low_res_ = low_res;
+  }
+
+  /**
+   * Size the video is displayed at, 0 if unknown. Without an explicit
+   * [low_res], the decoder decodes at the lowest resolution which still covers
+   * it.
+   */
+  int display_width() const {
+    return display_width_;
+  }
+
+  int display_height() const {
+    return display_height_;
+  }
+
+  void set_display_size(int width, int height) {
+    display_width_ = width;
+    display_height_ = height;
+  }
+
+  /**
+   * @return the largest lowres up to |max_lowres| which decodes at least the
+   *         display size, 0 if the display size is unknown.
+   */
+  int LowResForDisplaySize(int max_lowres) const {
+    if (display_width_ <= 0 || display_height_ <= 0) {
+      return 0;
+    }
+    int low_res = 0;
+    while (low_res < max_lowres
+        && (codec_parameters_.width >> (low_res + 1)) >= display_width_
+        && (codec_parameters_.height >> (low_res + 1)) >= display_height_) {
+      low_res++;
+    }
+    return low_res;
   }
 
   bool fast() const {
@@ -61,6 +115,35 @@ class VideoDecodeConfig {
     return max_frame_duration_;
   }
 
+  VideoDecoderThreadType thread_type() const {
+    return thread_type_;
+  }
+
+  /**
+   * @return count of decoder threads. 0 keeps the single thread FFmpeg
+   * decodes with by default, a negative value means one per core.
+   */
+  int thread_count() const {
+    return thread_count_;
+  }
+
+  void set_threading(VideoDecoderThreadType thread_type, int thread_count) {
+    thread_type_ = thread_type;
+    thread_count_ = thread_count;
+  }
+
+  /**
+   * Hardware devices to try in order, software decoding if none of them can
+   * be used. Empty to always decode in software.
+   */
+  const std::vector<AVHWDeviceType> &hw_device_types() const {
+    return hw_device_types_;
+  }
+
+  void set_hw_device_types(std::vector<AVHWDeviceType> types) {
+    hw_device_types_ = std::move(types);
+  }
+
   bool IsValidConfig() const {
     return true;
   }
@@ -70,6 +153,12 @@ class VideoDecodeConfig {
   AVRational time_base_;
   AVRational frame_rate_;
   double max_frame_duration_;
+  VideoDecoderThreadType thread_type_ = VideoDecoderThreadType::kAuto;
+  int thread_count_ = 0;
+  std::vector<AVHWDeviceType> hw_device_types_;
+  int low_res_ = 0;
+  int display_width_ = 0;
+  int display_height_ = 0;
 
 };
 
@@ -4,84 +4,21 @@
 
 #include "video_decoder.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 
 #include "ffmpeg_utils.h"
+#include "hw_device.h"
 
 extern "C" {
 #include "libavutil/pixdesc.h"
 }
 
-namespace {
-
-#if 1
-enum AVPixelFormat lychee_avcodec_get_format(struct AVCodecContext *avctx,
-                                             const enum AVPixelFormat *fmt) {
-  const AVPixFmtDescriptor *desc;
-  const AVCodecHWConfig *config;
-  int i, n;
-
-  // If a device was supplied when the codec was opened, assume that the
-  // user wants to use it.
-  if (avctx->hw_device_ctx && avctx->codec->hw_configs) {
-    AVHWDeviceContext *device_ctx =
-        (AVHWDeviceContext *) avctx->hw_device_ctx->data;
-    for (i = 0;; i++) {
-      config = avcodec_get_hw_config(avctx->codec, i);
-      if (!config)
-        break;
-      if (!(config->methods &
-          AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX))
-        continue;
-      if (device_ctx->type != config->device_type)
-        continue;
-      for (n = 0; fmt[n] != AV_PIX_FMT_NONE; n++) {
-        if (config->pix_fmt == fmt[n])
-          return fmt[n];
-      }
-    }
-  }
-  // No device or other setup, so we have to choose from things which
-  // don't any other external information.
-
-  // If the last element of the list is a software format, choose it
-  // (this should be best software format if any exist).
-  for (n = 0; fmt[n] != AV_PIX_FMT_NONE; n++);
-  desc = av_pix_fmt_desc_get(fmt[n - 1]);
-  if (!(desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
-    return fmt[n - 1];
-
-  // Finally, traverse the list in order and choose the first entry
-  // with no external dependencies (if there is no hardware configuration
-  // information available then this just picks the first entry).
-  for (n = 0; fmt[n] != AV_PIX_FMT_NONE; n++) {
-    for (i = 0;; i++) {
-      config = avcodec_get_hw_config(avctx->codec, i);
-      if (!config)
-        break;
-      if (config->pix_fmt == fmt[n])
-        break;
-    }
-    if (!config) {
-      // No specific config available, so the decoder must be able
-      // to handle this format without any additional setup.
-      return fmt[n];
-    }
-    if (config->methods & AV_CODEC_HW_CONFIG_METHOD_INTERNAL) {
-      // Usable with only internal setup.
-      return fmt[n];
-    }
-  }
-
-  // Nothing is usable, give up.
-  return AV_PIX_FMT_NONE;
-}
-#endif
-}
-
 namespace media {
 
-VideoDecoder::VideoDecoder() : hw_device_context_(nullptr) {};
+VideoDecoder::VideoDecoder()
+    : picture_buffer_pool_(std::make_unique<PictureBufferPool>()), hw_device_context_(nullptr) {};
 
 VideoDecoder::~VideoDecoder() {
   if (hw_device_context_) {
@@ -96,25 +33,59 @@ int VideoDecoder::Initialize(VideoDecodeConfig config,
   DCHECK(!codec_context_);
   DCHECK(output_callback);
 
-  codec_context_ = std::unique_ptr<AVCodecContext, AVCodecContextDeleter>(avcodec_alloc_context3(nullptr));
   output_callback_ = std::move(output_callback);
 
-  auto ret = avcodec_parameters_to_context(codec_context_.get(), &config.codec_parameters());
-  DCHECK_GE(ret, 0);
-
-  codec_context_->codec_id = config.codec_id();
-  codec_context_->pkt_timebase = config.time_base();
-
   auto *codec = avcodec_find_decoder(config.codec_id());
   DCHECK(codec) << "no decoder could be found" << avcodec_get_name(config.codec_id());
 
   if (codec == nullptr) {
-    codec_context_.reset();
     return -1;
   }
 
+  if (!config.hw_device_types().empty()) {
+    hw_device_context_ = CreateHwDevice(codec, config.hw_device_types(), &hw_pixel_format_);
+  }
+
+  auto ret = OpenCodec(config, codec);
+  if (ret < 0 && hw_device_context_) {
+    DLOG(WARNING) << "can not open " << codec->name << " with hardware device, fall back to software. "
+                  << ffmpeg::AVErrorToString(ret);
+    av_buffer_unref(&hw_device_context_);
+    hw_pixel_format_ = AV_PIX_FMT_NONE;
+    ret = OpenCodec(config, codec);
+  }
+  DCHECK_GE(ret, 0) << "can not open avcodec, reason: " << ffmpeg::AVErrorToString(ret);
+  if (ret < 0) {
+    return ret;
+  }
+
+  DLOG(INFO) << "video decoder " << codec->name << " opened, thread_count: " << codec_context_->thread_count
+             << ", active_thread_type: " << codec_context_->active_thread_type
+             << ", hardware: " << (hw_device_context_ ? av_get_pix_fmt_name(hw_pixel_format_) : "none");
+
+  ffmpeg_decoding_loop_ = std::make_unique<FFmpegDecodingLoop>(codec_context_.get(), true);
+//  video_render->SetMaxFrameDuration(video_decode_config_.max_frame_duration());
+  video_decode_config_ = config;
+
+  stream_ = stream;
+
+  return 0;
+}
+
+int VideoDecoder::OpenCodec(const VideoDecodeConfig &config, const AVCodec *codec) {
+  codec_context_ = std::unique_ptr<AVCodecContext, AVCodecContextDeleter>(avcodec_alloc_context3(nullptr));
+
+  auto ret = avcodec_parameters_to_context(codec_context_.get(), &config.codec_parameters());
+  DCHECK_GE(ret, 0);
+
   codec_context_->codec_id = codec->id;
+  codec_context_->pkt_timebase = config.time_base();
+
   int stream_lower = config.low_res();
+  if (stream_lower == 0 && !hw_device_context_) {
+    // Hardware decoders ignore lowres.
+    stream_lower = config.LowResForDisplaySize(codec->max_lowres);
+  }
   DCHECK_LE(stream_lower, int(codec->max_lowres))
       << "The maximum value for lowres supported by the decoder is " << codec->max_lowres
       << ", but is " << int(codec->max_lowres);
@@ -126,39 +97,82 @@ int VideoDecoder::Initialize(VideoDecodeConfig config,
     codec_context_->flags2 |= AV_CODEC_FLAG2_FAST;
   }
 
-#if defined(_MEDIA_ENABLE_HW_ACCEL)
-  auto *hw_config = avcodec_get_hw_config(codec, 0);
-  if (hw_config) {
-    DLOG(WARNING) << "hw_config: " << hw_config->pix_fmt;
-    DLOG(WARNING) << "hw_config: " << hw_config->device_type;
+  if (config.thread_count() < 0) {
+    // FFmpeg picks one thread per core.
+    codec_context_->thread_count = 0;
+  } else if (config.thread_count() > 0) {
+    codec_context_->thread_count = config.thread_count();
   }
-  ret = av_hwdevice_ctx_create(&hw_device_context_, AVHWDeviceType::AV_HWDEVICE_TYPE_VIDEOTOOLBOX, nullptr, nullptr, 0);
-  if (ret < 0) {
-    DLOG(INFO) << "failed to create hw device_context" << ffmpeg::AVErrorToString(ret);
-  } else {
-    codec_context_->hw_device_ctx = av_buffer_ref(hw_device_context_);
+  switch (config.thread_type()) {
+    case VideoDecoderThreadType::kFrame:codec_context_->thread_type = FF_THREAD_FRAME;
+      break;
+    case VideoDecoderThreadType::kSlice:codec_context_->thread_type = FF_THREAD_SLICE;
+      break;
+    case VideoDecoderThreadType::kAuto:codec_context_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+      break;
   }
+
+  codec_context_->opaque = this;
+  if (hw_device_context_) {
+    codec_context_->hw_device_ctx = av_buffer_ref(hw_device_context_);
+    codec_context_->get_format = &VideoDecoder::GetFormat;
+  } else if (codec->capabilities & AV_CODEC_CAP_DR1) {
+    codec_context_->get_buffer2 = &VideoDecoder::GetBuffer;
+    // PictureBufferPool locks, so frame threads may call it directly instead
+    // of being serialized through the main decoding thread. The field is
+    // deprecated by FFmpeg 4.4 and gone in 5.0.
+#if defined(FF_API_THREAD_SAFE_CALLBACKS) ? FF_API_THREAD_SAFE_CALLBACKS : LIBAVCODEC_VERSION_MAJOR < 59
+    codec_context_->thread_safe_callbacks = 1;
 #endif
+  }
+
   ret = avcodec_open2(codec_context_.get(), codec, nullptr);
-  DCHECK_GE(ret, 0) << "can not open avcodec, reason: " << ffmpeg::AVErrorToString(ret);
   if (ret < 0) {
     codec_context_.reset();
-    return ret;
   }
+  return ret;
+}
 
-  ffmpeg_decoding_loop_ = std::make_unique<FFmpegDecodingLoop>(codec_context_.get(), true);
-//  video_render->SetMaxFrameDuration(video_decode_config_.max_frame_duration());
-  video_decode_config_ = config;
-
-  stream_ = stream;
+// static
+AVPixelFormat VideoDecoder::GetFormat(AVCodecContext *context, const AVPixelFormat *formats) {
+  auto *decoder = static_cast<VideoDecoder *>(context->opaque);
+  const AVPixelFormat *format;
+  for (format = formats; *format != AV_PIX_FMT_NONE; format++) {
+    if (*format == decoder->hw_pixel_format_) {
+      return *format;
+    }
+  }
+  // e.g. a profile the device can not decode. The last entry is the best
+  // software format, if there is one.
+  DLOG(WARNING) << "hardware format " << av_get_pix_fmt_name(decoder->hw_pixel_format_)
+                << " is not offered, decode in software";
+  for (format = formats; *format != AV_PIX_FMT_NONE; format++) {
+    auto *descriptor = av_pix_fmt_desc_get(*format);
+    if (descriptor && !(descriptor->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+      return *format;
+    }
+  }
+  return AV_PIX_FMT_NONE;
+}
 
-  return 0;
+// static
+int VideoDecoder::GetBuffer(AVCodecContext *context, AVFrame *frame, int flags) {
+  auto *decoder = static_cast<VideoDecoder *>(context->opaque);
+  return decoder->picture_buffer_pool_->GetBuffer(context, frame, flags);
 }
 
 void VideoDecoder::Decode(std::shared_ptr<DecoderBuffer> decoder_buffer) {
   DCHECK(!decoder_buffer->end_of_stream());
+  if (discarding_) {
+    // The codec reads these for every packet, so only frames which will be
+    // discarded anyway are decoded at lower quality.
+    auto *packet = decoder_buffer->av_packet();
+    auto pts = packet->pts == AV_NOPTS_VALUE ? NAN : double(packet->pts) * av_q2d(video_decode_config_.time_base());
+    SetSkipNonReference(IsBeforeTarget(pts));
+  }
+  // Only captures |this|, so that the callback is not allocated per packet.
   switch (ffmpeg_decoding_loop_->DecodePacket(
-      decoder_buffer->av_packet(), std::bind(&VideoDecoder::OnFrameAvailable, this, std::placeholders::_1))) {
+      decoder_buffer->av_packet(), [this](AVFrame *frame) { return OnFrameAvailable(frame); })) {
     case FFmpegDecodingLoop::DecodeStatus::kFrameProcessingFailed :return;
     case FFmpegDecodingLoop::DecodeStatus::kSendPacketFailed: {
       DLOG(ERROR) << "Failed to send video packet for decoding";
@@ -174,12 +188,20 @@ void VideoDecoder::Decode(std::shared_ptr<DecoderBuffer> decoder_buffer) {
 }
 
 bool VideoDecoder::OnFrameAvailable(AVFrame *frame) {
-  auto frame_rate = video_decode_config_.frame_rate();
-  auto duration = (frame_rate.num && frame_rate.den ? av_q2d(AVRational{frame_rate.den, frame_rate.num}) : 0);
+  auto duration = FrameDuration();
   auto pts = (frame->pts == AV_NOPTS_VALUE) ? NAN : double(frame->pts) * av_q2d(video_decode_config_.time_base());
 
-  std::shared_ptr<VideoFrame> video_frame = std::make_shared<VideoFrame>(frame, pts, duration, 0);
-  output_callback_(std::move(video_frame));
+  if (discarding_) {
+    if (IsBeforeTarget(pts)) {
+      discarded_frames_++;
+      return true;
+    }
+    // Target reached, back to full quality decoding.
+    discarding_ = false;
+    SetSkipNonReference(false);
+  }
+
+  output_callback_(video_frame_pool_.Acquire(frame, pts, duration, 0));
   return false;
 }
 
@@ -187,4 +209,48 @@ void VideoDecoder::Flush() {
   avcodec_flush_buffers(codec_context_.get());
 }
 
+void VideoDecoder::SetTargetTimestamp(double timestamp) {
+  target_timestamp_ = timestamp;
+  discarding_ = timestamp > 0;
+  if (!discarding_) {
+    SetSkipNonReference(false);
+  }
+}
+
+double VideoDecoder::FrameDuration() const {
+  auto frame_rate = video_decode_config_.frame_rate();
+  return frame_rate.num && frame_rate.den ? av_q2d(AVRational{frame_rate.den, frame_rate.num}) : 0;
+}
+
+bool VideoDecoder::IsBeforeTarget(double pts) const {
+  // Same as the renderer, a frame which is still on screen at the target is kept.
+  return pts < target_timestamp_ && pts + FrameDuration() <= target_timestamp_;
+}
+
+void VideoDecoder::SetKeyframesOnly(bool keyframes_only) {
+  keyframes_only_ = keyframes_only;
+  UpdateSkipFlags();
+}
+
+void VideoDecoder::SetSkipNonReference(bool skip) {
+  if (skip == skipping_non_reference_) {
+    return;
+  }
+  skipping_non_reference_ = skip;
+  UpdateSkipFlags();
+}
+
+void VideoDecoder::UpdateSkipFlags() {
+  if (!codec_context_) {
+    return;
+  }
+  // Codecs which do not support them ignore both fields.
+  if (keyframes_only_) {
+    codec_context_->skip_frame = AVDISCARD_NONKEY;
+  } else {
+    codec_context_->skip_frame = skipping_non_reference_ ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+  }
+  codec_context_->skip_loop_filter = skipping_non_reference_ ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+}
+
 } // namespace media
\ No newline at end of file
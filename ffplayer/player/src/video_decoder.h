@@ -14,6 +14,7 @@ extern "C" {
 }
 
 #include "ffmpeg_decoding_loop.h"
+#include "picture_buffer_pool.h"
 #include "video_frame.h"
 #include "demuxer_stream.h"
 
@@ -34,19 +35,90 @@ class VideoDecoder {
 
   void Flush();
 
+  /**
+   * Discard the frames which end before |timestamp|, until the first frame at
+   * |timestamp| is decoded. Skipped frames are not wrapped in a VideoFrame, and
+   * non-reference frames and loop filters before |timestamp| are skipped by the
+   * codec. A |timestamp| of 0 turns it off.
+   */
+  void SetTargetTimestamp(double timestamp);
+
+  /**
+   * Only decode keyframes, for a cheap preview while scrubbing.
+   */
+  void SetKeyframesOnly(bool keyframes_only);
+
+  int discarded_frames() const {
+    return discarded_frames_;
+  }
+
+  /**
+   * Whether frames are decoded by a hardware device.
+   */
+  bool IsHardwareAccelerated() const {
+    return hw_device_context_ != nullptr;
+  }
+
+  /**
+   * Count of VideoFrames created, they are recycled afterwards.
+   */
+  size_t allocated_frames() const {
+    return video_frame_pool_.size();
+  }
+
+  /**
+   * Count of picture planes allocated by get_buffer2, 0 if the codec does not
+   * use it.
+   */
+  int64 allocated_picture_planes() const {
+    return picture_buffer_pool_->allocated_planes();
+  }
+
  private:
 
+  // Declared before |codec_context_|, the frame threads of the codec may still
+  // get buffers while it is closed.
+  std::unique_ptr<PictureBufferPool> picture_buffer_pool_;
+
   std::unique_ptr<FFmpegDecodingLoop> ffmpeg_decoding_loop_;
   std::unique_ptr<AVCodecContext, AVCodecContextDeleter> codec_context_;
   DemuxerStream *stream_ = nullptr;
   OutputCallback output_callback_;
 
+  // Null when decoding in software.
   AVBufferRef *hw_device_context_;
+  AVPixelFormat hw_pixel_format_ = AV_PIX_FMT_NONE;
 
   VideoDecodeConfig video_decode_config_;
 
+  // Frames before |target_timestamp_| are discarded while |discarding_|.
+  double target_timestamp_ = 0;
+  bool discarding_ = false;
+  bool skipping_non_reference_ = false;
+  bool keyframes_only_ = false;
+  int discarded_frames_ = 0;
+
+  VideoFramePool video_frame_pool_;
+
+  // Create and open |codec_context_|, with |hw_device_context_| if any.
+  int OpenCodec(const VideoDecodeConfig &config, const AVCodec *codec);
+
+  // AVCodecContext::get_format, picks |hw_pixel_format_| if it is offered.
+  static AVPixelFormat GetFormat(AVCodecContext *context, const AVPixelFormat *formats);
+
+  // AVCodecContext::get_buffer2, takes buffers from |picture_buffer_pool_|.
+  static int GetBuffer(AVCodecContext *context, AVFrame *frame, int flags);
+
   bool OnFrameAvailable(AVFrame *frame);
 
+  double FrameDuration() const;
+
+  bool IsBeforeTarget(double pts) const;
+
+  void SetSkipNonReference(bool skip);
+
+  void UpdateSkipFlags();
+
   DELETE_COPY_AND_ASSIGN(VideoDecoder);
 
 };
@@ -4,11 +4,17 @@
 
 #include "video_frame.h"
 
+#include <atomic>
+
+#include "base/logging.h"
+
 namespace media {
 
 // static
-std::shared_ptr<VideoFrame> VideoFrame::CreateEmptyFrame() {
-  return std::make_shared<VideoFrame>(nullptr, 0, 0, 0);
+const std::shared_ptr<VideoFrame> &VideoFrame::EmptyFrame() {
+  // Leaked, so that it outlives the renderers.
+  static auto *empty_frame = new std::shared_ptr<VideoFrame>(std::make_shared<VideoFrame>(nullptr, 0, 0, 0));
+  return *empty_frame;
 }
 
 VideoFrame::VideoFrame(AVFrame *frame, double pts, double duration, int serial)
@@ -26,4 +32,45 @@ VideoFrame::~VideoFrame() {
   }
 }
 
+void VideoFrame::Reset(AVFrame *frame, double pts, double duration, int serial) {
+  DCHECK(frame_);
+  DCHECK(frame);
+  av_frame_unref(frame_);
+  av_frame_ref(frame_, frame);
+  pts_ = pts;
+  duration_ = duration;
+  serial_ = serial;
+}
+
+void VideoFrame::ReleasePicture() {
+  DCHECK(frame_);
+  av_frame_unref(frame_);
+}
+
+std::shared_ptr<VideoFrame> VideoFramePool::Acquire(AVFrame *frame, double pts, double duration, int serial) {
+  DCHECK(frame);
+  std::shared_ptr<VideoFrame> acquired;
+  for (auto &video_frame : frames_) {
+    if (video_frame.use_count() != 1) {
+      continue;
+    }
+    // Pairs with the release of the renderer's reference, its reads of the
+    // picture happen before we unref it.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!acquired) {
+      video_frame->Reset(frame, pts, duration, serial);
+      acquired = video_frame;
+    } else {
+      video_frame->ReleasePicture();
+    }
+  }
+  if (acquired) {
+    return acquired;
+  }
+  acquired = std::make_shared<VideoFrame>(frame, pts, duration, serial);
+  frames_.push_back(acquired);
+  DLOG_IF(WARNING, frames_.size() > 32) << "video frame pool grows to " << frames_.size();
+  return acquired;
+}
+
 }
@@ -5,8 +5,10 @@
 #ifndef MEDIA_PLAYER_SRC_VIDEO_FRAME_H_
 #define MEDIA_PLAYER_SRC_VIDEO_FRAME_H_
 
+#include "memory"
 #include "string"
 #include "sstream"
+#include "vector"
 
 #include "base/basictypes.h"
 
@@ -20,7 +22,11 @@ class VideoFrame {
 
  public:
 
-  static std::shared_ptr<VideoFrame> CreateEmptyFrame();
+  /**
+   * The frame with nothing to show. A shared sentinel, getting it does not
+   * allocate.
+   */
+  static const std::shared_ptr<VideoFrame> &EmptyFrame();
 
   VideoFrame(AVFrame *frame, double pts, double duration, int serial);
 
@@ -73,10 +79,57 @@ class VideoFrame {
   double duration_;
   int serial_;
 
+  friend class VideoFramePool;
+
+  // Reference |frame| instead of the current picture, keeping the AVFrame.
+  void Reset(AVFrame *frame, double pts, double duration, int serial);
+
+  // Release the picture, keeping the AVFrame.
+  void ReleasePicture();
+
   DELETE_COPY_AND_ASSIGN(VideoFrame);
 
 };
 
+/**
+ * Recycles VideoFrames and their AVFrames between the decoder and the
+ * renderer, the same way as AudioBufferPool.
+ *
+ * Only the picture is referenced per frame, by av_frame_ref. It allocates an
+ * AVBufferRef per buffer of the picture, which is the floor for holding a
+ * decoded picture, nothing else is allocated once the pool is warm. The
+ * picture of a frame nobody else references is released at the next
+ * [Acquire], so the decoder gets its buffers back.
+ *
+ * Not thread safe, [Acquire] must be called from one thread.
+ */
+class VideoFramePool {
+
+ public:
+
+  VideoFramePool() = default;
+
+  /**
+   * @return A frame referencing the picture of |frame|, which is not
+   * referenced anywhere else. Allocates only if all pooled frames are in use.
+   */
+  std::shared_ptr<VideoFrame> Acquire(AVFrame *frame, double pts, double duration, int serial);
+
+  /**
+   * Count of frames created by this pool.
+   */
+  size_t size() const {
+    return frames_.size();
+  }
+
+ private:
+
+  std::vector<std::shared_ptr<VideoFrame>> frames_;
+
+  DELETE_COPY_AND_ASSIGN(VideoFramePool);
+
+};
+
 }
 
 #endif //MEDIA_PLAYER_SRC_VIDEO_FRAME_H_
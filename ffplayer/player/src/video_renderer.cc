@@ -9,11 +9,18 @@
 
 #include "base/bind_to_current_loop.h"
 #include "base/lambda.h"
+#include "base/time_ticks.h"
+#include "base/trace_event.h"
 
 namespace {
 // 默认绘制下一帧的延迟时延。
 // TODO: 根据过去播放的平均帧率进行计算？
 const media::TimeDelta kDefaultVideoRenderDelay = media::TimeDelta::FromMilliseconds(10);
+
+// How soon a free running renderer asks again while it waits for the decoder.
+const media::TimeDelta kFreeRunningPollDelay = media::TimeDelta::FromMilliseconds(1);
+
+const auto kAttemptReadFrameTaskId = 200;
 }
 
 namespace media {
@@ -45,10 +52,13 @@ void VideoRenderer::Initialize(DemuxerStream *stream, std::shared_ptr<MediaClock
   state_ = kInitializing;
   media_clock_ = std::move(media_clock);
   init_callback_ = std::move(BindToCurrentLoop(std::move(init_callback)));
-  decoder_stream_ = std::make_shared<VideoDecoderStream>(
-      std::make_unique<DecoderStreamTraits<DemuxerStream::Video>>(),
-      decode_task_runner_
-  );
+  auto traits = std::make_unique<DecoderStreamTraits<DemuxerStream::Video>>(decoder_thread_type_,
+                                                                            decoder_thread_count_,
+                                                                            hw_device_types_);
+  traits->SetDisplaySize(display_width_, display_height_);
+  decoder_stream_ = std::make_shared<VideoDecoderStream>(std::move(traits), decode_task_runner_);
+  decoder_stream_->set_max_outputs(max_decoder_outputs_);
+  decoder_stream_->set_metrics(metrics_);
   decoder_stream_->Initialize(stream, bind_weak(&VideoRenderer::OnDecodeStreamInitialized, shared_from_this()));
 
 }
@@ -61,7 +71,8 @@ void VideoRenderer::OnDecodeStreamInitialized(bool success) {
   if (!success) {
     return;
   }
-  decode_task_runner_->PostTask(FROM_HERE, bind_weak(&VideoRenderer::AttemptReadFrame, shared_from_this()));
+  attempt_read_frame_closure_ = bind_weak(&VideoRenderer::AttemptReadFrame, shared_from_this());
+  PostAttemptReadFrame();
 }
 
 void VideoRenderer::AttemptReadFrame() {
@@ -78,13 +89,20 @@ void VideoRenderer::AttemptReadFrame() {
 void VideoRenderer::OnNewFrameAvailable(std::shared_ptr<VideoFrame> frame) {
   DLOG_IF(WARNING, ready_frames_.size() > 3) << "ready_frames is enough. " << ready_frames_.size();
   reading_ = false;
+  // Decoded from the keyframe before an accurate seek target. Not a dropped
+  // frame, it was never due for display.
+  auto start_time = start_time_.load();
+  if (!frame->IsEmpty() && frame->pts() < start_time && frame->pts() + frame->duration() <= start_time) {
+    PostAttemptReadFrame();
+    return;
+  }
   ready_frames_.emplace_back(std::move(frame));
 
-  decode_task_runner_->PostTask(FROM_HERE, bind_weak(&VideoRenderer::AttemptReadFrame, shared_from_this()));
+  PostAttemptReadFrame();
 }
 
 bool VideoRenderer::CanDecodeMore() {
-  return ready_frames_.size() < 3;
+  return static_cast<int>(ready_frames_.size()) < max_ready_frames_;
 }
 
 void VideoRenderer::Start() {
@@ -101,23 +119,48 @@ void VideoRenderer::Stop() {
 }
 
 std::shared_ptr<VideoFrame> VideoRenderer::Render(TimeDelta &next_frame_delay) {
+  TRACE_METHOD_DURATION(2);
+  TRACE_EVENT("video", "Render");
+  auto render_begin = TimeTicks::Now();
+
+  auto frame = SelectFrame(next_frame_delay);
+  if (!frame->IsEmpty() && frame != last_presented_frame_) {
+    last_presented_frame_ = frame;
+    if (metrics_) {
+      metrics_->frames_rendered().fetch_add(1, std::memory_order_relaxed);
+      auto audio_clock = media_clock_->GetAudioClock()->GetClock();
+      if (!std::isnan(audio_clock)) {
+        metrics_->RecordAVDrift(static_cast<int64>((frame->pts() - audio_clock) * 1000000));
+      }
+    }
+  }
 
+  if (metrics_) {
+    metrics_->video().render_callback_time_us.Record((TimeTicks::Now() - render_begin).InMicroseconds());
+  }
+  return frame;
+}
+
+std::shared_ptr<VideoFrame> VideoRenderer::SelectFrame(TimeDelta &next_frame_delay) {
   next_frame_delay = kDefaultVideoRenderDelay;
-  TRACE_METHOD_DURATION(2);
 
   if (state_ != kPlaying) {
     DLOG(WARNING) << "not playing: " << state_;
-    return VideoFrame::CreateEmptyFrame();
+    return VideoFrame::EmptyFrame();
+  }
+
+  if (media_clock_->IsFreeRunning()) {
+    return SelectNextFrame(next_frame_delay);
   }
 
   if (ready_frames_.empty()) {
-    decode_task_runner_->PostTask(FROM_HERE, bind_weak(&VideoRenderer::AttemptReadFrame, shared_from_this()));
-    return VideoFrame::CreateEmptyFrame();
+    PostAttemptReadFrame();
+    return VideoFrame::EmptyFrame();
   }
 
   double clock = GetDrawingClock();
   if (std::isnan(clock)) {
-    return VideoFrame::CreateEmptyFrame();
+    return VideoFrame::EmptyFrame();
   }
 
   auto last_frame = ready_frames_.front();
@@ -156,11 +199,33 @@ std::shared_ptr<VideoFrame> VideoRenderer::Render(TimeDelta &next_frame_delay) {
   auto frame = ready_frames_.front();
   DCHECK(frame);
 
-  decode_task_runner_->PostTask(FROM_HERE, bind_weak(&VideoRenderer::AttemptReadFrame, shared_from_this()));
+  PostAttemptReadFrame();
+
+  return frame;
+}
 
+std::shared_ptr<VideoFrame> VideoRenderer::SelectNextFrame(TimeDelta &next_frame_delay) {
+  // The front frame was presented by the previous call, move on once the next
+  // one is decoded.
+  if (ready_frames_.size() > 1 && ready_frames_.front() == last_presented_frame_) {
+    ready_frames_.pop_front();
+  }
+  PostAttemptReadFrame();
+  if (ready_frames_.empty()) {
+    next_frame_delay = kFreeRunningPollDelay;
+    return VideoFrame::EmptyFrame();
+  }
+  auto frame = ready_frames_.front();
+  next_frame_delay = ready_frames_.size() > 1 ? TimeDelta() : kFreeRunningPollDelay;
+  media_clock_->GetVideoClock()->SetClock(frame->pts(), frame->serial());
   return frame;
 }
 
+void VideoRenderer::PostAttemptReadFrame() {
+  DCHECK(attempt_read_frame_closure_);
+  decode_task_runner_->PostTaskIfNotPending(FROM_HERE, kAttemptReadFrameTaskId, attempt_read_frame_closure_);
+}
+
 void VideoRenderer::OnFrameDrop() {
 
 }
@@ -170,14 +235,23 @@ double VideoRenderer::GetDrawingClock() {
   return media_clock_->GetMasterClock();
 }
 
-void VideoRenderer::Flush() {
+void VideoRenderer::SetDisplaySize(int width, int height) {
+  DCHECK(media_task_runner_.BelongsToCurrentThread());
+  display_width_ = width;
+  display_height_ = height;
+  sink_->SetDisplaySize(width, height);
+}
+
+void VideoRenderer::Flush(double start_time) {
   DCHECK(media_task_runner_.BelongsToCurrentThread());
   if (state_ == kFlushing || state_ == kUnInitialized) {
     return;
   }
+  start_time_ = start_time;
   bool playing = state_ == kPlaying;
   state_ = kFlushing;
   decoder_stream_->Flush();
+  decoder_stream_->SetTargetTimestamp(start_time);
   ready_frames_.clear();
   state_ = playing ? kPlaying : kFlushed;
 }
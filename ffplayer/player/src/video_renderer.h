@@ -7,11 +7,13 @@
 
 #include "base/task_runner.h"
 
+#include <atomic>
 #include <ostream>
 #include "video_renderer_sink.h"
 #include "demuxer_stream.h"
 #include "media_clock.h"
 #include "decoder_stream.h"
+#include "buffering_policy.h"
 
 namespace media {
 
@@ -31,10 +33,62 @@ class VideoRenderer : public VideoRendererSink::RenderCallback, public std::enab
 
   void Initialize(DemuxerStream *stream, std::shared_ptr<MediaClock> media_clock, InitCallback init_callback);
 
+  /**
+   * Threading policy of the video decoder, must be set before |Initialize|.
+   *
+   * @param thread_count count of decoder threads, 0 means one per core.
+   */
+  void SetDecoderThreading(VideoDecoderThreadType thread_type, int thread_count) {
+    decoder_thread_type_ = thread_type;
+    decoder_thread_count_ = thread_count;
+  }
+
+  /**
+   * Hardware devices the video decoder tries, see VideoDecodeConfig. Must be
+   * set before |Initialize|.
+   */
+  void SetHwDeviceTypes(std::vector<AVHWDeviceType> types) {
+    hw_device_types_ = std::move(types);
+  }
+
+  /**
+   * Size the video is shown at, 0 for the size of the video. Passed to the
+   * sink right away. The decoder picks its lowres from the size set before
+   * |Initialize|, it does not change later.
+   */
+  void SetDisplaySize(int width, int height);
+
+  /**
+   * Limits of decoded frames, must be set before |Initialize|.
+   */
+  void SetBufferingPolicy(const BufferingPolicy &policy) {
+    max_ready_frames_ = policy.max_decoded_video_frames;
+    max_decoder_outputs_ = policy.max_decoder_outputs;
+  }
+
+  /**
+   * Decoding, rendered frames and render callbacks go to |metrics|, which may
+   * be null. Must be set before |Initialize|.
+   */
+  void set_metrics(std::shared_ptr<MediaMetrics> metrics) {
+    metrics_ = std::move(metrics);
+  }
+
+  TaskStats GetDecoderTaskStats(int top_n = 0) const {
+    return decode_task_runner_->GetTaskStats(top_n);
+  }
+
   std::shared_ptr<VideoFrame> Render(TimeDelta &next_frame_delay) override;
 
   void OnFrameDrop() override;
 
+  /**
+   * Frames which were due but skipped because a later one was due as well.
+   */
+  int frame_drop_count() const {
+    return frame_drop_count_;
+  }
+
   void Start();
 
   void Stop();
@@ -43,7 +97,20 @@ class VideoRenderer : public VideoRendererSink::RenderCallback, public std::enab
     return sink_.get();
   }
 
-  void Flush();
+  /**
+   * Drop decoded frames for a seek. Frames which end before |start_time| are
+   * dropped as they are decoded, instead of being rendered late.
+   */
+  void Flush(double start_time = 0);
+
+  /**
+   * Only decode keyframes, as a preview while the user drags a scrubber.
+   */
+  void SetKeyframesOnly(bool keyframes_only) {
+    if (decoder_stream_) {
+      decoder_stream_->SetKeyframesOnly(keyframes_only);
+    }
+  }
 
   friend std::ostream &operator<<(std::ostream &os, const VideoRenderer &renderer);
 
@@ -65,9 +132,27 @@ class VideoRenderer : public VideoRendererSink::RenderCallback, public std::enab
 
   std::shared_ptr<MediaClock> media_clock_;
 
+  // Returned by the last Render which returned a frame.
+  std::shared_ptr<VideoFrame> last_presented_frame_;
+
+  std::shared_ptr<MediaMetrics> metrics_;
+
   InitCallback init_callback_;
 
-  int frame_drop_count_ = 0;
+  // Counted on the render thread.
+  std::atomic_int frame_drop_count_{0};
+
+  // Set on the media thread, read on the decode thread.
+  std::atomic<double> start_time_{0};
+
+  VideoDecoderThreadType decoder_thread_type_ = VideoDecoderThreadType::kAuto;
+  int decoder_thread_count_ = 0;
+  std::vector<AVHWDeviceType> hw_device_types_;
+  int display_width_ = 0;
+  int display_height_ = 0;
+
+  int max_ready_frames_ = 3;
+  int max_decoder_outputs_ = 9;
 
   bool reading_ = false;
 
@@ -75,6 +160,11 @@ class VideoRenderer : public VideoRendererSink::RenderCallback, public std::enab
 
   void AttemptReadFrame();
 
+  // Schedule |AttemptReadFrame| on |decode_task_runner_|, coalesced with a pending one.
+  void PostAttemptReadFrame();
+
+  TaskClosure attempt_read_frame_closure_;
+
   bool CanDecodeMore();
 
   void OnNewFrameAvailable(std::shared_ptr<VideoFrame> frame);
@@ -82,6 +172,12 @@ class VideoRenderer : public VideoRendererSink::RenderCallback, public std::enab
   // To get current clock time in seconds.
   double GetDrawingClock();
 
+  // The frame to render now, as the clock goes.
+  std::shared_ptr<VideoFrame> SelectFrame(TimeDelta &next_frame_delay);
+
+  // Select with a free running clock: every frame in order, none dropped.
+  std::shared_ptr<VideoFrame> SelectNextFrame(TimeDelta &next_frame_delay);
+
   DELETE_COPY_AND_ASSIGN(VideoRenderer);
 
 };
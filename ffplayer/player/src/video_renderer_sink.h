@@ -30,6 +30,12 @@ class VideoRendererSink {
 
   virtual void Stop() = 0;
 
+  /**
+   * Size the video is shown at, in pixels, 0 for the size of the video. Sinks
+   * which convert frames on the CPU need not convert to more than that.
+   */
+  virtual void SetDisplaySize(int, int) {}
+
   virtual ~VideoRendererSink() = default;
 
 };
@@ -0,0 +1,255 @@
+//
+// Created by yangbin on 2021/7/28.
+//
+
+#include "yuv_convert.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define MEDIA_YUV_CONVERT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MEDIA_YUV_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace media {
+namespace yuv_convert {
+
+namespace {
+
+// Fixed point with 6 fractional bits, small enough for 16 bit SIMD lanes:
+//
+//   Y' = ((Y * 257 * y_gain) >> 16) - y_bias
+//   R  = (Y' + vr * (V - 128)) >> 6
+//   G  = (Y' - ug * (U - 128) - vg * (V - 128)) >> 6
+//   B  = (Y' + ub * (U - 128)) >> 6
+//
+// Y * 257 * y_gain >> 16 is a 16 bit multiply-high, y_bias includes the
+// rounding of the final shift.
+struct Coefficients {
+  int y_gain;
+  int y_bias;
+  int vr;
+  int ug;
+  int vg;
+  int ub;
+};
+
+const Coefficients kBT601Limited = {19003, 1160, 102, 25, 52, 129};
+const Coefficients kBT709Limited = {19003, 1160, 115, 14, 34, 135};
+const Coefficients kBT601Full = {16320, -32, 90, 22, 46, 113};
+const Coefficients kBT709Full = {16320, -32, 101, 12, 30, 119};
+
+const Coefficients &GetCoefficients(YuvColorSpace color_space) {
+  if (color_space.matrix == YuvMatrix::kBT709) {
+    return color_space.full_range ? kBT709Full : kBT709Limited;
+  }
+  return color_space.full_range ? kBT601Full : kBT601Limited;
+}
+
+inline uint8 Clamp255(int value) {
+  return static_cast<uint8>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// U and V of pixel x are u[x / 2 * chroma_step] and v[x / 2 * chroma_step].
+void ConvertRow_C(const uint8 *y, const uint8 *u, const uint8 *v, int chroma_step,
+                  uint8 *dest, int width, const Coefficients &c, RgbOrder order) {
+  const int r_index = order == RgbOrder::kBGRA ? 2 : 0;
+  const int b_index = 2 - r_index;
+  for (int x = 0; x < width; ++x) {
+    int luma = ((y[x] * 257 * c.y_gain) >> 16) - c.y_bias;
+    int chroma_u = u[x / 2 * chroma_step] - 128;
+    int chroma_v = v[x / 2 * chroma_step] - 128;
+    dest[r_index] = Clamp255((luma + c.vr * chroma_v) >> 6);
+    dest[1] = Clamp255((luma - c.ug * chroma_u - c.vg * chroma_v) >> 6);
+    dest[b_index] = Clamp255((luma + c.ub * chroma_u) >> 6);
+    dest[3] = 255;
+    dest += 4;
+  }
+}
+
+#if defined(MEDIA_YUV_CONVERT_SSE2)
+
+// |luma|, |u| and |v| are 8 int16 lanes, |u| and |v| already minus 128.
+inline void Store8Pixels_SSE2(__m128i luma, __m128i u, __m128i v,
+                              const Coefficients &c, RgbOrder order, uint8 *dest) {
+  __m128i r = _mm_adds_epi16(luma, _mm_mullo_epi16(v, _mm_set1_epi16(int16(c.vr))));
+  __m128i g = _mm_subs_epi16(_mm_subs_epi16(luma, _mm_mullo_epi16(u, _mm_set1_epi16(int16(c.ug)))),
+                             _mm_mullo_epi16(v, _mm_set1_epi16(int16(c.vg))));
+  __m128i b = _mm_adds_epi16(luma, _mm_mullo_epi16(u, _mm_set1_epi16(int16(c.ub))));
+  r = _mm_srai_epi16(r, 6);
+  g = _mm_srai_epi16(g, 6);
+  b = _mm_srai_epi16(b, 6);
+  __m128i r8 = _mm_packus_epi16(r, r);
+  __m128i g8 = _mm_packus_epi16(g, g);
+  __m128i b8 = _mm_packus_epi16(b, b);
+  if (order == RgbOrder::kRGBA) {
+    std::swap(r8, b8);
+  }
+  __m128i bg = _mm_unpacklo_epi8(b8, g8);
+  __m128i ra = _mm_unpacklo_epi8(r8, _mm_set1_epi8(-1));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_unpacklo_epi16(bg, ra));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 16), _mm_unpackhi_epi16(bg, ra));
+}
+
+inline __m128i LoadLuma_SSE2(const uint8 *y, const Coefficients &c) {
+  __m128i y8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(y));
+  // Each lane is Y * 257.
+  __m128i y16 = _mm_unpacklo_epi8(y8, y8);
+  return _mm_sub_epi16(_mm_mulhi_epu16(y16, _mm_set1_epi16(int16(c.y_gain))), _mm_set1_epi16(int16(c.y_bias)));
+}
+
+void I420Row_SSE2(const uint8 *y, const uint8 *u, const uint8 *v,
+                  uint8 *dest, int width, const Coefficients &c, RgbOrder order) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(128);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    int32_t u4, v4;
+    memcpy(&u4, u + x / 2, 4);
+    memcpy(&v4, v + x / 2, 4);
+    __m128i u8 = _mm_cvtsi32_si128(u4);
+    __m128i v8 = _mm_cvtsi32_si128(v4);
+    // Every chroma sample covers two pixels.
+    __m128i u16 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(u8, u8), zero), bias);
+    __m128i v16 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(v8, v8), zero), bias);
+    Store8Pixels_SSE2(LoadLuma_SSE2(y + x, c), u16, v16, c, order, dest + x * 4);
+  }
+  ConvertRow_C(y + x, u + x / 2, v + x / 2, 1, dest + x * 4, width - x, c, order);
+}
+
+void NV12Row_SSE2(const uint8 *y, const uint8 *uv,
+                  uint8 *dest, int width, const Coefficients &c, RgbOrder order) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(128);
+  const __m128i low_mask = _mm_set1_epi32(0xFFFF);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    // U0 V0 U1 V1 U2 V2 U3 V3 as int16, so every int32 lane is U | V << 16.
+    __m128i uv16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(uv + x)), zero);
+    __m128i u32 = _mm_and_si128(uv16, low_mask);
+    __m128i v32 = _mm_srli_epi32(uv16, 16);
+    __m128i u16 = _mm_sub_epi16(_mm_or_si128(u32, _mm_slli_epi32(u32, 16)), bias);
+    __m128i v16 = _mm_sub_epi16(_mm_or_si128(v32, _mm_slli_epi32(v32, 16)), bias);
+    Store8Pixels_SSE2(LoadLuma_SSE2(y + x, c), u16, v16, c, order, dest + x * 4);
+  }
+  ConvertRow_C(y + x, uv + x, uv + x + 1, 2, dest + x * 4, width - x, c, order);
+}
+
+#endif // MEDIA_YUV_CONVERT_SSE2
+
+#if defined(MEDIA_YUV_CONVERT_NEON)
+
+inline void Store8Pixels_NEON(int16x8_t luma, int16x8_t u, int16x8_t v,
+                              const Coefficients &c, RgbOrder order, uint8 *dest) {
+  int16x8_t r = vqaddq_s16(luma, vmulq_n_s16(v, int16_t(c.vr)));
+  int16x8_t g = vqsubq_s16(vqsubq_s16(luma, vmulq_n_s16(u, int16_t(c.ug))), vmulq_n_s16(v, int16_t(c.vg)));
+  int16x8_t b = vqaddq_s16(luma, vmulq_n_s16(u, int16_t(c.ub)));
+  // Shift right and narrow with unsigned saturation.
+  uint8x8_t r8 = vqshrun_n_s16(r, 6);
+  uint8x8_t g8 = vqshrun_n_s16(g, 6);
+  uint8x8_t b8 = vqshrun_n_s16(b, 6);
+  uint8x8x4_t pixels;
+  pixels.val[0] = order == RgbOrder::kBGRA ? b8 : r8;
+  pixels.val[1] = g8;
+  pixels.val[2] = order == RgbOrder::kBGRA ? r8 : b8;
+  pixels.val[3] = vdup_n_u8(255);
+  vst4_u8(dest, pixels);
+}
+
+inline int16x8_t LoadLuma_NEON(const uint8 *y, const Coefficients &c) {
+  uint16x8_t y16 = vmulq_n_u16(vmovl_u8(vld1_u8(y)), 257);
+  uint32x4_t lo = vmull_n_u16(vget_low_u16(y16), uint16_t(c.y_gain));
+  uint32x4_t hi = vmull_n_u16(vget_high_u16(y16), uint16_t(c.y_gain));
+  uint16x8_t luma = vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+  return vsubq_s16(vreinterpretq_s16_u16(luma), vdupq_n_s16(int16_t(c.y_bias)));
+}
+
+inline int16x8_t ExpandChroma_NEON(uint8x8_t chroma) {
+  // Every chroma sample covers two pixels.
+  uint8x8_t doubled = vzip_u8(chroma, chroma).val[0];
+  return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(doubled)), vdupq_n_s16(128));
+}
+
+void I420Row_NEON(const uint8 *y, const uint8 *u, const uint8 *v,
+                  uint8 *dest, int width, const Coefficients &c, RgbOrder order) {
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint32_t u4, v4;
+    memcpy(&u4, u + x / 2, 4);
+    memcpy(&v4, v + x / 2, 4);
+    int16x8_t u16 = ExpandChroma_NEON(vreinterpret_u8_u32(vdup_n_u32(u4)));
+    int16x8_t v16 = ExpandChroma_NEON(vreinterpret_u8_u32(vdup_n_u32(v4)));
+    Store8Pixels_NEON(LoadLuma_NEON(y + x, c), u16, v16, c, order, dest + x * 4);
+  }
+  ConvertRow_C(y + x, u + x / 2, v + x / 2, 1, dest + x * 4, width - x, c, order);
+}
+
+void NV12Row_NEON(const uint8 *y, const uint8 *uv,
+                  uint8 *dest, int width, const Coefficients &c, RgbOrder order) {
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint8x8_t uv8 = vld1_u8(uv + x);
+    // val[0] is U0..U3 twice, val[1] is V0..V3 twice.
+    uint8x8x2_t planes = vuzp_u8(uv8, uv8);
+    Store8Pixels_NEON(LoadLuma_NEON(y + x, c), ExpandChroma_NEON(planes.val[0]),
+                      ExpandChroma_NEON(planes.val[1]), c, order, dest + x * 4);
+  }
+  ConvertRow_C(y + x, uv + x, uv + x + 1, 2, dest + x * 4, width - x, c, order);
+}
+
+#endif // MEDIA_YUV_CONVERT_NEON
+
+void I420Row(const uint8 *y, const uint8 *u, const uint8 *v,
+             uint8 *dest, int width, const Coefficients &c, RgbOrder order) {
+#if defined(MEDIA_YUV_CONVERT_SSE2)
+  I420Row_SSE2(y, u, v, dest, width, c, order);
+#elif defined(MEDIA_YUV_CONVERT_NEON)
+  I420Row_NEON(y, u, v, dest, width, c, order);
+#else
+  ConvertRow_C(y, u, v, 1, dest, width, c, order);
+#endif
+}
+
+void NV12Row(const uint8 *y, const uint8 *uv,
+             uint8 *dest, int width, const Coefficients &c, RgbOrder order) {
+#if defined(MEDIA_YUV_CONVERT_SSE2)
+  NV12Row_SSE2(y, uv, dest, width, c, order);
+#elif defined(MEDIA_YUV_CONVERT_NEON)
+  NV12Row_NEON(y, uv, dest, width, c, order);
+#else
+  ConvertRow_C(y, uv, uv + 1, 2, dest, width, c, order);
+#endif
+}
+
+} // namespace
+
+void I420ToRGB32(const uint8 *y, int y_stride,
+                 const uint8 *u, int u_stride,
+                 const uint8 *v, int v_stride,
+                 uint8 *dest, int dest_stride,
+                 int width, int height,
+                 YuvColorSpace color_space, RgbOrder order) {
+  const auto &c = GetCoefficients(color_space);
+  for (int row = 0; row < height; ++row) {
+    I420Row(y + row * y_stride, u + row / 2 * u_stride, v + row / 2 * v_stride,
+            dest + row * dest_stride, width, c, order);
+  }
+}
+
+void NV12ToRGB32(const uint8 *y, int y_stride,
+                 const uint8 *uv, int uv_stride,
+                 uint8 *dest, int dest_stride,
+                 int width, int height,
+                 YuvColorSpace color_space, RgbOrder order) {
+  const auto &c = GetCoefficients(color_space);
+  for (int row = 0; row < height; ++row) {
+    NV12Row(y + row * y_stride, uv + row / 2 * uv_stride, dest + row * dest_stride, width, c, order);
+  }
+}
+
+} // namespace yuv_convert
+} // namespace media
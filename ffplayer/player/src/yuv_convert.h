@@ -0,0 +1,57 @@
+//
+// Created by yangbin on 2021/7/28.
+//
+
+#ifndef MEDIA_PLAYER_SRC_YUV_CONVERT_H_
+#define MEDIA_PLAYER_SRC_YUV_CONVERT_H_
+
+#include "base/basictypes.h"
+
+namespace media {
+namespace yuv_convert {
+
+enum class YuvMatrix {
+  kBT601,
+  kBT709,
+};
+
+struct YuvColorSpace {
+  YuvMatrix matrix = YuvMatrix::kBT601;
+  // Y in [0, 255] instead of [16, 235].
+  bool full_range = false;
+};
+
+enum class RgbOrder {
+  // B, G, R, A in memory.
+  kBGRA,
+  // R, G, B, A in memory.
+  kRGBA,
+};
+
+/**
+ * Convert |height| rows of 4:2:0 planar YUV to 32 bit RGB with opaque alpha.
+ * Chroma row i / 2 is used for row i, so a caller which converts a frame in
+ * slices starts each slice on an even row.
+ *
+ * Uses SSE2 or NEON when available, otherwise plain C. Strides may be negative.
+ */
+void I420ToRGB32(const uint8 *y, int y_stride,
+                 const uint8 *u, int u_stride,
+                 const uint8 *v, int v_stride,
+                 uint8 *dest, int dest_stride,
+                 int width, int height,
+                 YuvColorSpace color_space, RgbOrder order);
+
+/**
+ * Same as [I420ToRGB32], for an interleaved UV plane.
+ */
+void NV12ToRGB32(const uint8 *y, int y_stride,
+                 const uint8 *uv, int uv_stride,
+                 uint8 *dest, int dest_stride,
+                 int width, int height,
+                 YuvColorSpace color_space, RgbOrder order);
+
+} // namespace yuv_convert
+} // namespace media
+
+#endif //MEDIA_PLAYER_SRC_YUV_CONVERT_H_
@@ -0,0 +1,142 @@
+//
+// Created by yangbin on 2021/8/6.
+//
+
+#include "allocation_counter.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include "base/logging.h"
+
+namespace media {
+
+namespace {
+
+// Trivially constructed, so reading them never allocates.
+thread_local int counting_depth = 0;
+thread_local int64 allocation_count = 0;
+thread_local int64 free_count = 0;
+
+void CountAllocation() {
+  if (counting_depth > 0) {
+    allocation_count++;
+  }
+}
+
+void CountFree(void *p) {
+  if (p && counting_depth > 0) {
+    free_count++;
+  }
+}
+
+} // namespace
+
+ScopedAllocationCounter::ScopedAllocationCounter()
+    : allocations_start_(allocation_count), frees_start_(free_count) {
+  counting_depth++;
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter() {
+  DCHECK_GT(counting_depth, 0);
+  counting_depth--;
+}
+
+int64 ScopedAllocationCounter::allocations() const {
+  return allocation_count - allocations_start_;
+}
+
+int64 ScopedAllocationCounter::frees() const {
+  return free_count - frees_start_;
+}
+
+} // namespace media
+
+#if defined(__GLIBC__)
+
+// Replaces the malloc family of glibc, so that C allocations such as FFmpeg's
+// av_malloc, which uses posix_memalign, are counted too. Operator new calls
+// malloc, it is counted there.
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+
+void *malloc(size_t size) {
+  media::CountAllocation();
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  media::CountAllocation();
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+  media::CountAllocation();
+  return __libc_realloc(p, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  media::CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void **p, size_t alignment, size_t size) {
+  if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  *p = memalign(alignment, size);
+  return *p ? 0 : ENOMEM;
+}
+
+void free(void *p) {
+  media::CountFree(p);
+  __libc_free(p);
+}
+
+} // extern "C"
+
+#endif
+
+void *operator new(std::size_t size) {
+#if !defined(__GLIBC__)
+  media::CountAllocation();
+#endif
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+#if !defined(__GLIBC__)
+  media::CountFree(p);
+#endif
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  operator delete(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+  operator delete(p);
+}
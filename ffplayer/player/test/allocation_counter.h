@@ -0,0 +1,44 @@
+//
+// Created by yangbin on 2021/8/6.
+//
+
+#ifndef MEDIA_PLAYER_TEST_ALLOCATION_COUNTER_H_
+#define MEDIA_PLAYER_TEST_ALLOCATION_COUNTER_H_
+
+#include "base/basictypes.h"
+
+namespace media {
+
+/**
+ * Counts the heap allocations and frees made by the current thread while it
+ * is alive. On glibc every malloc family call is counted, including FFmpeg's
+ * av_malloc. Elsewhere only the global operator new and delete of
+ * media_player_test are.
+ *
+ * Allocations of other threads, and of this thread outside of a counter, are
+ * not counted.
+ */
+class ScopedAllocationCounter {
+
+ public:
+
+  ScopedAllocationCounter();
+
+  ~ScopedAllocationCounter();
+
+  int64 allocations() const;
+
+  int64 frees() const;
+
+ private:
+
+  int64 allocations_start_;
+  int64 frees_start_;
+
+  DELETE_COPY_AND_ASSIGN(ScopedAllocationCounter);
+
+};
+
+} // namespace media
+
+#endif //MEDIA_PLAYER_TEST_ALLOCATION_COUNTER_H_
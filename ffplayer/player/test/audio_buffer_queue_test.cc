@@ -0,0 +1,149 @@
+//
+// Created by yangbin on 2021/7/20.
+//
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "audio_buffer_queue.h"
+
+using namespace media;
+
+namespace {
+
+std::shared_ptr<AudioBuffer> CreateBuffer(AudioBufferPool *pool, int size, uint8 value) {
+  auto buffer = pool->Acquire(size);
+  memset(buffer->writable_data(), value, size);
+  buffer->Prepare(size, 0);
+  return buffer;
+}
+
+}
+
+TEST(AudioBufferQueue, FlushDropsQueuedBuffers) {
+  AudioBufferPool pool(48000 * 4);
+  AudioBufferQueue queue(8);
+
+  queue.Push(CreateBuffer(&pool, 16, 1));
+  queue.Push(CreateBuffer(&pool, 16, 1));
+  EXPECT_EQ(queue.size(), 2);
+
+  queue.Flush();
+  EXPECT_EQ(queue.size(), 0);
+  EXPECT_FALSE(queue.IsFull());
+
+  queue.Push(CreateBuffer(&pool, 16, 2));
+  EXPECT_EQ(queue.size(), 1);
+
+  auto *buffer = queue.Front();
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(buffer->writable_data()[0], 2);
+  queue.Pop();
+  EXPECT_EQ(queue.Front(), nullptr);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(AudioBufferQueue, FlushPartiallyReadBuffer) {
+  AudioBufferPool pool(48000 * 4);
+  AudioBufferQueue queue(4);
+  vector_math::GainRamp volume;
+  uint8 out[8];
+
+  queue.Push(CreateBuffer(&pool, 16, 1));
+  queue.Front()->Read(out, sizeof(out), &volume);
+
+  queue.Flush();
+  EXPECT_EQ(queue.Front(), nullptr);
+}
+
+// Runs the audio callback against a decoder side which pushes and flushes
+// concurrently. Callbacks are paced by a counter instead of the wall clock, the
+// test checks what the callback reads, not how long it takes.
+TEST(AudioBufferQueue, ConcurrentPushFlushAndRead) {
+  const int kCallbacks = 20000;
+  const int kBufferSize = 256;
+
+  AudioBufferPool pool(48000 * 4);
+  AudioBufferQueue queue(8);
+  std::atomic_bool running(true);
+  // Sequence number of the first buffer pushed after the last flush.
+  std::atomic_int first_unflushed(0);
+  std::atomic_int flushes(0);
+
+  std::thread decoder([&]() {
+    int pushed = 0;
+    while (running) {
+      if (queue.size() >= 3 || queue.IsFull()) {
+        std::this_thread::yield();
+        continue;
+      }
+      auto buffer = pool.Acquire(kBufferSize);
+      memset(buffer->writable_data(), uint8(pushed), kBufferSize);
+      buffer->Prepare(kBufferSize, pushed);
+      queue.Push(std::move(buffer));
+      // Seek now and then.
+      if (++pushed % 50 == 0) {
+        queue.Flush();
+        first_unflushed.store(pushed, std::memory_order_release);
+        flushes++;
+      }
+    }
+  });
+
+  int underruns = 0;
+  int buffers_read = 0;
+  int flushed_reads = 0;
+  int out_of_order_reads = 0;
+  int corrupt_reads = 0;
+  double last_pts = -1;
+  vector_math::GainRamp volume;
+  std::vector<uint8> stream(200);
+  for (int i = 0; i < kCallbacks; ++i) {
+    int len = 0;
+    while (len < static_cast<int>(stream.size())) {
+      auto flushed_before = first_unflushed.load(std::memory_order_acquire);
+      auto *buffer = queue.Front();
+      if (!buffer) {
+        underruns++;
+        break;
+      }
+      // A flush which is visible has dropped every buffer pushed before it.
+      if (buffer->pts() < flushed_before) {
+        flushed_reads++;
+      }
+      // Buffers come out in push order, each one once.
+      if (buffer->pts() < last_pts) {
+        out_of_order_reads++;
+      }
+      auto *data = stream.data() + len;
+      auto read = buffer->Read(data, static_cast<int>(stream.size()) - len, &volume);
+      if (data[0] != uint8(buffer->pts())) {
+        corrupt_reads++;
+      }
+      len += read;
+      if (buffer->IsConsumed()) {
+        last_pts = buffer->pts() + 0.5;
+        buffers_read++;
+        queue.Pop();
+      }
+    }
+    if (len == 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  running = false;
+  decoder.join();
+
+  EXPECT_EQ(flushed_reads, 0);
+  EXPECT_EQ(out_of_order_reads, 0);
+  EXPECT_EQ(corrupt_reads, 0);
+  EXPECT_GT(buffers_read, 0);
+  EXPECT_GT(flushes, 0);
+  EXPECT_LT(underruns, kCallbacks);
+  EXPECT_LE(pool.size(), 12u);
+}
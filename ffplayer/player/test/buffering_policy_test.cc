@@ -0,0 +1,59 @@
+//
+// Created by yangbin on 2021/7/21.
+//
+
+#include "gtest/gtest.h"
+
+#include "buffering_policy.h"
+
+using namespace media;
+
+TEST(BufferingPolicy, DefaultsForZeroConfiguration) {
+  PlayerConfiguration configuration;
+  auto policy = BufferingPolicy::FromConfiguration(configuration);
+  BufferingPolicy defaults;
+
+  EXPECT_DOUBLE_EQ(policy.min_buffer_seconds, defaults.min_buffer_seconds);
+  EXPECT_DOUBLE_EQ(policy.max_buffer_seconds, defaults.max_buffer_seconds);
+  EXPECT_EQ(policy.max_buffer_bytes, defaults.max_buffer_bytes);
+  EXPECT_DOUBLE_EQ(policy.startup_buffer_seconds, defaults.startup_buffer_seconds);
+  EXPECT_DOUBLE_EQ(policy.rebuffer_seconds, defaults.rebuffer_seconds);
+  EXPECT_EQ(policy.max_decoded_video_frames, defaults.max_decoded_video_frames);
+  EXPECT_EQ(policy.max_decoded_audio_buffers, defaults.max_decoded_audio_buffers);
+  EXPECT_EQ(policy.max_decoder_outputs, defaults.max_decoder_outputs);
+}
+
+TEST(BufferingPolicy, ConfigurationOverridesDefaults) {
+  PlayerConfiguration configuration;
+  configuration.min_buffer_seconds = 10;
+  configuration.max_buffer_seconds = 30;
+  configuration.max_buffer_bytes = 64 * 1024 * 1024;
+  configuration.startup_buffer_seconds = 1;
+  configuration.rebuffer_seconds = 5;
+  configuration.max_decoded_video_frames = 6;
+  configuration.max_decoded_audio_buffers = 4;
+  configuration.max_decoder_outputs = 12;
+  auto policy = BufferingPolicy::FromConfiguration(configuration);
+
+  EXPECT_DOUBLE_EQ(policy.min_buffer_seconds, 10);
+  EXPECT_DOUBLE_EQ(policy.max_buffer_seconds, 30);
+  EXPECT_EQ(policy.max_buffer_bytes, 64 * 1024 * 1024);
+  EXPECT_DOUBLE_EQ(policy.startup_buffer_seconds, 1);
+  EXPECT_DOUBLE_EQ(policy.rebuffer_seconds, 5);
+  EXPECT_EQ(policy.max_decoded_video_frames, 6);
+  EXPECT_EQ(policy.max_decoded_audio_buffers, 4);
+  EXPECT_EQ(policy.max_decoder_outputs, 12);
+}
+
+TEST(BufferingPolicy, ThresholdsClampedToMaxBuffer) {
+  PlayerConfiguration configuration;
+  configuration.min_buffer_seconds = 8;
+  configuration.max_buffer_seconds = 1;
+  configuration.startup_buffer_seconds = 20;
+  configuration.rebuffer_seconds = 20;
+  auto policy = BufferingPolicy::FromConfiguration(configuration);
+
+  EXPECT_DOUBLE_EQ(policy.max_buffer_seconds, 8);
+  EXPECT_DOUBLE_EQ(policy.startup_buffer_seconds, 8);
+  EXPECT_DOUBLE_EQ(policy.rebuffer_seconds, 8);
+}
@@ -0,0 +1,168 @@
+//
+// Created by yangbin on 2021/7/23.
+//
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caching_data_source.h"
+
+using namespace media;
+
+namespace {
+
+// In memory DataSource which counts the reads it serves.
+class MemoryDataSource : public DataSource {
+
+ public:
+
+  explicit MemoryDataSource(size_t size) : data_(size), reads_(0), fail_reads_(false), stopped_(false) {
+    for (size_t i = 0; i < size; ++i) {
+      data_[i] = static_cast<uint8_t>(i * 7 + (i >> 16));
+    }
+  }
+
+  void Read(int64_t position, int size, uint8_t *data, DataSource::ReadCB read_cb) override {
+    reads_++;
+    if (fail_reads_ || stopped_) {
+      read_cb(kReadError);
+      return;
+    }
+    position = std::min<int64_t>(position, data_.size());
+    auto count = std::min<int64_t>(size, data_.size() - position);
+    memcpy(data, data_.data() + position, static_cast<size_t>(count));
+    read_cb(static_cast<int>(count));
+  }
+
+  void Stop() override { stopped_ = true; }
+  void Abort() override {}
+
+  bool GetSize(int64_t *size_out) override {
+    *size_out = data_.size();
+    return true;
+  }
+
+  bool IsStreaming() override { return false; }
+  void SetBitrate(int) override {}
+
+  const std::vector<uint8_t> &data() const { return data_; }
+
+  std::vector<uint8_t> data_;
+  std::atomic_int reads_;
+  std::atomic_bool fail_reads_;
+  std::atomic_bool stopped_;
+
+};
+
+const int kPageSize = 4096;
+
+int ReadSync(DataSource *source, int64_t position, int size, uint8_t *data) {
+  int result = 0;
+  source->Read(position, size, data, [&](int read) {
+    result = read;
+  });
+  return result;
+}
+
+}
+
+TEST(CachingDataSourceTest, RandomReadsMatchSource) {
+  auto inner = std::make_unique<MemoryDataSource>(1024 * 1024 + 17);
+  auto *memory = inner.get();
+  CachingDataSource source(std::move(inner), kPageSize, 32);
+
+  int64_t size;
+  ASSERT_TRUE(source.GetSize(&size));
+  EXPECT_EQ(size, 1024 * 1024 + 17);
+
+  std::mt19937 random(42);
+  std::vector<uint8_t> buffer(3 * kPageSize);
+  for (int i = 0; i < 500; ++i) {
+    int64_t position = random() % size;
+    int length = 1 + random() % buffer.size();
+    auto expected = std::min<int64_t>(length, size - position);
+    ASSERT_EQ(ReadSync(&source, position, length, buffer.data()), expected);
+    ASSERT_EQ(0, memcmp(buffer.data(), memory->data().data() + position, expected)) << position;
+  }
+  EXPECT_EQ(ReadSync(&source, size, 16, buffer.data()), 0);
+  // Bounded by the page limit.
+  EXPECT_LE(source.cached_pages_for_testing(), 32u);
+}
+
+TEST(CachingDataSourceTest, SequentialReadsHitPrefetchedPages) {
+  auto inner = std::make_unique<MemoryDataSource>(4 * 1024 * 1024);
+  CachingDataSource source(std::move(inner), kPageSize, 256);
+  // 1 Mbps, ten seconds of read ahead fill most of the cache.
+  source.SetBitrate(1000000);
+
+  std::vector<uint8_t> buffer(32 * 1024);
+  ASSERT_EQ(ReadSync(&source, 0, buffer.size(), buffer.data()), static_cast<int>(buffer.size()));
+  source.WaitForPrefetchForTesting();
+
+  auto misses = source.cache_misses_for_testing();
+  for (int64_t position = buffer.size(); position < 512 * 1024; position += buffer.size()) {
+    ASSERT_EQ(ReadSync(&source, position, buffer.size(), buffer.data()), static_cast<int>(buffer.size()));
+  }
+  EXPECT_EQ(source.cache_misses_for_testing(), misses);
+}
+
+TEST(CachingDataSourceTest, TailCachedWithoutReaderRequest) {
+  const int64_t kSize = 8 * 1024 * 1024;
+  auto inner = std::make_unique<MemoryDataSource>(kSize);
+  auto *memory = inner.get();
+  CachingDataSource source(std::move(inner), kPageSize, 1024);
+  source.WaitForPrefetchForTesting();
+
+  // A moov box at the end of the file is read while opening.
+  auto reads = memory->reads_.load();
+  std::vector<uint8_t> buffer(512 * 1024);
+  auto position = kSize - buffer.size();
+  ASSERT_EQ(ReadSync(&source, position, buffer.size(), buffer.data()), static_cast<int>(buffer.size()));
+  EXPECT_EQ(0, memcmp(buffer.data(), memory->data().data() + position, buffer.size()));
+  EXPECT_EQ(memory->reads_.load(), reads);
+}
+
+TEST(CachingDataSourceTest, TailPagesSurviveEviction) {
+  const int64_t kSize = 4 * 1024 * 1024;
+  auto inner = std::make_unique<MemoryDataSource>(kSize);
+  auto *memory = inner.get();
+  CachingDataSource source(std::move(inner), kPageSize, 64);
+  source.WaitForPrefetchForTesting();
+
+  // Stream through far more than the cache holds.
+  std::vector<uint8_t> buffer(32 * 1024);
+  for (int64_t position = 0; position < 3 * 1024 * 1024; position += buffer.size()) {
+    ASSERT_EQ(ReadSync(&source, position, buffer.size(), buffer.data()), static_cast<int>(buffer.size()));
+  }
+  source.WaitForPrefetchForTesting();
+  EXPECT_LE(source.cached_pages_for_testing(), 64u);
+
+  auto reads = memory->reads_.load();
+  ASSERT_EQ(ReadSync(&source, kSize - kPageSize, kPageSize, buffer.data()), kPageSize);
+  EXPECT_EQ(memory->reads_.load(), reads);
+}
+
+TEST(CachingDataSourceTest, ReadErrorIsReported) {
+  auto inner = std::make_unique<MemoryDataSource>(1024 * 1024);
+  auto *memory = inner.get();
+  memory->fail_reads_ = true;
+  CachingDataSource source(std::move(inner), kPageSize, 32);
+
+  uint8_t buffer[16];
+  EXPECT_EQ(ReadSync(&source, 0, sizeof(buffer), buffer), DataSource::kReadError);
+
+  memory->fail_reads_ = false;
+  EXPECT_EQ(ReadSync(&source, 0, sizeof(buffer), buffer), static_cast<int>(sizeof(buffer)));
+}
+
+TEST(CachingDataSourceTest, ReadFailsAfterStop) {
+  CachingDataSource source(std::make_unique<MemoryDataSource>(1024 * 1024), kPageSize, 32);
+  source.Stop();
+
+  uint8_t buffer[16];
+  EXPECT_EQ(ReadSync(&source, 0, sizeof(buffer), buffer), DataSource::kReadError);
+}
@@ -0,0 +1,82 @@
+//
+// Created by yangbin on 2021/8/5.
+//
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "decoder_buffer.h"
+#include "decoder_buffer_queue.h"
+
+using namespace media;
+
+namespace {
+
+std::shared_ptr<DecoderBuffer> CreateBuffer(double timestamp, int size) {
+  std::unique_ptr<AVPacket, AVPacketDeleter> packet(av_packet_alloc());
+  av_new_packet(packet.get(), size);
+  auto buffer = std::make_shared<DecoderBuffer>(packet.get());
+  buffer->set_timestamp(timestamp);
+  return buffer;
+}
+
+} // namespace
+
+TEST(DecoderBuffer, TakesPacketReference) {
+  std::unique_ptr<AVPacket, AVPacketDeleter> packet(av_packet_alloc());
+  av_new_packet(packet.get(), 16);
+  auto *data = packet->data;
+
+  DecoderBuffer buffer(packet.get());
+  EXPECT_EQ(packet->data, nullptr);
+  EXPECT_EQ(packet->buf, nullptr);
+  EXPECT_EQ(buffer.av_packet()->data, data);
+  EXPECT_EQ(buffer.data_size(), 16u);
+  EXPECT_EQ(av_buffer_get_ref_count(buffer.av_packet()->buf), 1);
+
+  DecoderBuffer moved(std::move(buffer));
+  EXPECT_TRUE(buffer.end_of_stream());
+  EXPECT_EQ(moved.av_packet()->data, data);
+
+  EXPECT_TRUE(DecoderBuffer::CreateEOSBuffer()->end_of_stream());
+  EXPECT_EQ(DecoderBuffer::CreateEOSBuffer()->av_packet(), nullptr);
+}
+
+TEST(DecoderBufferQueue, DurationSkipsOutOfOrderBuffers) {
+  DecoderBufferQueue queue;
+  // I P B B P, in decode order.
+  queue.Push(CreateBuffer(0, 10));
+  queue.Push(CreateBuffer(0.12, 10));
+  queue.Push(CreateBuffer(0.04, 10));
+  queue.Push(CreateBuffer(0.08, 10));
+  queue.Push(CreateBuffer(0.24, 10));
+  EXPECT_EQ(queue.data_size(), 50u);
+  EXPECT_DOUBLE_EQ(queue.Duration(), 0.24);
+
+  EXPECT_DOUBLE_EQ(queue.Pop()->timestamp(), 0);
+  EXPECT_DOUBLE_EQ(queue.Duration(), 0.12);
+  // The next in order buffer is after the B-frames.
+  EXPECT_DOUBLE_EQ(queue.Pop()->timestamp(), 0.12);
+  EXPECT_DOUBLE_EQ(queue.Duration(), 0);
+  queue.Pop();
+  queue.Pop();
+  EXPECT_EQ(queue.data_size(), 10u);
+  EXPECT_DOUBLE_EQ(queue.Pop()->timestamp(), 0.24);
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_EQ(queue.data_size(), 0u);
+}
+
+TEST(DecoderBufferQueue, Clear) {
+  DecoderBufferQueue queue;
+  queue.Push(CreateBuffer(1, 10));
+  queue.Push(CreateBuffer(2, 10));
+  queue.Clear();
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_DOUBLE_EQ(queue.Duration(), 0);
+
+  // Timestamps before the cleared ones are in order again, e.g. after a seek.
+  queue.Push(CreateBuffer(0, 10));
+  queue.Push(CreateBuffer(0.5, 10));
+  EXPECT_DOUBLE_EQ(queue.Duration(), 0.5);
+}
@@ -0,0 +1,85 @@
+//
+// Created by yangbin on 2021/7/28.
+//
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ffmpeg_deleters.h"
+#include "frame_converter.h"
+
+extern "C" {
+#include "libavutil/imgutils.h"
+}
+
+using namespace media;
+
+namespace {
+
+std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> CreateFrame(int width, int height, AVPixelFormat format) {
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->width = width;
+  frame->height = height;
+  frame->format = format;
+  av_frame_get_buffer(frame.get(), 0);
+  for (int i = 0; i < 4 && frame->buf[i]; ++i) {
+    for (int j = 0; j < frame->buf[i]->size; ++j) {
+      frame->buf[i]->data[j] = uint8_t((j * 13 + i * 71) ^ (j >> 7));
+    }
+  }
+  return frame;
+}
+
+std::vector<uint8_t> Convert(FrameConverter *converter, const AVFrame *frame, AVPixelFormat format,
+                             int width, int height) {
+  std::vector<uint8_t> buffer(size_t(av_image_get_buffer_size(format, width, height, 1)));
+  uint8_t *data[4];
+  int linesize[4];
+  av_image_fill_arrays(data, linesize, buffer.data(), format, width, height, 1);
+  EXPECT_EQ(converter->Convert(frame, format, width, height, data, linesize), 0);
+  return buffer;
+}
+
+}
+
+// A frame converted in slices on several threads is the same as converted
+// at once on one thread.
+TEST(FrameConverterTest, SlicesMatchSingleThread) {
+  // Odd height, the last slice is shorter.
+  const int kWidth = 640, kHeight = 362;
+  for (auto format : {AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12, AV_PIX_FMT_YUV422P, AV_PIX_FMT_RGB24}) {
+    auto frame = CreateFrame(kWidth, kHeight, format);
+    for (bool use_yuv_kernels : {true, false}) {
+      FrameConverter single(1, use_yuv_kernels);
+      FrameConverter sliced(4, use_yuv_kernels);
+      SCOPED_TRACE(testing::Message() << av_get_pix_fmt_name(format) << " kernels " << use_yuv_kernels);
+      auto expected = Convert(&single, frame.get(), AV_PIX_FMT_BGRA, kWidth, kHeight);
+      // The cached contexts are reused by the second frame.
+      for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(Convert(&sliced, frame.get(), AV_PIX_FMT_BGRA, kWidth, kHeight), expected);
+      }
+    }
+  }
+}
+
+TEST(FrameConverterTest, ScalesWithSwscale) {
+  auto frame = CreateFrame(640, 360, AV_PIX_FMT_YUV420P);
+  FrameConverter converter;
+  auto scaled = Convert(&converter, frame.get(), AV_PIX_FMT_RGBA, 320, 180);
+  EXPECT_EQ(scaled.size(), 320u * 180 * 4);
+  // Then back to the same size, with the kernel.
+  auto unscaled = Convert(&converter, frame.get(), AV_PIX_FMT_RGBA, 640, 360);
+  EXPECT_EQ(unscaled.size(), 640u * 360 * 4);
+}
+
+// Scaling filters read rows of the neighbouring slices, a frame scaled only
+// horizontally must not be sliced.
+TEST(FrameConverterTest, HorizontalScaleMatchesSingleThread) {
+  auto frame = CreateFrame(640, 362, AV_PIX_FMT_YUV420P);
+  FrameConverter single(1);
+  FrameConverter sliced(4);
+  auto expected = Convert(&single, frame.get(), AV_PIX_FMT_BGRA, 480, 362);
+  EXPECT_EQ(Convert(&sliced, frame.get(), AV_PIX_FMT_BGRA, 480, 362), expected);
+}
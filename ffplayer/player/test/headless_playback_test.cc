@@ -0,0 +1,223 @@
+//
+// Created by yangbin on 2021/7/31.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "base/message_loop.h"
+#include "base/task_runner.h"
+
+#include "ffplayer.h"
+#include "media_player.h"
+#include "null_audio_renderer_sink.h"
+#include "null_video_renderer_sink.h"
+#include "time_source.h"
+
+extern "C" {
+#include "libavformat/avformat.h"
+#include "libavutil/channel_layout.h"
+}
+
+using namespace media;
+
+namespace {
+
+const int kWidth = 64;
+const int kHeight = 36;
+const int kFrameRate = 25;
+const int kSampleRate = 8000;
+// 40 ms of audio per packet.
+const int kSamplesPerPacket = 320;
+
+// Steps of the time source, the audio sink pulls a buffer at each one.
+const int kStepMilliseconds = 10;
+const int kAudioFramesPerBuffer = kSampleRate * kStepMilliseconds / 1000;
+
+AVStream *AddStream(AVFormatContext *context, AVMediaType type, AVCodecID codec_id, AVRational time_base) {
+  auto *stream = avformat_new_stream(context, nullptr);
+  if (!stream) {
+    return nullptr;
+  }
+  stream->time_base = time_base;
+  stream->codecpar->codec_type = type;
+  stream->codecpar->codec_id = codec_id;
+  return stream;
+}
+
+bool WritePacket(AVFormatContext *context, AVStream *stream, AVRational time_base,
+                 int64_t pts, int64_t duration, int size, uint8_t value) {
+  auto *packet = av_packet_alloc();
+  if (!packet || av_new_packet(packet, size) < 0) {
+    av_packet_free(&packet);
+    return false;
+  }
+  memset(packet->data, value, static_cast<size_t>(size));
+  packet->stream_index = stream->index;
+  packet->pts = pts;
+  packet->dts = pts;
+  packet->duration = duration;
+  packet->flags |= AV_PKT_FLAG_KEY;
+  av_packet_rescale_ts(packet, time_base, stream->time_base);
+  auto ret = av_interleaved_write_frame(context, packet);
+  av_packet_free(&packet);
+  return ret >= 0;
+}
+
+// Writes |seconds| of raw I420 video and 16 bit mono PCM to |path|, both
+// decoded by FFmpeg without any external codec.
+bool WriteMediaFile(const std::string &path, int seconds) {
+  AVFormatContext *context = nullptr;
+  if (avformat_alloc_output_context2(&context, nullptr, "nut", path.c_str()) < 0) {
+    return false;
+  }
+  const AVRational video_time_base{1, kFrameRate};
+  const AVRational audio_time_base{1, kSampleRate};
+  auto *video = AddStream(context, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_RAWVIDEO, video_time_base);
+  auto *audio = AddStream(context, AVMEDIA_TYPE_AUDIO, AV_CODEC_ID_PCM_S16LE, audio_time_base);
+  bool success = video && audio;
+  if (success) {
+    video->codecpar->format = AV_PIX_FMT_YUV420P;
+    video->codecpar->width = kWidth;
+    video->codecpar->height = kHeight;
+    audio->codecpar->format = AV_SAMPLE_FMT_S16;
+    audio->codecpar->sample_rate = kSampleRate;
+    audio->codecpar->channels = 1;
+    audio->codecpar->channel_layout = AV_CH_LAYOUT_MONO;
+    audio->codecpar->bits_per_coded_sample = 16;
+    audio->codecpar->block_align = 2;
+    success = avio_open(&context->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0;
+  }
+  if (success) {
+    success = avformat_write_header(context, nullptr) >= 0;
+    const int frame_size = kWidth * kHeight * 3 / 2;
+    int64_t frame = 0, samples = 0;
+    while (success && frame < seconds * kFrameRate) {
+      // In order of time, the muxer interleaves them.
+      if (samples * kFrameRate < frame * kSampleRate) {
+        success = WritePacket(context, audio, audio_time_base, samples, kSamplesPerPacket,
+                              kSamplesPerPacket * 2, 0);
+        samples += kSamplesPerPacket;
+      } else {
+        success = WritePacket(context, video, video_time_base, frame, 1, frame_size, uint8_t(frame));
+        frame++;
+      }
+    }
+    success = av_write_trailer(context) >= 0 && success;
+    avio_closep(&context->pb);
+  }
+  avformat_free_context(context);
+  return success;
+}
+
+template<typename Predicate>
+bool WaitFor(Predicate predicate) {
+  for (int i = 0; i < 5000 && !predicate(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return predicate();
+}
+
+}
+
+class HeadlessPlaybackTest : public testing::Test {
+
+ protected:
+
+  std::string path_;
+  std::shared_ptr<ManualTimeSource> time_source_;
+  NullVideoRendererSink *video_sink_ = nullptr;
+  std::shared_ptr<NullAudioRendererSink> audio_sink_;
+  std::shared_ptr<MediaPlayer> player_;
+
+  void SetUp() override {
+    MediaPlayer::GlobalInit();
+    path_ = testing::TempDir() + "headless_playback.nut";
+    ASSERT_TRUE(WriteMediaFile(path_, 3));
+
+    time_source_ = std::make_shared<ManualTimeSource>();
+    auto video_sink = std::make_unique<NullVideoRendererSink>(time_source_);
+    video_sink_ = video_sink.get();
+    audio_sink_ = std::make_shared<NullAudioRendererSink>(1.0, kAudioFramesPerBuffer, time_source_);
+    player_ = std::make_shared<MediaPlayer>(std::move(video_sink), audio_sink_,
+                                            TaskRunner(MessageLooper::PrepareLooper("headless_playback")));
+    ASSERT_EQ(player_->SetTimeSource(time_source_), 0);
+  }
+
+  void TearDown() override {
+    if (player_) {
+      player_->SetPlayWhenReady(false);
+    }
+    remove(path_.c_str());
+  }
+
+  // Both sinks presented everything due at the current time.
+  bool CaughtUp() {
+    auto now = time_source_->Now();
+    return audio_sink_->next_pull_time() > now && video_sink_->next_render_time() > now;
+  }
+
+  // The decoders are at least |seconds| ahead of the current time, or done.
+  bool DecodedAhead(double seconds) {
+    int64_t stats[kStatCount];
+    player_->GetStats(stats, kStatCount);
+    auto until = time_source_->Now() + seconds;
+    auto total_frames = 3 * kFrameRate;
+    auto total_buffers = 3 * kSampleRate / kSamplesPerPacket;
+    return (stats[kStatVideoFramesDecoded] >= total_frames
+        || stats[kStatVideoFramesDecoded] > until * kFrameRate)
+        && (stats[kStatAudioBuffersDecoded] >= total_buffers
+            || stats[kStatAudioBuffersDecoded] * kSamplesPerPacket > until * kSampleRate);
+  }
+
+  // Step the time source by kStepMilliseconds up to |seconds|, each step once
+  // the pipeline is ready for it, so that a slow machine runs the same
+  // playback as a fast one.
+  void PlayUntil(double seconds) {
+    for (int step = 1; step <= seconds * 1000 / kStepMilliseconds; ++step) {
+      ASSERT_TRUE(WaitFor([&]() { return CaughtUp() && DecodedAhead(0.1); })) << "stalled at step " << step;
+      time_source_->SetNow(step * kStepMilliseconds / 1000.0);
+    }
+    ASSERT_TRUE(WaitFor([&]() { return CaughtUp(); }));
+  }
+
+};
+
+TEST_F(HeadlessPlaybackTest, KeepsAudioAndVideoInSync) {
+  player_->SetPlayWhenReady(true);
+  ASSERT_EQ(player_->OpenDataSource(path_.c_str()), 0);
+  // The renderers read the time source without a lock.
+  EXPECT_EQ(player_->SetTimeSource(std::make_shared<ManualTimeSource>()), -1);
+  // The sinks start at time 0, the first step waits for them.
+  PlayUntil(2);
+
+  auto presented = video_sink_->presented_frames();
+  // A frame every 40 ms, each one once, in order.
+  ASSERT_GE(presented.size(), 2u * kFrameRate - 1);
+  ASSERT_LE(presented.size(), 2u * kFrameRate + 1);
+  for (size_t i = 1; i < presented.size(); ++i) {
+    EXPECT_NEAR(presented[i].pts - presented[i - 1].pts, 1.0 / kFrameRate, 1e-6) << "frame " << i;
+  }
+  // Each frame is shown a fixed time after its pts, within a step of the time
+  // source. The offset is the start of the audio.
+  auto offset = presented[0].presented_at / 1000000.0 - presented[0].pts;
+  for (auto &frame : presented) {
+    EXPECT_NEAR(frame.presented_at / 1000000.0 - frame.pts, offset, kStepMilliseconds / 1000.0)
+              << "pts " << frame.pts;
+  }
+
+  int64_t stats[kStatCount];
+  player_->GetStats(stats, kStatCount);
+  EXPECT_EQ(player_->GetDroppedFrameCount(), 0);
+  // Max of |video pts - audio clock| when a frame is rendered, in
+  // microseconds, under half a frame.
+  EXPECT_LE(stats[kStatAVDriftAbs + 4], 1000000 / kFrameRate / 2);
+  // Only the pull made as soon as playback started may find no data.
+  EXPECT_LE(audio_sink_->underrun_frames(), kAudioFramesPerBuffer);
+}
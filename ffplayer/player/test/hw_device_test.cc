@@ -0,0 +1,152 @@
+//
+// Created by yangbin on 2021/7/26.
+//
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "decoder_buffer.h"
+#include "ffmpeg_deleters.h"
+#include "hw_device.h"
+#include "video_decoder.h"
+
+using namespace media;
+
+namespace {
+
+// Hardware device types |codec| can decode with.
+std::vector<AVHWDeviceType> SupportedTypes(const AVCodec *codec) {
+  std::vector<AVHWDeviceType> types;
+  for (int i = 0;; i++) {
+    auto *config = avcodec_get_hw_config(codec, i);
+    if (!config) {
+      break;
+    }
+    if (config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) {
+      types.push_back(config->device_type);
+    }
+  }
+  return types;
+}
+
+// A few small MPEG-4 frames, the first one a keyframe.
+bool EncodeFrames(int count, AVCodecParameters *parameters, std::vector<std::shared_ptr<DecoderBuffer>> *buffers) {
+  auto *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+  if (!codec) {
+    return false;
+  }
+  std::unique_ptr<AVCodecContext, AVCodecContextDeleter> encoder(avcodec_alloc_context3(codec));
+  encoder->width = 64;
+  encoder->height = 64;
+  encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+  encoder->time_base = AVRational{1, 25};
+  if (avcodec_open2(encoder.get(), codec, nullptr) < 0) {
+    return false;
+  }
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->format = encoder->pix_fmt;
+  frame->width = encoder->width;
+  frame->height = encoder->height;
+  av_frame_get_buffer(frame.get(), 0);
+
+  auto drain = [&]() {
+    std::unique_ptr<AVPacket, AVPacketDeleter> packet(av_packet_alloc());
+    while (avcodec_receive_packet(encoder.get(), packet.get()) >= 0) {
+      buffers->emplace_back(std::make_shared<DecoderBuffer>(packet.get()));
+    }
+  };
+  for (int i = 0; i < count; ++i) {
+    av_frame_make_writable(frame.get());
+    for (int plane = 0; plane < 3; ++plane) {
+      auto height = plane == 0 ? frame->height : frame->height / 2;
+      memset(frame->data[plane], 16 * i + plane, frame->linesize[plane] * height);
+    }
+    frame->pts = i;
+    avcodec_send_frame(encoder.get(), frame.get());
+    drain();
+  }
+  avcodec_send_frame(encoder.get(), nullptr);
+  drain();
+  avcodec_parameters_from_context(parameters, encoder.get());
+  return !buffers->empty();
+}
+
+}
+
+TEST(HwDeviceTest, ParseSkipsUnknownNames) {
+  auto types = ParseHwDeviceTypes("vaapi,no_such_device,,cuda");
+  ASSERT_EQ(types.size(), 2u);
+  EXPECT_EQ(types[0], AV_HWDEVICE_TYPE_VAAPI);
+  EXPECT_EQ(types[1], AV_HWDEVICE_TYPE_CUDA);
+  EXPECT_TRUE(ParseHwDeviceTypes("").empty());
+}
+
+TEST(HwDeviceTest, NoDeviceFallsBackToSoftware) {
+  auto *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+  ASSERT_TRUE(codec);
+  int attempts = 0;
+  AVPixelFormat format = AV_PIX_FMT_YUV420P;
+  auto *device = CreateHwDevice(codec, DefaultHwDeviceTypes(), &format, [&](AVBufferRef **, AVHWDeviceType) {
+    attempts++;
+    return AVERROR(ENODEV);
+  });
+  EXPECT_EQ(device, nullptr);
+  EXPECT_EQ(format, AV_PIX_FMT_NONE);
+  // Only the types the codec supports are tried.
+  EXPECT_LE(attempts, static_cast<int>(SupportedTypes(codec).size()));
+}
+
+TEST(HwDeviceTest, TriesTypesInOrder) {
+  auto *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+  ASSERT_TRUE(codec);
+  auto types = SupportedTypes(codec);
+  if (types.size() < 2) {
+    GTEST_SKIP() << "FFmpeg is built with less than two hardware decoders for h264";
+  }
+
+  std::vector<AVHWDeviceType> attempted;
+  AVPixelFormat format = AV_PIX_FMT_NONE;
+  auto *device = CreateHwDevice(codec, types, &format, [&](AVBufferRef **device, AVHWDeviceType type) {
+    attempted.push_back(type);
+    if (attempted.size() == 1) {
+      return AVERROR(ENODEV);
+    }
+    // Stands in for a device, it is only released.
+    *device = av_buffer_alloc(1);
+    return 0;
+  });
+  ASSERT_NE(device, nullptr);
+  ASSERT_EQ(attempted.size(), 2u);
+  EXPECT_EQ(attempted[1], types[1]);
+  EXPECT_NE(format, AV_PIX_FMT_NONE);
+  av_buffer_unref(&device);
+}
+
+TEST(HwDeviceTest, DecoderDecodesWithoutHardware) {
+  std::unique_ptr<AVCodecParameters, void (*)(AVCodecParameters *)> parameters(
+      avcodec_parameters_alloc(), [](AVCodecParameters *p) { avcodec_parameters_free(&p); });
+  std::vector<std::shared_ptr<DecoderBuffer>> buffers;
+  if (!EncodeFrames(5, parameters.get(), &buffers)) {
+    GTEST_SKIP() << "no mpeg4 encoder";
+  }
+
+  VideoDecodeConfig config(*parameters, AVRational{1, 25}, AVRational{25, 1}, 10);
+  // No GPU on CI, the decoder must still come up in software.
+  config.set_hw_device_types({AV_HWDEVICE_TYPE_VAAPI, AV_HWDEVICE_TYPE_VDPAU, AV_HWDEVICE_TYPE_CUDA});
+  config.set_threading(VideoDecoderThreadType::kSlice, 1);
+
+  int frames = 0;
+  bool hardware_frames = false;
+  VideoDecoder decoder;
+  ASSERT_EQ(decoder.Initialize(config, nullptr, [&](std::shared_ptr<VideoFrame> frame) {
+    frames++;
+    hardware_frames |= frame->frame()->hw_frames_ctx != nullptr;
+  }), 0);
+  for (auto &buffer : buffers) {
+    decoder.Decode(buffer);
+  }
+  EXPECT_GT(frames, 0);
+  EXPECT_EQ(hardware_frames, decoder.IsHardwareAccelerated());
+}
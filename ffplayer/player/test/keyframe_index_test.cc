@@ -0,0 +1,122 @@
+//
+// Created by yangbin on 2021/7/24.
+//
+
+#include "gtest/gtest.h"
+
+#include "keyframe_index.h"
+
+using namespace media;
+
+TEST(KeyframeIndex, Empty) {
+  KeyframeIndex index;
+  KeyframeIndex::Entry entry{};
+  EXPECT_FALSE(index.FindPrevious(1, &entry));
+  EXPECT_FALSE(index.FindNearest(1, &entry));
+  EXPECT_FALSE(index.Covers(0));
+}
+
+TEST(KeyframeIndex, OutOfOrderAndDuplicates) {
+  KeyframeIndex index;
+  index.Add(4, 400);
+  index.Add(0, 0);
+  index.Add(2, -1);
+  // The container index had no position, the demuxed packet has.
+  index.Add(2, 200);
+  index.Add(4, 999);
+  EXPECT_EQ(index.size(), 3u);
+
+  KeyframeIndex::Entry entry{};
+  ASSERT_TRUE(index.FindPrevious(3, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 2);
+  EXPECT_EQ(entry.position, 200);
+  ASSERT_TRUE(index.FindPrevious(4, &entry));
+  EXPECT_EQ(entry.position, 400);
+}
+
+TEST(KeyframeIndex, FindPrevious) {
+  KeyframeIndex index;
+  for (int i = 1; i <= 10; ++i) {
+    index.Add(i * 2.0, i);
+  }
+  KeyframeIndex::Entry entry{};
+  EXPECT_FALSE(index.FindPrevious(1.9, &entry));
+  ASSERT_TRUE(index.FindPrevious(2, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 2);
+  ASSERT_TRUE(index.FindPrevious(7.9, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 6);
+  ASSERT_TRUE(index.FindPrevious(100, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 20);
+}
+
+TEST(KeyframeIndex, FindNearest) {
+  KeyframeIndex index;
+  for (int i = 1; i <= 10; ++i) {
+    index.Add(i * 2.0, i);
+  }
+  KeyframeIndex::Entry entry{};
+  ASSERT_TRUE(index.FindNearest(0, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 2);
+  ASSERT_TRUE(index.FindNearest(6.9, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 6);
+  ASSERT_TRUE(index.FindNearest(7.1, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 8);
+  ASSERT_TRUE(index.FindNearest(100, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 20);
+}
+
+TEST(KeyframeIndex, CoversOnlyDemuxedRanges) {
+  KeyframeIndex index;
+  EXPECT_FALSE(index.Covers(1));
+  for (int i = 1; i <= 10; ++i) {
+    index.Add(i * 2.0, i);
+  }
+  // Keyframes alone do not tell whether some are missing between them.
+  EXPECT_FALSE(index.Covers(5));
+
+  index.AddCoveredRange(2, 20);
+  EXPECT_TRUE(index.Covers(2));
+  EXPECT_TRUE(index.Covers(5));
+  EXPECT_TRUE(index.Covers(20));
+  EXPECT_FALSE(index.Covers(1));
+  // No keyframe at or after it is known.
+  EXPECT_FALSE(index.Covers(20.5));
+}
+
+TEST(KeyframeIndex, SeekIntoAHole) {
+  KeyframeIndex index;
+  // Played 0 - 10 s, then seeked to 100 s and played a little.
+  for (int i = 0; i <= 49; ++i) {
+    index.Add(i * 0.2, -1);
+  }
+  index.AddCoveredRange(0, 9.96);
+  for (int i = 500; i <= 510; ++i) {
+    index.Add(i * 0.2, -1);
+  }
+  index.AddCoveredRange(100, 102.04);
+
+  // 50 s is in the hole, the keyframe before it is not 9.8 s.
+  EXPECT_FALSE(index.Covers(50));
+  EXPECT_FALSE(index.Covers(99.9));
+  EXPECT_TRUE(index.Covers(5.1));
+  EXPECT_TRUE(index.Covers(101.1));
+
+  // Played from 50 s into the range at 100 s, the hole is closed.
+  for (int i = 250; i < 500; ++i) {
+    index.Add(i * 0.2, -1);
+  }
+  index.AddCoveredRange(50, 100.04);
+  EXPECT_TRUE(index.Covers(50));
+  EXPECT_TRUE(index.Covers(99.9));
+  EXPECT_FALSE(index.Covers(30));
+
+  // Played from 9 s to 50 s, the ranges it overlaps merge into one.
+  for (int i = 45; i < 250; ++i) {
+    index.Add(i * 0.2, -1);
+  }
+  index.AddCoveredRange(9, 50);
+  EXPECT_TRUE(index.Covers(30));
+  KeyframeIndex::Entry entry{};
+  ASSERT_TRUE(index.FindPrevious(30.1, &entry));
+  EXPECT_DOUBLE_EQ(entry.timestamp, 30);
+}
@@ -0,0 +1,55 @@
+//
+// Created by yangbin on 2021/7/31.
+//
+
+#include <cmath>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "media_clock.h"
+#include "time_source.h"
+
+using namespace media;
+
+TEST(MediaClock, FollowsManualTimeSource) {
+  auto time_source = std::make_shared<ManualTimeSource>(100);
+  MediaClock media_clock(nullptr, nullptr, nullptr);
+  media_clock.SetTimeSource(time_source);
+  EXPECT_TRUE(std::isnan(media_clock.GetMasterClock()));
+
+  auto *clock = media_clock.GetAudioClock();
+  clock->SetClock(10, 0);
+  EXPECT_DOUBLE_EQ(clock->GetClock(), 10);
+  time_source->Advance(TimeDelta::FromMilliseconds(500));
+  EXPECT_DOUBLE_EQ(clock->GetClock(), 10.5);
+
+  clock->SetSpeed(2);
+  time_source->Advance(TimeDelta::FromSeconds(1));
+  EXPECT_DOUBLE_EQ(clock->GetClock(), 12.5);
+}
+
+TEST(MediaClock, PausedClockHoldsItsPts) {
+  auto time_source = std::make_shared<ManualTimeSource>();
+  MediaClock media_clock(nullptr, nullptr, nullptr);
+  media_clock.SetTimeSource(time_source);
+  auto *clock = media_clock.GetVideoClock();
+  clock->SetClock(3, 0);
+  clock->paused = 1;
+  time_source->Advance(TimeDelta::FromSeconds(2));
+  EXPECT_DOUBLE_EQ(clock->GetClock(), 3);
+}
+
+TEST(MediaClock, FreeRunningClockReadsLastPts) {
+  MediaClock media_clock(nullptr, nullptr, nullptr);
+  EXPECT_FALSE(media_clock.IsFreeRunning());
+  media_clock.SetTimeSource(std::make_shared<FreeRunningTimeSource>());
+  EXPECT_TRUE(media_clock.IsFreeRunning());
+
+  auto *clock = media_clock.GetAudioClock();
+  clock->SetClockAt(7.25, 0, media_clock.time_source()->Now());
+  EXPECT_DOUBLE_EQ(clock->GetClock(), 7.25);
+  EXPECT_DOUBLE_EQ(media_clock.GetMasterClock(), 7.25);
+  clock->SetClockAt(8, 0, media_clock.time_source()->Now());
+  EXPECT_DOUBLE_EQ(media_clock.GetMasterClock(), 8);
+}
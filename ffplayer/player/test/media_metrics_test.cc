@@ -0,0 +1,46 @@
+//
+// Created by yangbin on 2021/8/1.
+//
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "media_metrics.h"
+
+using namespace media;
+
+TEST(MediaMetrics, SnapshotWritesAtStatIndex) {
+  MediaMetrics metrics;
+  metrics.video().packets_demuxed += 3;
+  metrics.audio().decoded += 5;
+  metrics.frames_rendered() += 2;
+  metrics.RecordAVDrift(-40);
+  metrics.RecordAVDrift(10);
+  metrics.video().decode_time_us.Record(1000);
+
+  std::vector<int64_t> values(kStatCount, -1);
+  metrics.Snapshot(values.data(), kStatCount);
+  EXPECT_EQ(values[kStatVideoPacketsDemuxed], 3);
+  EXPECT_EQ(values[kStatAudioPacketsDemuxed], 0);
+  EXPECT_EQ(values[kStatAudioBuffersDecoded], 5);
+  EXPECT_EQ(values[kStatVideoFramesRendered], 2);
+  EXPECT_EQ(values[kStatAVDrift], 10);
+  EXPECT_EQ(values[kStatAVDriftAbs], 2);
+  EXPECT_EQ(values[kStatAVDriftAbs + 4], 40);
+  EXPECT_EQ(values[kStatVideoDecodeTime], 1);
+  EXPECT_EQ(values[kStatAudioDecodeTime], 0);
+  // Not kept by the registry.
+  EXPECT_EQ(values[kStatPlayerQueueDepth], -1);
+}
+
+TEST(MediaMetrics, SnapshotStopsAtCount) {
+  MediaMetrics metrics;
+  metrics.video().packets_demuxed += 1;
+  metrics.audio().packets_demuxed += 1;
+  std::vector<int64_t> values(kStatCount, -1);
+  metrics.Snapshot(values.data(), kStatAudioPacketsDemuxed);
+  EXPECT_EQ(values[kStatVideoPacketsDemuxed], 1);
+  EXPECT_EQ(values[kStatAudioPacketsDemuxed], -1);
+  EXPECT_EQ(values[kStatVideoDecodeTime], -1);
+}
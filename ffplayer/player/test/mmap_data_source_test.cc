@@ -0,0 +1,123 @@
+//
+// Created by yangbin on 2021/7/22.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "mmap_data_source.h"
+#include "blocking_url_protocol.h"
+
+using namespace media;
+
+namespace {
+
+class MmapDataSourceTest : public testing::Test {
+
+ protected:
+
+  std::string path_;
+  std::vector<uint8_t> content_;
+
+  void SetUp() override {
+    // Spans several prefetch windows.
+    content_.resize(10 * 1024 * 1024 + 123);
+    for (size_t i = 0; i < content_.size(); ++i) {
+      content_[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+    }
+    path_ = testing::TempDir() + "mmap_data_source_test.bin";
+    auto *file = fopen(path_.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(fwrite(content_.data(), 1, content_.size(), file), content_.size());
+    fclose(file);
+  }
+
+  void TearDown() override {
+    remove(path_.c_str());
+  }
+
+  static int ReadSync(DataSource *source, int64_t position, int size, uint8_t *data) {
+    int result = 0;
+    source->Read(position, size, data, [&](int read) {
+      result = read;
+    });
+    return result;
+  }
+
+};
+
+}
+
+TEST_F(MmapDataSourceTest, InitializeMissingFile) {
+  MmapDataSource source;
+  EXPECT_FALSE(source.Initialize(path_ + ".missing"));
+  int64_t size;
+  EXPECT_FALSE(source.GetSize(&size));
+}
+
+TEST_F(MmapDataSourceTest, ReadRanges) {
+  MmapDataSource source;
+  ASSERT_TRUE(source.Initialize(path_));
+
+  int64_t size;
+  ASSERT_TRUE(source.GetSize(&size));
+  EXPECT_EQ(size, static_cast<int64_t>(content_.size()));
+  EXPECT_FALSE(source.IsStreaming());
+
+  std::vector<uint8_t> data(32 * 1024);
+  // Sequential reads, then seeks forward and backward.
+  std::vector<int64_t> positions = {0, 32 * 1024, 64 * 1024, 7 * 1024 * 1024 + 5, 1024 * 1024 - 7};
+  for (auto position : positions) {
+    ASSERT_EQ(ReadSync(&source, position, data.size(), data.data()), static_cast<int>(data.size()));
+    EXPECT_EQ(0, memcmp(data.data(), content_.data() + position, data.size())) << position;
+  }
+  EXPECT_EQ(source.bytes_read_for_testing(), positions.size() * data.size());
+}
+
+TEST_F(MmapDataSourceTest, ReadClampedAtEnd) {
+  MmapDataSource source;
+  ASSERT_TRUE(source.Initialize(path_));
+
+  std::vector<uint8_t> data(1024);
+  auto position = static_cast<int64_t>(content_.size()) - 100;
+  ASSERT_EQ(ReadSync(&source, position, data.size(), data.data()), 100);
+  EXPECT_EQ(0, memcmp(data.data(), content_.data() + position, 100));
+
+  EXPECT_EQ(ReadSync(&source, content_.size(), data.size(), data.data()), 0);
+}
+
+TEST_F(MmapDataSourceTest, ReadFailsAfterStop) {
+  MmapDataSource source;
+  ASSERT_TRUE(source.Initialize(path_));
+  source.Stop();
+
+  uint8_t data[16];
+  EXPECT_EQ(ReadSync(&source, 0, sizeof(data), data), DataSource::kReadError);
+}
+
+TEST_F(MmapDataSourceTest, ReadThroughBlockingUrlProtocol) {
+  MmapDataSource source;
+  ASSERT_TRUE(source.Initialize(path_));
+  bool error = false;
+  BlockingUrlProtocol protocol(&source, [&]() { error = true; });
+
+  std::vector<uint8_t> data(64 * 1024);
+  ASSERT_TRUE(protocol.SetPosition(4096));
+  ASSERT_EQ(protocol.Read(data.size(), data.data()), static_cast<int>(data.size()));
+  EXPECT_EQ(0, memcmp(data.data(), content_.data() + 4096, data.size()));
+
+  int64_t position;
+  ASSERT_TRUE(protocol.GetPosition(&position));
+  EXPECT_EQ(position, 4096 + static_cast<int64_t>(data.size()));
+
+  ASSERT_TRUE(protocol.SetPosition(content_.size()));
+  EXPECT_EQ(protocol.Read(data.size(), data.data()), AVERROR_EOF);
+
+  protocol.Abort();
+  EXPECT_EQ(protocol.Read(data.size(), data.data()), AVERROR(EIO));
+  EXPECT_FALSE(error);
+}
@@ -0,0 +1,166 @@
+//
+// Created by yangbin on 2021/7/30.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ffmpeg_deleters.h"
+#include "null_audio_renderer_sink.h"
+#include "null_video_renderer_sink.h"
+#include "time_source.h"
+
+using namespace media;
+
+namespace {
+
+std::shared_ptr<VideoFrame> CreateFrame(double pts, uint8_t value) {
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->width = 32;
+  frame->height = 18;
+  frame->format = AV_PIX_FMT_YUV420P;
+  if (av_frame_get_buffer(frame.get(), 0) < 0) {
+    return nullptr;
+  }
+  for (int i = 0; i < 3; ++i) {
+    memset(frame->buf[i]->data, value, frame->buf[i]->size);
+  }
+  return std::make_shared<VideoFrame>(frame.get(), pts, 0.04, 0);
+}
+
+// Hands out |frames| in order, each one twice as a renderer does while the
+// next frame is not due.
+class FakeVideoRenderer : public VideoRendererSink::RenderCallback {
+
+ public:
+
+  explicit FakeVideoRenderer(std::vector<std::shared_ptr<VideoFrame>> frames) : frames_(std::move(frames)) {}
+
+  std::shared_ptr<VideoFrame> Render(TimeDelta &next_frame_delay) override {
+    next_frame_delay = TimeDelta::FromMilliseconds(1);
+    auto index = calls_++ / 2;
+    if (index >= static_cast<int>(frames_.size())) {
+      return VideoFrame::EmptyFrame();
+    }
+    return frames_[index];
+  }
+
+  void OnFrameDrop() override {}
+
+  bool done() const { return calls_ >= static_cast<int>(frames_.size()) * 2; }
+
+ private:
+
+  std::vector<std::shared_ptr<VideoFrame>> frames_;
+  std::atomic_int calls_{0};
+
+};
+
+class FakeAudioRenderer : public AudioRendererSink::RenderCallback {
+
+ public:
+
+  // Has data for the first |available| bytes only.
+  explicit FakeAudioRenderer(int available) : available_(available) {}
+
+  int Render(double, uint8 *stream, int len) override {
+    auto size = std::min(len, available_ - rendered_);
+    memset(stream, 1, size);
+    rendered_ += size;
+    return size;
+  }
+
+  void OnRenderError() override {}
+
+ private:
+
+  int available_;
+  int rendered_ = 0;
+
+};
+
+template<typename Predicate>
+bool WaitFor(Predicate predicate) {
+  for (int i = 0; i < 500 && !predicate(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return predicate();
+}
+
+}
+
+TEST(NullVideoRendererSink, RecordsEachFrameOnce) {
+  std::vector<std::shared_ptr<VideoFrame>> frames;
+  for (int i = 0; i < 5; ++i) {
+    frames.push_back(CreateFrame(i * 0.04, uint8_t(i % 2)));
+    ASSERT_TRUE(frames.back());
+  }
+  FakeVideoRenderer renderer(frames);
+  NullVideoRendererSink sink;
+  sink.set_compute_checksums(true);
+  sink.Start(&renderer);
+  ASSERT_TRUE(WaitFor([&]() { return renderer.done(); }));
+  sink.Stop();
+
+  auto presented = sink.presented_frames();
+  ASSERT_EQ(presented.size(), frames.size());
+  for (size_t i = 0; i < presented.size(); ++i) {
+    EXPECT_DOUBLE_EQ(presented[i].pts, frames[i]->pts());
+    EXPECT_EQ(presented[i].checksum, NullVideoRendererSink::ComputeChecksum(frames[i]->frame()));
+    if (i > 0) {
+      EXPECT_GE(presented[i].presented_at, presented[i - 1].presented_at);
+    }
+  }
+  // Same pixels, same checksum.
+  EXPECT_EQ(presented[0].checksum, presented[2].checksum);
+  EXPECT_NE(presented[0].checksum, presented[1].checksum);
+}
+
+TEST(NullAudioRendererSink, PullsAtSpeedAndCountsUnderruns) {
+  const int kChannels = 2;
+  const int kSampleRate = 48000;
+  const int kFramesPerBuffer = 480;
+  // Data for 2.5 buffers.
+  FakeAudioRenderer renderer(kFramesPerBuffer * kChannels * 2 * 5 / 2);
+  // 10 ms buffers pulled every millisecond.
+  NullAudioRendererSink sink(10, kFramesPerBuffer);
+  sink.Initialize(kChannels, kSampleRate, &renderer);
+  sink.Play();
+  ASSERT_TRUE(WaitFor([&]() { return sink.rendered_frames() >= kFramesPerBuffer * 20; }));
+  sink.Pause();
+
+  EXPECT_GE(sink.played_seconds(), 0.2);
+  EXPECT_EQ(sink.rendered_frames() - sink.underrun_frames(), kFramesPerBuffer * 5 / 2);
+}
+
+TEST(NullAudioRendererSink, PullsOnlyWhenTheTimeSourceIsDue) {
+  const int kChannels = 1;
+  const int kSampleRate = 8000;
+  // 10 ms buffers.
+  const int kFramesPerBuffer = 80;
+  auto time_source = std::make_shared<ManualTimeSource>();
+  FakeAudioRenderer renderer(1 << 20);
+  NullAudioRendererSink sink(1.0, kFramesPerBuffer, time_source);
+  sink.Initialize(kChannels, kSampleRate, &renderer);
+  sink.Play();
+
+  // The first buffer is pulled at once, the next one waits for the source.
+  ASSERT_TRUE(WaitFor([&]() { return sink.next_pull_time() > 0; }));
+  EXPECT_EQ(sink.rendered_frames(), kFramesPerBuffer);
+  EXPECT_DOUBLE_EQ(sink.next_pull_time(), 0.01);
+
+  for (int step = 1; step <= 10; ++step) {
+    time_source->SetNow(step * 3 / 100.0);
+    ASSERT_TRUE(WaitFor([&]() { return sink.next_pull_time() > time_source->Now(); }));
+    // Every buffer due at or before now, none after.
+    EXPECT_EQ(sink.rendered_frames(), (step * 3 + 1) * kFramesPerBuffer);
+  }
+  sink.Pause();
+  EXPECT_EQ(sink.underrun_frames(), 0);
+}
@@ -0,0 +1,245 @@
+//
+// Created by yangbin on 2021/7/25.
+//
+
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "base/message_loop.h"
+#include "base/task_runner.h"
+
+#include "data_source.h"
+#include "demuxer.h"
+#include "seek_coalescer.h"
+
+using namespace media;
+
+namespace {
+
+const int kSampleRate = 8000;
+const int kDurationSeconds = 10;
+
+void WriteLE(std::vector<uint8_t> *out, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// A mono 16 bit PCM wav file in memory, every demuxer seek lands exactly on
+// the target.
+class WavDataSource : public DataSource {
+
+ public:
+
+  explicit WavDataSource(int seconds) {
+    uint32_t data_size = static_cast<uint32_t>(seconds) * kSampleRate * 2;
+    data_.insert(data_.end(), {'R', 'I', 'F', 'F'});
+    WriteLE(&data_, 36 + data_size, 4);
+    data_.insert(data_.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    WriteLE(&data_, 16, 4);
+    WriteLE(&data_, 1, 2);
+    WriteLE(&data_, 1, 2);
+    WriteLE(&data_, kSampleRate, 4);
+    WriteLE(&data_, kSampleRate * 2, 4);
+    WriteLE(&data_, 2, 2);
+    WriteLE(&data_, 16, 2);
+    data_.insert(data_.end(), {'d', 'a', 't', 'a'});
+    WriteLE(&data_, data_size, 4);
+    data_.resize(data_.size() + data_size);
+  }
+
+  void Read(int64_t position, int size, uint8_t *data, DataSource::ReadCB read_cb) override {
+    position = std::min<int64_t>(position, data_.size());
+    auto count = std::min<int64_t>(size, data_.size() - position);
+    memcpy(data, data_.data() + position, static_cast<size_t>(count));
+    read_cb(static_cast<int>(count));
+  }
+
+  void Stop() override {}
+  void Abort() override {}
+
+  bool GetSize(int64_t *size_out) override {
+    *size_out = data_.size();
+    return true;
+  }
+
+  bool IsStreaming() override { return false; }
+  void SetBitrate(int) override {}
+
+ private:
+
+  std::vector<uint8_t> data_;
+
+};
+
+class NullDemuxerHost : public DemuxerHost {
+ public:
+  void SetDuration(double) override {}
+  void OnDemuxerError(PipelineStatus error) override {
+    ADD_FAILURE() << "demuxer error " << error;
+  }
+};
+
+}
+
+TEST(SeekCoalescerTest, PushReplacesThePendingSeek) {
+  SeekCoalescer coalescer;
+  std::vector<bool> results;
+  coalescer.Push(TimeDelta::FromSeconds(1), SeekMode::kFast, [&](bool success) { results.push_back(success); });
+  coalescer.Push(TimeDelta::FromSeconds(2), SeekMode::kAccurate, [&](bool success) { results.push_back(success); });
+  ASSERT_EQ(results, std::vector<bool>{false});
+  EXPECT_EQ(coalescer.superseded_count(), 1);
+
+  SeekCoalescer::Request request;
+  ASSERT_TRUE(coalescer.Take(&request));
+  EXPECT_EQ(request.position, TimeDelta::FromSeconds(2));
+  EXPECT_EQ(request.mode, SeekMode::kAccurate);
+  EXPECT_FALSE(coalescer.has_pending());
+  EXPECT_FALSE(coalescer.Take(&request));
+
+  request.callback(true);
+  EXPECT_EQ(results, (std::vector<bool>{false, true}));
+}
+
+TEST(SeekCoalescerTest, CancelFailsThePendingSeek) {
+  SeekCoalescer coalescer;
+  bool result = true;
+  coalescer.Push(TimeDelta::FromSeconds(3), SeekMode::kPreviousSync, [&](bool success) { result = success; });
+  EXPECT_EQ(coalescer.pending_position(), TimeDelta::FromSeconds(3));
+
+  coalescer.Cancel();
+  EXPECT_FALSE(result);
+  EXPECT_FALSE(coalescer.has_pending());
+  EXPECT_LT(coalescer.pending_position(), TimeDelta());
+
+  SeekCoalescer::Request request;
+  EXPECT_FALSE(coalescer.Take(&request));
+}
+
+class DemuxerSeekTest : public testing::Test {
+
+ protected:
+
+  std::shared_ptr<MessageLooper> host_looper_;
+  TaskRunner demux_task_runner_;
+  NullDemuxerHost host_;
+  std::unique_ptr<WavDataSource> data_source_;
+  std::shared_ptr<Demuxer> demuxer_;
+
+  std::mutex results_lock_;
+  std::vector<int> succeeded_, failed_;
+
+  void SetUp() override {
+    host_looper_ = MessageLooper::PrepareLooper("seek_test");
+    demux_task_runner_ = TaskRunner(MessageLooper::PrepareLooper("demuxer"));
+    data_source_ = std::make_unique<WavDataSource>(kDurationSeconds);
+    demuxer_ = std::make_shared<Demuxer>(demux_task_runner_, "memory.wav",
+                                         [](std::unique_ptr<MediaTracks>) {}, data_source_.get());
+
+    std::promise<int> initialized;
+    host_looper_->PostTask(FROM_HERE, [&]() {
+      demuxer_->Initialize(&host_, [&](int status) { initialized.set_value(status); });
+    });
+    ASSERT_EQ(initialized.get_future().get(), 0);
+    ASSERT_NE(demuxer_->GetFirstStream(DemuxerStream::Audio), nullptr);
+  }
+
+  void TearDown() override {
+    std::promise<void> stopped;
+    demuxer_->Stop([&]() { stopped.set_value(); });
+    stopped.get_future().wait();
+  }
+
+  // Holds the demuxer thread, like a seek which is still running, until the
+  // returned promise is set.
+  std::shared_ptr<std::promise<void>> BlockDemuxer() {
+    auto release = std::make_shared<std::promise<void>>();
+    auto released = release->get_future().share();
+    demux_task_runner_.PostTask(FROM_HERE, [released]() { released.wait(); });
+    return release;
+  }
+
+  // Returns a future completed once seek |id| is done.
+  std::shared_future<bool> SeekTo(int id, TimeDelta position) {
+    auto done = std::make_shared<std::promise<bool>>();
+    auto future = done->get_future().share();
+    demuxer_->SeekTo(position, SeekMode::kAccurate, [this, id, done](bool success) {
+      {
+        std::lock_guard<std::mutex> lock(results_lock_);
+        (success ? succeeded_ : failed_).push_back(id);
+      }
+      done->set_value(success);
+    });
+    return future;
+  }
+
+  // Timestamp of the next packet of the audio stream.
+  double ReadTimestamp() {
+    std::promise<double> timestamp;
+    host_looper_->PostTask(FROM_HERE, [&]() {
+      demuxer_->GetFirstStream(DemuxerStream::Audio)->Read([&](std::shared_ptr<DecoderBuffer> buffer) {
+        timestamp.set_value(buffer->end_of_stream() ? -1 : buffer->timestamp());
+      });
+    });
+    return timestamp.get_future().get();
+  }
+
+};
+
+TEST_F(DemuxerSeekTest, RapidSeeksExecuteOnlyTheLatest) {
+  auto release = BlockDemuxer();
+
+  const int kSeeks = 100;
+  std::vector<std::shared_future<bool>> seeks;
+  for (int i = 0; i < kSeeks; ++i) {
+    seeks.push_back(SeekTo(i, TimeDelta::FromMilliseconds(i * 50)));
+  }
+  // Superseded seeks fail as soon as they are replaced.
+  for (int i = 0; i < kSeeks - 1; ++i) {
+    EXPECT_FALSE(seeks[i].get());
+  }
+  release->set_value();
+  EXPECT_TRUE(seeks.back().get());
+
+  {
+    std::lock_guard<std::mutex> lock(results_lock_);
+    EXPECT_EQ(succeeded_, std::vector<int>{kSeeks - 1});
+    EXPECT_EQ(static_cast<int>(failed_.size()), kSeeks - 1);
+  }
+  EXPECT_EQ(demuxer_->superseded_seek_count(), kSeeks - 1);
+  EXPECT_LT(demuxer_->GetPendingSeekingPosition(), TimeDelta());
+  EXPECT_NEAR(ReadTimestamp(), (kSeeks - 1) * 0.05, 0.01);
+}
+
+TEST_F(DemuxerSeekTest, SeeksDuringASeekRunOnceAfterIt) {
+  // The first seek runs, then the demuxer thread is held as if it was busy
+  // with it.
+  auto first = SeekTo(0, TimeDelta::FromSeconds(1));
+  auto release = BlockDemuxer();
+  // The seek which started is completed, it is what a scrubber previews.
+  EXPECT_TRUE(first.get());
+
+  std::vector<std::shared_future<bool>> superseded;
+  for (int i = 1; i <= 10; ++i) {
+    superseded.push_back(SeekTo(i, TimeDelta::FromSeconds(2)));
+  }
+  auto last = SeekTo(11, TimeDelta::FromSeconds(3));
+  release->set_value();
+
+  for (auto &seek : superseded) {
+    EXPECT_FALSE(seek.get());
+  }
+  EXPECT_TRUE(last.get());
+
+  {
+    std::lock_guard<std::mutex> lock(results_lock_);
+    EXPECT_EQ(succeeded_, (std::vector<int>{0, 11}));
+  }
+  EXPECT_EQ(demuxer_->superseded_seek_count(), 10);
+  EXPECT_NEAR(ReadTimestamp(), 3.0, 0.01);
+}
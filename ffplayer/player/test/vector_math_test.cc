@@ -0,0 +1,106 @@
+//
+// Created by yangbin on 2021/7/19.
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "vector_math.h"
+
+using namespace media;
+
+namespace {
+
+// Odd length, so that the scalar tail of every kernel runs as well.
+const int kSampleCount = 1027;
+
+std::vector<int16> CreateS16Samples() {
+  std::vector<int16> samples(kSampleCount);
+  srand(42);
+  for (auto &sample : samples) {
+    sample = static_cast<int16>(rand() % 65536 - 32768);
+  }
+  samples[0] = 32767;
+  samples[1] = -32768;
+  return samples;
+}
+
+int16 ExpectedS16(int16 sample, float gain) {
+  float value = std::min(std::max(float(sample) * gain, -32768.0f), 32767.0f);
+  return static_cast<int16>(lrintf(value));
+}
+
+}
+
+TEST(VectorMath, ScaleS16) {
+  auto samples = CreateS16Samples();
+  std::vector<int16> dest(kSampleCount);
+
+  for (float gain : {0.0f, 0.3f, 0.5f, 1.0f, 2.0f}) {
+    vector_math::ScaleS16(samples.data(), gain, kSampleCount, dest.data());
+    for (int i = 0; i < kSampleCount; ++i) {
+      ASSERT_EQ(dest[i], ExpectedS16(samples[i], gain)) << "gain " << gain << " at " << i;
+    }
+  }
+}
+
+TEST(VectorMath, ScaleS16InPlace) {
+  auto samples = CreateS16Samples();
+  auto expected = samples;
+  for (auto &sample : expected) {
+    sample = ExpectedS16(sample, 0.25f);
+  }
+  vector_math::ScaleS16(samples.data(), 0.25f, kSampleCount, samples.data());
+  EXPECT_EQ(samples, expected);
+}
+
+TEST(VectorMath, ScaleS16Ramp) {
+  std::vector<int16> samples(kSampleCount, 10000);
+  std::vector<int16> dest(kSampleCount);
+
+  vector_math::ScaleS16Ramp(samples.data(), 1.0f, 0.0f, kSampleCount, dest.data());
+  EXPECT_EQ(dest[0], 10000);
+  for (int i = 1; i < kSampleCount; ++i) {
+    // Monotonic and without a jump larger than a step.
+    ASSERT_LE(dest[i], dest[i - 1]);
+    ASSERT_LE(dest[i - 1] - dest[i], 10000 / kSampleCount + 1);
+  }
+  EXPECT_LE(dest[kSampleCount - 1], 10000 / kSampleCount + 1);
+}
+
+TEST(VectorMath, ScaleFloat) {
+  std::vector<float> samples(kSampleCount);
+  for (int i = 0; i < kSampleCount; ++i) {
+    samples[i] = std::sin(float(i) * 0.01f);
+  }
+  std::vector<float> dest(kSampleCount);
+
+  vector_math::ScaleFloat(samples.data(), 0.7f, kSampleCount, dest.data());
+  for (int i = 0; i < kSampleCount; ++i) {
+    ASSERT_FLOAT_EQ(dest[i], samples[i] * 0.7f);
+  }
+
+  vector_math::ScaleFloatRamp(samples.data(), 0.0f, 1.0f, kSampleCount, dest.data());
+  for (int i = 0; i < kSampleCount; ++i) {
+    ASSERT_NEAR(dest[i], samples[i] * float(i) / kSampleCount, 1e-5);
+  }
+}
+
+TEST(VectorMath, GainRamp) {
+  vector_math::GainRamp ramp;
+  ramp.current = 1;
+  ramp.target = 0;
+  ramp.step = 0.001f;
+  EXPECT_TRUE(ramp.IsRamping());
+
+  EXPECT_FLOAT_EQ(ramp.Advance(100), 0.9f);
+  EXPECT_FLOAT_EQ(ramp.Advance(2000), 0.0f);
+  EXPECT_FALSE(ramp.IsRamping());
+
+  ramp.target = 0.5f;
+  EXPECT_FLOAT_EQ(ramp.Advance(1000), 0.5f);
+  EXPECT_FALSE(ramp.IsRamping());
+}
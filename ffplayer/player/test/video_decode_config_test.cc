@@ -0,0 +1,44 @@
+//
+// Created by yangbin on 2021/7/29.
+//
+
+#include "gtest/gtest.h"
+
+#include "video_decode_config.h"
+
+using namespace media;
+
+namespace {
+
+VideoDecodeConfig CreateConfig(int width, int height) {
+  AVCodecParameters parameters{};
+  parameters.width = width;
+  parameters.height = height;
+  return VideoDecodeConfig(parameters, AVRational{1, 1000}, AVRational{30, 1}, 10);
+}
+
+}
+
+TEST(VideoDecodeConfigTest, LowResCoversTheDisplay) {
+  auto config = CreateConfig(3840, 2160);
+  // Unknown display size.
+  EXPECT_EQ(config.LowResForDisplaySize(3), 0);
+
+  config.set_display_size(1920, 1080);
+  EXPECT_EQ(config.LowResForDisplaySize(3), 1);
+
+  // A thumbnail in a grid, 3840x2160 >> 3 is 480x270.
+  config.set_display_size(320, 180);
+  EXPECT_EQ(config.LowResForDisplaySize(3), 3);
+  EXPECT_EQ(config.LowResForDisplaySize(1), 1);
+  // The codec does not support lowres.
+  EXPECT_EQ(config.LowResForDisplaySize(0), 0);
+
+  // Slightly smaller than half is not enough.
+  config.set_display_size(1921, 1000);
+  EXPECT_EQ(config.LowResForDisplaySize(3), 0);
+
+  // A portrait display limits by height.
+  config.set_display_size(400, 1080);
+  EXPECT_EQ(config.LowResForDisplaySize(3), 1);
+}
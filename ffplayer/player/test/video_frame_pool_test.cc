@@ -0,0 +1,143 @@
+//
+// Created by yangbin on 2021/8/4.
+//
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "allocation_counter.h"
+#include "ffmpeg_deleters.h"
+#include "picture_buffer_pool.h"
+#include "video_frame.h"
+
+using namespace media;
+
+namespace {
+
+std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> CreatePicture(int width, int height) {
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+  frame->width = width;
+  frame->height = height;
+  frame->format = AV_PIX_FMT_YUV420P;
+  av_frame_get_buffer(frame.get(), 0);
+  return frame;
+}
+
+std::unique_ptr<AVCodecContext, AVCodecContextDeleter> CreateCodecContext() {
+  std::unique_ptr<AVCodecContext, AVCodecContextDeleter> context(avcodec_alloc_context3(nullptr));
+  context->codec_type = AVMEDIA_TYPE_VIDEO;
+  context->codec_id = AV_CODEC_ID_H264;
+  context->pix_fmt = AV_PIX_FMT_YUV420P;
+  return context;
+}
+
+} // namespace
+
+TEST(VideoFrame, EmptyFrameIsShared) {
+  auto empty = VideoFrame::EmptyFrame();
+  EXPECT_TRUE(empty->IsEmpty());
+  EXPECT_EQ(empty, VideoFrame::EmptyFrame());
+}
+
+TEST(VideoFramePool, ReuseReleasedFrame) {
+  auto picture = CreatePicture(64, 36);
+  VideoFramePool pool;
+
+  auto frame = pool.Acquire(picture.get(), 1, 0.04, 0);
+  auto *av_frame = frame->frame();
+  EXPECT_EQ(frame->frame()->data[0], picture->data[0]);
+  EXPECT_DOUBLE_EQ(frame->pts(), 1);
+
+  auto in_use = pool.Acquire(picture.get(), 2, 0.04, 0);
+  EXPECT_NE(in_use, frame);
+  EXPECT_EQ(pool.size(), 2u);
+
+  frame = nullptr;
+  auto reused = pool.Acquire(picture.get(), 3, 0.04, 0);
+  EXPECT_EQ(reused->frame(), av_frame);
+  EXPECT_DOUBLE_EQ(reused->pts(), 3);
+  EXPECT_EQ(reused->Width(), 64);
+  EXPECT_EQ(pool.size(), 2u);
+}
+
+TEST(VideoFramePool, ReleasesPictureOfIdleFrames) {
+  auto picture = CreatePicture(64, 36);
+  VideoFramePool pool;
+  pool.Acquire(picture.get(), 1, 0.04, 0);
+  pool.Acquire(picture.get(), 2, 0.04, 0);
+  // Both frames are idle: one is reused, the other drops its reference.
+  auto frame = pool.Acquire(picture.get(), 3, 0.04, 0);
+  EXPECT_EQ(av_buffer_get_ref_count(picture->buf[0]), 2);
+  frame = nullptr;
+}
+
+TEST(VideoFramePool, SteadyStateAllocatesOnlyBufferReferences) {
+  auto picture = CreatePicture(64, 36);
+  int64 buffers = 0;
+  for (auto *buffer : picture->buf) {
+    buffers += buffer != nullptr;
+  }
+  ASSERT_GT(buffers, 0);
+  VideoFramePool pool;
+  pool.Acquire(picture.get(), 0, 0.04, 0);
+
+  const int kFrames = 10;
+  int64 allocations, frees;
+  {
+    ScopedAllocationCounter counter;
+    for (int i = 1; i <= kFrames; ++i) {
+      pool.Acquire(picture.get(), i, 0.04, 0);
+    }
+    allocations = counter.allocations();
+    frees = counter.frees();
+  }
+  EXPECT_EQ(pool.size(), 1u);
+#if defined(__GLIBC__)
+  // av_frame_ref allocates an AVBufferRef per buffer, av_frame_unref frees
+  // those of the previous picture.
+  EXPECT_EQ(allocations, kFrames * buffers);
+  EXPECT_EQ(frees, kFrames * buffers);
+#else
+  EXPECT_EQ(allocations, 0);
+  EXPECT_EQ(frees, 0);
+#endif
+}
+
+TEST(PictureBufferPool, SteadyStateDoesNotAllocate) {
+  auto context = CreateCodecContext();
+  PictureBufferPool pool;
+  std::unique_ptr<AVFrame, ScopedPtrAVFreeFrame> frame(av_frame_alloc());
+
+  auto get_buffer = [&]() {
+    frame->width = 1280;
+    frame->height = 720;
+    frame->format = AV_PIX_FMT_YUV420P;
+    return pool.GetBuffer(context.get(), frame.get(), 0);
+  };
+
+  ASSERT_EQ(get_buffer(), 0);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(frame->data[i]) % PictureBufferPool::kAlignment, 0u);
+    EXPECT_EQ(frame->linesize[i] % PictureBufferPool::kAlignment, 0);
+  }
+  EXPECT_GE(frame->linesize[0], 1280);
+  auto *data = frame->data[0];
+  av_frame_unref(frame.get());
+  EXPECT_EQ(pool.allocated_planes(), 3);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(get_buffer(), 0);
+    EXPECT_EQ(frame->data[0], data);
+    av_frame_unref(frame.get());
+  }
+  EXPECT_EQ(pool.allocated_planes(), 3);
+
+  // A new geometry gets new buffers.
+  frame->width = 640;
+  frame->height = 360;
+  frame->format = AV_PIX_FMT_YUV420P;
+  ASSERT_EQ(pool.GetBuffer(context.get(), frame.get(), 0), 0);
+  EXPECT_EQ(pool.allocated_planes(), 6);
+  av_frame_unref(frame.get());
+}
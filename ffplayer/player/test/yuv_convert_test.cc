@@ -0,0 +1,148 @@
+//
+// Created by yangbin on 2021/7/28.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yuv_convert.h"
+
+using namespace media;
+using namespace media::yuv_convert;
+
+namespace {
+
+// Not a multiple of 8, so that the scalar tail of every kernel runs as well.
+const int kWidth = 67;
+const int kHeight = 35;
+
+struct I420Image {
+  int chroma_width = (kWidth + 1) / 2;
+  int chroma_height = (kHeight + 1) / 2;
+  std::vector<uint8> y = std::vector<uint8>(kWidth * kHeight);
+  std::vector<uint8> u = std::vector<uint8>(chroma_width * chroma_height);
+  std::vector<uint8> v = std::vector<uint8>(chroma_width * chroma_height);
+};
+
+I420Image CreateImage() {
+  I420Image image;
+  srand(7);
+  for (auto &sample : image.y) {
+    sample = static_cast<uint8>(rand() % 256);
+  }
+  for (auto &sample : image.u) {
+    sample = static_cast<uint8>(rand() % 256);
+  }
+  for (auto &sample : image.v) {
+    sample = static_cast<uint8>(rand() % 256);
+  }
+  // The extremes, which saturate.
+  image.y[0] = 0;
+  image.u[0] = 0;
+  image.v[0] = 0;
+  image.y[2] = 255;
+  image.u[1] = 255;
+  image.v[1] = 255;
+  return image;
+}
+
+// Reference in floating point, returns R, G, B.
+void ReferenceRGB(int y, int u, int v, YuvColorSpace color_space, int rgb[3]) {
+  double kr = color_space.matrix == YuvMatrix::kBT709 ? 0.2126 : 0.299;
+  double kb = color_space.matrix == YuvMatrix::kBT709 ? 0.0722 : 0.114;
+  double kg = 1 - kr - kb;
+  double luma, cb, cr;
+  if (color_space.full_range) {
+    luma = y / 255.0;
+    cb = (u - 128) / 255.0;
+    cr = (v - 128) / 255.0;
+  } else {
+    luma = (y - 16) / 219.0;
+    cb = (u - 128) / 224.0;
+    cr = (v - 128) / 224.0;
+  }
+  double r = luma + 2 * (1 - kr) * cr;
+  double b = luma + 2 * (1 - kb) * cb;
+  double g = (luma - kr * r - kb * b) / kg;
+  for (auto value : {std::make_pair(0, r), std::make_pair(1, g), std::make_pair(2, b)}) {
+    rgb[value.first] = std::min(std::max(int(std::lround(value.second * 255)), 0), 255);
+  }
+}
+
+void ExpectNearReference(const I420Image &image, const std::vector<uint8> &rgb32,
+                         YuvColorSpace color_space, RgbOrder order) {
+  const int r_index = order == RgbOrder::kBGRA ? 2 : 0;
+  const int b_index = 2 - r_index;
+  for (int row = 0; row < kHeight; ++row) {
+    for (int x = 0; x < kWidth; ++x) {
+      int chroma = row / 2 * image.chroma_width + x / 2;
+      int expected[3];
+      ReferenceRGB(image.y[row * kWidth + x], image.u[chroma], image.v[chroma], color_space, expected);
+      const uint8 *pixel = &rgb32[(row * kWidth + x) * 4];
+      ASSERT_NEAR(pixel[r_index], expected[0], 2) << "R at " << x << "," << row;
+      ASSERT_NEAR(pixel[1], expected[1], 2) << "G at " << x << "," << row;
+      ASSERT_NEAR(pixel[b_index], expected[2], 2) << "B at " << x << "," << row;
+      ASSERT_EQ(pixel[3], 255);
+    }
+  }
+}
+
+}
+
+TEST(YuvConvert, I420ToRGB32) {
+  auto image = CreateImage();
+  std::vector<uint8> rgb32(kWidth * kHeight * 4);
+  for (auto matrix : {YuvMatrix::kBT601, YuvMatrix::kBT709}) {
+    for (bool full_range : {false, true}) {
+      for (auto order : {RgbOrder::kBGRA, RgbOrder::kRGBA}) {
+        YuvColorSpace color_space;
+        color_space.matrix = matrix;
+        color_space.full_range = full_range;
+        I420ToRGB32(image.y.data(), kWidth, image.u.data(), image.chroma_width, image.v.data(), image.chroma_width,
+                    rgb32.data(), kWidth * 4, kWidth, kHeight, color_space, order);
+        SCOPED_TRACE(testing::Message() << "matrix " << int(matrix) << " full range " << full_range);
+        ExpectNearReference(image, rgb32, color_space, order);
+      }
+    }
+  }
+}
+
+TEST(YuvConvert, NV12MatchesI420) {
+  auto image = CreateImage();
+  std::vector<uint8> uv(image.u.size() * 2);
+  for (size_t i = 0; i < image.u.size(); ++i) {
+    uv[i * 2] = image.u[i];
+    uv[i * 2 + 1] = image.v[i];
+  }
+  std::vector<uint8> from_i420(kWidth * kHeight * 4);
+  std::vector<uint8> from_nv12(kWidth * kHeight * 4);
+  YuvColorSpace color_space;
+  color_space.matrix = YuvMatrix::kBT709;
+  I420ToRGB32(image.y.data(), kWidth, image.u.data(), image.chroma_width, image.v.data(), image.chroma_width,
+              from_i420.data(), kWidth * 4, kWidth, kHeight, color_space, RgbOrder::kRGBA);
+  NV12ToRGB32(image.y.data(), kWidth, uv.data(), image.chroma_width * 2,
+              from_nv12.data(), kWidth * 4, kWidth, kHeight, color_space, RgbOrder::kRGBA);
+  EXPECT_EQ(from_i420, from_nv12);
+}
+
+TEST(YuvConvert, SlicesMatchWholeFrame) {
+  auto image = CreateImage();
+  YuvColorSpace color_space;
+  std::vector<uint8> whole(kWidth * kHeight * 4);
+  I420ToRGB32(image.y.data(), kWidth, image.u.data(), image.chroma_width, image.v.data(), image.chroma_width,
+              whole.data(), kWidth * 4, kWidth, kHeight, color_space, RgbOrder::kBGRA);
+
+  std::vector<uint8> sliced(kWidth * kHeight * 4);
+  for (int start = 0; start < kHeight; start += 6) {
+    int rows = std::min(6, kHeight - start);
+    I420ToRGB32(image.y.data() + start * kWidth, kWidth,
+                image.u.data() + start / 2 * image.chroma_width, image.chroma_width,
+                image.v.data() + start / 2 * image.chroma_width, image.chroma_width,
+                sliced.data() + start * kWidth * 4, kWidth * 4, kWidth, rows, color_space, RgbOrder::kBGRA);
+  }
+  EXPECT_EQ(whole, sliced);
+}
@@ -95,24 +95,14 @@ int SdlVideoRendererSink::UploadTexture(AVFrame *frame) {
     return -1;
   switch (sdl_pix_fmt) {
     case SDL_PIXELFORMAT_UNKNOWN: {
-      static int sws_flags = SWS_BICUBIC;
-      /* This should only happen if we are not using avfilter... */
-      img_convert_ctx = sws_getCachedContext(img_convert_ctx,
-                                             frame->width, frame->height, AVPixelFormat(frame->format),
-                                             frame->width, frame->height, AVPixelFormat::AV_PIX_FMT_BGRA,
-                                             sws_flags, nullptr, nullptr, nullptr);
-
-      if (img_convert_ctx != nullptr) {
-        uint8_t *pixels[4];
-        int pitch[4];
-        if (!SDL_LockTexture(texture_, nullptr, (void **) pixels, pitch)) {
-          sws_scale(img_convert_ctx, (const uint8_t *const *) frame->data, frame->linesize,
-                    0, frame->height, pixels, pitch);
-          SDL_UnlockTexture(texture_);
+      uint8_t *pixels[4] = {};
+      int pitch[4] = {};
+      if (!SDL_LockTexture(texture_, nullptr, (void **) pixels, pitch)) {
+        ret = frame_converter_.Convert(frame, AV_PIX_FMT_BGRA, frame->width, frame->height, pixels, pitch);
+        SDL_UnlockTexture(texture_);
+        if (ret < 0) {
+          av_log(nullptr, AV_LOG_FATAL, "Cannot convert the frame\n");
         }
-      } else {
-        av_log(nullptr, AV_LOG_FATAL, "Cannot initialize the conversion context\n");
-        ret = -1;
       }
     }
       break;
@@ -7,11 +7,11 @@
 
 extern "C" {
 #include "SDL2/SDL.h"
-#include "libswscale/swscale.h"
 }
 
 #include "video_renderer_sink.h"
 #include "base/task_runner.h"
+#include "frame_converter.h"
 
 namespace media {
 
@@ -45,7 +45,7 @@ class SdlVideoRendererSink : public VideoRendererSink {
 
   SDL_Texture *texture_ = nullptr;
 
-  struct SwsContext *img_convert_ctx = nullptr;
+  FrameConverter frame_converter_;
 
   void RenderInternal();
 
@@ -116,6 +116,50 @@ public:
 		}
 	}
 
+	// NV12 frames are handed to Flutter as they are, it converts them to RGB
+	// on the GPU.
+	bool SupportsPixelFormat(PixelFormat format) override {
+		return format == kFormat_NV12 || format == GetSupportFormat();
+	}
+
+	void MaybeInitPlanes(int width, int height, PixelFormat format) override {
+		if (format != kFormat_NV12) {
+			return;
+		}
+		NSDictionary* cvBufferProperties = @{
+			(__bridge NSString*)kCVPixelBufferPixelFormatTypeKey: @(kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange),
+			(__bridge NSString*)kCVPixelBufferIOSurfacePropertiesKey: @{},
+			(__bridge NSString*)kCVPixelBufferOpenGLCompatibilityKey : @YES,
+			(__bridge NSString*)kCVPixelBufferMetalCompatibilityKey : @YES,
+		};
+		auto ret = CVPixelBufferCreate(kCFAllocatorDefault,
+		                               width,
+		                               height,
+		                               kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange,
+		                               (__bridge CFDictionaryRef) cvBufferProperties,
+		                               &cv_pixel_buffer_ref_);
+		if (ret != kCVReturnSuccess) {
+			cv_pixel_buffer_ref_ = nullptr;
+			NSLog(@"create NV12 pixel buffer failed. error : %d", ret);
+		}
+	}
+
+	bool GetPlanes(Planes *planes) override {
+		if (!cv_pixel_buffer_ref_
+			|| CVPixelBufferGetPixelFormatType(cv_pixel_buffer_ref_) != kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange) {
+			return false;
+		}
+		planes->format = kFormat_NV12;
+		planes->width = (int)CVPixelBufferGetWidth(cv_pixel_buffer_ref_);
+		planes->height = (int)CVPixelBufferGetHeight(cv_pixel_buffer_ref_);
+		planes->num_planes = 2;
+		for (int i = 0; i < 2; i++) {
+			planes->data[i] = (uint8_t *)CVPixelBufferGetBaseAddressOfPlane(cv_pixel_buffer_ref_, i);
+			planes->stride[i] = (int)CVPixelBufferGetBytesPerRowOfPlane(cv_pixel_buffer_ref_, i);
+		}
+		return true;
+	}
+
 	void LockBuffer() override {
 		if (cv_pixel_buffer_ref_) {
 			CVPixelBufferLockBaseAddress(cv_pixel_buffer_ref_, 0);
@@ -149,6 +193,10 @@ public:
 		[textures_registry unregisterTexture: texture_id_];
 	}
 
+	bool SupportsHWSurface(HWSurfaceType type) override {
+		return type == kHWSurface_CVPixelBuffer;
+	}
+
 	void RenderWithHWAccel(void *pixel_buffer) override {
 		auto cv_pixel_buffer = static_cast<CVPixelBufferRef>(pixel_buffer);
 //		auto format = CVPixelBufferGetPixelFormatType(cv_pixel_buffer);
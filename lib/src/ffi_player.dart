@@ -29,6 +29,47 @@ class _PlayerConfiguration extends Struct {
   @Int32()
   external int loop;
 
+  /// Threading of the video decoder. 0: auto, 1: frame threads, 2: slice threads.
+  @Int32()
+  external int video_decoder_thread_type;
+
+  /// Count of video decoder threads. 0 keeps a single thread, a negative value
+  /// means one per core.
+  @Int32()
+  external int video_decoder_thread_count;
+
+  /// Decode video with the hardware of the platform, software if none works.
+  @Int32()
+  external int video_hw_accel;
+
+  /// Buffering policy, 0 means the default value.
+  /// Demuxing resumes below [min_buffer_seconds] and pauses at [max_buffer_seconds].
+  @Double()
+  external double min_buffer_seconds;
+
+  @Double()
+  external double max_buffer_seconds;
+
+  /// Bytes of packets one stream may hold.
+  @Int64()
+  external int max_buffer_bytes;
+
+  /// Seconds to buffer before leaving buffering state at start and after an underrun.
+  @Double()
+  external double startup_buffer_seconds;
+
+  @Double()
+  external double rebuffer_seconds;
+
+  @Int32()
+  external int max_decoded_video_frames;
+
+  @Int32()
+  external int max_decoded_audio_buffers;
+
+  @Int32()
+  external int max_decoder_outputs;
+
   static Pointer<_PlayerConfiguration> alloctConfiguration() {
     final pointer = calloc<_PlayerConfiguration>();
     pointer.ref
@@ -37,7 +78,18 @@ class _PlayerConfiguration extends Struct {
       ..subtitle_disable = 1
       ..start_time = 0
       ..loop = 1
-      ..show_status = 0;
+      ..show_status = 0
+      ..video_decoder_thread_type = 0
+      ..video_decoder_thread_count = 0
+      ..video_hw_accel = 0
+      ..min_buffer_seconds = 0
+      ..max_buffer_seconds = 0
+      ..max_buffer_bytes = 0
+      ..startup_buffer_seconds = 0
+      ..rebuffer_seconds = 0
+      ..max_decoded_video_frames = 0
+      ..max_decoded_audio_buffers = 0
+      ..max_decoder_outputs = 0;
     return pointer;
   }
 }
@@ -88,6 +140,18 @@ final ffplayer_seek_to_position = _library.lookupFunction<
     Void Function(Pointer, Double),
     void Function(Pointer, double)>("ffplayer_seek_to_position");
 
+final ffplayer_seek_to_position_with_mode = _library.lookupFunction<
+    Void Function(Pointer, Double, Int32),
+    void Function(Pointer, double, int)>("ffplayer_seek_to_position_with_mode");
+
+final ffplayer_set_scrubbing = _library.lookupFunction<
+    Void Function(Pointer, Int8),
+    void Function(Pointer, int)>("ffplayer_set_scrubbing");
+
+final ffplayer_set_display_size = _library.lookupFunction<
+    Void Function(Pointer, Int32, Int32),
+    void Function(Pointer, int, int)>("ffplayer_set_display_size");
+
 final ffp_set_message_callback = _library.lookupFunction<
     Void Function(Pointer, Int64),
     void Function(Pointer, int)>("ffp_set_message_callback_dart");
@@ -119,6 +183,17 @@ final ffp_get_video_aspect_ratio =
     _library.lookupFunction<Double Function(Pointer), double Function(Pointer)>(
         "ffp_get_video_aspect_ratio");
 
+final ffp_get_stats = _library.lookupFunction<
+    Int32 Function(Pointer, Pointer<Int64>, Int32),
+    int Function(Pointer, Pointer<Int64>, int)>("ffp_get_stats");
+
+final ffp_set_trace_enabled =
+    _library.lookupFunction<Void Function(Int8), void Function(int)>(
+        "ffp_set_trace_enabled");
+
+final ffp_dump_trace = _library.lookupFunction<Int32 Function(Pointer<Utf8>),
+    int Function(Pointer<Utf8>)>("ffp_dump_trace");
+
 var _inited = false;
 
 void _ensureFfplayerGlobalInited() {